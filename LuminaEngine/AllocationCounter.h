@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+/// <summary>
+/// Counts the allocations made through the global operator new, which this module replaces. Sampling
+/// the count around a frame shows whether steady state rendering still touches the heap. Counts are
+/// kept per thread, so loaders and workers allocating meanwhile do not show up in the render thread's.
+/// </summary>
+namespace AllocationCounter
+{
+    /// <summary>
+    /// Allocations the calling thread made since it started
+    /// </summary>
+    uint64_t count();
+}
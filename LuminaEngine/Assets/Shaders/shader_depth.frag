@@ -0,0 +1,6 @@
+#version 330 core
+
+// Depth only, written by the fixed function stage
+void main()
+{
+}
@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 5) in uint aNode;
+
+// Must produce bit identical positions to shader_object.vert for the GL_EQUAL main pass
+invariant gl_Position;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec2 jitter;
+uniform samplerBuffer nodeTransforms; // World transform of every scene graph node, four texels each
+
+mat4 nodeTransform(samplerBuffer transforms, uint node)
+{
+    int texel = int(node) * 4;
+    return mat4(texelFetch(transforms, texel), texelFetch(transforms, texel + 1),
+                texelFetch(transforms, texel + 2), texelFetch(transforms, texel + 3));
+}
+
+void main()
+{
+    vec4 worldPos = model * (nodeTransform(nodeTransforms, aNode) * vec4(aPos, 1.0));
+    gl_Position = projection * view * worldPos;
+    gl_Position.xy += jitter * gl_Position.w;
+}
@@ -12,12 +12,34 @@ in vec2 TexCoords;
 
 uniform sampler2D srcTexture;
 uniform vec2 srcResolution;
+// Part of srcTexture holding the image, below 1 when the scene was rendered at a reduced resolution
+uniform vec2 srcUvScale = vec2(1.0);
+// First pass only: keep the parts of the scene above the threshold, fading in over the soft knee
+uniform bool prefilter = false;
+uniform float threshold = 1.0;
+uniform float softKnee = 0.5;
+
+vec3 applyThreshold(vec3 color)
+{
+    float brightness = max(color.r, max(color.g, color.b));
+    float knee = threshold * softKnee + 0.0001;
+    float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+    soft = soft * soft / (4.0 * knee);
+    return color * max(soft, brightness - threshold) / max(brightness, 0.0001);
+}
+
+vec3 sampleSource(vec2 uv)
+{
+    // Keep the taps inside the rendered region, the rest of the texture holds stale pixels
+    return texture(srcTexture, min(uv, srcUvScale - 0.5 / srcResolution)).rgb;
+}
 
 void main()
 {
     vec2 srcTexelSize = 1.0 / srcResolution;
     float x = srcTexelSize.x;
     float y = srcTexelSize.y;
+    vec2 uv = TexCoords * srcUvScale;
 
     // Take 13 samples around current texel:
     // a - b - c
@@ -26,22 +48,22 @@ void main()
     // - l - m -
     // g - h - i
     // === ('e' is the current texel) ===
-    vec3 a = texture(srcTexture, vec2(TexCoords.x - 2*x, TexCoords.y + 2*y)).rgb;
-    vec3 b = texture(srcTexture, vec2(TexCoords.x, TexCoords.y + 2*y)).rgb;
-    vec3 c = texture(srcTexture, vec2(TexCoords.x + 2*x, TexCoords.y + 2*y)).rgb;
+    vec3 a = sampleSource(vec2(uv.x - 2*x, uv.y + 2*y));
+    vec3 b = sampleSource(vec2(uv.x, uv.y + 2*y));
+    vec3 c = sampleSource(vec2(uv.x + 2*x, uv.y + 2*y));
 
-    vec3 d = texture(srcTexture, vec2(TexCoords.x - 2*x, TexCoords.y)).rgb;
-    vec3 e = texture(srcTexture, vec2(TexCoords.x, TexCoords.y)).rgb;
-    vec3 f = texture(srcTexture, vec2(TexCoords.x + 2*x, TexCoords.y)).rgb;
+    vec3 d = sampleSource(vec2(uv.x - 2*x, uv.y));
+    vec3 e = sampleSource(vec2(uv.x, uv.y));
+    vec3 f = sampleSource(vec2(uv.x + 2*x, uv.y));
 
-    vec3 g = texture(srcTexture, vec2(TexCoords.x - 2*x, TexCoords.y - 2*y)).rgb;
-    vec3 h = texture(srcTexture, vec2(TexCoords.x, TexCoords.y - 2*y)).rgb;
-    vec3 i = texture(srcTexture, vec2(TexCoords.x + 2*x, TexCoords.y - 2*y)).rgb;
+    vec3 g = sampleSource(vec2(uv.x - 2*x, uv.y - 2*y));
+    vec3 h = sampleSource(vec2(uv.x, uv.y - 2*y));
+    vec3 i = sampleSource(vec2(uv.x + 2*x, uv.y - 2*y));
 
-    vec3 j = texture(srcTexture, vec2(TexCoords.x - x, TexCoords.y + y)).rgb;
-    vec3 k = texture(srcTexture, vec2(TexCoords.x + x, TexCoords.y + y)).rgb;
-    vec3 l = texture(srcTexture, vec2(TexCoords.x - x, TexCoords.y - y)).rgb;
-    vec3 m = texture(srcTexture, vec2(TexCoords.x + x, TexCoords.y - y)).rgb;
+    vec3 j = sampleSource(vec2(uv.x - x, uv.y + y));
+    vec3 k = sampleSource(vec2(uv.x + x, uv.y + y));
+    vec3 l = sampleSource(vec2(uv.x - x, uv.y - y));
+    vec3 m = sampleSource(vec2(uv.x + x, uv.y - y));
 
     // Apply weighted distribution:
     // 0.5 + 0.125 + 0.125 + 0.125 + 0.125 = 1
@@ -60,4 +82,9 @@ void main()
     downsample += (a+c+g+i)*0.03125;
     downsample += (b+d+f+h)*0.0625;
     downsample += (j+k+l+m)*0.125;
+
+    if (prefilter)
+    {
+        downsample = applyThreshold(downsample);
+    }
 }
@@ -4,8 +4,15 @@ layout (location = 0) in vec3 aPos;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform mat4 prevViewProjection;
+uniform vec2 jitter;
+
+out vec3 PrevClipPos;
 
 void main()
 {
+    // Light previews do not move, only the camera does
+    PrevClipPos = (prevViewProjection * model * vec4(aPos, 1.0)).xyw;
     gl_Position = projection * view * model * vec4(aPos, 1.0);
-}
\ No newline at end of file
+    gl_Position.xy += jitter * gl_Position.w;
+}
@@ -1,11 +1,14 @@
 #version 330 core
 
 #define NR_LIGHTS 5
+#define CASCADE_COUNT 3
 
 const float PI = 3.14159265359;
 
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec2 Velocity; // Screen space motion since the previous frame, in texture coordinates
 in vec2 TexCoords;
+flat in float MaterialLayer;
 in vec3 TangentDirLightDirection;
 in vec3 TangentPointLightPos[NR_LIGHTS];
 in vec3 TangentSpotLightPos[NR_LIGHTS];
@@ -13,6 +16,7 @@ in vec3 TangentSpotLightDir[NR_LIGHTS];
 in vec3 TangentCamPos;
 in vec3 TangentFragPos;
 in mat3 inversedTBN;
+in vec3 PrevClipPos;
 
 struct DirLight
 {
@@ -69,18 +73,51 @@ struct MaterialPbr
     sampler2D texture_ao1;
 };
 
+// Materials packed into texture arrays, indexed by MaterialLayer
+struct MaterialArrays
+{
+    sampler2DArray texture_diffuse;
+    sampler2DArray texture_specular;
+    sampler2DArray texture_albedo;
+    sampler2DArray texture_metallic;
+    sampler2DArray texture_roughness;
+    sampler2DArray texture_normal;
+    sampler2DArray texture_ao;
+};
+
+// The velocity output is derived from the fragment position, only the previous one is interpolated
+uniform vec2 renderSize; // Size of the viewport the scene is rendered into
+uniform vec2 jitter; // Sub-pixel TAA offset in clip space
 uniform bool isPbr;
+uniform bool useMaterialArrays;
 uniform DirLight dirLight;
 uniform PointLight pointLights[NR_LIGHTS];
 uniform SpotLight spotLights[NR_LIGHTS];
 uniform Material material;
 uniform MaterialPbr materialPbr;
+uniform MaterialArrays materialArrays;
 uniform samplerCube skybox;
 uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLut;
 uniform bool enableIBL;
 
+uniform mat4 view;
+uniform vec3 pointLightPos[NR_LIGHTS];
+uniform bool shadowsEnabled;
+uniform sampler2DArrayShadow cascadeShadowMap;
+uniform mat4 cascadeViewProjections[CASCADE_COUNT];
+uniform float cascadeSplits[CASCADE_COUNT]; // Far view depth of each cascade, negative while not rendered
+uniform float cascadeTexelSizes[CASCADE_COUNT]; // World size of a shadow map texel
+// Six layers per light, in cube map face order
+uniform sampler2DArrayShadow pointShadowMap;
+uniform bool pointShadowValid[NR_LIGHTS];
+uniform vec3 pointShadowPos[NR_LIGHTS]; // Where each map was rendered from
+uniform float pointShadowFar;
+uniform bool ssaoEnabled;
+uniform sampler2D ssaoTexture; // Low resolution occlusion, view depth
+uniform vec2 ssaoUvScale; // Part of ssaoTexture holding this frame
+
 vec3 normal = vec3(0.0);
 vec3 albedo = vec3(0.0);
 float metallic = 0.0;
@@ -88,9 +125,9 @@ float roughness = 0.0;
 float ao = 0.0;
 vec3 F0 = vec3(0.04); // Non-metallic / dielectric
 
-vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir);
-vec3 calcPointLight(PointLight light, vec3 lightPos, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 calcPbrPointLight(PointLight light, vec3 lightPos, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir, float shadow);
+vec3 calcPointLight(PointLight light, vec3 lightPos, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow);
+vec3 calcPbrPointLight(PointLight light, vec3 lightPos, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow);
 vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 calcDiffuse(vec3 color, vec3 normal, vec3 lightDir);
 vec3 calcSpecular(vec3 color, vec3 normal, vec3 lightDir, vec3 viewDir);
@@ -99,24 +136,25 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness);
 float distributionGGX(vec3 N, vec3 H, float roughness);
 float geometrySchlickGGX(float NdotV, float roughness);
 float geometrySmith(vec3 N, vec3 V, vec3 L, float roughness);
+vec4 sampleMaterial(sampler2D map, sampler2DArray arrayMap);
 
-vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir)
+vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir, float shadow)
 {
     vec3 lightDir = normalize(-TangentDirLightDirection);
 
-    vec3 ambient = texture(material.texture_diffuse1, TexCoords).rgb * light.ambient;
+    vec3 ambient = sampleMaterial(material.texture_diffuse1, materialArrays.texture_diffuse).rgb * light.ambient;
     vec3 diffuse = calcDiffuse(light.diffuse, normal, lightDir);
     vec3 specular = calcSpecular(light.specular, normal, lightDir, viewDir);
 
-    return (ambient + diffuse + specular);
+    return (ambient + (diffuse + specular) * shadow);
 }
 
-vec3 calcPointLight(PointLight light, vec3 lightPos, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 calcPointLight(PointLight light, vec3 lightPos, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow)
 {
     // Light direction from fragment to light
     vec3 lightDir = normalize(lightPos - fragPos);
 
-    vec3 ambient = texture(material.texture_diffuse1, TexCoords).rgb * light.ambient;
+    vec3 ambient = sampleMaterial(material.texture_diffuse1, materialArrays.texture_diffuse).rgb * light.ambient;
     vec3 diffuse = calcDiffuse(light.diffuse, normal, lightDir);
     vec3 specular = calcSpecular(light.specular, normal, lightDir, viewDir);
 
@@ -128,10 +166,10 @@ vec3 calcPointLight(PointLight light, vec3 lightPos, vec3 normal, vec3 fragPos,
     diffuse *= attenuation;
     specular *= attenuation;
 
-    return (ambient + diffuse + specular);
+    return (ambient + (diffuse + specular) * shadow);
 }
 
-vec3 calcPbrPointLight(PointLight light, vec3 lightPos, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 calcPbrPointLight(PointLight light, vec3 lightPos, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow)
 {
     vec3 radianceOut = vec3(0.0); // Outgoing radiance (Lo)
 
@@ -142,7 +180,7 @@ vec3 calcPbrPointLight(PointLight light, vec3 lightPos, vec3 normal, vec3 fragPo
 
     float distance = length(lightPos - fragPos);
     float attenuation = 1.0 / (distance * distance);
-    vec3 radiance = light.diffuse * attenuation;
+    vec3 radiance = light.diffuse * attenuation * shadow;
 
     vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
 
@@ -216,7 +254,7 @@ vec3 calcSpotLight(SpotLight light, vec3 lightPos, vec3 spotDir, vec3 normal, ve
     // Light direction from fragment to light
     vec3 lightDir = normalize(lightPos - fragPos);
 
-    vec3 ambient = texture(material.texture_diffuse1, TexCoords).rgb * light.ambient;
+    vec3 ambient = sampleMaterial(material.texture_diffuse1, materialArrays.texture_diffuse).rgb * light.ambient;
     vec3 diffuse = calcDiffuse(light.diffuse, normal, lightDir);
     vec3 specular = calcSpecular(light.specular, normal, lightDir, viewDir);
 
@@ -241,7 +279,7 @@ vec3 calcSpotLight(SpotLight light, vec3 lightPos, vec3 spotDir, vec3 normal, ve
 vec3 calcDiffuse(vec3 color, vec3 normal, vec3 lightDir)
 {
     float diff = max(dot(normal, lightDir), 0.0);
-    return (diff * texture(material.texture_diffuse1, TexCoords).rgb * color);
+    return (diff * sampleMaterial(material.texture_diffuse1, materialArrays.texture_diffuse).rgb * color);
 }
 
 vec3 calcSpecular(vec3 color, vec3 normal, vec3 lightDir, vec3 viewDir)
@@ -249,35 +287,134 @@ vec3 calcSpecular(vec3 color, vec3 normal, vec3 lightDir, vec3 viewDir)
     // Specular (Blinn-Phong)
     vec3 halfwayDir = normalize(lightDir + viewDir);
     float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
-    return (spec * texture(material.texture_specular1, TexCoords).rgb * color);
+    return (spec * sampleMaterial(material.texture_specular1, materialArrays.texture_specular).rgb * color);
+}
+
+vec4 sampleMaterial(sampler2D map, sampler2DArray arrayMap)
+{
+    return useMaterialArrays ? texture(arrayMap, vec3(TexCoords, MaterialLayer)) : texture(map, TexCoords);
+}
+
+// Normal maps may be stored as two channel BC5 textures, so z is always rebuilt from x and y
+vec3 sampleNormalMap(sampler2D normalMap, sampler2DArray normalArrayMap)
+{
+    vec2 xy = sampleMaterial(normalMap, normalArrayMap).rg * 2.0 - 1.0;
+    return vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+}
+
+// Fraction of the directional light reaching the fragment, from the first cascade covering it
+float directionalShadow(vec3 worldPos, vec3 worldNormal)
+{
+    float viewDepth = -(view * vec4(worldPos, 1.0)).z;
+    for (int i = 0; i < CASCADE_COUNT; i++)
+    {
+        if (viewDepth > cascadeSplits[i]) { continue; }
+
+        // Moving the lookup along the normal by about a texel keeps surfaces from shadowing themselves
+        vec3 offsetPos = worldPos + worldNormal * cascadeTexelSizes[i] * 1.5;
+        vec3 coords = (cascadeViewProjections[i] * vec4(offsetPos, 1.0)).xyz * 0.5 + 0.5;
+        vec2 texelSize = 1.0 / vec2(textureSize(cascadeShadowMap, 0).xy);
+
+        // Four bilinear comparisons, 4x4 texels of PCF
+        float lit = 0.0;
+        lit += texture(cascadeShadowMap, vec4(coords.xy + vec2(-0.5, -0.5) * texelSize, i, coords.z));
+        lit += texture(cascadeShadowMap, vec4(coords.xy + vec2( 0.5, -0.5) * texelSize, i, coords.z));
+        lit += texture(cascadeShadowMap, vec4(coords.xy + vec2(-0.5,  0.5) * texelSize, i, coords.z));
+        lit += texture(cascadeShadowMap, vec4(coords.xy + vec2( 0.5,  0.5) * texelSize, i, coords.z));
+        return lit * 0.25;
+    }
+    return 1.0;
+}
+
+// Point light maps are cube maps laid out as array layers, so the face and its coordinates are picked
+// the way the hardware does for cube map lookups
+float pointShadow(int light, vec3 worldPos, vec3 worldNormal)
+{
+    vec3 toFrag = worldPos + worldNormal * 0.02 - pointShadowPos[light];
+    float distance = length(toFrag);
+    if (distance >= pointShadowFar) { return 1.0; }
+
+    vec3 absDir = abs(toFrag);
+    int face;
+    float majorAxis;
+    vec2 sc;
+    if (absDir.x >= absDir.y && absDir.x >= absDir.z)
+    {
+        face = toFrag.x > 0.0 ? 0 : 1;
+        majorAxis = absDir.x;
+        sc = vec2(toFrag.x > 0.0 ? -toFrag.z : toFrag.z, -toFrag.y);
+    }
+    else if (absDir.y >= absDir.z)
+    {
+        face = toFrag.y > 0.0 ? 2 : 3;
+        majorAxis = absDir.y;
+        sc = vec2(toFrag.x, toFrag.y > 0.0 ? toFrag.z : -toFrag.z);
+    }
+    else
+    {
+        face = toFrag.z > 0.0 ? 4 : 5;
+        majorAxis = absDir.z;
+        sc = vec2(toFrag.z > 0.0 ? toFrag.x : -toFrag.x, -toFrag.y);
+    }
+    vec2 uv = sc / majorAxis * 0.5 + 0.5;
+    return texture(pointShadowMap, vec4(uv, light * 6 + face, distance / pointShadowFar - 0.002));
+}
+
+// Bilinear upsample of the low resolution occlusion, with taps weighted down by how far their depth is
+// from the fragment so dark halos do not spill over silhouettes
+float sampleSsao(float viewDepth)
+{
+    vec2 texSize = vec2(textureSize(ssaoTexture, 0));
+    vec2 samplePos = gl_FragCoord.xy / renderSize * ssaoUvScale * texSize - 0.5;
+    ivec2 base = ivec2(floor(samplePos));
+    vec2 f = samplePos - floor(samplePos);
+    ivec2 maxTexel = ivec2(ssaoUvScale * texSize) - 1;
+
+    float occlusion = 0.0;
+    float weightSum = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        vec2 tap = texelFetch(ssaoTexture, clamp(base + offset, ivec2(0), maxTexel), 0).rg;
+        vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+        float weight = bilinear.x * bilinear.y / (0.001 + abs(tap.g - viewDepth));
+        occlusion += tap.r * weight;
+        weightSum += weight;
+    }
+    return weightSum > 0.0 ? occlusion / weightSum : 1.0;
 }
 
 void main()
 {
     if (isPbr)
     {
-        normal = texture(materialPbr.texture_normal1, TexCoords).rgb;
-        albedo = texture(materialPbr.texture_albedo1, TexCoords).rgb;
-        metallic = texture(materialPbr.texture_metallic1, TexCoords).r;
-        roughness = texture(materialPbr.texture_roughness1, TexCoords).r;
-        ao = texture(materialPbr.texture_ao1, TexCoords).r;
+        normal = sampleNormalMap(materialPbr.texture_normal1, materialArrays.texture_normal);
+        albedo = sampleMaterial(materialPbr.texture_albedo1, materialArrays.texture_albedo).rgb;
+        metallic = sampleMaterial(materialPbr.texture_metallic1, materialArrays.texture_metallic).r;
+        roughness = sampleMaterial(materialPbr.texture_roughness1, materialArrays.texture_roughness).r;
+        ao = sampleMaterial(materialPbr.texture_ao1, materialArrays.texture_ao).r;
         F0 = mix(F0, albedo, metallic);
     }
     else
     {
-        normal = texture(material.texture_normal1, TexCoords).rgb;
+        normal = sampleNormalMap(material.texture_normal1, materialArrays.texture_normal);
     }
-    normal = normalize(normal * 2.0 - 1.0);
+    normal = normalize(normal);
 
     // Light reflection from fragment to camera/eye
     vec3 viewDir = normalize(TangentCamPos - TangentFragPos);
 
     vec3 result = vec3(0.0); // Reflectance equation output of PBR workflow
 
+    // The tangent space basis is orthonormal, so its inverse takes positions back to world space
+    vec3 worldPos = inversedTBN * TangentFragPos;
+    vec3 worldNormal = normalize(inversedTBN * normal);
+
     // Phase 1: Directional lighting
     if (dirLight.isActive)
     {
-        result += calcDirLight(dirLight, normal, viewDir);
+        float shadow = shadowsEnabled ? directionalShadow(worldPos, worldNormal) : 1.0;
+        result += calcDirLight(dirLight, normal, viewDir, shadow);
     }
 
     for (int i = 0; i < NR_LIGHTS; i++)
@@ -285,13 +422,15 @@ void main()
         // Phase 2: Point lights
         if (pointLights[i].isActive)
         {
+            float shadow = shadowsEnabled && pointShadowValid[i] ? pointShadow(i, worldPos, worldNormal) : 1.0;
             if (isPbr)
             {
                 result += calcPbrPointLight(pointLights[i],
                                         TangentPointLightPos[i],
                                         normal,
                                         TangentFragPos,
-                                        viewDir);
+                                        viewDir,
+                                        shadow);
             }
             else
             {
@@ -299,7 +438,8 @@ void main()
                                          TangentPointLightPos[i],
                                          normal,
                                          TangentFragPos,
-                                         viewDir);
+                                         viewDir,
+                                         shadow);
             }
         }
 
@@ -334,10 +474,17 @@ void main()
         vec2 brdf = texture(brdfLut, vec2(cosTheta, roughness)).rg;
         vec3 specular = prefilteredColor * (F * brdf.x + brdf.y);
 
-        vec3 ambient = (kD * diffuse + specular) * ao;
+        float occlusion = ao;
+        if (ssaoEnabled)
+        {
+            occlusion *= sampleSsao(-(view * vec4(worldPos, 1.0)).z);
+        }
+        vec3 ambient = (kD * diffuse + specular) * occlusion;
 
         result += ambient;
     }
 
     FragColor = vec4(result, 1.0);
+    vec2 prevUv = PrevClipPos.xy / PrevClipPos.z * 0.5 + 0.5;
+    Velocity = gl_FragCoord.xy / renderSize - jitter * 0.5 - prevUv;
 }
@@ -3,10 +3,13 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 layout (location = 3) in vec3 aTangent;
+layout (location = 4) in float aMaterialLayer;
+layout (location = 5) in uint aNode;
 
 #define NR_LIGHTS 5
 
 out vec2 TexCoords;
+flat out float MaterialLayer;
 out vec3 TangentDirLightDirection;
 out vec3 TangentPointLightPos[NR_LIGHTS];
 out vec3 TangentSpotLightPos[NR_LIGHTS];
@@ -14,29 +17,50 @@ out vec3 TangentSpotLightDir[NR_LIGHTS];
 out vec3 TangentCamPos;
 out vec3 TangentFragPos;
 out mat3 inversedTBN;
+out vec3 PrevClipPos; // x, y and w of the vertex in the previous frame
+// Matches shader_depth_prepass.vert exactly, so the pre-pass depth passes the GL_EQUAL test
+invariant gl_Position;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform mat4 prevModel;
+uniform mat4 prevViewProjection;
+uniform vec2 jitter; // Sub-pixel offset in clip space, zero without TAA
 uniform vec3 camPos;
 uniform vec3 dirLightDirection;
 uniform vec3 pointLightPos[NR_LIGHTS];
 uniform vec3 spotLightPos[NR_LIGHTS];
 uniform vec3 spotLightDir[NR_LIGHTS];
+uniform samplerBuffer nodeTransforms; // World transform of every scene graph node, four texels each
+uniform samplerBuffer prevNodeTransforms; // The same for the previous frame, for motion vectors
+
+mat4 nodeTransform(samplerBuffer transforms, uint node)
+{
+    int texel = int(node) * 4;
+    return mat4(texelFetch(transforms, texel), texelFetch(transforms, texel + 1),
+                texelFetch(transforms, texel + 2), texelFetch(transforms, texel + 3));
+}
 
 void main()
 {
     TexCoords = aTexCoords;
+    MaterialLayer = aMaterialLayer;
+
+    mat4 node = nodeTransform(nodeTransforms, aNode);
+    // Same association as shader_depth_prepass.vert, so the positions stay bit identical
+    vec4 worldPos = model * (node * vec4(aPos, 1.0));
+    mat4 world = model * node;
 
-    vec3 T = normalize(vec3(model * vec4(aTangent, 0.0)));
-    vec3 N = normalize(vec3(model * vec4(aNormal, 0.0)));
+    vec3 T = normalize(vec3(world * vec4(aTangent, 0.0)));
+    vec3 N = normalize(vec3(world * vec4(aNormal, 0.0)));
     // Re-orthogonalize T with respect to N
     T = normalize(T - dot(T, N) * N);
     vec3 B = cross(N, T);
     mat3 TBN = transpose(mat3(T, B, N));
     inversedTBN = inverse(TBN);
     TangentCamPos = TBN * camPos;
-    TangentFragPos = TBN * vec3(model * vec4(aPos, 1.0));
+    TangentFragPos = TBN * worldPos.xyz;
     TangentDirLightDirection = TBN * dirLightDirection;
     for (int i = 0; i < NR_LIGHTS; i++)
     {
@@ -45,5 +69,9 @@ void main()
         TangentSpotLightDir[i] = TBN * spotLightDir[i];
     }
 
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    // Moved nodes get motion vectors from their transform of the previous frame
+    vec4 prevPos = prevViewProjection * prevModel * (nodeTransform(prevNodeTransforms, aNode) * vec4(aPos, 1.0));
+    PrevClipPos = prevPos.xyw;
+    gl_Position = projection * view * worldPos;
+    gl_Position.xy += jitter * gl_Position.w;
 }
@@ -8,10 +8,69 @@ uniform float gamma;
 uniform float exposure;
 uniform float bloomStrength = 0.04f;
 uniform bool bloomEnabled = true;
+// Part of screenTexture holding the scene, below 1 when dynamic resolution lowered the render size
+uniform vec2 renderScale = vec2(1.0);
+
+vec3 sampleScene(vec2 uv, vec2 minUv, vec2 maxUv)
+{
+    return texture(screenTexture, clamp(uv, minUv, maxUv)).rgb;
+}
+
+// Catmull-Rom upscale in 9 bilinear taps, as described by Jorge Jimenez in "Filmic SMAA" (Siggraph 2016).
+// Keeps edges sharper than a plain bilinear stretch of the lower resolution scene.
+vec3 sampleSceneCatmullRom(vec2 uv)
+{
+    vec2 texSize = vec2(textureSize(screenTexture, 0));
+    vec2 texelSize = 1.0 / texSize;
+    // Taps may not read past the rendered region, the rest of the texture holds stale pixels
+    vec2 minUv = 0.5 * texelSize;
+    vec2 maxUv = renderScale - 0.5 * texelSize;
+
+    vec2 samplePos = uv * texSize;
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+
+    // The middle two taps of each axis are merged into one bilinear fetch
+    vec2 w12 = w1 + w2;
+    vec2 offset12 = w2 / w12;
+
+    vec2 texPos0 = (texPos1 - 1.0) * texelSize;
+    vec2 texPos3 = (texPos1 + 2.0) * texelSize;
+    vec2 texPos12 = (texPos1 + offset12) * texelSize;
+
+    vec3 result = vec3(0.0);
+    result += sampleScene(vec2(texPos0.x, texPos0.y), minUv, maxUv) * w0.x * w0.y;
+    result += sampleScene(vec2(texPos12.x, texPos0.y), minUv, maxUv) * w12.x * w0.y;
+    result += sampleScene(vec2(texPos3.x, texPos0.y), minUv, maxUv) * w3.x * w0.y;
+
+    result += sampleScene(vec2(texPos0.x, texPos12.y), minUv, maxUv) * w0.x * w12.y;
+    result += sampleScene(vec2(texPos12.x, texPos12.y), minUv, maxUv) * w12.x * w12.y;
+    result += sampleScene(vec2(texPos3.x, texPos12.y), minUv, maxUv) * w3.x * w12.y;
+
+    result += sampleScene(vec2(texPos0.x, texPos3.y), minUv, maxUv) * w0.x * w3.y;
+    result += sampleScene(vec2(texPos12.x, texPos3.y), minUv, maxUv) * w12.x * w3.y;
+    result += sampleScene(vec2(texPos3.x, texPos3.y), minUv, maxUv) * w3.x * w3.y;
+
+    // Negative lobes can ring below zero next to very bright pixels
+    return max(result, vec3(0.0));
+}
 
 void main()
 {
-    vec3 hdrColor = texture(screenTexture, TexCoords).rgb;
+    vec3 hdrColor;
+    if (renderScale.x < 1.0 || renderScale.y < 1.0)
+    {
+        hdrColor = sampleSceneCatmullRom(TexCoords * renderScale);
+    }
+    else
+    {
+        hdrColor = texture(screenTexture, TexCoords).rgb;
+    }
     vec3 bloomBlur = texture(bloomBlurTexture, TexCoords).rgb;
 
     if (bloomEnabled)
@@ -0,0 +1,11 @@
+#version 330 core
+in vec3 WorldPos;
+
+uniform vec3 lightPos;
+uniform float farPlane;
+
+// Distance to the light over farPlane, so every cube face stores and compares the same value
+void main()
+{
+    gl_FragDepth = length(WorldPos - lightPos) / farPlane;
+}
@@ -1,10 +1,16 @@
 #version 330 core
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec2 Velocity;
 in vec3 WorldPos;
+in vec3 PrevClipPos;
 
 uniform samplerCube skybox;
+uniform vec2 renderSize;
+uniform vec2 jitter;
 
 void main()
 {
     FragColor = texture(skybox, WorldPos);
+    vec2 prevUv = PrevClipPos.xy / PrevClipPos.z * 0.5 + 0.5;
+    Velocity = gl_FragCoord.xy / renderSize - jitter * 0.5 - prevUv;
 }
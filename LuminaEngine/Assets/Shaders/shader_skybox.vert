@@ -2,9 +2,12 @@
 layout (location = 0) in vec3 aPos;
 
 out vec3 WorldPos;
+out vec3 PrevClipPos;
 
 uniform mat4 view;
 uniform mat4 projection;
+uniform mat4 prevViewProjection; // Without translation, like view
+uniform vec2 jitter;
 
 void main()
 {
@@ -15,4 +18,6 @@ void main()
     // z component of the resulting division (z / w) = vertex depth value
     // Hence, making z = w will give us w / w = 1.0, a depth value of 1.0 all the time
     gl_Position = pos.xyww;
+    gl_Position.xy += jitter * gl_Position.w;
+    PrevClipPos = (prevViewProjection * vec4(aPos, 1.0)).xyw;
 }
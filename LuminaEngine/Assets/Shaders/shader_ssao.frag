@@ -0,0 +1,59 @@
+#version 330 core
+// Normal oriented hemisphere SSAO. Writes occlusion to red and the view depth of the pixel to green for
+// the depth-aware blur and upsample.
+#define KERNEL_SIZE 16
+
+layout (location = 0) out vec2 FragColor;
+in vec2 TexCoords;
+
+uniform sampler2D normalDepthTexture; // View space normal, view depth (0 where nothing was drawn)
+uniform sampler2D noiseTexture;
+uniform vec3 samples[KERNEL_SIZE];
+uniform mat4 projection;
+uniform vec2 uvScale; // Part of the textures holding this frame
+uniform vec2 noiseScale; // Viewport size over the noise texture size
+uniform float radius;
+uniform float intensity;
+uniform float bias = 0.025;
+
+vec3 viewPosition(vec2 screenUv, float depth)
+{
+    vec2 ndc = screenUv * 2.0 - 1.0;
+    return vec3(ndc.x * depth / projection[0][0], ndc.y * depth / projection[1][1], -depth);
+}
+
+void main()
+{
+    vec4 normalDepth = texture(normalDepthTexture, TexCoords * uvScale);
+    float depth = normalDepth.w;
+    if (depth <= 0.0)
+    {
+        FragColor = vec2(1.0, 0.0);
+        return;
+    }
+
+    vec3 fragPos = viewPosition(TexCoords, depth);
+    vec3 normal = normalDepth.xyz;
+    // Gram-Schmidt with a per-pixel random vector rotates the kernel around the normal
+    vec3 randomVec = vec3(texture(noiseTexture, TexCoords * noiseScale).xy, 0.0);
+    vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
+    vec3 bitangent = cross(normal, tangent);
+    mat3 TBN = mat3(tangent, bitangent, normal);
+
+    float occlusion = 0.0;
+    for (int i = 0; i < KERNEL_SIZE; i++)
+    {
+        vec3 samplePos = fragPos + TBN * samples[i] * radius;
+        vec4 offset = projection * vec4(samplePos, 1.0);
+        vec2 sampleUv = offset.xy / offset.w * 0.5 + 0.5;
+        if (any(lessThan(sampleUv, vec2(0.0))) || any(greaterThan(sampleUv, vec2(1.0)))) { continue; }
+
+        float sampleDepth = texture(normalDepthTexture, sampleUv * uvScale).w;
+        if (sampleDepth <= 0.0) { continue; }
+        // Occluders far in front of the pixel are separate objects and should not darken it
+        float rangeCheck = smoothstep(0.0, 1.0, radius / abs(depth - sampleDepth));
+        occlusion += (sampleDepth <= -samplePos.z - bias ? 1.0 : 0.0) * rangeCheck;
+    }
+
+    FragColor = vec2(pow(1.0 - occlusion / KERNEL_SIZE, intensity), depth);
+}
@@ -0,0 +1,41 @@
+#version 330 core
+// One axis of a separable Gaussian blur that ignores taps across depth discontinuities, so occlusion
+// does not bleed between objects
+layout (location = 0) out vec2 FragColor;
+in vec2 TexCoords;
+
+uniform sampler2D aoTexture; // Occlusion, view depth
+uniform vec2 direction; // One texel along the blur axis, in texture coordinates
+uniform vec2 uvScale; // Part of the texture holding this frame
+// Relative depth difference at which a tap stops contributing
+uniform float depthTolerance = 0.05;
+
+const float weights[5] = float[](0.2270270270, 0.1945945946, 0.1216216216, 0.0540540541, 0.0162162162);
+
+void main()
+{
+    vec2 uv = TexCoords * uvScale;
+    vec2 maxUv = uvScale - 0.5 * abs(direction);
+    vec2 center = texture(aoTexture, uv).rg;
+    if (center.g <= 0.0)
+    {
+        FragColor = center;
+        return;
+    }
+
+    float occlusion = center.r * weights[0];
+    float weightSum = weights[0];
+    for (int i = 1; i < 5; i++)
+    {
+        for (int side = -1; side <= 1; side += 2)
+        {
+            vec2 tap = texture(aoTexture, min(uv + direction * float(i * side), maxUv)).rg;
+            float depthWeight = max(0.0, 1.0 - abs(tap.g - center.g) / (center.g * depthTolerance));
+            float weight = weights[i] * depthWeight;
+            occlusion += tap.r * weight;
+            weightSum += weight;
+        }
+    }
+
+    FragColor = vec2(occlusion / weightSum, center.g);
+}
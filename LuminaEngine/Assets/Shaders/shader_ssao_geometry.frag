@@ -0,0 +1,12 @@
+#version 330 core
+layout (location = 0) out vec4 NormalDepth;
+
+in vec3 ViewPos;
+
+void main()
+{
+    // Face normals from the position derivatives, drawn from the position only stream. Vertex and normal map
+    // detail are too fine for the low resolution occlusion anyway. Always faces the camera.
+    vec3 normal = normalize(cross(dFdx(ViewPos), dFdy(ViewPos)));
+    NormalDepth = vec4(normal, -ViewPos.z);
+}
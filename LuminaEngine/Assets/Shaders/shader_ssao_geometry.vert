@@ -0,0 +1,24 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 5) in uint aNode;
+
+out vec3 ViewPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform samplerBuffer nodeTransforms; // World transform of every scene graph node, four texels each
+
+mat4 nodeTransform(samplerBuffer transforms, uint node)
+{
+    int texel = int(node) * 4;
+    return mat4(texelFetch(transforms, texel), texelFetch(transforms, texel + 1),
+                texelFetch(transforms, texel + 2), texelFetch(transforms, texel + 3));
+}
+
+void main()
+{
+    vec4 viewPos = view * model * (nodeTransform(nodeTransforms, aNode) * vec4(aPos, 1.0));
+    ViewPos = viewPos.xyz;
+    gl_Position = projection * viewPos;
+}
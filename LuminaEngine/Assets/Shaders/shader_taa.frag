@@ -0,0 +1,130 @@
+#version 330 core
+// Temporal anti-aliasing resolve. Blends the jittered scene with the reprojected history of previous
+// frames, clipping the history to the colours found around the pixel so moving edges do not ghost.
+// Runs at the output resolution, so a scene rendered at a lower resolution is upscaled along the way.
+layout (location = 0) out vec4 FragColor;
+in vec2 TexCoords;
+
+uniform sampler2D sceneTexture;
+uniform sampler2D velocityTexture;
+uniform sampler2D historyTexture;
+// Part of the scene and velocity textures holding the current frame
+uniform vec2 sceneUvScale;
+uniform bool historyValid;
+// Weight of the current frame, lower values trade responsiveness for smoother edges
+uniform float currentWeight = 0.1;
+
+vec3 rgbToYCoCg(vec3 c)
+{
+    return vec3(0.25 * c.r + 0.5 * c.g + 0.25 * c.b,
+                0.5 * c.r - 0.5 * c.b,
+                -0.25 * c.r + 0.5 * c.g - 0.25 * c.b);
+}
+
+vec3 yCoCgToRgb(vec3 c)
+{
+    return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+// Brightness weighting keeps single very bright samples from flickering, see Karis "High Quality Temporal
+// Supersampling" (Siggraph 2014)
+float luminanceWeight(vec3 yCoCg)
+{
+    return 1.0 / (1.0 + yCoCg.x);
+}
+
+// Catmull-Rom history fetch in 9 bilinear taps, repeated bilinear fetches would blur the history over time
+vec3 sampleHistory(vec2 uv)
+{
+    vec2 texSize = vec2(textureSize(historyTexture, 0));
+    vec2 samplePos = uv * texSize;
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+    vec2 w12 = w1 + w2;
+
+    vec2 texPos0 = (texPos1 - 1.0) / texSize;
+    vec2 texPos3 = (texPos1 + 2.0) / texSize;
+    vec2 texPos12 = (texPos1 + w2 / w12) / texSize;
+
+    vec3 result = vec3(0.0);
+    result += texture(historyTexture, vec2(texPos0.x, texPos0.y)).rgb * w0.x * w0.y;
+    result += texture(historyTexture, vec2(texPos12.x, texPos0.y)).rgb * w12.x * w0.y;
+    result += texture(historyTexture, vec2(texPos3.x, texPos0.y)).rgb * w3.x * w0.y;
+    result += texture(historyTexture, vec2(texPos0.x, texPos12.y)).rgb * w0.x * w12.y;
+    result += texture(historyTexture, vec2(texPos12.x, texPos12.y)).rgb * w12.x * w12.y;
+    result += texture(historyTexture, vec2(texPos3.x, texPos12.y)).rgb * w3.x * w12.y;
+    result += texture(historyTexture, vec2(texPos0.x, texPos3.y)).rgb * w0.x * w3.y;
+    result += texture(historyTexture, vec2(texPos12.x, texPos3.y)).rgb * w12.x * w3.y;
+    result += texture(historyTexture, vec2(texPos3.x, texPos3.y)).rgb * w3.x * w3.y;
+    return max(result, vec3(0.0));
+}
+
+// Moves the history towards the centre of the neighbourhood box until it lies inside it
+vec3 clipToBox(vec3 history, vec3 boxMin, vec3 boxMax)
+{
+    vec3 center = 0.5 * (boxMax + boxMin);
+    vec3 extents = 0.5 * (boxMax - boxMin) + 0.0001;
+    vec3 offset = history - center;
+    vec3 units = abs(offset / extents);
+    float maxUnit = max(units.x, max(units.y, units.z));
+    return maxUnit > 1.0 ? center + offset / maxUnit : history;
+}
+
+void main()
+{
+    vec2 sceneTexelSize = 1.0 / vec2(textureSize(sceneTexture, 0));
+    vec2 sceneUv = TexCoords * sceneUvScale;
+    // Taps may not read past the rendered region, the rest of the texture holds stale pixels
+    vec2 maxSceneUv = sceneUvScale - 0.5 * sceneTexelSize;
+
+    // Colour statistics and the longest motion of the 3x3 neighbourhood. Taking the longest motion
+    // keeps edges of moving objects reprojected with the object instead of the background.
+    vec3 current = vec3(0.0);
+    vec3 moment1 = vec3(0.0);
+    vec3 moment2 = vec3(0.0);
+    vec3 boxMin = vec3(1e9);
+    vec3 boxMax = vec3(-1e9);
+    vec2 velocity = vec2(0.0);
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            vec2 uv = min(max(sceneUv + vec2(x, y) * sceneTexelSize, vec2(0.0)), maxSceneUv);
+            vec3 color = rgbToYCoCg(texture(sceneTexture, uv).rgb);
+            if (x == 0 && y == 0) { current = color; }
+            moment1 += color;
+            moment2 += color * color;
+            boxMin = min(boxMin, color);
+            boxMax = max(boxMax, color);
+
+            vec2 tapVelocity = texture(velocityTexture, uv).xy;
+            if (dot(tapVelocity, tapVelocity) > dot(velocity, velocity)) { velocity = tapVelocity; }
+        }
+    }
+
+    vec2 historyUv = TexCoords - velocity;
+    if (!historyValid || any(lessThan(historyUv, vec2(0.0))) || any(greaterThan(historyUv, vec2(1.0))))
+    {
+        FragColor = vec4(yCoCgToRgb(current), 1.0);
+        return;
+    }
+
+    // Variance clipping, tighter than the min/max box on its own (Salvi, GDC 2016)
+    vec3 mean = moment1 / 9.0;
+    vec3 sigma = sqrt(max(moment2 / 9.0 - mean * mean, vec3(0.0)));
+    boxMin = max(boxMin, mean - sigma);
+    boxMax = min(boxMax, mean + sigma);
+
+    vec3 history = clipToBox(rgbToYCoCg(sampleHistory(historyUv)), boxMin, boxMax);
+
+    float currentFactor = currentWeight * luminanceWeight(current);
+    float historyFactor = (1.0 - currentWeight) * luminanceWeight(history);
+    vec3 result = (current * currentFactor + history * historyFactor) / (currentFactor + historyFactor);
+
+    FragColor = vec4(yCoCgToRgb(result), 1.0);
+}
@@ -0,0 +1,467 @@
+// CPU microbenchmarks of the loading and per frame hot paths. GL calls go to GLStub, so only the CPU
+// side of every path is timed and the suite runs on machines without a GPU.
+
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <assimp/scene.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include "GLStub.h"
+#include "AllocationCounter.h"
+#include "FrameArena.h"
+#include "FramePreparer.h"
+#include "JobSystem.h"
+#include "LightPreview.h"
+#include "Mesh.h"
+#include "Model.h"
+#include "OcclusionCuller.h"
+#include "Renderer.h"
+#include "SceneGraph.h"
+#include "Shader.h"
+#include "TextureUtils.h"
+
+struct BenchmarkAccess
+{
+    static void processMesh(Model& model, aiMesh* mesh)
+    {
+        model.processMesh(mesh, nullptr, SceneGraph::NO_PARENT);
+        model.meshData.clear();
+    }
+
+    static std::vector<Texture> loadMaterialTextures(Model& model, aiMaterial* material)
+    {
+        return model.loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_albedo");
+    }
+
+    static void setLoadedTextures(Model& model, const std::vector<Texture>& textures)
+    {
+        model.texturesLoaded = textures;
+    }
+
+    // Quads spread over a grid in front of the camera, as a scene with many small objects
+    static void addGridMeshes(Model& model, const unsigned int count, const std::vector<Texture>& textures)
+    {
+        const auto side = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(count))));
+        for (unsigned int i = 0; i < count; i++)
+        {
+            const float x = static_cast<float>(i % side) - static_cast<float>(side) * 0.5f;
+            const float y = static_cast<float>(i / side) - static_cast<float>(side) * 0.5f;
+            std::vector<Vertex> verticies(4);
+            verticies[0].position = glm::vec3(x, y, -20.0f);
+            verticies[1].position = glm::vec3(x + 0.5f, y, -20.0f);
+            verticies[2].position = glm::vec3(x + 0.5f, y + 0.5f, -20.0f);
+            verticies[3].position = glm::vec3(x, y + 0.5f, -20.0f);
+            // Every 16th mesh shares a material, so the sort has runs to group
+            std::vector<Texture> material = textures;
+            material[0].id += i % 16;
+            model.meshes.emplace_back(verticies, std::vector<unsigned int>{0, 1, 2, 2, 3, 0}, material, true);
+        }
+        model.assignMaterialIds();
+        model.meshOccluded.assign(model.meshes.size(), false);
+    }
+
+    static void setObjectShader(Renderer& renderer, Shader* shader)
+    {
+        renderer.objectShader = shader;
+    }
+
+    static void setLightParameters(Renderer& renderer, const Camera& camera, const RenderSettings& settings)
+    {
+        renderer.setLightParameters(camera, settings);
+    }
+};
+
+namespace
+{
+    const char* OBJ_V_SHADER_PATH = "Assets/Shaders/shader_object.vert";
+    const char* OBJ_F_SHADER_PATH = "Assets/Shaders/shader_object.frag";
+
+    // Global heap allocations per iteration since the count was taken, zero on a steady per frame path
+    void reportAllocations(benchmark::State& state, const uint64_t countBefore)
+    {
+        state.counters["allocations"] = benchmark::Counter(static_cast<double>(AllocationCounter::count() - countBefore),
+                                                           benchmark::Counter::kAvgIterations);
+    }
+
+    std::filesystem::path scratchDirectory()
+    {
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "lumina_benchmarks";
+        std::filesystem::create_directories(directory);
+        return directory;
+    }
+
+    // Model without materials to call the private loading steps on
+    std::unique_ptr<Model> createEmptyModel()
+    {
+        const std::filesystem::path path = scratchDirectory() / "triangle.obj";
+        std::ofstream(path) << "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+        return std::make_unique<Model>(path.generic_string(), true);
+    }
+
+    // Grid of quads with every attribute processMesh reads
+    std::unique_ptr<aiMesh> createGridMesh(const unsigned int vertexCount)
+    {
+        auto mesh = std::make_unique<aiMesh>();
+        const auto side = static_cast<unsigned int>(std::sqrt(static_cast<double>(vertexCount)));
+        mesh->mNumVertices = side * side;
+        mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+        mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+        mesh->mTangents = new aiVector3D[mesh->mNumVertices];
+        mesh->mBitangents = new aiVector3D[mesh->mNumVertices];
+        mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+        mesh->mNumUVComponents[0] = 2;
+        for (unsigned int y = 0; y < side; y++)
+        {
+            for (unsigned int x = 0; x < side; x++)
+            {
+                const unsigned int i = y * side + x;
+                const float u = static_cast<float>(x) / static_cast<float>(side - 1);
+                const float v = static_cast<float>(y) / static_cast<float>(side - 1);
+                mesh->mVertices[i] = aiVector3D(u, v, 0.0f);
+                mesh->mNormals[i] = aiVector3D(0.0f, 0.0f, 1.0f);
+                mesh->mTangents[i] = aiVector3D(1.0f, 0.0f, 0.0f);
+                mesh->mBitangents[i] = aiVector3D(0.0f, 1.0f, 0.0f);
+                mesh->mTextureCoords[0][i] = aiVector3D(u, v, 0.0f);
+            }
+        }
+
+        mesh->mNumFaces = (side - 1) * (side - 1) * 2;
+        mesh->mFaces = new aiFace[mesh->mNumFaces];
+        unsigned int face = 0;
+        for (unsigned int y = 0; y + 1 < side; y++)
+        {
+            for (unsigned int x = 0; x + 1 < side; x++)
+            {
+                const unsigned int i = y * side + x;
+                for (const auto& triangle : {std::array{i, i + 1, i + side}, std::array{i + 1, i + side + 1, i + side}})
+                {
+                    mesh->mFaces[face].mNumIndices = 3;
+                    mesh->mFaces[face].mIndices = new unsigned int[3]{triangle[0], triangle[1], triangle[2]};
+                    face++;
+                }
+            }
+        }
+        return mesh;
+    }
+
+    std::vector<Texture> createPbrTextures()
+    {
+        return {{1, "texture_albedo", "albedo.png"},
+                {2, "texture_metallic", "metallic.png"},
+                {3, "texture_roughness", "roughness.png"},
+                {4, "texture_ao", "ao.png"},
+                {5, "texture_normal", "normal.png"}};
+    }
+}
+
+static void BM_ProcessMesh(benchmark::State& state)
+{
+    const std::unique_ptr<Model> model = createEmptyModel();
+    const std::unique_ptr<aiMesh> mesh = createGridMesh(static_cast<unsigned int>(state.range(0)));
+    for (auto _ : state)
+    {
+        BenchmarkAccess::processMesh(*model, mesh.get());
+    }
+    state.SetItemsProcessed(state.iterations() * mesh->mNumVertices);
+}
+BENCHMARK(BM_ProcessMesh)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+// Every lookup scans the textures loaded so far, the argument is how many there are
+static void BM_LoadMaterialTexturesDeduplicated(benchmark::State& state)
+{
+    const std::unique_ptr<Model> model = createEmptyModel();
+    std::vector<Texture> loaded;
+    for (int i = 0; i < state.range(0); i++)
+    {
+        loaded.push_back({static_cast<unsigned int>(i + 1), "texture_albedo", "texture_" + std::to_string(i) + ".png"});
+    }
+    BenchmarkAccess::setLoadedTextures(*model, loaded);
+
+    // The last loaded texture is the worst case of the scan
+    aiMaterial material;
+    const aiString name(loaded.back().name);
+    material.AddProperty(&name, AI_MATKEY_TEXTURE_DIFFUSE(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(BenchmarkAccess::loadMaterialTextures(*model, &material));
+    }
+}
+BENCHMARK(BM_LoadMaterialTexturesDeduplicated)->RangeMultiplier(4)->Range(4, 1024);
+
+static void BM_EvaluateFormats(benchmark::State& state)
+{
+    GLenum internalFormat;
+    GLenum dataFormat;
+    for (auto _ : state)
+    {
+        for (int channels = 1; channels <= 4; channels++)
+        {
+            benchmark::DoNotOptimize(TextureUtils::evaluateFormats(channels, internalFormat, dataFormat, true));
+            benchmark::DoNotOptimize(TextureUtils::evaluateFormats(channels, internalFormat, dataFormat, false));
+        }
+    }
+}
+BENCHMARK(BM_EvaluateFormats);
+
+// PNG decode plus format selection, the upload itself is stubbed out
+static void BM_LoadTexture(benchmark::State& state)
+{
+    const int size = static_cast<int>(state.range(0));
+    std::vector<unsigned char> pixels(static_cast<size_t>(size) * size * 4);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = static_cast<unsigned char>((i * 2654435761u) >> 24);
+    }
+    const std::string path = (scratchDirectory() / ("texture_" + std::to_string(size) + ".png")).generic_string();
+    stbi_write_png(path.c_str(), size, size, 4, pixels.data(), size * 4);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(TextureUtils::loadTexture(path, true));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(pixels.size()));
+}
+BENCHMARK(BM_LoadTexture)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+static void BM_SetLightParameters(benchmark::State& state)
+{
+    Renderer renderer{RendererConfig()};
+    BenchmarkAccess::setObjectShader(renderer, new Shader(OBJ_V_SHADER_PATH, OBJ_F_SHADER_PATH));
+    const Camera camera;
+    const RenderSettings settings;
+    const uint64_t allocations = AllocationCounter::count();
+    for (auto _ : state)
+    {
+        // Every iteration stands for a frame, with the uniform names built in the frame arena
+        FrameArena::frame().reset();
+        BenchmarkAccess::setLightParameters(renderer, camera, settings);
+    }
+    reportAllocations(state, allocations);
+}
+BENCHMARK(BM_SetLightParameters);
+
+static void BM_ShaderSetUniforms(benchmark::State& state)
+{
+    const Shader shader(OBJ_V_SHADER_PATH, OBJ_F_SHADER_PATH);
+    const glm::mat4 matrix(1.0f);
+    const glm::vec3 vector(1.0f);
+    const uint64_t allocations = AllocationCounter::count();
+    for (auto _ : state)
+    {
+        shader.setMat4("model", matrix);
+        shader.setMat3("normalMatrix", glm::mat3(matrix));
+        shader.setVec3("pointLights[0].diffuse", vector);
+        shader.setFloat("pointLights[0].quadratic", 0.032f);
+        shader.setInt("materialPbr.texture_albedo1", 0);
+        shader.setBool("isPbr", true);
+    }
+    state.SetItemsProcessed(state.iterations() * 6);
+    reportAllocations(state, allocations);
+}
+BENCHMARK(BM_ShaderSetUniforms);
+
+// Material binding and draw of a five texture PBR mesh, the sampler names are only built by the first draw
+static void BM_MeshDraw(benchmark::State& state)
+{
+    Shader shader(OBJ_V_SHADER_PATH, OBJ_F_SHADER_PATH);
+    const std::vector<Vertex> verticies(4);
+    const std::vector<unsigned int> indices = {0, 1, 2, 2, 3, 0};
+    Mesh mesh(verticies, indices, createPbrTextures(), true);
+    mesh.Draw(shader);
+    const uint64_t allocations = AllocationCounter::count();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(mesh.Draw(shader));
+    }
+    reportAllocations(state, allocations);
+}
+BENCHMARK(BM_MeshDraw);
+
+static void BM_LightPreviewSetup(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        LightPreview lightPreview;
+        benchmark::DoNotOptimize(&lightPreview);
+    }
+}
+BENCHMARK(BM_LightPreviewSetup);
+
+// Culling, sorting and command recording of a scene with many meshes on the worker threads
+static void BM_FramePrepare(benchmark::State& state)
+{
+    const std::unique_ptr<Model> model = createEmptyModel();
+    BenchmarkAccess::addGridMeshes(*model, static_cast<unsigned int>(state.range(0)), createPbrTextures());
+    const DrawView view = {glm::mat4(1.0f), glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f),
+                           glm::vec3(0.0f), glm::radians(45.0f), 1080.0f};
+
+    FramePreparer framePreparer;
+    // The first frame sizes the command lists
+    framePreparer.prepare(*model, view);
+    const uint64_t allocations = AllocationCounter::count();
+    for (auto _ : state)
+    {
+        framePreparer.prepare(*model, view);
+        benchmark::DoNotOptimize(framePreparer.commands().data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    reportAllocations(state, allocations);
+}
+BENCHMARK(BM_FramePrepare)->RangeMultiplier(8)->Range(64, 1 << 15)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// Occluder rasterization and pyramid build of a screen filling 8192 triangle grid, scalar (0) against AVX2 (1)
+static void BM_OcclusionRasterize(benchmark::State& state)
+{
+    constexpr int SIDE = 65;
+    std::vector<Vertex> verticies(SIDE * SIDE);
+    std::vector<unsigned int> indices;
+    for (int y = 0; y < SIDE; y++)
+    {
+        for (int x = 0; x < SIDE; x++)
+        {
+            const float u = static_cast<float>(x) / static_cast<float>(SIDE - 1);
+            const float v = static_cast<float>(y) / static_cast<float>(SIDE - 1);
+            verticies[y * SIDE + x].position = glm::vec3(u * 8.0f - 4.0f, v * 4.0f - 2.0f, -2.0f - u);
+            if (x + 1 == SIDE || y + 1 == SIDE) { continue; }
+
+            const auto i = static_cast<unsigned int>(y * SIDE + x);
+            indices.insert(indices.end(), {i, i + 1, i + SIDE, i + 1, i + SIDE + 1, i + SIDE});
+        }
+    }
+    Mesh mesh(verticies, indices, {}, true);
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 2.0f, 0.1f, 100.0f);
+
+    OcclusionCuller culler;
+    culler.setSimdEnabled(state.range(0) != 0);
+    culler.beginFrame(viewProjection);
+    culler.addOccluder(mesh, glm::mat4(1.0f));
+    culler.rasterize();
+
+    // The timed path has to agree with the scalar rasterizer and give the known answers
+    OcclusionCuller reference;
+    reference.setSimdEnabled(false);
+    reference.beginFrame(viewProjection);
+    reference.addOccluder(mesh, glm::mat4(1.0f));
+    reference.rasterize();
+    for (size_t i = 0; i < reference.depthBuffer().size(); i++)
+    {
+        if (std::abs(culler.depthBuffer()[i] - reference.depthBuffer()[i]) > 1e-4f)
+        {
+            state.SkipWithError("Depth buffer differs from the scalar rasterizer");
+            return;
+        }
+    }
+    if (!culler.isSphereOccluded(glm::vec3(0.0f, 0.0f, -10.0f), 0.5f))
+    {
+        state.SkipWithError("Sphere behind the grid is not occluded");
+        return;
+    }
+    if (culler.isSphereOccluded(glm::vec3(0.0f, 0.0f, -1.5f), 0.2f))
+    {
+        state.SkipWithError("Sphere in front of the grid is occluded");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        culler.beginFrame(viewProjection);
+        culler.addOccluder(mesh, glm::mat4(1.0f));
+        culler.rasterize();
+        benchmark::DoNotOptimize(culler.isSphereOccluded(glm::vec3(0.0f, 0.0f, -10.0f), 0.5f));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(indices.size() / 3));
+}
+BENCHMARK(BM_OcclusionRasterize)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// World transform update of a 32768 node assembly after moving a node near the root, so nearly every node
+// is recomputed, scalar (0) against AVX2 (1)
+static void BM_SceneGraphUpdate(benchmark::State& state)
+{
+    constexpr int NODE_COUNT = 1 << 15;
+    constexpr int CHILDREN = 8;
+    SceneGraph sceneGraph;
+    sceneGraph.setSimdEnabled(state.range(0) != 0);
+    sceneGraph.addNode("Root", SceneGraph::NO_PARENT, glm::mat4(1.0f));
+    for (int node = 1; node < NODE_COUNT; node++)
+    {
+        const glm::vec3 offset(static_cast<float>(node % CHILDREN), 0.0f, 0.1f);
+        sceneGraph.addNode("Part", (node - 1) / CHILDREN, glm::translate(glm::mat4(1.0f), offset));
+    }
+
+    float angle = 0.0f;
+    for (auto _ : state)
+    {
+        angle += 0.01f;
+        sceneGraph.setLocalTransform(1, glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+        sceneGraph.update();
+        benchmark::DoNotOptimize(sceneGraph.worldTransform(NODE_COUNT - 1));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(sceneGraph.updatedNodes().size()));
+}
+BENCHMARK(BM_SceneGraphUpdate)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// 4096 independent jobs of a few microseconds each plus a reduction depending on all of them, on 1, 2, 4...
+// threads, for how the scheduler scales across core counts
+static void BM_JobSystemScaling(benchmark::State& state)
+{
+    const auto workers = static_cast<unsigned int>(state.range(0));
+    if (workers > JobSystem::maxWorkerCount())
+    {
+        state.SkipWithError("Not enough cores");
+        return;
+    }
+
+    constexpr int JOB_COUNT = 4096;
+    constexpr int STEPS = 2000;
+    std::vector<float> results(JOB_COUNT);
+    JobSystem::setWorkerLimit(workers);
+    for (auto _ : state)
+    {
+        JobCounter jobs;
+        JobCounter reduction;
+        float total = 0.0f;
+        for (int i = 0; i < JOB_COUNT; i++)
+        {
+            JobSystem::run([&results, i]
+            {
+                float value = static_cast<float>(i);
+                for (int step = 0; step < STEPS; step++) { value = value * 0.999f + 0.5f; }
+                results[i] = value;
+            }, &jobs);
+        }
+        JobSystem::runAfter(jobs, [&results, &total]
+        {
+            for (const float result : results) { total += result; }
+        }, &reduction);
+        JobSystem::wait(reduction);
+        benchmark::DoNotOptimize(total);
+    }
+    JobSystem::setWorkerLimit(JobSystem::maxWorkerCount());
+    state.SetItemsProcessed(state.iterations() * JOB_COUNT);
+}
+BENCHMARK(BM_JobSystemScaling)->RangeMultiplier(2)->Range(1, 64)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char** argv)
+{
+    if (!GLStub::load())
+    {
+        std::cout << "Failed to load the stub GL functions" << std::endl;
+        return -1;
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) { return -1; }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
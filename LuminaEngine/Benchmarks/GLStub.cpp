@@ -0,0 +1,107 @@
+#include "GLStub.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <glad/glad.h>
+
+namespace
+{
+    GLuint nextName = 1;
+
+    void APIENTRY genNames(const GLsizei n, GLuint* names)
+    {
+        for (GLsizei i = 0; i < n; i++) { names[i] = nextName++; }
+    }
+
+    GLuint APIENTRY createShader(GLenum)
+    {
+        return nextName++;
+    }
+
+    GLuint APIENTRY createProgram()
+    {
+        return nextName++;
+    }
+
+    const GLubyte* APIENTRY getString(const GLenum name)
+    {
+        // glad parses the version to decide which entry points to load
+        return reinterpret_cast<const GLubyte*>(name == GL_VERSION ? "4.6.0 Stub" : "Stub");
+    }
+
+    const GLubyte* APIENTRY getStringi(GLenum, GLuint)
+    {
+        return reinterpret_cast<const GLubyte*>("");
+    }
+
+    void APIENTRY getIntegerv(const GLenum pname, GLint* data)
+    {
+        switch (pname)
+        {
+            case GL_MAX_TEXTURE_SIZE:
+                *data = 16384;
+                break;
+            case GL_MAX_ARRAY_TEXTURE_LAYERS:
+                *data = 2048;
+                break;
+            default:
+                *data = 0; // Also reports no extensions
+                break;
+        }
+    }
+
+    void APIENTRY getObjectStatus(GLuint, GLenum, GLint* params)
+    {
+        *params = GL_TRUE;
+    }
+
+    GLint APIENTRY getUniformLocation(GLuint, const GLchar*)
+    {
+        return 0;
+    }
+
+    GLenum APIENTRY checkFramebufferStatus(GLenum)
+    {
+        return GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    // Called through pointers of other signatures. Fine with the caller cleaned up calling conventions
+    // of 64 bit targets, which is all the benchmarks are built for.
+    std::uintptr_t APIENTRY noop()
+    {
+        return 0;
+    }
+
+    void* getProcAddress(const char* name)
+    {
+        static const std::unordered_map<std::string, void*> overrides = {
+            {"glGenBuffers", reinterpret_cast<void*>(&genNames)},
+            {"glGenTextures", reinterpret_cast<void*>(&genNames)},
+            {"glGenVertexArrays", reinterpret_cast<void*>(&genNames)},
+            {"glGenFramebuffers", reinterpret_cast<void*>(&genNames)},
+            {"glGenRenderbuffers", reinterpret_cast<void*>(&genNames)},
+            {"glGenQueries", reinterpret_cast<void*>(&genNames)},
+            {"glCreateShader", reinterpret_cast<void*>(&createShader)},
+            {"glCreateProgram", reinterpret_cast<void*>(&createProgram)},
+            {"glGetString", reinterpret_cast<void*>(&getString)},
+            {"glGetStringi", reinterpret_cast<void*>(&getStringi)},
+            {"glGetIntegerv", reinterpret_cast<void*>(&getIntegerv)},
+            {"glGetShaderiv", reinterpret_cast<void*>(&getObjectStatus)},
+            {"glGetProgramiv", reinterpret_cast<void*>(&getObjectStatus)},
+            {"glGetUniformLocation", reinterpret_cast<void*>(&getUniformLocation)},
+            {"glCheckFramebufferStatus", reinterpret_cast<void*>(&checkFramebufferStatus)},
+        };
+
+        const auto stub = overrides.find(name);
+        return stub != overrides.end() ? stub->second : reinterpret_cast<void*>(&noop);
+    }
+}
+
+namespace GLStub
+{
+    bool load()
+    {
+        return gladLoadGLLoader(getProcAddress) != 0;
+    }
+}
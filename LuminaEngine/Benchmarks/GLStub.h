@@ -0,0 +1,11 @@
+#pragma once
+
+namespace GLStub
+{
+    /// <summary>
+    /// Points every GL function loaded by glad at a CPU-only stub, so engine code runs without a GPU or a
+    /// context. Object names are handed out from a counter, shaders always compile and link, and every
+    /// other call does nothing and returns zero. Only for timing the CPU side of engine code.
+    /// </summary>
+    bool load();
+}
@@ -33,36 +33,13 @@ bool BloomFBO::init(unsigned int windowWidth, unsigned int windowHeight, unsigne
         mipIntSize /= 2;
         mip.size = mipSize;
         mip.intSize = mipIntSize;
-
-        glGenTextures(1, &mip.texture);
-        glBindTexture(GL_TEXTURE_2D, mip.texture);
-        // we are downscaling an HDR color buffer, so we need a float texture format
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, static_cast<int>(mipSize.x),
-            static_cast<int>(mipSize.y), 0, GL_RGB, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
         mMipChain.emplace_back(mip);
     }
 
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                           GL_TEXTURE_2D, mMipChain[0].texture, 0);
-
     // setup attachments
     constexpr unsigned int attachments[1] = { GL_COLOR_ATTACHMENT0 };
     glDrawBuffers(1, attachments);
 
-    // check completion status
-    const int status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-    if (status != GL_FRAMEBUFFER_COMPLETE)
-    {
-        printf("gbuffer FBO error, status: 0x%X\n", status);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        return false;
-    }
-
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     mInit = true;
     return true;
@@ -70,11 +47,7 @@ bool BloomFBO::init(unsigned int windowWidth, unsigned int windowHeight, unsigne
 
 void BloomFBO::destroy()
 {
-    for (auto &[size, intSize, texture] : mMipChain)
-    {
-        glDeleteTextures(1, &texture);
-        texture = 0;
-    }
+    mMipChain.clear();
 
     glDeleteFramebuffers(1, &mFBO);
     mFBO = 0;
@@ -86,6 +59,14 @@ void BloomFBO::bindForWriting() const
     glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
 }
 
+void BloomFBO::setMipTextures(std::span<const unsigned int> textures)
+{
+    for (size_t i = 0; i < mMipChain.size() && i < textures.size(); i++)
+    {
+        mMipChain[i].texture = textures[i];
+    }
+}
+
 const std::vector<BloomMip>& BloomFBO::mipChain() const
 {
     return mMipChain;
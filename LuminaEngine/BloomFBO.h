@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/vec2.hpp>
+#include <span>
 #include <vector>
 
 struct BloomMip
@@ -10,6 +11,10 @@ struct BloomMip
     unsigned int texture;
 };
 
+/// <summary>
+/// Framebuffer and mip chain layout of the bloom. The mip textures are transient frame graph textures
+/// handed over every frame with setMipTextures.
+/// </summary>
 class BloomFBO
 {
 public:
@@ -18,6 +23,7 @@ public:
     bool init(unsigned int windowWidth, unsigned int windowHeight, unsigned int mipChainLength);
     void destroy();
     void bindForWriting() const;
+    void setMipTextures(std::span<const unsigned int> textures);
     const std::vector<BloomMip>& mipChain() const;
 
 private:
@@ -2,6 +2,13 @@
 
 #include <iostream>
 #include <glad/glad.h>
+#include "FrameArena.h"
+#include "GpuMemory.h"
+
+namespace
+{
+    constexpr unsigned int NUM_BLOOM_MIPS = 5; // Experiment with this value
+}
 
 BloomRenderer::BloomRenderer(const unsigned int& windowWidth, const unsigned int& windowHeight) :
     mInit(false),
@@ -26,6 +33,7 @@ BloomRenderer::BloomRenderer(const unsigned int& windowWidth, const unsigned int
     glBindVertexArray(mQuadVAO);
     glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICIES), &QUAD_VERTICIES, GL_STATIC_DRAW);
+    GpuMemory::track(GpuResourceType::Buffer, quadVBO, sizeof(QUAD_VERTICIES), "Bloom", "Bloom quad");
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
@@ -52,7 +60,6 @@ bool BloomRenderer::init(const unsigned int windowWidth, const unsigned int wind
     mSrcViewportSizeFloat = glm::vec2(static_cast<float>(windowWidth), static_cast<float>(windowHeight));
 
     // Framebuffer
-    constexpr unsigned int NUM_BLOOM_MIPS = 5; // Experiment with this value
     const bool status = mFBO.init(windowWidth, windowHeight, NUM_BLOOM_MIPS);
     if (!status) {
         std::cerr << "Failed to initialize bloom FBO - cannot create bloom renderer!\n";
@@ -79,29 +86,51 @@ bool BloomRenderer::init(const unsigned int windowWidth, const unsigned int wind
     return true;
 }
 
-void BloomRenderer::renderBloomTexture(unsigned int srcTexture, float filterRadius)
+void BloomRenderer::renderBloomTexture(unsigned int srcTexture, std::span<const unsigned int> mipTextures,
+                                       const glm::vec2& srcUvScale, float filterRadius, float threshold,
+                                       float softKnee, Profiler* profiler)
 {
+    mFBO.setMipTextures(mipTextures);
     mFBO.bindForWriting();
 
-    renderDownsamples(srcTexture);
-    renderUpsamples(filterRadius);
+    renderDownsamples(srcTexture, srcUvScale, threshold, softKnee, profiler);
+    renderUpsamples(filterRadius, profiler);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     // Restore viewport
     glViewport(0, 0, mSrcViewportSize.x, mSrcViewportSize.y);
 }
 
-GLuint BloomRenderer::bloomTexture() const
+const std::vector<BloomMip>& BloomRenderer::mipChain() const
+{
+    return mFBO.mipChain();
+}
+
+void BloomRenderer::resize(const unsigned int windowWidth, const unsigned int windowHeight)
 {
-    return mFBO.mipChain()[0].texture;
+    mFBO.destroy();
+    if (!mFBO.init(windowWidth, windowHeight, NUM_BLOOM_MIPS))
+    {
+        std::cerr << "Failed to resize bloom FBO!\n";
+        return;
+    }
+
+    mSrcViewportSize = glm::ivec2(windowWidth, windowHeight);
+    mSrcViewportSizeFloat = glm::vec2(static_cast<float>(windowWidth), static_cast<float>(windowHeight));
 }
 
-void BloomRenderer::renderDownsamples(unsigned int srcTexture)
+void BloomRenderer::renderDownsamples(unsigned int srcTexture, const glm::vec2& srcUvScale, float threshold,
+                                      float softKnee, Profiler* profiler)
 {
     const std::vector<BloomMip>& mipChain = mFBO.mipChain();
 
     mDownsampleShader->use();
     mDownsampleShader->setVec2("srcResolution", mSrcViewportSizeFloat);
+    mDownsampleShader->setFloat("threshold", threshold);
+    mDownsampleShader->setFloat("softKnee", softKnee);
+    // Only the first pass reads the scene, the following ones work on already thresholded mips
+    mDownsampleShader->setBool("prefilter", true);
+    mDownsampleShader->setVec2("srcUvScale", srcUvScale);
 
     // Bind srcTexture (HDR color buffer) as initial texture input
     glActiveTexture(GL_TEXTURE0);
@@ -110,6 +139,7 @@ void BloomRenderer::renderDownsamples(unsigned int srcTexture)
     // Progressively downsample through the mip chain
     for (int i = 0; i < mipChain.size(); i++)
     {
+        ProfileScope scope(profiler, FrameArena::frame().format("Downsample %d", i));
         const BloomMip& mip = mipChain[i];
         glViewport(0, 0, mip.size.x, mip.size.y);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
@@ -122,12 +152,14 @@ void BloomRenderer::renderDownsamples(unsigned int srcTexture)
 
         // Set current mip resolution as srcResolution for next iteration
         mDownsampleShader->setVec2("srcResolution", mip.size);
+        mDownsampleShader->setBool("prefilter", false);
+        mDownsampleShader->setVec2("srcUvScale", glm::vec2(1.0f));
         // Set current mip as texture input for next iteration
         glBindTexture(GL_TEXTURE_2D, mip.texture);
     }
 }
 
-void BloomRenderer::renderUpsamples(float filterRadius)
+void BloomRenderer::renderUpsamples(float filterRadius, Profiler* profiler)
 {
     const std::vector<BloomMip>& mipChain = mFBO.mipChain();
 
@@ -141,6 +173,7 @@ void BloomRenderer::renderUpsamples(float filterRadius)
 
     for (int i = mipChain.size() - 1; i > 0; i--)
     {
+        ProfileScope scope(profiler, FrameArena::frame().format("Upsample %d", i));
         const BloomMip& mip = mipChain[i];
         const BloomMip& nextMip = mipChain[i-1];
 
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <span>
+
 #include "BloomFBO.h"
+#include "Profiler.h"
 #include "Shader.h"
 
 class BloomRenderer
@@ -8,13 +11,23 @@ class BloomRenderer
 public:
     BloomRenderer(const unsigned int& windowWidth, const unsigned int& windowHeight);
     ~BloomRenderer();
-    void renderBloomTexture(unsigned int srcTexture, float filterRadius);
-    unsigned int bloomTexture() const;
+    /// <summary>
+    /// Blurs the parts of the HDR scene texture brighter than the threshold into the mip textures, laid
+    /// out as mipChain() describes. The threshold is applied by the first downsample, so the scene does
+    /// not need a separate bright color attachment. Only the srcUvScale part of the texture is read, for
+    /// scenes rendered below the output resolution.
+    /// </summary>
+    void renderBloomTexture(unsigned int srcTexture, std::span<const unsigned int> mipTextures,
+                            const glm::vec2& srcUvScale, float filterRadius, float threshold, float softKnee,
+                            Profiler* profiler = nullptr);
+    const std::vector<BloomMip>& mipChain() const;
+    void resize(unsigned int windowWidth, unsigned int windowHeight);
 
 private:
     bool init(unsigned int windowWidth, unsigned int windowHeight);
-    void renderDownsamples(unsigned int srcTexture);
-    void renderUpsamples(float filterRadius);
+    void renderDownsamples(unsigned int srcTexture, const glm::vec2& srcUvScale, float threshold, float softKnee,
+                           Profiler* profiler);
+    void renderUpsamples(float filterRadius, Profiler* profiler);
 
     bool mInit;
     BloomFBO mFBO;
@@ -0,0 +1,114 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+CameraPath CameraPath::orbit(const glm::vec3& center, const float radius, const float height, const float duration)
+{
+    // One key per degree keeps the linear interpolation close to a circle
+    constexpr int KEY_COUNT = 360;
+    CameraPath path;
+    for (int i = 0; i <= KEY_COUNT; i++)
+    {
+        const float angle = glm::radians(360.0f * static_cast<float>(i) / static_cast<float>(KEY_COUNT));
+        const glm::vec3 position = center + glm::vec3(radius * std::sin(angle), height, radius * std::cos(angle));
+        path.addKey({duration * static_cast<float>(i) / static_cast<float>(KEY_COUNT), position,
+                     glm::normalize(center - position), 45.0f});
+    }
+    return path;
+}
+
+bool CameraPath::load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::CAMERA_PATH::Failed to open " << path << std::endl;
+        return false;
+    }
+
+    keys.clear();
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == '#') { continue; }
+
+        std::istringstream stream(line);
+        CameraKey key = {};
+        stream >> key.time >> key.position.x >> key.position.y >> key.position.z
+               >> key.front.x >> key.front.y >> key.front.z >> key.fov;
+        if (!stream)
+        {
+            std::cout << "ERROR::CAMERA_PATH::Malformed key in " << path << ": " << line << std::endl;
+            return false;
+        }
+        addKey(key);
+    }
+    return !keys.empty();
+}
+
+bool CameraPath::save(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::CAMERA_PATH::Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    file << "# time position.x position.y position.z front.x front.y front.z fov\n";
+    for (const CameraKey& key : keys)
+    {
+        file << key.time << " " << key.position.x << " " << key.position.y << " " << key.position.z << " "
+             << key.front.x << " " << key.front.y << " " << key.front.z << " " << key.fov << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+void CameraPath::addKey(const CameraKey& key)
+{
+    // Keys are expected in time order, anything going back in time is dropped
+    if (!keys.empty() && key.time < keys.back().time) { return; }
+    keys.push_back(key);
+}
+
+void CameraPath::clear()
+{
+    keys.clear();
+}
+
+bool CameraPath::empty() const
+{
+    return keys.empty();
+}
+
+float CameraPath::duration() const
+{
+    return keys.empty() ? 0.0f : keys.back().time;
+}
+
+const std::vector<CameraKey>& CameraPath::getKeys() const
+{
+    return keys;
+}
+
+Camera CameraPath::sample(const float time) const
+{
+    Camera camera;
+    if (keys.empty()) { return camera; }
+
+    const auto next = std::upper_bound(keys.begin(), keys.end(), time,
+                                       [](const float t, const CameraKey& key) { return t < key.time; });
+    const CameraKey& a = next == keys.begin() ? *next : *(next - 1);
+    const CameraKey& b = next == keys.end() ? keys.back() : *next;
+    const float span = b.time - a.time;
+    const float t = span > 0.0f ? std::clamp((time - a.time) / span, 0.0f, 1.0f) : 0.0f;
+
+    camera.position = glm::mix(a.position, b.position, t);
+    camera.front = glm::normalize(glm::mix(a.front, b.front, t));
+    camera.fov = glm::mix(a.fov, b.fov, t);
+    return camera;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Renderer.h"
+
+struct CameraKey
+{
+    float time; // In seconds from the start of the path
+    glm::vec3 position;
+    glm::vec3 front;
+    float fov;
+};
+
+/// <summary>
+/// Timed camera keys, either recorded from the interactive camera or scripted, replayed by sampling
+/// with linear interpolation. Stored as plain text, one key per line.
+/// </summary>
+class CameraPath
+{
+public:
+    static CameraPath orbit(const glm::vec3& center, float radius, float height, float duration);
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    void addKey(const CameraKey& key);
+    void clear();
+    bool empty() const;
+    float duration() const;
+    const std::vector<CameraKey>& getKeys() const;
+    /// <summary>
+    /// Camera at the given time, clamped to the ends of the path
+    /// </summary>
+    Camera sample(float time) const;
+
+private:
+    std::vector<CameraKey> keys;
+};
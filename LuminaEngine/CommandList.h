@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// <summary>
+/// Camera state the frame preparation jobs read, copied so the jobs never touch the renderer
+/// </summary>
+struct DrawView
+{
+    glm::mat4 model;
+    glm::mat4 viewProjection;
+    glm::vec3 cameraPosition;
+    float fovY;
+    float screenHeight;
+};
+
+/// <summary>
+/// Draw of a visible index range of one mesh. Commands sort by material first, then front to back.
+/// </summary>
+struct DrawCommand
+{
+    uint64_t sortKey;
+    uint32_t mesh;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+
+    uint32_t material() const { return static_cast<uint32_t>(sortKey >> 32); }
+    bool operator<(const DrawCommand& other) const { return sortKey < other.sortKey; }
+};
+
+struct TextureDetailRequest
+{
+    unsigned int textureId;
+    float uvPerPixel;
+};
+
+/// <summary>
+/// Engine level commands recorded by one job without touching GL, replayed on the GL thread
+/// </summary>
+struct CommandList
+{
+    std::vector<DrawCommand> draws;
+    std::vector<TextureDetailRequest> detailRequests;
+
+    void clear()
+    {
+        draws.clear();
+        detailRequests.clear();
+    }
+};
@@ -0,0 +1,54 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace CpuFeatures
+{
+    namespace
+    {
+        struct Features
+        {
+            bool f16c = false;
+            bool avx2 = false;
+        };
+
+        Features detect()
+        {
+            Features features;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            int info[4];
+            __cpuid(info, 1);
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            const bool avx = (info[2] & (1 << 28)) != 0;
+            // The OS has to save the YMM registers on context switches, otherwise AVX is unusable
+            const bool ymmEnabled = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+            features.f16c = ymmEnabled && avx && (info[2] & (1 << 29)) != 0;
+            __cpuidex(info, 7, 0);
+            features.avx2 = ymmEnabled && avx && (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+            __builtin_cpu_init();
+            features.f16c = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+            features.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+            return features;
+        }
+
+        const Features& features()
+        {
+            static const Features detected = detect();
+            return detected;
+        }
+    }
+
+    bool hasF16C()
+    {
+        return features().f16c;
+    }
+
+    bool hasAvx2()
+    {
+        return features().avx2;
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// Runtime detection of the x86 instruction set extensions used by the SIMD code paths. The engine is
+// built for baseline x86-64, so every SIMD routine must be guarded by one of these checks.
+namespace CpuFeatures
+{
+    bool hasF16C();
+    bool hasAvx2();
+}
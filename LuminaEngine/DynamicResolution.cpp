@@ -0,0 +1,88 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float MAX_SCALE = 1.0f;
+    // Scales are snapped to this step, so frame time noise does not change the resolution every frame
+    constexpr float SCALE_STEP = 0.05f;
+    // Go down as soon as the smoothed time nears the target, only go back up with clear headroom
+    constexpr float DECREASE_THRESHOLD = 0.95f;
+    constexpr float INCREASE_THRESHOLD = 0.80f;
+    constexpr float MAX_INCREASE = 0.05f;
+    constexpr float MAX_DECREASE = 0.20f;
+    constexpr float SMOOTHING = 0.2f;
+    // Frames to let through after a change, covers the profiler latency
+    constexpr uint64_t SETTLE_FRAMES = 4;
+
+    float frameMilliseconds(const ProfileFrame& frame)
+    {
+        const ProfileEvent& root = frame.events[0];
+        if (root.gpuStartMs >= 0.0) { return static_cast<float>(root.gpuEndMs - root.gpuStartMs); }
+
+        // Without GPU timings use the CPU time, leaving out the swap which only waits on vsync
+        double cpuMs = root.cpuEndMs - root.cpuStartMs;
+        for (const ProfileEvent& event : frame.events)
+        {
+            if (event.depth == 1 && event.name == "Swap") { cpuMs -= event.cpuEndMs - event.cpuStartMs; }
+        }
+        return static_cast<float>(cpuMs);
+    }
+}
+
+DynamicResolution::DynamicResolution() :
+    mScale(MAX_SCALE),
+    mSmoothedMs(0.0f),
+    mLastFrameIndex(0),
+    mLastChangeFrameIndex(0),
+    mHasSample(false)
+{
+}
+
+float DynamicResolution::update(const ProfileFrame* frame, const float targetFrameMs, const float minScale)
+{
+    if (!frame || frame->events.empty() || frame->index == mLastFrameIndex) { return mScale; }
+    mLastFrameIndex = frame->index;
+
+    // Frames submitted before the last change were rendered at the old scale
+    if (frame->index < mLastChangeFrameIndex + SETTLE_FRAMES) { return mScale; }
+
+    const float frameMs = frameMilliseconds(*frame);
+    mSmoothedMs = mHasSample ? mSmoothedMs + SMOOTHING * (frameMs - mSmoothedMs) : frameMs;
+    mHasSample = true;
+    if (mSmoothedMs <= 0.0f) { return mScale; }
+
+    float newScale = mScale;
+    if (mSmoothedMs > targetFrameMs * DECREASE_THRESHOLD || mSmoothedMs < targetFrameMs * INCREASE_THRESHOLD)
+    {
+        // Frame time follows the pixel count, which goes with the square of the scale
+        const float ideal = mScale * std::sqrt(targetFrameMs * DECREASE_THRESHOLD / mSmoothedMs);
+        newScale = std::clamp(ideal, mScale - MAX_DECREASE, mScale + MAX_INCREASE);
+        newScale = std::round(newScale / SCALE_STEP) * SCALE_STEP;
+        newScale = std::clamp(newScale, std::min(minScale, MAX_SCALE), MAX_SCALE);
+    }
+
+    if (newScale != mScale)
+    {
+        mScale = newScale;
+        mLastChangeFrameIndex = frame->index;
+        mSmoothedMs = 0.0f;
+        mHasSample = false;
+    }
+    return mScale;
+}
+
+void DynamicResolution::reset()
+{
+    mScale = MAX_SCALE;
+    mSmoothedMs = 0.0f;
+    mHasSample = false;
+    mLastChangeFrameIndex = mLastFrameIndex;
+}
+
+float DynamicResolution::scale() const
+{
+    return mScale;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Profiler.h"
+
+/// <summary>
+/// Picks the fraction of the output resolution the scene is rendered at so frames stay within a time
+/// budget. Fed with resolved profiler frames, which arrive a frame or two late, so after every change it
+/// waits for frames rendered at the new scale before adjusting again.
+/// </summary>
+class DynamicResolution
+{
+public:
+    DynamicResolution();
+
+    /// <summary>
+    /// Adjusts the scale from the frame time of a resolved frame and returns it. Frames already seen are
+    /// ignored, so it is safe to pass Profiler::latestFrame every frame.
+    /// </summary>
+    float update(const ProfileFrame* frame, float targetFrameMs, float minScale);
+    void reset();
+    float scale() const;
+
+private:
+    float mScale;
+    float mSmoothedMs;
+    uint64_t mLastFrameIndex;
+    uint64_t mLastChangeFrameIndex;
+    bool mHasSample;
+};
@@ -0,0 +1,141 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    // Offset from the start of the block where an allocation of the alignment can begin
+    size_t alignedOffset(const unsigned char* block, const size_t offset, const size_t alignment)
+    {
+        const auto address = reinterpret_cast<uintptr_t>(block) + offset;
+        return offset + ((alignment - address % alignment) % alignment);
+    }
+}
+
+FrameArena::FrameArena(const size_t capacity) :
+    mCurrent(nullptr),
+    mCurrentSize(0),
+    mOffset(0),
+    mUsedBefore(0),
+    mPeak(0)
+{
+    mBlocks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[capacity]), capacity});
+    reset();
+}
+
+FrameArena::~FrameArena() = default;
+
+FrameArena& FrameArena::frame()
+{
+    static FrameArena arena;
+    return arena;
+}
+
+void* FrameArena::allocate(const size_t bytes, const size_t alignment)
+{
+    size_t start = alignedOffset(mCurrent, mOffset, alignment);
+    if (start + bytes > mCurrentSize)
+    {
+        addBlock(bytes + alignment);
+        start = alignedOffset(mCurrent, 0, alignment);
+    }
+
+    mOffset = start + bytes;
+    mPeak = std::max(mPeak, usedBytes());
+    return mCurrent + start;
+}
+
+void FrameArena::deallocate(void* pointer, const size_t bytes)
+{
+    auto* data = static_cast<unsigned char*>(pointer);
+    if (data && data + bytes == mCurrent + mOffset)
+    {
+        mOffset = static_cast<size_t>(data - mCurrent);
+    }
+}
+
+std::string_view FrameArena::copy(const std::string_view text)
+{
+    char* data = allocate<char>(text.size() + 1);
+    std::memcpy(data, text.data(), text.size());
+    data[text.size()] = '\0';
+    return {data, text.size()};
+}
+
+const char* FrameArena::format(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    va_list retry;
+    va_copy(retry, args);
+
+    // Formatted straight into the free space, only text too long for it is formatted twice
+    char* text = reinterpret_cast<char*>(mCurrent + mOffset);
+    const size_t space = mCurrentSize - mOffset;
+    const int length = std::vsnprintf(text, space, format, args);
+    if (length < 0)
+    {
+        text = nullptr;
+    }
+    else if (static_cast<size_t>(length) < space)
+    {
+        mOffset += static_cast<size_t>(length) + 1;
+        mPeak = std::max(mPeak, usedBytes());
+    }
+    else
+    {
+        text = allocate<char>(static_cast<size_t>(length) + 1);
+        std::vsnprintf(text, static_cast<size_t>(length) + 1, format, retry);
+    }
+
+    va_end(retry);
+    va_end(args);
+    return text ? text : "";
+}
+
+void FrameArena::reset()
+{
+    if (mBlocks.size() > 1)
+    {
+        // Room for the busiest frame so far, with some to spare so the next one does not spill again
+        const size_t size = mPeak + mPeak / 4;
+        mBlocks.clear();
+        mBlocks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+    }
+
+    mCurrent = mBlocks.front().data.get();
+    mCurrentSize = mBlocks.front().size;
+    mOffset = 0;
+    mUsedBefore = 0;
+}
+
+size_t FrameArena::usedBytes() const
+{
+    return mUsedBefore + mOffset;
+}
+
+size_t FrameArena::capacity() const
+{
+    size_t total = 0;
+    for (const Block& block : mBlocks) { total += block.size; }
+    return total;
+}
+
+size_t FrameArena::peakBytes() const
+{
+    return mPeak;
+}
+
+void FrameArena::addBlock(const size_t minimumSize)
+{
+    mUsedBefore += mOffset;
+    const size_t size = std::max(minimumSize, mBlocks.front().size);
+    mBlocks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+    mCurrent = mBlocks.back().data.get();
+    mCurrentSize = size;
+    mOffset = 0;
+}
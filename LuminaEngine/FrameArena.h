@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// Linear allocator for data that only lives for one frame. Allocating bumps a pointer and nothing is
+/// freed on its own, reset() drops everything at once. Running out of space chains further blocks, the
+/// next reset replaces them with one block as large as the whole frame needed, so after a few frames
+/// the arena stops touching the heap. Nothing allocated from it may be used after the reset.
+/// </summary>
+class FrameArena
+{
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 256 * 1024;
+
+    explicit FrameArena(size_t capacity = DEFAULT_CAPACITY);
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /// <summary>
+    /// Arena of the render thread, reset at the start of every Renderer::render. Other threads must
+    /// not use it.
+    /// </summary>
+    static FrameArena& frame();
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    /// <summary>
+    /// Gives the space back when it was the last allocation, so a growing container reuses it
+    /// </summary>
+    void deallocate(void* pointer, size_t bytes);
+
+    template <typename T>
+    T* allocate(const size_t count)
+    {
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    /// <summary>
+    /// Constructs an object in the arena. Its destructor never runs, so it has to be trivially destructible.
+    /// </summary>
+    template <typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "Arena objects are dropped without destruction");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /// <summary>
+    /// Null terminated copy of the text
+    /// </summary>
+    std::string_view copy(std::string_view text);
+    /// <summary>
+    /// printf style formatting into the arena, for uniform and pass names built every frame
+    /// </summary>
+    const char* format(const char* format, ...);
+
+    void reset();
+
+    size_t usedBytes() const;
+    size_t capacity() const;
+    /// <summary>
+    /// Most bytes a single frame used since the arena was created
+    /// </summary>
+    size_t peakBytes() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    void addBlock(size_t minimumSize);
+
+private:
+    std::vector<Block> mBlocks; // Only the first one is kept across resets
+    unsigned char* mCurrent;
+    size_t mCurrentSize;
+    size_t mOffset;
+    size_t mUsedBefore; // Bytes used in the blocks before the current one
+    size_t mPeak;
+};
+
+/// <summary>
+/// Standard allocator handing out memory of a FrameArena, of the frame arena unless told otherwise.
+/// Containers using it must be gone before the arena resets.
+/// </summary>
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept : mArena(&FrameArena::frame()) {}
+    explicit ArenaAllocator(FrameArena& arena) noexcept : mArena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : mArena(other.arena()) {}
+
+    T* allocate(const size_t count) { return mArena->allocate<T>(count); }
+    void deallocate(T* pointer, const size_t count) noexcept { mArena->deallocate(pointer, sizeof(T) * count); }
+
+    FrameArena* arena() const noexcept { return mArena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return mArena == other.arena(); }
+
+private:
+    FrameArena* mArena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,359 @@
+#include "FrameGraph.h"
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <utility>
+#include <glad/glad.h>
+#include "GpuMemory.h"
+
+namespace
+{
+    // Client side format and type for allocating a texture without uploading anything
+    GLenum transferFormat(const GLenum internalFormat)
+    {
+        switch (internalFormat)
+        {
+            case GL_DEPTH_COMPONENT:
+            case GL_DEPTH_COMPONENT16:
+            case GL_DEPTH_COMPONENT24:
+            case GL_DEPTH_COMPONENT32F:
+                return GL_DEPTH_COMPONENT;
+            case GL_R8:
+            case GL_R16F:
+            case GL_R32F:
+                return GL_RED;
+            case GL_RG8:
+            case GL_RG16F:
+            case GL_RG32F:
+                return GL_RG;
+            case GL_RGB16F:
+            case GL_RGB32F:
+            case GL_R11F_G11F_B10F:
+                return GL_RGB;
+            default:
+                return GL_RGBA;
+        }
+    }
+}
+
+FrameGraph::FrameGraph(const std::string& memoryCategory) :
+    mMemoryCategory(memoryCategory),
+    mExecution(0)
+{
+}
+
+FrameGraph::~FrameGraph()
+{
+    destroyFramebuffers();
+    for (PhysicalTexture& texture : mTextures)
+    {
+        GpuMemory::release(GpuResourceType::Texture, texture.id);
+        glDeleteTextures(1, &texture.id);
+    }
+}
+
+FrameGraphResource FrameGraph::createTexture(const std::string_view name, const FrameGraphTextureDesc& desc)
+{
+    mResources.push_back({FrameArena::frame().copy(name), desc, false, 0, -1, -1, {}});
+    return static_cast<FrameGraphResource>(mResources.size() - 1);
+}
+
+FrameGraphResource FrameGraph::importTexture(const std::string_view name, const unsigned int texture)
+{
+    mResources.push_back({FrameArena::frame().copy(name), {0, 0, 0}, true, texture, -1, -1, {}});
+    return static_cast<FrameGraphResource>(mResources.size() - 1);
+}
+
+void FrameGraph::addPass(const std::string_view name, FrameVector<FrameGraphResource> reads,
+                         FrameVector<FrameGraphResource> writes, const PassExecute execute)
+{
+    const auto passIndex = static_cast<int>(mPasses.size());
+    for (const FrameGraphResource resource : writes)
+    {
+        mResources[resource].writers.push_back(passIndex);
+    }
+    mPasses.push_back({FrameArena::frame().copy(name), std::move(reads), std::move(writes), execute});
+}
+
+void FrameGraph::execute(Profiler* profiler)
+{
+    mExecution++;
+    const FrameVector<int> order = sortPasses(cullPasses());
+    allocateTextures(order);
+    mStats.passCount = order.size();
+    mStats.culledPassCount = mPasses.size() - order.size();
+
+    for (const int passIndex : order)
+    {
+        const Pass& pass = mPasses[passIndex];
+        ProfileScope scope(profiler, pass.name);
+        pass.execute.invoke(pass.execute.object, *this);
+    }
+
+    releaseUnusedTextures();
+    mPasses.clear();
+    mResources.clear();
+}
+
+unsigned int FrameGraph::texture(const FrameGraphResource resource) const
+{
+    return mResources[resource].texture;
+}
+
+unsigned int FrameGraph::bindFramebuffer(const std::span<const FrameGraphResource> colors, const FrameGraphResource depth)
+{
+    std::vector<unsigned int>& key = mFramebufferKey;
+    key.clear();
+    for (const FrameGraphResource color : colors) { key.push_back(texture(color)); }
+    // Separates the colors from the depth texture
+    key.push_back(0);
+    if (depth >= 0) { key.push_back(texture(depth)); }
+
+    const auto cached = mFramebuffers.find(key);
+    if (cached != mFramebuffers.end())
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, cached->second);
+        return cached->second;
+    }
+
+    unsigned int framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    std::vector<GLenum> drawBuffers;
+    for (size_t i = 0; i < colors.size(); i++)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, texture(colors[i]), 0);
+        drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+    }
+    if (depth >= 0)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture(depth), 0);
+    }
+    if (!colors.empty())
+    {
+        glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "ERROR::FRAMEGRAPH::Framebuffer of " << mResources[colors[0]].name << " is not complete"
+                      << std::endl;
+        }
+    }
+
+    mFramebuffers.emplace(key, framebuffer);
+    return framebuffer;
+}
+
+const FrameGraphStats& FrameGraph::stats() const
+{
+    return mStats;
+}
+
+FrameVector<int> FrameGraph::cullPasses() const
+{
+    // Walk back from the passes writing imported textures, everything they do not depend on is culled
+    FrameVector<char> kept(mPasses.size(), false);
+    FrameVector<int> pending;
+    for (size_t i = 0; i < mPasses.size(); i++)
+    {
+        for (const FrameGraphResource resource : mPasses[i].writes)
+        {
+            if (mResources[resource].imported && !kept[i])
+            {
+                kept[i] = true;
+                pending.push_back(static_cast<int>(i));
+            }
+        }
+    }
+
+    while (!pending.empty())
+    {
+        const int passIndex = pending.back();
+        pending.pop_back();
+        for (const FrameGraphResource resource : mPasses[passIndex].reads)
+        {
+            for (const int writer : mResources[resource].writers)
+            {
+                if (kept[writer]) { continue; }
+                kept[writer] = true;
+                pending.push_back(writer);
+            }
+        }
+    }
+
+    FrameVector<int> result;
+    for (size_t i = 0; i < mPasses.size(); i++)
+    {
+        if (kept[i]) { result.push_back(static_cast<int>(i)); }
+    }
+    return result;
+}
+
+FrameVector<int> FrameGraph::sortPasses(const FrameVector<int>& kept) const
+{
+    FrameVector<char> isKept(mPasses.size(), false);
+    for (const int passIndex : kept) { isKept[passIndex] = true; }
+
+    // Readers run after every writer of what they read, several writers of a texture in declaration order
+    FrameVector<std::pair<int, int>> edges;
+    for (const int passIndex : kept)
+    {
+        for (const FrameGraphResource resource : mPasses[passIndex].reads)
+        {
+            for (const int writer : mResources[resource].writers)
+            {
+                if (writer != passIndex && isKept[writer]) { edges.emplace_back(writer, passIndex); }
+            }
+        }
+    }
+    for (const Resource& resource : mResources)
+    {
+        for (size_t i = 1; i < resource.writers.size(); i++)
+        {
+            if (isKept[resource.writers[i - 1]] && isKept[resource.writers[i]])
+            {
+                edges.emplace_back(resource.writers[i - 1], resource.writers[i]);
+            }
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    FrameVector<int> inDegree(mPasses.size(), 0);
+    for (const auto& [from, to] : edges) { inDegree[to]++; }
+    // Ties keep the declaration order
+    std::priority_queue<int, FrameVector<int>, std::greater<>> ready;
+    for (const int passIndex : kept)
+    {
+        if (inDegree[passIndex] == 0) { ready.push(passIndex); }
+    }
+
+    FrameVector<int> order;
+    order.reserve(kept.size());
+    while (!ready.empty())
+    {
+        const int passIndex = ready.top();
+        ready.pop();
+        order.push_back(passIndex);
+        auto edge = std::lower_bound(edges.begin(), edges.end(), std::make_pair(passIndex, 0));
+        for (; edge != edges.end() && edge->first == passIndex; ++edge)
+        {
+            if (--inDegree[edge->second] == 0) { ready.push(edge->second); }
+        }
+    }
+
+    if (order.size() != kept.size())
+    {
+        std::cout << "ERROR::FRAMEGRAPH::Passes depend on each other in a cycle, running them as declared"
+                  << std::endl;
+        return kept;
+    }
+    return order;
+}
+
+void FrameGraph::allocateTextures(const FrameVector<int>& order)
+{
+    for (size_t position = 0; position < order.size(); position++)
+    {
+        const Pass& pass = mPasses[order[position]];
+        for (const FrameVector<FrameGraphResource>* resources : {&pass.reads, &pass.writes})
+        {
+            for (const FrameGraphResource resource : *resources)
+            {
+                Resource& used = mResources[resource];
+                if (used.firstUse < 0) { used.firstUse = static_cast<int>(position); }
+                used.lastUse = static_cast<int>(position);
+            }
+        }
+    }
+
+    for (PhysicalTexture& texture : mTextures) { texture.busyUntil = -1; }
+    mStats.textureCount = 0;
+    mStats.requestedBytes = 0;
+    // Resources are handed textures in the order they come alive, so a texture is only shared with
+    // resources whose lifetimes start after the previous holder's ended
+    for (size_t position = 0; position < order.size(); position++)
+    {
+        for (Resource& resource : mResources)
+        {
+            if (resource.imported || resource.firstUse != static_cast<int>(position)) { continue; }
+
+            const size_t physical = acquireTexture(resource, resource.firstUse);
+            resource.texture = mTextures[physical].id;
+            mStats.textureCount++;
+            mStats.requestedBytes += GpuMemory::textureBytes(resource.desc.internalFormat, resource.desc.width,
+                                                             resource.desc.height);
+        }
+    }
+
+    mStats.physicalTextureCount = 0;
+    mStats.allocatedBytes = 0;
+    for (const PhysicalTexture& texture : mTextures)
+    {
+        if (texture.lastExecution != mExecution) { continue; }
+        mStats.physicalTextureCount++;
+        mStats.allocatedBytes += texture.bytes;
+    }
+}
+
+size_t FrameGraph::acquireTexture(const Resource& resource, const int firstUse)
+{
+    for (size_t i = 0; i < mTextures.size(); i++)
+    {
+        PhysicalTexture& texture = mTextures[i];
+        if (texture.desc == resource.desc && texture.busyUntil < firstUse)
+        {
+            texture.busyUntil = resource.lastUse;
+            texture.lastExecution = mExecution;
+            return i;
+        }
+    }
+
+    const FrameGraphTextureDesc& desc = resource.desc;
+    // Allocating rebinds the active unit, which may hold a texture bound once at startup
+    GLint previousTexture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+    unsigned int id = 0;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(desc.internalFormat), desc.width, desc.height, 0,
+                 transferFormat(desc.internalFormat), GL_FLOAT, nullptr);
+    const GLint filter = desc.linearFilter ? GL_LINEAR : GL_NEAREST;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previousTexture));
+
+    const size_t bytes = GpuMemory::textureBytes(desc.internalFormat, desc.width, desc.height);
+    GpuMemory::track(GpuResourceType::Texture, id, bytes, mMemoryCategory, std::string(resource.name));
+    mTextures.push_back({desc, id, bytes, resource.lastUse, mExecution});
+    return mTextures.size() - 1;
+}
+
+void FrameGraph::releaseUnusedTextures()
+{
+    // Textures of passes that stopped running, or of a size from before a resize
+    const auto unused = std::remove_if(mTextures.begin(), mTextures.end(), [this](PhysicalTexture& texture)
+    {
+        if (mExecution - texture.lastExecution < KEEP_EXECUTIONS) { return false; }
+        GpuMemory::release(GpuResourceType::Texture, texture.id);
+        glDeleteTextures(1, &texture.id);
+        return true;
+    });
+    if (unused == mTextures.end()) { return; }
+
+    mTextures.erase(unused, mTextures.end());
+    // Deleted texture names get reused, so no cached framebuffer may outlive its textures
+    destroyFramebuffers();
+}
+
+void FrameGraph::destroyFramebuffers()
+{
+    for (auto& [textures, framebuffer] : mFramebuffers)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+    }
+    mFramebuffers.clear();
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "FrameArena.h"
+#include "Profiler.h"
+
+using FrameGraphResource = int;
+
+struct FrameGraphTextureDesc
+{
+    int width;
+    int height;
+    unsigned int internalFormat;
+    bool linearFilter = true;
+
+    bool operator==(const FrameGraphTextureDesc& other) const = default;
+};
+
+struct FrameGraphStats
+{
+    size_t passCount = 0;
+    size_t culledPassCount = 0;
+    size_t textureCount = 0;         // Transient textures declared by the executed passes
+    size_t physicalTextureCount = 0; // GL textures backing them after aliasing
+    size_t requestedBytes = 0;       // Memory the transient textures would take allocated separately
+    size_t allocatedBytes = 0;
+
+    // 0 when nothing aliases
+    size_t savedBytes() const { return requestedBytes > allocatedBytes ? requestedBytes - allocatedBytes : 0; }
+};
+
+/// <summary>
+/// Passes declare the textures they read and write, the graph works out the rest. Passes whose output
+/// is never read are culled, the rest run in dependency order. Transient textures only live from their
+/// first to their last use, and ones with the same size and format whose lifetimes do not overlap share
+/// a GL texture. The GL textures are pooled across executions and freed once no graph has used them for
+/// a few executions. Passes and resources are declared anew for every execution, everything they are
+/// declared with lives in the frame arena until the execution is done.
+/// </summary>
+class FrameGraph
+{
+public:
+    /// <summary>
+    /// The textures are reported to GpuMemory under the category
+    /// </summary>
+    explicit FrameGraph(const std::string& memoryCategory);
+    ~FrameGraph();
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+
+    FrameGraphResource createTexture(std::string_view name, const FrameGraphTextureDesc& desc);
+    /// <summary>
+    /// Texture owned outside the graph, such as a history or the output. Passes writing imported
+    /// textures are never culled.
+    /// </summary>
+    FrameGraphResource importTexture(std::string_view name, unsigned int texture);
+    /// <summary>
+    /// The execute callable is copied into the frame arena and never destroyed, lambdas capturing by
+    /// reference fit that
+    /// </summary>
+    template <typename Execute>
+    void addPass(std::string_view name, FrameVector<FrameGraphResource> reads, FrameVector<FrameGraphResource> writes,
+                 Execute&& execute)
+    {
+        using Callable = std::decay_t<Execute>;
+        Callable* callable = FrameArena::frame().create<Callable>(std::forward<Execute>(execute));
+        addPass(name, std::move(reads), std::move(writes),
+                {callable, [](void* object, FrameGraph& graph) { (*static_cast<Callable*>(object))(graph); }});
+    }
+
+    /// <summary>
+    /// Culls, orders and runs the declared passes, each in its own profiler scope, then clears them
+    /// </summary>
+    void execute(Profiler* profiler = nullptr);
+
+    /// <summary>
+    /// GL texture of a resource, only valid while the passes execute
+    /// </summary>
+    unsigned int texture(FrameGraphResource resource) const;
+    /// <summary>
+    /// Binds a framebuffer with the textures attached, cached while they stay allocated. Without color
+    /// textures the draw buffer stays on attachment 0 for the pass to attach its own target.
+    /// </summary>
+    unsigned int bindFramebuffer(std::span<const FrameGraphResource> colors, FrameGraphResource depth = -1);
+
+    /// <summary>
+    /// Statistics of the last execution
+    /// </summary>
+    const FrameGraphStats& stats() const;
+
+private:
+    struct Resource
+    {
+        std::string_view name;
+        FrameGraphTextureDesc desc;
+        bool imported;
+        unsigned int texture;
+        int firstUse; // Position in the execution order
+        int lastUse;
+        FrameVector<int> writers;
+    };
+
+    // Type erased pass body living in the frame arena
+    struct PassExecute
+    {
+        void* object;
+        void (*invoke)(void* object, FrameGraph& graph);
+    };
+
+    struct Pass
+    {
+        std::string_view name;
+        FrameVector<FrameGraphResource> reads;
+        FrameVector<FrameGraphResource> writes;
+        PassExecute execute;
+    };
+
+    struct PhysicalTexture
+    {
+        FrameGraphTextureDesc desc;
+        unsigned int id;
+        size_t bytes;
+        int busyUntil;        // Last use in this execution of the resource holding it, -1 when free
+        uint64_t lastExecution;
+    };
+
+    void addPass(std::string_view name, FrameVector<FrameGraphResource> reads, FrameVector<FrameGraphResource> writes,
+                 PassExecute execute);
+    FrameVector<int> cullPasses() const;
+    FrameVector<int> sortPasses(const FrameVector<int>& kept) const;
+    void allocateTextures(const FrameVector<int>& order);
+    size_t acquireTexture(const Resource& resource, int firstUse);
+    void releaseUnusedTextures();
+    void destroyFramebuffers();
+
+    static constexpr uint64_t KEEP_EXECUTIONS = 3;
+
+    std::string mMemoryCategory;
+    std::vector<Resource> mResources;
+    std::vector<Pass> mPasses;
+    std::vector<PhysicalTexture> mTextures;
+    std::map<std::vector<unsigned int>, unsigned int> mFramebuffers;
+    std::vector<unsigned int> mFramebufferKey; // Reused for the lookups, only copied for new framebuffers
+    uint64_t mExecution;
+    FrameGraphStats mStats;
+};
@@ -0,0 +1,65 @@
+#include "FramePreparer.h"
+
+#include <algorithm>
+#include "Parallel.h"
+
+namespace
+{
+    // Below this a job costs more to start than the culling it does
+    constexpr size_t MIN_MESHES_PER_JOB = 32;
+}
+
+FramePreparer::FramePreparer() :
+    mLists(Parallel::workerCount()),
+    mJobCount(0)
+{
+}
+
+void FramePreparer::prepare(const Model& model, const DrawView& view)
+{
+    const size_t meshCount = model.meshCount();
+    mJobCount = std::clamp((meshCount + MIN_MESHES_PER_JOB - 1) / MIN_MESHES_PER_JOB, static_cast<size_t>(1),
+                           mLists.size());
+    const size_t meshesPerJob = (meshCount + mJobCount - 1) / mJobCount;
+
+    // One command list per job, so the jobs never share a container
+    Parallel::parallelFor(static_cast<unsigned int>(mJobCount), 1,
+                          [&](const unsigned int firstJob, const unsigned int lastJob)
+    {
+        for (unsigned int job = firstJob; job < lastJob; job++)
+        {
+            CommandList& list = mLists[job];
+            list.clear();
+            const size_t begin = std::min(job * meshesPerJob, meshCount);
+            model.recordDraws(begin, std::min(begin + meshesPerJob, meshCount), view, list);
+            std::sort(list.draws.begin(), list.draws.end());
+        }
+    });
+
+    mCommands.clear();
+    for (size_t job = 0; job < mJobCount; job++)
+    {
+        const std::vector<DrawCommand>& draws = mLists[job].draws;
+        mMergeBuffer.resize(mCommands.size() + draws.size());
+        std::merge(mCommands.begin(), mCommands.end(), draws.begin(), draws.end(), mMergeBuffer.begin());
+        mCommands.swap(mMergeBuffer);
+    }
+}
+
+void FramePreparer::applyTextureDetail(Model& model) const
+{
+    for (size_t job = 0; job < mJobCount; job++)
+    {
+        model.applyTextureDetail(mLists[job].detailRequests);
+    }
+}
+
+const std::vector<DrawCommand>& FramePreparer::commands() const
+{
+    return mCommands;
+}
+
+size_t FramePreparer::jobCount() const
+{
+    return mJobCount;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include "CommandList.h"
+#include "Model.h"
+
+/// <summary>
+/// Splits the CPU side of a frame into jobs on the worker threads. Each job culls a range of meshes,
+/// picks the texture detail they need, and records and sorts its own command list. The lists are then
+/// merged into one sorted queue the GL thread replays with Model::DrawCommands.
+/// </summary>
+class FramePreparer
+{
+public:
+    FramePreparer();
+
+    /// <summary>
+    /// Records the draws of the model for the view. Does not touch GL state.
+    /// </summary>
+    void prepare(const Model& model, const DrawView& view);
+    /// <summary>
+    /// Hands the texture detail recorded by the jobs to the model's texture streamer, on the GL thread
+    /// </summary>
+    void applyTextureDetail(Model& model) const;
+
+    /// <summary>
+    /// Sorted draws of the last prepared frame
+    /// </summary>
+    const std::vector<DrawCommand>& commands() const;
+    size_t jobCount() const;
+
+private:
+    std::vector<CommandList> mLists;
+    std::vector<DrawCommand> mCommands;
+    std::vector<DrawCommand> mMergeBuffer;
+    size_t mJobCount;
+};
@@ -0,0 +1,124 @@
+#include "FrameReadback.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "GpuMemory.h"
+
+namespace
+{
+    constexpr GLuint64 WAIT_STEP_NS = 1000000;
+}
+
+FrameReadback::FrameReadback(const int width, const int height, FrameCallback onFrame, const unsigned int ringSize) :
+    mWidth(width),
+    mHeight(height),
+    mOnFrame(std::move(onFrame)),
+    mSlots(std::max(1u, ringSize))
+{
+    for (Slot& slot : mSlots)
+    {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(frameBytes()), nullptr, GL_STREAM_READ);
+        GpuMemory::track(GpuResourceType::Buffer, slot.buffer, frameBytes(), "Readback", "Pixel pack buffer");
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FrameReadback::capture(const unsigned int framebuffer, const int frame)
+{
+    // Frames done since the last capture go out first, without blocking
+    while (mInFlight > 0 && collectOldest(false)) {}
+    if (mInFlight == mSlots.size())
+    {
+        mStalls++;
+        collectOldest(true);
+    }
+
+    Slot& slot = mSlots[(mOldest + mInFlight) % mSlots.size()];
+    slot.frame = frame;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(framebuffer == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    // With a pack buffer bound the copy returns immediately, the last argument is an offset into it
+    glReadPixels(0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // The fence has to reach the GPU, or waiting on it from the next capture could wait forever
+    glFlush();
+    mInFlight++;
+}
+
+void FrameReadback::flush()
+{
+    while (mInFlight > 0) { collectOldest(true); }
+}
+
+bool FrameReadback::collectOldest(const bool wait)
+{
+    Slot& slot = mSlots[mOldest];
+    GLenum status = glClientWaitSync(slot.fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        if (!wait) { return false; }
+        do
+        {
+            status = glClientWaitSync(slot.fence, 0, WAIT_STEP_NS);
+        } while (status == GL_TIMEOUT_EXPIRED);
+    }
+    if (status == GL_WAIT_FAILED)
+    {
+        std::cout << "ERROR::FRAME_READBACK::Waiting on the copy of frame " << slot.frame << " failed" << std::endl;
+    }
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    std::vector<unsigned char> pixels(frameBytes());
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(pixels.size()), GL_MAP_READ_BIT);
+    if (mapped)
+    {
+        std::memcpy(pixels.data(), mapped, pixels.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else
+    {
+        std::cout << "ERROR::FRAME_READBACK::Failed to map the pixels of frame " << slot.frame << std::endl;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    const int frame = slot.frame;
+    mOldest = (mOldest + 1) % mSlots.size();
+    mInFlight--;
+    if (mapped) { mOnFrame(frame, std::move(pixels)); }
+    return true;
+}
+
+void FrameReadback::deinit()
+{
+    for (Slot& slot : mSlots)
+    {
+        if (slot.fence) { glDeleteSync(slot.fence); }
+        GpuMemory::release(GpuResourceType::Buffer, slot.buffer);
+        glDeleteBuffers(1, &slot.buffer);
+        slot = Slot();
+    }
+    mInFlight = 0;
+}
+
+size_t FrameReadback::frameBytes() const
+{
+    return static_cast<size_t>(mWidth) * static_cast<size_t>(mHeight) * 4;
+}
+
+uint64_t FrameReadback::stallCount() const
+{
+    return mStalls;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glad/glad.h>
+
+/// <summary>
+/// Reads finished frames back to the CPU without stalling the pipeline. Each capture copies the color
+/// attachment into the next pixel pack buffer of a ring and fences it, the buffer is only mapped once
+/// the fence has signalled, so the copy of frame N overlaps rendering frame N + 1. Frames are handed
+/// out in capture order as tightly packed RGBA8 rows, bottom row first.
+/// </summary>
+class FrameReadback
+{
+public:
+    using FrameCallback = std::function<void(int frame, std::vector<unsigned char>&& pixels)>;
+
+    static constexpr unsigned int DEFAULT_RING_SIZE = 3;
+
+    FrameReadback(int width, int height, FrameCallback onFrame, unsigned int ringSize = DEFAULT_RING_SIZE);
+    FrameReadback(const FrameReadback&) = delete;
+    FrameReadback& operator=(const FrameReadback&) = delete;
+
+    /// <summary>
+    /// Queues the copy of the framebuffer's first color attachment and hands out the frames already
+    /// done. Waits on the oldest copy only when every buffer of the ring is still in flight.
+    /// </summary>
+    void capture(unsigned int framebuffer, int frame);
+    /// <summary>
+    /// Waits for every copy in flight and hands it out
+    /// </summary>
+    void flush();
+    void deinit();
+
+    size_t frameBytes() const;
+    /// <summary>
+    /// Captures that had to wait for the GPU, a ring too short for the frame rate when this keeps growing
+    /// </summary>
+    uint64_t stallCount() const;
+
+private:
+    struct Slot
+    {
+        unsigned int buffer = 0;
+        GLsync fence = nullptr;
+        int frame = 0;
+    };
+
+    // Hands out the oldest copy in flight, false when it is not done yet and wait is false
+    bool collectOldest(bool wait);
+
+private:
+    int mWidth;
+    int mHeight;
+    FrameCallback mOnFrame;
+    std::vector<Slot> mSlots;
+    unsigned int mOldest = 0;
+    unsigned int mInFlight = 0;
+    uint64_t mStalls = 0;
+};
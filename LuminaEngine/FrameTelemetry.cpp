@@ -0,0 +1,252 @@
+#include "FrameTelemetry.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <imgui.h>
+
+namespace
+{
+    constexpr int HISTOGRAM_BUCKETS = 32;
+    constexpr size_t LISTED_STUTTERS = 16;
+
+    // Nearest rank percentile of sorted values
+    float percentile(const std::vector<float>& sorted, const float p)
+    {
+        const auto rank = static_cast<size_t>(std::ceil(p / 100.0f * static_cast<float>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    float gpuDuration(const ProfileEvent& event)
+    {
+        return event.gpuStartMs >= 0.0 ? static_cast<float>(event.gpuEndMs - event.gpuStartMs) : 0.0f;
+    }
+
+    // Top level pass with the longest CPU or GPU time
+    void findSlowestPass(const ProfileFrame& frame, FrameSample& sample)
+    {
+        for (const ProfileEvent& event : frame.events)
+        {
+            if (event.depth != 1) { continue; }
+
+            const float passMs = std::max(static_cast<float>(event.cpuEndMs - event.cpuStartMs), gpuDuration(event));
+            if (passMs > sample.slowestPassMs)
+            {
+                sample.slowestPassMs = passMs;
+                const size_t length = event.name.copy(sample.slowestPass, sizeof(sample.slowestPass) - 1);
+                sample.slowestPass[length] = '\0';
+            }
+        }
+    }
+}
+
+FrameTelemetry::FrameTelemetry(const float budgetMs) :
+    mWriteIndex(0),
+    mBudgetMs(budgetMs),
+    mLastFrameIndex(0),
+    mHasRecorded(false),
+    mLastResolvedIndex(0),
+    mHasResolved(false)
+{
+}
+
+void FrameTelemetry::record(const ProfileFrame& frame)
+{
+    if (frame.events.empty() || (mHasRecorded && frame.index == mLastFrameIndex)) { return; }
+    mLastFrameIndex = frame.index;
+    mHasRecorded = true;
+
+    const ProfileEvent& root = frame.events[0];
+    FrameSample sample = {};
+    sample.frameIndex = frame.index;
+    sample.cpuMs = static_cast<float>(root.cpuEndMs - root.cpuStartMs);
+    sample.gpuMs = gpuDuration(root);
+    for (const ProfileEvent& event : frame.events)
+    {
+        if (event.depth == 1 && event.name == "Swap")
+        {
+            sample.swapMs = static_cast<float>(event.cpuEndMs - event.cpuStartMs);
+        }
+    }
+    findSlowestPass(frame, sample);
+
+    const uint64_t index = mWriteIndex.load(std::memory_order_relaxed);
+    publish(mSlots[index % CAPACITY], index, sample);
+    mWriteIndex.store(index + 1, std::memory_order_release);
+}
+
+void FrameTelemetry::resolveGpu(const ProfileFrame& frame)
+{
+    if (frame.events.empty() || (mHasResolved && frame.index == mLastResolvedIndex)) { return; }
+    mLastResolvedIndex = frame.index;
+    mHasResolved = true;
+
+    // Only the recording thread writes, so it reads the slots without the sequence check. The frame
+    // resolves a frame or two after it was recorded, the search stops at the first older sample.
+    const uint64_t end = mWriteIndex.load(std::memory_order_relaxed);
+    const uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+    for (uint64_t index = end; index > begin; index--)
+    {
+        Slot& slot = mSlots[(index - 1) % CAPACITY];
+        if (slot.sample.frameIndex < frame.index) { return; }
+        if (slot.sample.frameIndex != frame.index) { continue; }
+
+        FrameSample sample = slot.sample;
+        sample.gpuMs = gpuDuration(frame.events[0]);
+        findSlowestPass(frame, sample);
+        publish(slot, index - 1, sample);
+        return;
+    }
+}
+
+void FrameTelemetry::publish(Slot& slot, const uint64_t writeIndex, const FrameSample& sample)
+{
+    // Odd sequence while writing, readers that see it or a changed sequence drop their copy
+    const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.writeIndex = writeIndex;
+    slot.sample = sample;
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+std::vector<FrameSample> FrameTelemetry::snapshot() const
+{
+    const uint64_t end = mWriteIndex.load(std::memory_order_acquire);
+    const uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+
+    std::vector<FrameSample> samples;
+    samples.reserve(end - begin);
+    for (uint64_t i = begin; i < end; i++)
+    {
+        const Slot& slot = mSlots[i % CAPACITY];
+        const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence % 2 != 0) { continue; }
+
+        // Samples get rewritten when their GPU timings resolve, so the slot is matched by write index
+        const uint64_t writeIndex = slot.writeIndex;
+        const FrameSample sample = slot.sample;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence || writeIndex != i) { continue; }
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+FrameTimeStats FrameTelemetry::computeStats(const std::vector<FrameSample>& samples, const float budgetMs)
+{
+    FrameTimeStats stats;
+    if (samples.empty()) { return stats; }
+
+    std::vector<float> sorted;
+    sorted.reserve(samples.size());
+    for (const FrameSample& sample : samples)
+    {
+        sorted.push_back(sample.cpuMs);
+        if (sample.cpuMs > budgetMs) { stats.overBudget++; }
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    stats.p50 = percentile(sorted, 50.0f);
+    stats.p95 = percentile(sorted, 95.0f);
+    stats.p99 = percentile(sorted, 99.0f);
+    stats.max = sorted.back();
+    return stats;
+}
+
+bool FrameTelemetry::exportCsv(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::TELEMETRY::Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    const float budgetMs = budget();
+    file << "frame,cpu_ms,gpu_ms,swap_ms,over_budget,slowest_pass,slowest_pass_ms\n";
+    for (const FrameSample& sample : snapshot())
+    {
+        file << sample.frameIndex << "," << sample.cpuMs << "," << sample.gpuMs << "," << sample.swapMs << ","
+             << (sample.cpuMs > budgetMs ? 1 : 0) << "," << sample.slowestPass << "," << sample.slowestPassMs << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+void FrameTelemetry::drawUI()
+{
+    const std::vector<FrameSample> samples = snapshot();
+    float budgetMs = budget();
+    const FrameTimeStats stats = computeStats(samples, budgetMs);
+
+    ImGui::SetNextWindowSize(ImVec2(360, 0), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Frame Times");
+
+    ImGui::Text("p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms", stats.p50, stats.p95, stats.p99, stats.max);
+    ImGui::Text("Over budget: %u of %zu frames", stats.overBudget, samples.size());
+    ImGui::PushItemWidth(80);
+    if (ImGui::DragFloat("Budget (ms)", &budgetMs, 0.1f, 1.0f, 100.0f, "%.2f"))
+    {
+        setBudget(budgetMs);
+    }
+    ImGui::PopItemWidth();
+
+    std::vector<float> frameTimes;
+    frameTimes.reserve(samples.size());
+    // Everything past twice the budget lands in the last bucket
+    std::vector<float> histogram(HISTOGRAM_BUCKETS, 0.0f);
+    for (const FrameSample& sample : samples)
+    {
+        frameTimes.push_back(sample.cpuMs);
+        const int bucket = static_cast<int>(sample.cpuMs / (2.0f * budgetMs) * HISTOGRAM_BUCKETS);
+        histogram[std::clamp(bucket, 0, HISTOGRAM_BUCKETS - 1)]++;
+    }
+
+    const float graphMax = std::max(2.0f * budgetMs, stats.max);
+    char budgetLabel[32];
+    std::snprintf(budgetLabel, sizeof(budgetLabel), "budget %.2f ms", budgetMs);
+    ImGui::PlotLines("##frametimes", frameTimes.data(), static_cast<int>(frameTimes.size()), 0, budgetLabel, 0.0f,
+                     graphMax, ImVec2(0, 80));
+    ImGui::PlotHistogram("##distribution", histogram.data(), HISTOGRAM_BUCKETS, 0, "0 to 2x budget", 0.0f,
+                         FLT_MAX, ImVec2(0, 60));
+
+    if (ImGui::CollapsingHeader("Stutters"))
+    {
+        size_t listed = 0;
+        for (auto sample = samples.rbegin(); sample != samples.rend() && listed < LISTED_STUTTERS; ++sample)
+        {
+            if (sample->cpuMs <= budgetMs) { continue; }
+            ImGui::Text("Frame %llu: %.2f ms, %s %.2f ms", static_cast<unsigned long long>(sample->frameIndex),
+                        sample->cpuMs, sample->slowestPass, sample->slowestPassMs);
+            listed++;
+        }
+        if (listed == 0) { ImGui::TextDisabled("None in the last %zu frames", samples.size()); }
+    }
+
+    if (ImGui::Button("Export CSV"))
+    {
+        const std::string path = "frame_times.csv";
+        mExportStatus = exportCsv(path) ? "Saved " + path : "Failed to save " + path;
+    }
+    if (!mExportStatus.empty())
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", mExportStatus.c_str());
+    }
+
+    ImGui::End();
+}
+
+float FrameTelemetry::budget() const
+{
+    return mBudgetMs.load(std::memory_order_relaxed);
+}
+
+void FrameTelemetry::setBudget(const float budgetMs)
+{
+    mBudgetMs.store(budgetMs, std::memory_order_relaxed);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Profiler.h"
+
+struct FrameSample
+{
+    uint64_t frameIndex;
+    float cpuMs;   // Whole frame on the CPU, swap included
+    float gpuMs;   // Whole frame on the GPU, 0 until it resolves and for frames whose GPU timings were dropped
+    float swapMs;
+    // Top level pass with the longest CPU or GPU time, reported for frames over budget
+    char slowestPass[32];
+    float slowestPassMs;
+};
+
+struct FrameTimeStats
+{
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+    unsigned int overBudget = 0;
+};
+
+/// <summary>
+/// Keeps the timings of the last CAPACITY frames in a ring buffer and derives rolling percentiles and
+/// stutters from them. The ring is single producer, slots are sequence locked so snapshots can be taken
+/// from any thread without blocking the frame that records.
+/// </summary>
+class FrameTelemetry
+{
+public:
+    static constexpr size_t CAPACITY = 1024;
+
+    explicit FrameTelemetry(float budgetMs = 1000.0f / 60.0f);
+
+    /// <summary>
+    /// Records the CPU timings of an ended profiler frame. Pass Profiler::endedFrame every frame so
+    /// hitches whose GPU timings get dropped are still recorded. Frames already recorded are ignored.
+    /// </summary>
+    void record(const ProfileFrame& frame);
+    /// <summary>
+    /// Patches the GPU timings of a resolved profiler frame into its sample, if it is still in the ring.
+    /// Safe to pass Profiler::latestFrame every frame.
+    /// </summary>
+    void resolveGpu(const ProfileFrame& frame);
+    /// <summary>
+    /// Recorded samples, oldest first. Slots overwritten while being copied are skipped.
+    /// </summary>
+    std::vector<FrameSample> snapshot() const;
+    static FrameTimeStats computeStats(const std::vector<FrameSample>& samples, float budgetMs);
+
+    bool exportCsv(const std::string& path) const;
+    void drawUI();
+
+    float budget() const;
+    void setBudget(float budgetMs);
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence{0}; // Odd while the sample is being written
+        uint64_t writeIndex = 0;
+        FrameSample sample;
+    };
+
+    void publish(Slot& slot, uint64_t writeIndex, const FrameSample& sample);
+
+    std::array<Slot, CAPACITY> mSlots;
+    std::atomic<uint64_t> mWriteIndex;
+    std::atomic<float> mBudgetMs;
+    uint64_t mLastFrameIndex;
+    bool mHasRecorded;
+    uint64_t mLastResolvedIndex;
+    bool mHasResolved;
+    std::string mExportStatus;
+};
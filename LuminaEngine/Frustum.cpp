@@ -0,0 +1,24 @@
+#include "Frustum.h"
+
+namespace Frustum
+{
+    std::array<glm::vec4, 6> extractPlanes(const glm::mat4& viewProjection)
+    {
+        const glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+        const glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+        const glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+        const glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+        return {row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2};
+    }
+
+    bool isSphereVisible(const std::array<glm::vec4, 6>& planes, const glm::vec3& center, const float radius)
+    {
+        for (const glm::vec4& plane : planes)
+        {
+            const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+            // Planes are not normalized, so scale the radius instead
+            if (distance < -radius * glm::length(glm::vec3(plane))) { return false; }
+        }
+        return true;
+    }
+}
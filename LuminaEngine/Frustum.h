@@ -0,0 +1,15 @@
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+
+namespace Frustum
+{
+    /// <summary>
+    /// Extracts the six clip planes of a (model) view projection matrix. Planes are in the space the
+    /// matrix transforms from, with normals pointing inside.
+    /// </summary>
+    std::array<glm::vec4, 6> extractPlanes(const glm::mat4& viewProjection);
+
+    bool isSphereVisible(const std::array<glm::vec4, 6>& planes, const glm::vec3& center, float radius);
+}
@@ -0,0 +1,268 @@
+#include "GpuMemory.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <imgui.h>
+
+// Compressed formats that are not part of the core 3.3 profile
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+
+namespace GpuMemory
+{
+    namespace
+    {
+        constexpr size_t DEFAULT_BUDGET_BYTES = static_cast<size_t>(2048) * 1024 * 1024;
+
+        std::map<std::pair<GpuResourceType, unsigned int>, GpuAllocation> registry;
+        size_t total = 0;
+        size_t budgetBytes = DEFAULT_BUDGET_BYTES;
+        BudgetPolicy budgetPolicy = BudgetPolicy::Warn;
+        // Reported once per crossing, so streaming does not repeat the message every frame
+        bool overBudgetReported = false;
+        unsigned int refusedAllocations = 0;
+
+        double toMegabytes(const size_t bytes)
+        {
+            return static_cast<double>(bytes) / (1024.0 * 1024.0);
+        }
+
+        void reportOverBudget(const std::string& owner, const size_t bytes)
+        {
+            if (overBudgetReported) { return; }
+            overBudgetReported = true;
+
+            std::ostringstream report;
+            report << std::fixed << std::setprecision(2) << "GPU memory budget of " << toMegabytes(budgetBytes)
+                   << " MB exceeded by " << owner << " (" << toMegabytes(bytes) << " MB, "
+                   << toMegabytes(total) << " MB in use)";
+            std::cout << (budgetPolicy == BudgetPolicy::Fail ? "ERROR::GPU_MEMORY::" : "WARNING::GPU_MEMORY::")
+                      << report.str() << std::endl;
+        }
+
+        // Bytes of a 4x4 block for block compressed formats, 0 for everything else
+        size_t blockBytes(const GLenum internalFormat)
+        {
+            switch (internalFormat)
+            {
+                case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+                case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+                case GL_COMPRESSED_RED_RGTC1:
+                    return 8;
+                case GL_COMPRESSED_RG_RGTC2:
+                case GL_COMPRESSED_RGBA_BPTC_UNORM:
+                case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+                    return 16;
+                default:
+                    return 0;
+            }
+        }
+
+        size_t texelBytes(const GLenum internalFormat)
+        {
+            switch (internalFormat)
+            {
+                case GL_RED:
+                case GL_R8:
+                    return 1;
+                case GL_RG8:
+                case GL_R16F:
+                case GL_DEPTH_COMPONENT16:
+                    return 2;
+                case GL_RGB:
+                case GL_RGB8:
+                case GL_SRGB:
+                case GL_SRGB8:
+                    return 3;
+                case GL_RGBA:
+                case GL_RGBA8:
+                case GL_SRGB_ALPHA:
+                case GL_SRGB8_ALPHA8:
+                case GL_RG16F:
+                case GL_R32F:
+                case GL_R11F_G11F_B10F:
+                case GL_DEPTH_COMPONENT:
+                case GL_DEPTH_COMPONENT24: // Stored in 32 bits by every driver we know of
+                case GL_DEPTH_COMPONENT32F:
+                case GL_DEPTH24_STENCIL8:
+                    return 4;
+                case GL_RGB16F:
+                    return 6;
+                case GL_RGBA16F:
+                case GL_RG32F:
+                case GL_DEPTH32F_STENCIL8:
+                    return 8;
+                case GL_RGB32F:
+                    return 12;
+                case GL_RGBA32F:
+                    return 16;
+                default:
+                    return 4;
+            }
+        }
+    }
+
+    void track(const GpuResourceType type, const unsigned int id, const size_t bytes, const std::string& category,
+               const std::string& owner)
+    {
+        if (id == 0) { return; }
+
+        auto [allocation, inserted] = registry.try_emplace({type, id}, GpuAllocation{type, id, 0, category, owner});
+        total = total - allocation->second.bytes + bytes;
+        allocation->second.bytes = bytes;
+        if (!inserted)
+        {
+            allocation->second.category = category;
+            allocation->second.owner = owner;
+        }
+
+        if (total > budgetBytes) { reportOverBudget(owner, bytes); }
+        else { overBudgetReported = false; }
+    }
+
+    void release(const GpuResourceType type, const unsigned int id)
+    {
+        const auto allocation = registry.find({type, id});
+        if (allocation == registry.end()) { return; }
+
+        total -= allocation->second.bytes;
+        registry.erase(allocation);
+        if (total <= budgetBytes) { overBudgetReported = false; }
+    }
+
+    bool canAllocate(const size_t bytes, const std::string& owner)
+    {
+        if (total + bytes <= budgetBytes) { return true; }
+
+        reportOverBudget(owner, bytes);
+        if (budgetPolicy == BudgetPolicy::Warn) { return true; }
+        refusedAllocations++;
+        return false;
+    }
+
+    size_t textureBytes(const GLenum internalFormat, const int width, const int height, const int levels,
+                        const int layers)
+    {
+        const size_t block = blockBytes(internalFormat);
+        size_t bytes = 0;
+        int w = width;
+        int h = height;
+        for (int level = 0; level < levels; level++)
+        {
+            bytes += block > 0 ? static_cast<size_t>((w + 3) / 4) * ((h + 3) / 4) * block
+                               : static_cast<size_t>(w) * h * texelBytes(internalFormat);
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+        return bytes * layers;
+    }
+
+    int fullMipCount(const int width, const int height)
+    {
+        int levels = 1;
+        for (int size = std::max(width, height); size > 1; size /= 2) { levels++; }
+        return levels;
+    }
+
+    size_t totalBytes()
+    {
+        return total;
+    }
+
+    size_t budget()
+    {
+        return budgetBytes;
+    }
+
+    void setBudget(const size_t newBudgetBytes)
+    {
+        budgetBytes = newBudgetBytes;
+        overBudgetReported = false;
+    }
+
+    BudgetPolicy policy()
+    {
+        return budgetPolicy;
+    }
+
+    void setPolicy(const BudgetPolicy newPolicy)
+    {
+        budgetPolicy = newPolicy;
+        overBudgetReported = false;
+    }
+
+    std::vector<GpuAllocation> allocations()
+    {
+        std::vector<GpuAllocation> result;
+        result.reserve(registry.size());
+        for (const auto& [key, allocation] : registry) { result.push_back(allocation); }
+        return result;
+    }
+
+    void drawUI()
+    {
+        ImGui::SetNextWindowSize(ImVec2(380, 0), ImGuiCond_FirstUseEver);
+        ImGui::Begin("GPU Memory");
+
+        char overlay[64];
+        std::snprintf(overlay, sizeof(overlay), "%.1f / %.0f MB", toMegabytes(total), toMegabytes(budgetBytes));
+        const float fraction = budgetBytes > 0 ? static_cast<float>(total) / static_cast<float>(budgetBytes) : 1.0f;
+        if (total > budgetBytes) { ImGui::PushStyleColor(ImGuiCol_PlotHistogram, ImVec4(0.9f, 0.2f, 0.2f, 1.0f)); }
+        ImGui::ProgressBar(std::min(fraction, 1.0f), ImVec2(-1.0f, 0.0f), overlay);
+        if (total > budgetBytes) { ImGui::PopStyleColor(); }
+
+        float budgetMb = static_cast<float>(toMegabytes(budgetBytes));
+        ImGui::PushItemWidth(80);
+        if (ImGui::DragFloat("Budget (MB)", &budgetMb, 4.0f, 16.0f, 65536.0f, "%.0f"))
+        {
+            setBudget(static_cast<size_t>(budgetMb * 1024.0f * 1024.0f));
+        }
+        ImGui::SameLine();
+        int policyIndex = budgetPolicy == BudgetPolicy::Fail ? 1 : 0;
+        if (ImGui::Combo("Over budget", &policyIndex, "Warn\0Fail\0"))
+        {
+            setPolicy(policyIndex == 1 ? BudgetPolicy::Fail : BudgetPolicy::Warn);
+        }
+        ImGui::PopItemWidth();
+        if (refusedAllocations > 0) { ImGui::Text("Refused allocations: %u", refusedAllocations); }
+
+        std::map<std::string, std::vector<const GpuAllocation*>> categories;
+        for (const auto& [key, allocation] : registry) { categories[allocation.category].push_back(&allocation); }
+
+        for (auto& [category, entries] : categories)
+        {
+            size_t categoryBytes = 0;
+            for (const GpuAllocation* allocation : entries) { categoryBytes += allocation->bytes; }
+
+            const bool open = ImGui::TreeNode(category.c_str(), "%s: %.2f MB (%zu)", category.c_str(),
+                                              toMegabytes(categoryBytes), entries.size());
+            if (!open) { continue; }
+
+            std::sort(entries.begin(), entries.end(), [](const GpuAllocation* a, const GpuAllocation* b)
+            {
+                return a->bytes > b->bytes;
+            });
+            for (const GpuAllocation* allocation : entries)
+            {
+                ImGui::Text("%.2f MB  %s", toMegabytes(allocation->bytes), allocation->owner.c_str());
+            }
+            ImGui::TreePop();
+        }
+
+        ImGui::End();
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+enum class GpuResourceType
+{
+    Texture,
+    Renderbuffer,
+    Buffer
+};
+
+enum class BudgetPolicy
+{
+    Warn, // Allocations over budget go ahead and are reported
+    Fail  // Optional allocations over budget are refused
+};
+
+struct GpuAllocation
+{
+    GpuResourceType type;
+    unsigned int id;
+    size_t bytes;
+    std::string category;
+    std::string owner;
+};
+
+/// <summary>
+/// Registry of every texture, renderbuffer and buffer the engine allocates, with its estimated size.
+/// Sizes are derived from the internal format and dimensions, so driver padding is not included.
+/// Must only be used from the thread owning the OpenGL context.
+/// </summary>
+namespace GpuMemory
+{
+    /// <summary>
+    /// Records an allocation, or the new size of one already tracked. Required resources such as render
+    /// targets are always recorded, going over budget only reports it.
+    /// </summary>
+    void track(GpuResourceType type, unsigned int id, size_t bytes, const std::string& category,
+               const std::string& owner);
+    void release(GpuResourceType type, unsigned int id);
+    /// <summary>
+    /// Whether an optional allocation of the given size fits in the budget. Under BudgetPolicy::Fail the
+    /// caller skips the allocation when this returns false.
+    /// </summary>
+    bool canAllocate(size_t bytes, const std::string& owner);
+
+    size_t textureBytes(GLenum internalFormat, int width, int height, int levels = 1, int layers = 1);
+    int fullMipCount(int width, int height);
+
+    size_t totalBytes();
+    size_t budget();
+    void setBudget(size_t budgetBytes);
+    BudgetPolicy policy();
+    void setPolicy(BudgetPolicy budgetPolicy);
+    std::vector<GpuAllocation> allocations();
+
+    void drawUI();
+}
@@ -0,0 +1,268 @@
+#include "HdrDecoder.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "CpuFeatures.h"
+#include "Parallel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LUMINA_X86 1
+#include <immintrin.h>
+#endif
+
+namespace HdrDecoder
+{
+    namespace
+    {
+        constexpr unsigned int MIN_SCANLINES_PER_THREAD = 16;
+
+        uint16_t floatToHalfScalar(const float value)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+            const uint32_t abs = bits & 0x7FFFFFFF;
+
+            if (abs >= 0x7F800000) // Inf or NaN
+            {
+                return sign | 0x7C00 | (abs > 0x7F800000 ? 0x0200 : 0);
+            }
+            if (abs >= 0x477FF000) // Rounds to a value above the largest half (65504)
+            {
+                return sign | 0x7C00;
+            }
+            if (abs < 0x38800000) // Below the smallest normal half, result is denormal or zero
+            {
+                if (abs < 0x33000000) { return sign; }
+
+                const uint32_t mantissa = (abs & 0x7FFFFF) | 0x800000;
+                const uint32_t shift = 126 - (abs >> 23);
+                uint32_t half = mantissa >> shift;
+                const uint32_t remainder = mantissa & ((1u << shift) - 1);
+                const uint32_t halfway = 1u << (shift - 1);
+                if (remainder > halfway || (remainder == halfway && (half & 1))) { half++; }
+                return static_cast<uint16_t>(sign | half);
+            }
+
+            // Re-bias the exponent from 127 to 15 and round the dropped 13 mantissa bits
+            uint32_t half = (abs >> 13) - ((127 - 15) << 10);
+            const uint32_t remainder = abs & 0x1FFF;
+            if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) { half++; }
+            return static_cast<uint16_t>(sign | half);
+        }
+
+#if LUMINA_X86
+#if defined(__GNUC__) || defined(__clang__)
+        __attribute__((target("avx,f16c")))
+#endif
+        void floatToHalfF16C(const float* src, uint16_t* dst, const size_t count)
+        {
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m256 values = _mm256_loadu_ps(src + i);
+                const __m128i halves = _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), halves);
+            }
+            for (; i < count; i++)
+            {
+                dst[i] = floatToHalfScalar(src[i]);
+            }
+        }
+#endif
+
+        bool readFile(const std::string& filePath, std::vector<uint8_t>& bytes)
+        {
+            std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+            if (!file) { return false; }
+
+            const std::streamsize size = file.tellg();
+            if (size <= 0) { return false; }
+            file.seekg(0, std::ios::beg);
+            bytes.resize(static_cast<size_t>(size));
+            return static_cast<bool>(file.read(reinterpret_cast<char*>(bytes.data()), size));
+        }
+
+        // Reads one '\n' terminated header line. Returns false if the buffer ends first.
+        bool readLine(const uint8_t*& p, const uint8_t* end, std::string& line)
+        {
+            const auto* newLine = static_cast<const uint8_t*>(std::memchr(p, '\n', end - p));
+            if (!newLine) { return false; }
+            line.assign(reinterpret_cast<const char*>(p), newLine - p);
+            p = newLine + 1;
+            return true;
+        }
+
+        bool isRleScanline(const uint8_t* p, const uint8_t* end, const int width)
+        {
+            return width >= 8 && width < 32768 && end - p >= 4 &&
+                   p[0] == 2 && p[1] == 2 && (p[2] & 0x80) == 0 && ((p[2] << 8) | p[3]) == width;
+        }
+
+        // Old style run-length encoding marks a repeat of the previous pixel with a (1, 1, 1) pixel whose
+        // exponent holds the count. Such scanlines look flat but are shorter than width pixels.
+        bool hasOldStyleRuns(const uint8_t* p, const int width)
+        {
+            for (int x = 0; x < width; x++, p += 4)
+            {
+                if (p[0] == 1 && p[1] == 1 && p[2] == 1) { return true; }
+            }
+            return false;
+        }
+
+        // Walks a "new style" run-length encoded scanline, where each of the four RGBE components is
+        // stored as its own run-length encoded plane. Writes interleaved RGBE pixels when rgbe is not
+        // null. Returns the first byte after the scanline, or null if the scanline is malformed.
+        const uint8_t* walkRleScanline(const uint8_t* p, const uint8_t* end, const int width, uint8_t* rgbe)
+        {
+            p += 4; // Skip the scanline marker
+            for (int c = 0; c < 4; c++)
+            {
+                int x = 0;
+                while (x < width)
+                {
+                    if (p >= end) { return nullptr; }
+                    int count = *p++;
+                    if (count > 128) // Run of a single value
+                    {
+                        count -= 128;
+                        if (p >= end || x + count > width) { return nullptr; }
+                        const uint8_t value = *p++;
+                        if (rgbe)
+                        {
+                            for (int i = 0; i < count; i++) { rgbe[(x + i) * 4 + c] = value; }
+                        }
+                    }
+                    else // Literal values
+                    {
+                        if (count == 0 || end - p < count || x + count > width) { return nullptr; }
+                        if (rgbe)
+                        {
+                            for (int i = 0; i < count; i++) { rgbe[(x + i) * 4 + c] = p[i]; }
+                        }
+                        p += count;
+                    }
+                    x += count;
+                }
+            }
+            return p;
+        }
+
+        void rgbeToFloat(const uint8_t* rgbe, float* rgb, const int width)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                // Build 2^(e - 136) straight from the exponent bits. Exponents this small only produce
+                // values far below the smallest half-float, so they are flushed to zero.
+                const uint32_t e = rgbe[x * 4 + 3];
+                const uint32_t scaleBits = e > 9 ? (e - 9) << 23 : 0;
+                float scale;
+                std::memcpy(&scale, &scaleBits, sizeof(scale));
+
+                rgb[x * 3 + 0] = static_cast<float>(rgbe[x * 4 + 0]) * scale;
+                rgb[x * 3 + 1] = static_cast<float>(rgbe[x * 4 + 1]) * scale;
+                rgb[x * 3 + 2] = static_cast<float>(rgbe[x * 4 + 2]) * scale;
+            }
+        }
+    }
+
+    void floatToHalf(const float* src, uint16_t* dst, const size_t count)
+    {
+#if LUMINA_X86
+        if (CpuFeatures::hasF16C())
+        {
+            floatToHalfF16C(src, dst, count);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < count; i++)
+        {
+            dst[i] = floatToHalfScalar(src[i]);
+        }
+    }
+
+    bool decodeRgbe(const std::string& filePath, HdrImage& image)
+    {
+        std::vector<uint8_t> bytes;
+        if (!readFile(filePath, bytes)) { return false; }
+
+        const uint8_t* p = bytes.data();
+        const uint8_t* end = bytes.data() + bytes.size();
+
+        // Header: magic line, variables, an empty line, then the resolution string
+        std::string line;
+        if (!readLine(p, end, line) || (line.rfind("#?RADIANCE", 0) != 0 && line.rfind("#?RGBE", 0) != 0))
+        {
+            return false;
+        }
+        while (true)
+        {
+            if (!readLine(p, end, line)) { return false; }
+            if (line.empty()) { break; }
+            if (line.rfind("FORMAT=", 0) == 0 && line != "FORMAT=32-bit_rle_rgbe")
+            {
+                return false; // XYZE and other formats are left to the fallback loader
+            }
+        }
+
+        int width = 0;
+        int height = 0;
+        if (!readLine(p, end, line) || std::sscanf(line.c_str(), "-Y %d +X %d", &height, &width) != 2 ||
+            width <= 0 || height <= 0)
+        {
+            return false;
+        }
+
+        // Locate every scanline first. This pass only reads the run headers, which is what allows the
+        // actual decode to be split across threads since compressed scanlines have variable length.
+        std::vector<const uint8_t*> scanlines(height);
+        std::vector<uint8_t> isRle(height);
+        for (int y = 0; y < height; y++)
+        {
+            scanlines[y] = p;
+            isRle[y] = isRleScanline(p, end, width);
+            if (isRle[y])
+            {
+                p = walkRleScanline(p, end, width, nullptr);
+                if (!p) { return false; }
+            }
+            else
+            {
+                // Flat scanline of raw RGBE pixels. Old style run-length encoding is left to the fallback loader.
+                if (end - p < static_cast<std::ptrdiff_t>(width) * 4 || hasOldStyleRuns(p, width)) { return false; }
+                p += static_cast<size_t>(width) * 4;
+            }
+        }
+
+        image.width = width;
+        image.height = height;
+        image.pixels.resize(static_cast<size_t>(width) * height * 3);
+
+        Parallel::parallelFor(height, MIN_SCANLINES_PER_THREAD, [&](const unsigned int first, const unsigned int last)
+        {
+            std::vector<uint8_t> rgbe(static_cast<size_t>(width) * 4);
+            std::vector<float> rgb(static_cast<size_t>(width) * 3);
+            for (unsigned int y = first; y < last; y++)
+            {
+                const uint8_t* scanline = scanlines[y];
+                if (isRle[y])
+                {
+                    walkRleScanline(scanline, end, width, rgbe.data());
+                }
+                else
+                {
+                    std::memcpy(rgbe.data(), scanline, rgbe.size());
+                }
+                rgbeToFloat(rgbe.data(), rgb.data(), width);
+
+                // Radiance files store the top row first, OpenGL expects the bottom row first
+                const size_t row = static_cast<size_t>(height - 1 - y);
+                floatToHalf(rgb.data(), image.pixels.data() + row * width * 3, rgb.size());
+            }
+        });
+
+        return true;
+    }
+}
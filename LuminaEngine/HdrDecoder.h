@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct HdrImage
+{
+    int width = 0;
+    int height = 0;
+    // Tightly packed RGB half-floats, bottom row first to match the OpenGL texture origin
+    std::vector<uint16_t> pixels;
+};
+
+// Radiance (.hdr) decoder that expands RGBE scanlines straight into half-floats. Scanlines are located
+// in a quick sequential pass and then decoded in parallel, so the image never exists as 32-bit floats.
+namespace HdrDecoder
+{
+    /// <summary>
+    /// Decodes a Radiance RGBE file with the standard "-Y height +X width" orientation.
+    /// Returns false for unsupported or malformed files, old style run-length encoding included, so callers
+    /// can fall back to another loader.
+    /// </summary>
+    bool decodeRgbe(const std::string& filePath, HdrImage& image);
+
+    /// <summary>
+    /// Converts floats to IEEE half-floats (round to nearest even), using F16C when the CPU has it
+    /// </summary>
+    void floatToHalf(const float* src, uint16_t* dst, size_t count);
+}
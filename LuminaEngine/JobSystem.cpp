@@ -0,0 +1,407 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace
+{
+    struct Job
+    {
+        std::function<void()> func;
+        JobCounter* counter;
+    };
+
+    // Chase-Lev deque with a fixed capacity. The owning worker pushes and pops at the bottom, any other
+    // thread steals from the top, and only the last job is contended.
+    class WorkStealingDeque
+    {
+    public:
+        static constexpr int64_t CAPACITY = 4096;
+
+        // Owner only, false when full
+        bool push(Job* job)
+        {
+            const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+            const int64_t top = mTop.load(std::memory_order_acquire);
+            if (bottom - top >= CAPACITY) { return false; }
+
+            mJobs[bottom & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Owner only
+        Job* pop()
+        {
+            const int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+            mBottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t top = mTop.load(std::memory_order_relaxed);
+            if (top > bottom)
+            {
+                mBottom.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            Job* job = mJobs[bottom & (CAPACITY - 1)].load(std::memory_order_relaxed);
+            if (top == bottom)
+            {
+                // Last job, race the thieves for it
+                if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed))
+                {
+                    job = nullptr;
+                }
+                mBottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+
+        Job* steal()
+        {
+            int64_t top = mTop.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t bottom = mBottom.load(std::memory_order_acquire);
+            if (top >= bottom) { return nullptr; }
+
+            Job* job = mJobs[top & (CAPACITY - 1)].load(std::memory_order_relaxed);
+            if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return nullptr;
+            }
+            return job;
+        }
+
+    private:
+        alignas(64) std::atomic<int64_t> mTop{0};
+        alignas(64) std::atomic<int64_t> mBottom{0};
+        std::array<std::atomic<Job*>, CAPACITY> mJobs{};
+    };
+
+    // Index of the worker's deque, -1 on threads the scheduler did not start
+    thread_local int workerIndex = -1;
+}
+
+namespace JobSystem
+{
+    struct Scheduler
+    {
+        Scheduler()
+        {
+            // The thread waiting on jobs runs them as well, so one core is left to it
+            const unsigned int threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+            workerLimit = threadCount + 1;
+            for (unsigned int i = 0; i < threadCount; i++)
+            {
+                deques.push_back(std::make_unique<WorkStealingDeque>());
+            }
+            for (unsigned int i = 0; i < threadCount; i++)
+            {
+                threads.emplace_back(&Scheduler::workerThread, this, static_cast<int>(i));
+            }
+        }
+
+        ~Scheduler()
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                stop = true;
+            }
+            wake.notify_all();
+            for (std::thread& thread : threads) { thread.join(); }
+            for (Job* job : freeJobs) { delete job; }
+        }
+
+        // Finished jobs are kept for reuse, so a steady stream of jobs stops allocating once the pool
+        // has grown to the most jobs in flight at once
+        Job* acquire(std::function<void()> func, JobCounter* counter)
+        {
+            Job* job = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(poolMutex);
+                if (!freeJobs.empty())
+                {
+                    job = freeJobs.back();
+                    freeJobs.pop_back();
+                }
+            }
+            if (!job) { return new Job{std::move(func), counter}; }
+            job->func = std::move(func);
+            job->counter = counter;
+            return job;
+        }
+
+        void recycle(Job* job)
+        {
+            // Drops the captures now rather than when the job is next reused
+            job->func = nullptr;
+            std::lock_guard<std::mutex> lock(poolMutex);
+            freeJobs.push_back(job);
+        }
+
+        void submit(Job* job)
+        {
+            if (workerIndex < 0 || !deques[workerIndex]->push(job))
+            {
+                std::lock_guard<std::mutex> lock(sharedMutex);
+                pushShared(job);
+                sharedCount.fetch_add(1, std::memory_order_release);
+            }
+            workEpoch.fetch_add(1, std::memory_order_seq_cst);
+            // Pairs with the sleeper count raised before a worker checks the epoch, one of the two sees the other
+            if (sleepers.load(std::memory_order_seq_cst) > 0)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(sleepMutex);
+                }
+                wake.notify_all();
+            }
+        }
+
+        Job* findJob()
+        {
+            if (workerIndex >= 0)
+            {
+                if (Job* job = deques[workerIndex]->pop()) { return job; }
+            }
+            if (sharedCount.load(std::memory_order_acquire) > 0)
+            {
+                std::lock_guard<std::mutex> lock(sharedMutex);
+                if (sharedSize > 0)
+                {
+                    Job* job = sharedJobs[sharedHead];
+                    sharedHead = (sharedHead + 1) % sharedJobs.size();
+                    sharedSize--;
+                    sharedCount.fetch_sub(1, std::memory_order_relaxed);
+                    return job;
+                }
+            }
+            // Start at a different victim on every thread so thieves do not pile onto the same deque
+            const auto dequeCount = static_cast<int>(deques.size());
+            const int first = workerIndex >= 0 ? workerIndex + 1 : 0;
+            for (int i = 0; i < dequeCount; i++)
+            {
+                const int victim = (first + i) % dequeCount;
+                if (victim == workerIndex) { continue; }
+                if (Job* job = deques[victim]->steal()) { return job; }
+            }
+            return nullptr;
+        }
+
+        // Caller holds sharedMutex. The ring only grows, a std::deque would free and allocate blocks as
+        // jobs pass through it.
+        void pushShared(Job* job)
+        {
+            if (sharedSize == sharedJobs.size())
+            {
+                std::vector<Job*> grown(std::max<size_t>(64, sharedJobs.size() * 2));
+                for (size_t i = 0; i < sharedSize; i++)
+                {
+                    grown[i] = sharedJobs[(sharedHead + i) % sharedJobs.size()];
+                }
+                sharedJobs.swap(grown);
+                sharedHead = 0;
+            }
+            sharedJobs[(sharedHead + sharedSize) % sharedJobs.size()] = job;
+            sharedSize++;
+        }
+
+        void execute(Job* job)
+        {
+            job->func();
+            finish(job->counter);
+            recycle(job);
+        }
+
+        void finish(JobCounter* counter)
+        {
+            if (!counter) { return; }
+
+            // Counts above one drop without the lock, the last one drops under it so no waiter returns
+            // and frees the counter while its continuations are still being taken
+            unsigned int pending = counter->mPending.load(std::memory_order_relaxed);
+            while (pending > 1)
+            {
+                if (counter->mPending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel))
+                {
+                    return;
+                }
+            }
+
+            std::vector<JobCounter::Continuation> ready;
+            {
+                std::lock_guard<std::mutex> lock(counter->mMutex);
+                if (counter->mPending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    ready.swap(counter->mContinuations);
+                }
+            }
+            for (JobCounter::Continuation& continuation : ready)
+            {
+                submit(acquire(std::move(continuation.job), continuation.counter));
+            }
+        }
+
+        static void count(JobCounter* counter)
+        {
+            if (counter) { counter->mPending.fetch_add(1, std::memory_order_relaxed); }
+        }
+
+        void submitAfter(JobCounter& dependency, Job* job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(dependency.mMutex);
+                if (dependency.mPending.load(std::memory_order_acquire) != 0)
+                {
+                    dependency.mContinuations.push_back({std::move(job->func), job->counter});
+                    recycle(job);
+                    return;
+                }
+            }
+            submit(job);
+        }
+
+        void wait(JobCounter& counter)
+        {
+            while (counter.mPending.load(std::memory_order_acquire) != 0)
+            {
+                if (Job* job = findJob())
+                {
+                    execute(job);
+                    continue;
+                }
+                std::this_thread::yield();
+            }
+            // The last job may still be handing out the continuations
+            std::lock_guard<std::mutex> lock(counter.mMutex);
+        }
+
+        void workerThread(const int index)
+        {
+            workerIndex = index;
+            while (true)
+            {
+                const uint64_t epoch = workEpoch.load(std::memory_order_seq_cst);
+                // Workers over the limit only sleep, the limit counts the waiting thread as well
+                if (static_cast<unsigned int>(index) + 1 < workerLimit.load(std::memory_order_relaxed))
+                {
+                    if (Job* job = findJob())
+                    {
+                        execute(job);
+                        continue;
+                    }
+                }
+
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                sleepers.fetch_add(1, std::memory_order_seq_cst);
+                wake.wait(lock, [&] { return stop || workEpoch.load(std::memory_order_seq_cst) != epoch; });
+                sleepers.fetch_sub(1, std::memory_order_relaxed);
+                if (stop) { return; }
+            }
+        }
+
+        std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+        std::vector<std::thread> threads;
+        std::atomic<unsigned int> workerLimit{1};
+
+        // Jobs queued from threads without a deque, or by workers whose deque is full
+        std::mutex sharedMutex;
+        std::vector<Job*> sharedJobs; // Ring of sharedSize jobs starting at sharedHead
+        size_t sharedHead = 0;
+        size_t sharedSize = 0;
+        std::atomic<size_t> sharedCount{0};
+
+        std::mutex poolMutex;
+        std::vector<Job*> freeJobs;
+
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        std::atomic<uint64_t> workEpoch{0};
+        std::atomic<unsigned int> sleepers{0};
+        bool stop = false;
+
+        std::mutex mainThreadMutex;
+        std::vector<Job> mainThreadJobs;
+        std::vector<Job> runningMainThreadJobs; // Only touched by the main thread, kept for its capacity
+    };
+
+    namespace
+    {
+        Scheduler& scheduler()
+        {
+            static Scheduler instance;
+            return instance;
+        }
+    }
+
+    unsigned int workerCount()
+    {
+        return std::min(scheduler().workerLimit.load(std::memory_order_relaxed), maxWorkerCount());
+    }
+
+    unsigned int maxWorkerCount()
+    {
+        return static_cast<unsigned int>(scheduler().threads.size()) + 1;
+    }
+
+    void setWorkerLimit(const unsigned int limit)
+    {
+        Scheduler& instance = scheduler();
+        instance.workerLimit.store(std::clamp(limit, 1u, maxWorkerCount()), std::memory_order_relaxed);
+        // Wakes the workers allowed back in
+        instance.workEpoch.fetch_add(1, std::memory_order_seq_cst);
+        {
+            std::lock_guard<std::mutex> lock(instance.sleepMutex);
+        }
+        instance.wake.notify_all();
+    }
+
+    void run(std::function<void()> job, JobCounter* counter)
+    {
+        Scheduler::count(counter);
+        Scheduler& instance = scheduler();
+        instance.submit(instance.acquire(std::move(job), counter));
+    }
+
+    void runAfter(JobCounter& dependency, std::function<void()> job, JobCounter* counter)
+    {
+        Scheduler::count(counter);
+        Scheduler& instance = scheduler();
+        instance.submitAfter(dependency, instance.acquire(std::move(job), counter));
+    }
+
+    void wait(JobCounter& counter)
+    {
+        scheduler().wait(counter);
+    }
+
+    void runOnMainThread(std::function<void()> job, JobCounter* counter)
+    {
+        Scheduler::count(counter);
+        Scheduler& instance = scheduler();
+        std::lock_guard<std::mutex> lock(instance.mainThreadMutex);
+        instance.mainThreadJobs.push_back({std::move(job), counter});
+    }
+
+    void runMainThreadJobs()
+    {
+        Scheduler& instance = scheduler();
+        std::vector<Job>& jobs = instance.runningMainThreadJobs;
+        {
+            std::lock_guard<std::mutex> lock(instance.mainThreadMutex);
+            jobs.swap(instance.mainThreadJobs);
+        }
+        // Jobs queued while these run wait for the next call
+        for (Job& job : jobs)
+        {
+            job.func();
+            instance.finish(job.counter);
+        }
+        jobs.clear();
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace JobSystem
+{
+    struct Scheduler;
+}
+
+/// <summary>
+/// Counts the unfinished jobs run with it. Jobs queued with runAfter start once it drops to zero. Must
+/// outlive its jobs, wait on it before it goes out of scope.
+/// </summary>
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+private:
+    friend struct JobSystem::Scheduler;
+
+    struct Continuation
+    {
+        std::function<void()> job;
+        JobCounter* counter;
+    };
+
+    std::atomic<unsigned int> mPending{0};
+    // Only taken when the count may reach zero and by runAfter, never for every finished job
+    std::mutex mMutex;
+    std::vector<Continuation> mContinuations;
+};
+
+/// <summary>
+/// Work stealing job scheduler shared by the whole engine. Every background worker owns a lock-free
+/// deque, it runs its own jobs newest first and steals the oldest jobs of the others when it runs dry.
+/// Jobs queued from other threads go through a shared queue. Threads waiting on a counter run jobs
+/// until it is done, so jobs may queue and wait on further jobs. Jobs must not touch OpenGL, work that
+/// needs the context goes through runOnMainThread.
+/// </summary>
+namespace JobSystem
+{
+    /// <summary>
+    /// Threads running jobs, counting the one waiting on them
+    /// </summary>
+    unsigned int workerCount();
+    unsigned int maxWorkerCount();
+    /// <summary>
+    /// Caps the threads running jobs, for measuring how the engine scales across core counts
+    /// </summary>
+    void setWorkerLimit(unsigned int limit);
+
+    void run(std::function<void()> job, JobCounter* counter = nullptr);
+    /// <summary>
+    /// Starts the job once every job counted by the dependency has finished
+    /// </summary>
+    void runAfter(JobCounter& dependency, std::function<void()> job, JobCounter* counter = nullptr);
+    /// <summary>
+    /// Runs queued jobs on the calling thread until every job counted by the counter has finished
+    /// </summary>
+    void wait(JobCounter& counter);
+
+    /// <summary>
+    /// Queues work for the thread owning the OpenGL context. Jobs must never wait on it, the main thread
+    /// may be waiting on them.
+    /// </summary>
+    void runOnMainThread(std::function<void()> job, JobCounter* counter = nullptr);
+    /// <summary>
+    /// Runs the work queued with runOnMainThread, on the thread owning the OpenGL context
+    /// </summary>
+    void runMainThreadJobs();
+}
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <glad/glad.h>
+#include "GpuMemory.h"
 
 LightPreview::LightPreview() : vao(0), indexCount(0)
 {
@@ -85,8 +86,11 @@ void LightPreview::setup()
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+    GpuMemory::track(GpuResourceType::Buffer, vbo, data.size() * sizeof(float), "Geometry", "Light preview vertices");
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    GpuMemory::track(GpuResourceType::Buffer, ebo, indices.size() * sizeof(unsigned int), "Geometry",
+                     "Light preview indices");
     constexpr unsigned int stride = (3 + 2 + 3) * sizeof(float);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
@@ -1,14 +1,91 @@
 #include "Mesh.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
 #include <glad/glad.h>
+#include "GpuMemory.h"
+
+namespace
+{
+    // Every active sampler needs a unit no sampler of another type points at, otherwise draws fail with
+    // GL_INVALID_OPERATION. The samplers of the texture family a mesh does not use are parked on these.
+    constexpr unsigned int IDLE_TEXTURE_UNIT = 12;
+    constexpr unsigned int IDLE_ARRAY_TEXTURE_UNIT = 13;
+
+    const char* MATERIAL_SAMPLERS[] =
+    {
+        "material.texture_diffuse1", "material.texture_specular1", "material.texture_normal1",
+        "materialPbr.texture_albedo1", "materialPbr.texture_metallic1", "materialPbr.texture_roughness1",
+        "materialPbr.texture_normal1", "materialPbr.texture_ao1"
+    };
+
+    const char* MATERIAL_ARRAY_SAMPLERS[] =
+    {
+        "materialArrays.texture_diffuse", "materialArrays.texture_specular", "materialArrays.texture_albedo",
+        "materialArrays.texture_metallic", "materialArrays.texture_roughness", "materialArrays.texture_normal",
+        "materialArrays.texture_ao"
+    };
+
+    const char* FRUSTUM_PLANE_UNIFORMS[] =
+    {
+        "frustumPlanes[0]", "frustumPlanes[1]", "frustumPlanes[2]", "frustumPlanes[3]", "frustumPlanes[4]",
+        "frustumPlanes[5]"
+    };
+
+    constexpr unsigned int CULL_GROUP_SIZE = 64;
+
+    // std430 layouts of the buffers read and written by shader_cull.comp
+    struct GpuSubMesh
+    {
+        glm::vec4 sphere;
+        glm::uvec4 range;
+    };
+
+    std::vector<GpuSubMesh> toGpuSubMeshes(const std::vector<SubMesh>& subMeshes)
+    {
+        std::vector<GpuSubMesh> gpuSubMeshes;
+        gpuSubMeshes.reserve(subMeshes.size());
+        for (const SubMesh& subMesh : subMeshes)
+        {
+            gpuSubMeshes.push_back({glm::vec4(subMesh.boundsCenter, subMesh.boundsRadius),
+                                    glm::uvec4(subMesh.firstIndex, subMesh.indexCount, 0, 0)});
+        }
+        return gpuSubMeshes;
+    }
+
+    // Vertex of the depth only stream
+    struct DepthVertex
+    {
+        glm::vec3 position;
+        unsigned int node;
+    };
+
+    struct DrawElementsIndirectCommand
+    {
+        unsigned int count;
+        unsigned int instanceCount;
+        unsigned int firstIndex;
+        int baseVertex;
+        unsigned int baseInstance;
+    };
+}
 
 Mesh::Mesh(const std::vector<Vertex>& verticies,
            const std::vector<unsigned int>& indices,
            const std::vector<Texture>& textures,
-           const bool isPbr)
-    : verticies(verticies), indices(indices), textures(textures), isPbr(isPbr)
+           const bool isPbr,
+           const std::vector<SubMesh>& subMeshes)
+    : verticies(verticies), indices(indices), textures(textures), subMeshes(subMeshes), isPbr(isPbr)
 {
+    if (this->subMeshes.empty())
+    {
+        this->subMeshes.push_back({0, static_cast<unsigned int>(indices.size()), glm::vec3(0.0f), 0.0f});
+    }
     setupMesh();
+    computeBounds();
 }
 
 void Mesh::setupMesh()
@@ -28,6 +105,11 @@ void Mesh::setupMesh()
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
+    const std::string owner = "Mesh " + std::to_string(vao);
+    GpuMemory::track(GpuResourceType::Buffer, vbo, verticies.size() * sizeof(Vertex), "Geometry", owner + " vertices");
+    GpuMemory::track(GpuResourceType::Buffer, ebo, indices.size() * sizeof(unsigned int), "Geometry",
+                     owner + " indices");
+
     // Vertex positions
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -40,11 +122,283 @@ void Mesh::setupMesh()
     // Vertex tangent
     glEnableVertexAttribArray(3);
     glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
+    // Material layer
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, materialLayer));
+    // Node, an integer attribute
+    glEnableVertexAttribArray(5);
+    glVertexAttribIPointer(5, 1, GL_UNSIGNED_INT, sizeof(Vertex), (void*)offsetof(Vertex, node));
+
+    // Position only stream for depth passes, with the node to place the positions
+    std::vector<DepthVertex> positions;
+    positions.reserve(verticies.size());
+    for (const Vertex& vertex : verticies) { positions.push_back({vertex.position, vertex.node}); }
+    glGenVertexArrays(1, &depthVao);
+    glGenBuffers(1, &positionVbo);
+    glBindVertexArray(depthVao);
+    glBindBuffer(GL_ARRAY_BUFFER, positionVbo);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(DepthVertex), positions.data(), GL_STATIC_DRAW);
+    GpuMemory::track(GpuResourceType::Buffer, positionVbo, positions.size() * sizeof(DepthVertex), "Geometry",
+                     owner + " positions");
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DepthVertex), (void*)0);
+    glEnableVertexAttribArray(5);
+    glVertexAttribIPointer(5, 1, GL_UNSIGNED_INT, sizeof(DepthVertex), (void*)offsetof(DepthVertex, node));
 
     glBindVertexArray(0); // Unbind
 }
 
+void Mesh::setupIndirect()
+{
+    const std::vector<GpuSubMesh> gpuSubMeshes = toGpuSubMeshes(subMeshes);
+    glGenBuffers(1, &subMeshBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, subMeshBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, gpuSubMeshes.size() * sizeof(GpuSubMesh), gpuSubMeshes.data(), GL_STATIC_DRAW);
+
+    // Written by the cull pass every frame and only ever read by the GPU
+    glGenBuffers(1, &commandBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, subMeshes.size() * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    const std::string owner = "Mesh " + std::to_string(vao);
+    GpuMemory::track(GpuResourceType::Buffer, subMeshBuffer, gpuSubMeshes.size() * sizeof(GpuSubMesh), "Culling",
+                     owner + " sub meshes");
+    GpuMemory::track(GpuResourceType::Buffer, commandBuffer, subMeshes.size() * sizeof(DrawElementsIndirectCommand),
+                     "Culling", owner + " draw commands");
+}
+
+void Mesh::placeSubMeshes(const SceneGraph& sceneGraph)
+{
+    glm::vec3 minBound(std::numeric_limits<float>::max());
+    glm::vec3 maxBound(std::numeric_limits<float>::lowest());
+    for (SubMesh& subMesh : subMeshes)
+    {
+        const glm::mat4& world = sceneGraph.worldTransform(subMesh.node);
+        const float maxScale = std::max({glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])),
+                                         glm::length(glm::vec3(world[2]))});
+        subMesh.boundsCenter = glm::vec3(world * glm::vec4(subMesh.localCenter, 1.0f));
+        subMesh.boundsRadius = subMesh.localRadius * maxScale;
+        minBound = glm::min(minBound, subMesh.boundsCenter - glm::vec3(subMesh.boundsRadius));
+        maxBound = glm::max(maxBound, subMesh.boundsCenter + glm::vec3(subMesh.boundsRadius));
+    }
+
+    boundsCenter = (minBound + maxBound) * 0.5f;
+    boundsRadius = 0.0f;
+    for (const SubMesh& subMesh : subMeshes)
+    {
+        boundsRadius = std::max(boundsRadius, glm::length(subMesh.boundsCenter - boundsCenter) + subMesh.boundsRadius);
+    }
+
+    // The GPU culling pass reads the sub mesh spheres from its own copy
+    if (subMeshBuffer)
+    {
+        const std::vector<GpuSubMesh> gpuSubMeshes = toGpuSubMeshes(subMeshes);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, subMeshBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, gpuSubMeshes.size() * sizeof(GpuSubMesh), gpuSubMeshes.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+}
+
+void Mesh::computeBounds()
+{
+    boundsCenter = glm::vec3(0.0f);
+    boundsRadius = 0.0f;
+    uvDensity = 0.0f;
+    if (verticies.empty()) { return; }
+
+    glm::vec3 minBound = verticies[0].position;
+    glm::vec3 maxBound = verticies[0].position;
+    for (const Vertex& vertex : verticies)
+    {
+        minBound = glm::min(minBound, vertex.position);
+        maxBound = glm::max(maxBound, vertex.position);
+    }
+    boundsCenter = (minBound + maxBound) * 0.5f;
+    for (const Vertex& vertex : verticies)
+    {
+        boundsRadius = std::max(boundsRadius, glm::length(vertex.position - boundsCenter));
+    }
+
+    for (SubMesh& subMesh : subMeshes)
+    {
+        if (subMesh.indexCount == 0) { continue; }
+        minBound = verticies[indices[subMesh.firstIndex]].position;
+        maxBound = minBound;
+        for (unsigned int i = subMesh.firstIndex; i < subMesh.firstIndex + subMesh.indexCount; i++)
+        {
+            minBound = glm::min(minBound, verticies[indices[i]].position);
+            maxBound = glm::max(maxBound, verticies[indices[i]].position);
+        }
+        subMesh.localCenter = (minBound + maxBound) * 0.5f;
+        subMesh.localRadius = 0.0f;
+        for (unsigned int i = subMesh.firstIndex; i < subMesh.firstIndex + subMesh.indexCount; i++)
+        {
+            subMesh.localRadius = std::max(subMesh.localRadius,
+                                           glm::length(verticies[indices[i]].position - subMesh.localCenter));
+        }
+        // Node space until placeSubMeshes places them
+        subMesh.boundsCenter = subMesh.localCenter;
+        subMesh.boundsRadius = subMesh.localRadius;
+    }
+
+    // Ratio of the total UV area to the total surface area gives the texture coordinate density
+    double surfaceArea = 0.0;
+    double uvArea = 0.0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const Vertex& v0 = verticies[indices[i]];
+        const Vertex& v1 = verticies[indices[i + 1]];
+        const Vertex& v2 = verticies[indices[i + 2]];
+        surfaceArea += 0.5 * glm::length(glm::cross(v1.position - v0.position, v2.position - v0.position));
+        const glm::vec2 uv1 = v1.texCoords - v0.texCoords;
+        const glm::vec2 uv2 = v2.texCoords - v0.texCoords;
+        uvArea += 0.5 * std::abs(uv1.x * uv2.y - uv1.y * uv2.x);
+    }
+    if (surfaceArea > 0.0)
+    {
+        uvDensity = static_cast<float>(std::sqrt(uvArea / surfaceArea));
+    }
+}
+
 unsigned int Mesh::Draw(Shader& shader)
+{
+    bindTextures(shader);
+
+    // Draw
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+
+    return indices.size();
+}
+
+void Mesh::resolveMaterial(Shader& shader)
+{
+    resolveBinding(shader.getProgramID(), material);
+}
+
+void Mesh::bindMaterial() const
+{
+    applyBinding(material);
+}
+
+void Mesh::resolveBinding(const unsigned int program, MaterialBinding& binding) const
+{
+    std::vector<std::pair<std::string, int>> uniforms;
+    binding.program = program;
+    binding.uniforms.clear();
+    binding.textures.clear();
+    collectMaterial(uniforms, binding.textures);
+
+    for (const auto& [name, value] : uniforms)
+    {
+        binding.uniforms.emplace_back(glGetUniformLocation(program, name.c_str()), value);
+    }
+}
+
+void Mesh::applyBinding(const MaterialBinding& resolved)
+{
+    for (const auto& [location, value] : resolved.uniforms) { glUniform1i(location, value); }
+    for (const TextureBinding& binding : resolved.textures)
+    {
+        // Activate proper texture unit before binding
+        glActiveTexture(GL_TEXTURE0 + binding.unit);
+        glBindTexture(binding.target, binding.id);
+    }
+    // Reset active texture unit to 0 as a good practice. This is not mandatory.
+    // https://community.khronos.org/t/glactivetexture-before-drawing/73757/2
+    glActiveTexture(GL_TEXTURE0);
+}
+
+unsigned int Mesh::DrawRange(const unsigned int firstIndex, const unsigned int indexCount)
+{
+    // The caller unbinds the vertex array after its last range
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT,
+                   reinterpret_cast<const void*>(static_cast<uintptr_t>(firstIndex) * sizeof(unsigned int)));
+    return indexCount;
+}
+
+unsigned int Mesh::DrawIndirect(Shader& shader, Shader& cullShader, const std::array<glm::vec4, 6>& frustumPlanes)
+{
+    cullSubMeshes(cullShader, frustumPlanes);
+    shader.use();
+    return DrawCulledIndirect(shader);
+}
+
+unsigned int Mesh::DrawCulledIndirect(Shader& shader)
+{
+    bindTextures(shader);
+
+    // Culled commands have no instances, so the draw count stays fixed and is never read back
+    glBindVertexArray(vao);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(subMeshes.size()), 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+
+    return indices.size();
+}
+
+unsigned int Mesh::DrawDepth()
+{
+    glBindVertexArray(depthVao);
+    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+
+    return indices.size();
+}
+
+unsigned int Mesh::DrawDepthIndirect(Shader& depthShader, Shader& cullShader,
+                                     const std::array<glm::vec4, 6>& frustumPlanes)
+{
+    cullSubMeshes(cullShader, frustumPlanes);
+    depthShader.use();
+
+    glBindVertexArray(depthVao);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(subMeshes.size()), 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+
+    return indices.size();
+}
+
+void Mesh::cullSubMeshes(Shader& cullShader, const std::array<glm::vec4, 6>& frustumPlanes)
+{
+    if (!commandBuffer) { setupIndirect(); }
+
+    // Cull pass, one thread per sub mesh
+    cullShader.use();
+    for (size_t i = 0; i < frustumPlanes.size(); i++)
+    {
+        cullShader.setVec4(FRUSTUM_PLANE_UNIFORMS[i], frustumPlanes[i]);
+    }
+    cullShader.setInt("subMeshCount", static_cast<int>(subMeshes.size()));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, subMeshBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, commandBuffer);
+    glDispatchCompute((static_cast<unsigned int>(subMeshes.size()) + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
+
+void Mesh::bindTextures(Shader& shader)
+{
+    // The uniform names are only built the first time the mesh is drawn with a program
+    const unsigned int program = shader.getProgramID();
+    auto binding = std::find_if(drawMaterials.begin(), drawMaterials.end(),
+                                [program](const MaterialBinding& candidate) { return candidate.program == program; });
+    if (binding == drawMaterials.end())
+    {
+        binding = drawMaterials.emplace(drawMaterials.end());
+        resolveBinding(program, *binding);
+    }
+    applyBinding(*binding);
+}
+
+void Mesh::collectMaterial(std::vector<std::pair<std::string, int>>& uniforms,
+                           std::vector<TextureBinding>& bindings) const
 {
     unsigned int albedoNr = 1;
     unsigned int metallicNr = 1;
@@ -55,17 +409,34 @@ unsigned int Mesh::Draw(Shader& shader)
     unsigned int specularNr = 1;
     unsigned int normalNr = 1;
 
-    shader.setBool("isPbr", isPbr);
+    uniforms.emplace_back("isPbr", isPbr);
 
-    for (unsigned int i = 0; i < textures.size(); i++)
+    // Materials are either packed into texture arrays as a whole or not at all
+    const bool useMaterialArrays = !textures.empty() && textures[0].isArray;
+    uniforms.emplace_back("useMaterialArrays", useMaterialArrays);
+    if (useMaterialArrays)
     {
-        // Activate proper texture unit before binding
-        glActiveTexture(GL_TEXTURE0 + i);
+        for (const char* sampler : MATERIAL_SAMPLERS) { uniforms.emplace_back(sampler, IDLE_TEXTURE_UNIT); }
+    }
+    else
+    {
+        for (const char* sampler : MATERIAL_ARRAY_SAMPLERS) { uniforms.emplace_back(sampler, IDLE_ARRAY_TEXTURE_UNIT); }
+    }
 
+    for (unsigned int i = 0; i < textures.size(); i++)
+    {
         std::string number;
         std::string name = textures[i].type;
         std::string materialName;
 
+        if (textures[i].isArray)
+        {
+            // All materials of the batch share the arrays, the layer comes from the vertices
+            uniforms.emplace_back("materialArrays." + name, i);
+            bindings.push_back({i, GL_TEXTURE_2D_ARRAY, textures[i].id});
+            continue;
+        }
+
         if (name == "texture_normal")
         {
             number = std::to_string(normalNr++);
@@ -106,19 +477,9 @@ unsigned int Mesh::Draw(Shader& shader)
             materialName.append("material.").append(name).append(number);
         }
 
-        shader.setInt(materialName, i);
-        glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        uniforms.emplace_back(materialName, i);
+        bindings.push_back({i, GL_TEXTURE_2D, textures[i].id});
     }
-    // Reset active texture unit to 0 as a good practice. This is not mandatory.
-    // https://community.khronos.org/t/glactivetexture-before-drawing/73757/2
-    glActiveTexture(GL_TEXTURE0);
-
-    // Draw
-    glBindVertexArray(vao);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-
-    return indices.size();
 }
 
 void Mesh::deinit()
@@ -126,7 +487,19 @@ void Mesh::deinit()
     // Doing cleanup in a separate function instead of the destructor because these meshes are stored
     // in a std::vector at Model class. Each time this vector grows, it deletes and recreate these
     // meshes so the OpenGL objects loses their references.
+    GpuMemory::release(GpuResourceType::Buffer, vbo);
+    GpuMemory::release(GpuResourceType::Buffer, ebo);
+    GpuMemory::release(GpuResourceType::Buffer, positionVbo);
     glDeleteBuffers(1, &vbo);
     glDeleteBuffers(1, &ebo);
+    glDeleteBuffers(1, &positionVbo);
     glDeleteVertexArrays(1, &vao);
+    glDeleteVertexArrays(1, &depthVao);
+    if (commandBuffer)
+    {
+        GpuMemory::release(GpuResourceType::Buffer, subMeshBuffer);
+        GpuMemory::release(GpuResourceType::Buffer, commandBuffer);
+        glDeleteBuffers(1, &subMeshBuffer);
+        glDeleteBuffers(1, &commandBuffer);
+    }
 }
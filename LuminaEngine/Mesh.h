@@ -1,8 +1,11 @@
 #pragma once
 
+#include <array>
 #include <glm/glm.hpp>
 #include <string>
+#include <utility>
 #include <vector>
+#include "SceneGraph.h"
 #include "Shader.h"
 
 struct Vertex
@@ -11,6 +14,8 @@ struct Vertex
     glm::vec3 normal;
     glm::vec2 texCoords;
     glm::vec3 tangent;
+    float materialLayer; // Layer of the material in the texture arrays, when the mesh uses them
+    unsigned int node; // Scene graph node placing the vertex, the shaders fetch its world transform
 };
 
 struct Texture
@@ -18,6 +23,34 @@ struct Texture
     unsigned int id;
     std::string type;
     std::string name;
+    bool isArray = false; // GL_TEXTURE_2D_ARRAY shared by several materials
+};
+
+// Range of indices drawn and culled on its own, meshes merged for a texture array batch keep one per source mesh
+struct SubMesh
+{
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    glm::vec3 boundsCenter; // Model space, placed by the node's world transform
+    float boundsRadius;
+    int node = 0;
+    glm::vec3 localCenter = glm::vec3(0.0f); // Node space
+    float localRadius = 0.0f;
+};
+
+struct TextureBinding
+{
+    unsigned int unit;
+    unsigned int target;
+    unsigned int id;
+};
+
+// Material uniforms of a mesh resolved to the locations of one shader, bound without any name lookups
+struct MaterialBinding
+{
+    unsigned int program = 0;
+    std::vector<std::pair<int, int>> uniforms;
+    std::vector<TextureBinding> textures;
 };
 
 class Mesh
@@ -26,8 +59,46 @@ public:
     Mesh(const std::vector<Vertex>& verticies,
          const std::vector<unsigned int>& indices,
          const std::vector<Texture>& textures,
-         bool isPbr);
+         bool isPbr,
+         const std::vector<SubMesh>& subMeshes = {});
     unsigned int Draw(Shader& shader);
+    /// <summary>
+    /// GL 4.3+ path. A compute pass culls the sub meshes against the model space frustum planes and
+    /// writes their draw commands, then all of them are submitted with a single multi draw indirect call.
+    /// Returns the number of indices submitted before culling.
+    /// </summary>
+    unsigned int DrawIndirect(Shader& shader, Shader& cullShader, const std::array<glm::vec4, 6>& frustumPlanes);
+    /// <summary>
+    /// Submits the commands the last cull pass wrote, for a second pass over the same view
+    /// </summary>
+    unsigned int DrawCulledIndirect(Shader& shader);
+    /// <summary>
+    /// Draws from a position only vertex stream without binding any textures, for depth only passes.
+    /// The caller binds the shader.
+    /// </summary>
+    unsigned int DrawDepth();
+    /// <summary>
+    /// Culls like DrawIndirect, then draws the depth stream with depthShader
+    /// </summary>
+    unsigned int DrawDepthIndirect(Shader& depthShader, Shader& cullShader,
+                                   const std::array<glm::vec4, 6>& frustumPlanes);
+    /// <summary>
+    /// Looks up the material uniform locations in the shader once, for bindMaterial() to replay
+    /// </summary>
+    void resolveMaterial(Shader& shader);
+    /// <summary>
+    /// Binds the resolved material to the shader in use
+    /// </summary>
+    void bindMaterial() const;
+    /// <summary>
+    /// Draws a range of indices with whatever material is bound, leaving the vertex array bound
+    /// </summary>
+    unsigned int DrawRange(unsigned int firstIndex, unsigned int indexCount);
+    /// <summary>
+    /// Places the sub mesh bounds by the world transforms of their nodes and recomputes the mesh bounds.
+    /// The verticies stay in node space, the vertex shaders place them.
+    /// </summary>
+    void placeSubMeshes(const SceneGraph& sceneGraph);
     void deinit();
 
 public:
@@ -35,13 +106,36 @@ public:
     std::vector<Vertex>         verticies;
     std::vector<unsigned int>   indices;
     std::vector<Texture>        textures;
+    std::vector<SubMesh>        subMeshes;
+
+    // Model space bounding sphere and the average number of texture coordinate units per model space
+    // unit, used to estimate the on-screen texel density of the mesh for texture streaming
+    glm::vec3 boundsCenter;
+    float boundsRadius;
+    float uvDensity;
 
 private:
     void setupMesh();
+    void setupIndirect();
+    void computeBounds();
+    void bindTextures(Shader& shader);
+    void resolveBinding(unsigned int program, MaterialBinding& binding) const;
+    static void applyBinding(const MaterialBinding& binding);
+    void collectMaterial(std::vector<std::pair<std::string, int>>& uniforms, std::vector<TextureBinding>& bindings) const;
+    void cullSubMeshes(Shader& cullShader, const std::array<glm::vec4, 6>& frustumPlanes);
 
 private:
     unsigned int vao;
     unsigned int vbo;
     unsigned int ebo;
+    // Tightly packed positions and nodes sharing ebo, a quarter of the vertex fetch bandwidth of the full layout
+    unsigned int depthVao;
+    unsigned int positionVbo;
+    unsigned int subMeshBuffer = 0;
+    unsigned int commandBuffer = 0;
+    MaterialBinding material; // Resolved by resolveMaterial, replayed by bindMaterial
+    // One binding per program drawn with through Draw and DrawIndirect, apart from material so another
+    // pass drawing the mesh never changes what bindMaterial replays
+    std::vector<MaterialBinding> drawMaterials;
     bool isPbr;
 };
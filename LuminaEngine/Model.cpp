@@ -1,38 +1,400 @@
 #include "Model.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
+#include "Frustum.h"
+#include "GpuMemory.h"
 #include "TextureUtils.h"
 
-Model::Model(const std::string& path, const bool isPbr) : isPbr(isPbr)
+namespace
+{
+    // Occluders are the largest meshes with a triangle count the CPU rasterizer gets through quickly
+    constexpr size_t MAX_OCCLUDER_TRIANGLES = 4096;
+    constexpr size_t MAX_OCCLUDER_TRIANGLES_TOTAL = 32768;
+    constexpr float MIN_OCCLUDER_SIZE = 0.1f; // Of the model's bounding radius
+
+    // Picks the block compression format for a material slot. Falls back to uncompressed textures
+    // when the driver does not support the preferred codec.
+    TextureCodec selectCodec(const aiTextureType type, const bool isPbr, const bool srgb)
+    {
+        TextureCodec codec = TextureCodec::None;
+        switch (type)
+        {
+            case aiTextureType_NORMALS:
+                codec = TextureCodec::BC5;
+                break;
+            case aiTextureType_SPECULAR:
+            case aiTextureType_SHININESS:
+            case aiTextureType_AMBIENT:
+                // Metallic, roughness and AO are sampled as single channel maps in the PBR workflow
+                codec = isPbr ? TextureCodec::BC4 : TextureCodec::BC7;
+                break;
+            default:
+                codec = TextureCodec::BC7;
+                break;
+        }
+
+        if (codec == TextureCodec::BC7 && !TextureUtils::isCodecSupported(codec, srgb))
+        {
+            codec = TextureCodec::BC1;
+        }
+        return TextureUtils::isCodecSupported(codec, srgb) ? codec : TextureCodec::None;
+    }
+
+    // Diffuse and AO textures are almost always in the sRGB space. Therefore, only convert
+    // these textures into linear space when loading.
+    bool shouldCorrectGamma(const aiTextureType type)
+    {
+        return type == aiTextureType_DIFFUSE || type == aiTextureType_AMBIENT;
+    }
+
+    // Assimp matrices are row major
+    glm::mat4 toMat4(const aiMatrix4x4& m)
+    {
+        return glm::mat4(m.a1, m.b1, m.c1, m.d1,
+                         m.a2, m.b2, m.c2, m.d2,
+                         m.a3, m.b3, m.c3, m.d3,
+                         m.a4, m.b4, m.c4, m.d4);
+    }
+}
+
+Model::Model(const std::string& path, const bool isPbr, TextureStreamer* textureStreamer,
+             const bool packMaterialTextures)
+    : isPbr(isPbr), textureStreamer(textureStreamer), packMaterialTextures(packMaterialTextures)
 {
     loadModel(path);
 }
 
 Model::~Model()
 {
-    for (auto& [id, type, name] : texturesLoaded)
+    for (Texture& texture : texturesLoaded)
     {
-        glDeleteTextures(1, &id);
+        if (textureStreamer) { textureStreamer->removeTexture(texture.id); }
+        GpuMemory::release(GpuResourceType::Texture, texture.id);
+        glDeleteTextures(1, &texture.id);
+    }
+
+    for (unsigned int& textureArray : textureArrays)
+    {
+        GpuMemory::release(GpuResourceType::Texture, textureArray);
+        glDeleteTextures(1, &textureArray);
     }
 
     for (auto& mesh : meshes)
     {
         mesh.deinit();
     }
+
+    for (const unsigned int buffer : transformBuffers)
+    {
+        if (buffer) { GpuMemory::release(GpuResourceType::Buffer, buffer); }
+    }
+    glDeleteTextures(2, transformTextures);
+    glDeleteBuffers(2, transformBuffers);
 }
 
 unsigned int Model::Draw(Shader& shader)
 {
     unsigned int indiceCount = 0;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (meshOccluded[i]) { continue; }
+        indiceCount += meshes[i].Draw(shader);
+    }
+    return indiceCount;
+}
+
+unsigned int Model::DrawIndirect(Shader& shader, Shader& cullShader, const glm::mat4& modelViewProjection)
+{
+    const std::array<glm::vec4, 6> frustumPlanes = Frustum::extractPlanes(modelViewProjection);
+    unsigned int indiceCount = 0;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (meshOccluded[i]) { continue; }
+        indiceCount += meshes[i].DrawIndirect(shader, cullShader, frustumPlanes);
+    }
+    return indiceCount;
+}
+
+unsigned int Model::DrawCulledIndirect(Shader& shader)
+{
+    shader.use();
+    unsigned int indiceCount = 0;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (meshOccluded[i]) { continue; }
+        indiceCount += meshes[i].DrawCulledIndirect(shader);
+    }
+    return indiceCount;
+}
+
+unsigned int Model::DrawDepth(const bool skipOccluded)
+{
+    unsigned int indiceCount = 0;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (skipOccluded && meshOccluded[i]) { continue; }
+        indiceCount += meshes[i].DrawDepth();
+    }
+    return indiceCount;
+}
+
+unsigned int Model::DrawDepthIndirect(Shader& depthShader, Shader& cullShader, const glm::mat4& modelViewProjection)
+{
+    const std::array<glm::vec4, 6> frustumPlanes = Frustum::extractPlanes(modelViewProjection);
+    unsigned int indiceCount = 0;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (meshOccluded[i]) { continue; }
+        indiceCount += meshes[i].DrawDepthIndirect(depthShader, cullShader, frustumPlanes);
+    }
+    return indiceCount;
+}
+
+void Model::getBounds(glm::vec3& center, float& radius) const
+{
+    center = glm::vec3(0.0f);
+    radius = 0.0f;
+    if (meshes.empty()) { return; }
+
+    glm::vec3 minBound(std::numeric_limits<float>::max());
+    glm::vec3 maxBound(std::numeric_limits<float>::lowest());
+    for (const Mesh& mesh : meshes)
+    {
+        minBound = glm::min(minBound, mesh.boundsCenter - glm::vec3(mesh.boundsRadius));
+        maxBound = glm::max(maxBound, mesh.boundsCenter + glm::vec3(mesh.boundsRadius));
+    }
+    center = (minBound + maxBound) * 0.5f;
+    for (const Mesh& mesh : meshes)
+    {
+        radius = std::max(radius, glm::length(mesh.boundsCenter - center) + mesh.boundsRadius);
+    }
+}
+
+void Model::cullOccluded(OcclusionCuller& culler, const glm::mat4& model)
+{
+    for (const size_t index : occluderMeshes)
+    {
+        // Occluders have a single node, see selectOccluders
+        culler.addOccluder(meshes[index], model * sceneGraph.worldTransform(meshes[index].subMeshes[0].node));
+    }
+    culler.rasterize();
+
+    const float maxScale = std::max({glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])),
+                                     glm::length(glm::vec3(model[2]))});
+    occludedCount = 0;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        const glm::vec3 center = glm::vec3(model * glm::vec4(meshes[i].boundsCenter, 1.0f));
+        meshOccluded[i] = culler.isSphereOccluded(center, meshes[i].boundsRadius * maxScale);
+        if (meshOccluded[i]) { occludedCount++; }
+    }
+}
+
+void Model::clearOcclusion()
+{
+    std::fill(meshOccluded.begin(), meshOccluded.end(), false);
+    occludedCount = 0;
+}
+
+size_t Model::occludedMeshCount() const
+{
+    return occludedCount;
+}
+
+size_t Model::meshCount() const
+{
+    return meshes.size();
+}
+
+SceneGraph& Model::getSceneGraph()
+{
+    return sceneGraph;
+}
+
+bool Model::updateTransforms()
+{
+    if (!transformBuffers[0]) { return false; }
+
+    const bool moved = sceneGraph.update();
+    // The previous transforms only differ from the current ones until a frame without movement
+    if (moved || movedLastFrame)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, transformBuffers[0]);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, transformBuffers[1]);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                            static_cast<GLsizeiptr>(sceneGraph.nodeCount() * sizeof(glm::mat4)));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    movedLastFrame = moved;
+    if (!moved) { return false; }
+
+    // Updated subtrees are spread over the breadth first order, one upload of their span beats one per node
+    const std::vector<int>& updated = sceneGraph.updatedNodes();
+    const auto [first, last] = std::minmax_element(updated.begin(), updated.end());
+    glBindBuffer(GL_TEXTURE_BUFFER, transformBuffers[0]);
+    glBufferSubData(GL_TEXTURE_BUFFER, static_cast<GLintptr>(*first * sizeof(glm::mat4)),
+                    static_cast<GLsizeiptr>((*last - *first + 1) * sizeof(glm::mat4)),
+                    &sceneGraph.worldTransform(*first));
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    movedNodes.resize(sceneGraph.nodeCount(), 0);
+    for (const int node : updated) { movedNodes[node] = 1; }
     for (Mesh& mesh : meshes)
     {
-        indiceCount += mesh.Draw(shader);
+        const bool meshMoved = std::any_of(mesh.subMeshes.begin(), mesh.subMeshes.end(),
+                                           [this](const SubMesh& subMesh) { return movedNodes[subMesh.node]; });
+        if (meshMoved) { mesh.placeSubMeshes(sceneGraph); }
+    }
+    for (const int node : updated) { movedNodes[node] = 0; }
+
+    transformVersion++;
+    return true;
+}
+
+void Model::bindTransforms(Shader& shader, const unsigned int unit) const
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_BUFFER, transformTextures[0]);
+    glActiveTexture(GL_TEXTURE0);
+    shader.setInt("nodeTransforms", static_cast<int>(unit));
+}
+
+void Model::bindPreviousTransforms(Shader& shader, const unsigned int unit) const
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_BUFFER, transformTextures[1]);
+    glActiveTexture(GL_TEXTURE0);
+    shader.setInt("prevNodeTransforms", static_cast<int>(unit));
+}
+
+uint64_t Model::getTransformVersion() const
+{
+    return transformVersion;
+}
+
+void Model::setupTransforms()
+{
+    // Both start out with the load time transforms, so the first frame has no motion
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(sceneGraph.nodeCount() * sizeof(glm::mat4));
+    glGenBuffers(2, transformBuffers);
+    glGenTextures(2, transformTextures);
+    for (int i = 0; i < 2; i++)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, transformBuffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, bytes, &sceneGraph.worldTransform(0), GL_DYNAMIC_DRAW);
+        GpuMemory::track(GpuResourceType::Buffer, transformBuffers[i], static_cast<size_t>(bytes), "Geometry",
+                         i == 0 ? "Node transforms" : "Previous node transforms");
+        glBindTexture(GL_TEXTURE_BUFFER, transformTextures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, transformBuffers[i]);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void Model::applyTextureDetail(const std::vector<TextureDetailRequest>& requests)
+{
+    if (!textureStreamer) { return; }
+
+    for (const TextureDetailRequest& request : requests)
+    {
+        textureStreamer->requestDetail(request.textureId, request.uvPerPixel);
+    }
+}
+
+unsigned int Model::DrawCommands(const std::vector<DrawCommand>& commands)
+{
+    unsigned int indiceCount = 0;
+    uint32_t boundMaterial = std::numeric_limits<uint32_t>::max();
+    for (const DrawCommand& command : commands)
+    {
+        Mesh& mesh = meshes[command.mesh];
+        if (command.material() != boundMaterial)
+        {
+            mesh.bindMaterial();
+            boundMaterial = command.material();
+        }
+        indiceCount += mesh.DrawRange(command.firstIndex, command.indexCount);
     }
+    glBindVertexArray(0);
     return indiceCount;
 }
 
+void Model::resolveMaterials(Shader& shader)
+{
+    shader.use();
+    for (Mesh& mesh : meshes)
+    {
+        mesh.resolveMaterial(shader);
+    }
+}
+
+void Model::recordDraws(const size_t begin, const size_t end, const DrawView& view, CommandList& commands) const
+{
+    const float maxScale = std::max({glm::length(glm::vec3(view.model[0])), glm::length(glm::vec3(view.model[1])),
+                                     glm::length(glm::vec3(view.model[2]))});
+    // World space size of a pixel at unit distance from the camera
+    const float pixelAngle = 2.0f * std::tan(view.fovY * 0.5f) / view.screenHeight;
+    const std::array<glm::vec4, 6> frustumPlanes = Frustum::extractPlanes(view.viewProjection * view.model);
+
+    for (size_t i = begin; i < end; i++)
+    {
+        if (meshOccluded[i]) { continue; }
+
+        // Merged meshes are tested per sub mesh so the visible part closest to the camera decides the detail
+        const Mesh& mesh = meshes[i];
+        const size_t firstDraw = commands.draws.size();
+        float distance = -1.0f;
+        for (const SubMesh& subMesh : mesh.subMeshes)
+        {
+            if (!Frustum::isSphereVisible(frustumPlanes, subMesh.boundsCenter, subMesh.boundsRadius)) { continue; }
+
+            const glm::vec3 center = glm::vec3(view.model * glm::vec4(subMesh.boundsCenter, 1.0f));
+            const float radius = subMesh.boundsRadius * maxScale;
+            // Use the nearest point of the bounds so large meshes get the detail their closest part needs
+            const float subMeshDistance = std::max(glm::length(center - view.cameraPosition) - radius, 0.01f);
+            distance = distance < 0.0f ? subMeshDistance : std::min(distance, subMeshDistance);
+
+            // Neighbouring visible sub meshes are drawn as one range
+            if (commands.draws.size() > firstDraw &&
+                commands.draws.back().firstIndex + commands.draws.back().indexCount == subMesh.firstIndex)
+            {
+                commands.draws.back().indexCount += subMesh.indexCount;
+                continue;
+            }
+            commands.draws.push_back({0, static_cast<uint32_t>(i), subMesh.firstIndex, subMesh.indexCount});
+        }
+        if (distance < 0.0f) { continue; }
+
+        // Material first to bind each one once, then front to back for early depth rejection. Positive
+        // floats order the same as their bit patterns.
+        uint32_t depthBits;
+        std::memcpy(&depthBits, &distance, sizeof(depthBits));
+        const uint64_t sortKey = static_cast<uint64_t>(meshMaterials[i]) << 32 | depthBits;
+        for (size_t draw = firstDraw; draw < commands.draws.size(); draw++)
+        {
+            commands.draws[draw].sortKey = sortKey;
+        }
+
+        if (!textureStreamer || mesh.uvDensity <= 0.0f) { continue; }
+        const float uvPerPixel = mesh.uvDensity / maxScale * distance * pixelAngle;
+        for (const Texture& texture : mesh.textures)
+        {
+            commands.detailRequests.push_back({texture.id, uvPerPixel});
+        }
+    }
+}
+
 void Model::loadModel(const std::string& path)
 {
     Assimp::Importer importer;
@@ -46,28 +408,66 @@ void Model::loadModel(const std::string& path)
     }
 
     this->directory = path.substr(0, path.find_last_of('/'));
-    processNode(scene->mRootNode, scene);
-}
+    processNodes(scene);
+    if (sceneGraph.nodeCount() > 0) { setupTransforms(); }
 
-void Model::processNode(aiNode* node, const aiScene* scene)
-{
-    for (unsigned int i = 0; i < node->mNumMeshes; i++)
+    std::unordered_map<unsigned int, PackedMaterial> packedMaterials;
+    std::vector<std::vector<Texture>> batchTextures;
+    if (packMaterialTextures)
     {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        processMesh(mesh, scene);
+        buildMaterialArrays(scene, packedMaterials, batchTextures);
     }
+    createMeshes(scene, packedMaterials, batchTextures);
+    assignMaterialIds();
+    selectOccluders();
 
-    for (unsigned int i = 0; i < node->mNumChildren; i++)
+    const TextureMemoryStats& stats = TextureUtils::textureMemoryStats();
+    const double uploadedMb = static_cast<double>(stats.uploadedBytes) / (1024.0 * 1024.0);
+    const double uncompressedMb = static_cast<double>(stats.uncompressedBytes) / (1024.0 * 1024.0);
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(2) << "Texture memory: " << uploadedMb << " MB for "
+           << stats.textureCount << " textures (" << uncompressedMb << " MB uncompressed, saved "
+           << uncompressedMb - uploadedMb << " MB)";
+    if (stats.reducedTextures > 0)
     {
-        processNode(node->mChildren[i], scene);
+        report << ", " << stats.reducedTextures << " reduced to fit the GPU memory budget";
+    }
+    std::cout << report.str() << std::endl;
+
+    if (textureStreamer)
+    {
+        report.str("");
+        report << "Streamed texture memory: " << static_cast<double>(textureStreamer->residentBytes()) / (1024.0 * 1024.0)
+               << " MB resident of " << static_cast<double>(textureStreamer->fullResolutionBytes()) / (1024.0 * 1024.0)
+               << " MB at full resolution for " << textureStreamer->streamingCount() << " textures";
+        std::cout << report.str() << std::endl;
     }
 }
 
-void Model::processMesh(aiMesh* mesh, const aiScene* scene)
+void Model::processNodes(const aiScene* scene)
+{
+    // Breadth first, the order the scene graph keeps its nodes in
+    std::vector<std::pair<const aiNode*, int>> queue = {{scene->mRootNode, SceneGraph::NO_PARENT}};
+    for (size_t i = 0; i < queue.size(); i++)
+    {
+        const aiNode* node = queue[i].first;
+        const int index = sceneGraph.addNode(node->mName.C_Str(), queue[i].second, toMat4(node->mTransformation));
+        for (unsigned int j = 0; j < node->mNumMeshes; j++)
+        {
+            processMesh(scene->mMeshes[node->mMeshes[j]], scene, index);
+        }
+        for (unsigned int j = 0; j < node->mNumChildren; j++)
+        {
+            queue.emplace_back(node->mChildren[j], index);
+        }
+    }
+    std::cout << "Scene graph: " << sceneGraph.nodeCount() << " nodes" << std::endl;
+}
+
+void Model::processMesh(aiMesh* mesh, const aiScene* scene, const int node)
 {
     std::vector<Vertex> verticies;
     std::vector<unsigned int> indices;
-    std::vector<Texture> textures;
 
     for (unsigned int i = 0; i < mesh->mNumVertices; i++)
     {
@@ -126,46 +526,273 @@ void Model::processMesh(aiMesh* mesh, const aiScene* scene)
         }
     }
 
-    // Process materials
-    if (mesh->mMaterialIndex >= 0)
+    meshData.push_back({std::move(verticies), std::move(indices), mesh->mMaterialIndex, {}, node});
+}
+
+void Model::buildMaterialArrays(const aiScene* scene, std::unordered_map<unsigned int, PackedMaterial>& packedMaterials,
+                                std::vector<std::vector<Texture>>& batchTextures)
+{
+    std::set<unsigned int> materialIndices;
+    for (const MeshData& data : meshData)
     {
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+        materialIndices.insert(data.materialIndex);
+    }
 
-        if (isPbr)
+    // Materials are grouped by a signature of the size and format of every slot. Only materials with
+    // identical signatures can share a set of texture arrays, everything else keeps individual textures.
+    const std::vector<MaterialSlot> slots = materialSlots();
+    std::unordered_map<std::string, CompressedTexture> sources;
+    std::unordered_map<unsigned int, std::vector<std::string>> materialSources;
+    std::map<std::string, std::vector<unsigned int>> groups;
+    for (const unsigned int materialIndex : materialIndices)
+    {
+        aiMaterial* material = scene->mMaterials[materialIndex];
+        std::ostringstream signature;
+        std::vector<std::string> sourceKeys;
+        bool packable = true;
+        for (const MaterialSlot& slot : slots)
         {
-            std::vector<Texture> albedoMaps =
-                loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_albedo");
-            textures.insert(textures.end(), albedoMaps.begin(), albedoMaps.end());
+            const unsigned int textureCount = material->GetTextureCount(slot.type);
+            if (textureCount == 0)
+            {
+                signature << slot.typeName << ":none;";
+                sourceKeys.emplace_back();
+                continue;
+            }
 
-            std::vector<Texture> metallicMaps =
-                loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_metallic");
-            textures.insert(textures.end(), metallicMaps.begin(), metallicMaps.end());
+            const bool gammaCorrection = shouldCorrectGamma(slot.type);
+            const TextureCodec codec = selectCodec(slot.type, isPbr, gammaCorrection);
+            if (textureCount > 1 || codec == TextureCodec::None)
+            {
+                packable = false;
+                break;
+            }
 
-            std::vector<Texture> roughnessMaps =
-                loadMaterialTextures(material, aiTextureType_SHININESS, "texture_roughness");
-            textures.insert(textures.end(), roughnessMaps.begin(), roughnessMaps.end());
+            aiString str;
+            material->GetTexture(slot.type, 0, &str);
+            const std::string path = this->directory + "/" + str.C_Str();
+            const std::string key = path + "|" + TextureCompressor::codecName(codec);
+            auto source = sources.find(key);
+            if (source == sources.end())
+            {
+                CompressedTexture texture;
+                bool fromCache = false;
+                if (!TextureUtils::loadCompressedMips(path, codec, gammaCorrection, texture, fromCache))
+                {
+                    packable = false;
+                    break;
+                }
+                source = sources.emplace(key, std::move(texture)).first;
+            }
 
-            std::vector<Texture> aoMaps =
-                loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_ao");
-            textures.insert(textures.end(), aoMaps.begin(), aoMaps.end());
+            const CompressedTexture& texture = source->second;
+            signature << slot.typeName << ":" << TextureCompressor::codecName(codec) << (texture.srgb ? "s" : "")
+                      << ":" << texture.width << "x" << texture.height << ":" << texture.mips.size() << ";";
+            sourceKeys.push_back(key);
         }
-        else
+
+        if (packable)
+        {
+            groups[signature.str()].push_back(materialIndex);
+            materialSources[materialIndex] = std::move(sourceKeys);
+        }
+    }
+
+    // Decoded mips are only held until the last array using them is uploaded, not for the whole load
+    std::unordered_map<std::string, size_t> remainingUses;
+    for (const auto& [signature, materials] : groups)
+    {
+        for (const unsigned int materialIndex : materials)
+        {
+            for (const std::string& key : materialSources[materialIndex])
+            {
+                if (!key.empty()) { remainingUses[key]++; }
+            }
+        }
+    }
+    std::erase_if(sources, [&remainingUses](const auto& source) { return !remainingUses.contains(source.first); });
+
+    int maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    for (const auto& [signature, materials] : groups)
+    {
+        for (size_t first = 0; first < materials.size(); first += static_cast<size_t>(maxLayers))
         {
-            std::vector<Texture> diffuseMaps =
-                loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-            textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+            const size_t last = std::min(materials.size(), first + static_cast<size_t>(maxLayers));
+            // A lone material has nothing to batch with and keeps its individual textures
+            if (last - first < 2) { break; }
+
+            std::vector<Texture> textures;
+            for (size_t slot = 0; slot < slots.size(); slot++)
+            {
+                if (materialSources[materials[first]][slot].empty()) { continue; }
+
+                std::vector<const CompressedTexture*> layers;
+                for (size_t i = first; i < last; i++)
+                {
+                    layers.push_back(&sources.at(materialSources[materials[i]][slot]));
+                }
 
-            std::vector<Texture> specularMaps =
-                loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+                Texture texture;
+                texture.id = TextureUtils::loadCompressedTextureArray(layers);
+                texture.type = slots[slot].typeName;
+                texture.name = signature;
+                texture.isArray = true;
+                textures.push_back(texture);
+                textureArrays.push_back(texture.id);
+            }
+
+            for (size_t i = first; i < last; i++)
+            {
+                packedMaterials[materials[i]] = {batchTextures.size(), static_cast<int>(i - first)};
+                for (const std::string& key : materialSources[materials[i]])
+                {
+                    if (!key.empty() && --remainingUses[key] == 0) { sources.erase(key); }
+                }
+            }
+            batchTextures.push_back(std::move(textures));
         }
+    }
+}
 
-        std::vector<Texture> normalMaps =
-                    loadMaterialTextures(material, aiTextureType_NORMALS, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+void Model::createMeshes(const aiScene* scene, const std::unordered_map<unsigned int, PackedMaterial>& packedMaterials,
+                         const std::vector<std::vector<Texture>>& batchTextures)
+{
+    // Verticies stay in node space and carry their node, so moving a node only uploads its transform
+    for (MeshData& data : meshData)
+    {
+        const auto node = static_cast<unsigned int>(std::max(data.node, 0));
+        for (Vertex& vertex : data.verticies) { vertex.node = node; }
     }
 
-    meshes.emplace_back(verticies, indices, textures, isPbr);
+    std::vector<MeshData> batches(batchTextures.size());
+    std::unordered_map<unsigned int, std::vector<Texture>> materialTextures;
+    for (size_t i = 0; i < meshData.size(); i++)
+    {
+        MeshData& data = meshData[i];
+        const int node = std::max(data.node, 0);
+        const auto packed = packedMaterials.find(data.materialIndex);
+        if (packed != packedMaterials.end())
+        {
+            // Append to the merged mesh of the batch, tagging every vertex with its material layer
+            MeshData& batch = batches[packed->second.batch];
+            const auto baseVertex = static_cast<unsigned int>(batch.verticies.size());
+            // Bounds are filled in by the mesh once the batch is complete
+            batch.subMeshes.push_back({static_cast<unsigned int>(batch.indices.size()),
+                                       static_cast<unsigned int>(data.indices.size()), glm::vec3(0.0f), 0.0f, node});
+            for (Vertex vertex : data.verticies)
+            {
+                vertex.materialLayer = static_cast<float>(packed->second.layer);
+                batch.verticies.push_back(vertex);
+            }
+            for (const unsigned int index : data.indices)
+            {
+                batch.indices.push_back(baseVertex + index);
+            }
+            continue;
+        }
+
+        auto textures = materialTextures.find(data.materialIndex);
+        if (textures == materialTextures.end())
+        {
+            textures = materialTextures.emplace(data.materialIndex,
+                                                loadMaterial(scene->mMaterials[data.materialIndex])).first;
+        }
+        const std::vector<SubMesh> subMeshes = {{0, static_cast<unsigned int>(data.indices.size()), glm::vec3(0.0f),
+                                                 0.0f, node}};
+        meshes.emplace_back(data.verticies, data.indices, textures->second, isPbr, subMeshes);
+    }
+
+    for (size_t i = 0; i < batches.size(); i++)
+    {
+        if (batches[i].verticies.empty()) { continue; }
+        meshes.emplace_back(batches[i].verticies, batches[i].indices, batchTextures[i], isPbr, batches[i].subMeshes);
+    }
+    if (!batches.empty())
+    {
+        std::cout << "Packed " << packedMaterials.size() << " materials into " << batches.size()
+                  << " texture array batches" << std::endl;
+    }
+    meshData.clear();
+
+    if (sceneGraph.nodeCount() == 0) { return; }
+    for (Mesh& mesh : meshes) { mesh.placeSubMeshes(sceneGraph); }
+}
+
+void Model::assignMaterialIds()
+{
+    std::map<std::vector<unsigned int>, uint32_t> materialIds;
+    meshMaterials.clear();
+    for (const Mesh& mesh : meshes)
+    {
+        std::vector<unsigned int> textureIds;
+        for (const Texture& texture : mesh.textures) { textureIds.push_back(texture.id); }
+        const auto id = materialIds.emplace(textureIds, static_cast<uint32_t>(materialIds.size())).first;
+        meshMaterials.push_back(id->second);
+    }
+}
+
+void Model::selectOccluders()
+{
+    meshOccluded.assign(meshes.size(), false);
+    occluderMeshes.clear();
+
+    glm::vec3 center;
+    float radius;
+    getBounds(center, radius);
+
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        const size_t triangleCount = meshes[i].indices.size() / 3;
+        if (triangleCount > MAX_OCCLUDER_TRIANGLES || meshes[i].boundsRadius < radius * MIN_OCCLUDER_SIZE) { continue; }
+        // The culler places an occluder with one matrix, merged meshes spanning several nodes are left out
+        const int node = meshes[i].subMeshes[0].node;
+        const bool singleNode = std::all_of(meshes[i].subMeshes.begin(), meshes[i].subMeshes.end(),
+                                            [node](const SubMesh& subMesh) { return subMesh.node == node; });
+        if (!singleNode) { continue; }
+        candidates.push_back(i);
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](const size_t a, const size_t b)
+    {
+        return meshes[a].boundsRadius > meshes[b].boundsRadius;
+    });
+
+    size_t triangleTotal = 0;
+    for (const size_t index : candidates)
+    {
+        const size_t triangleCount = meshes[index].indices.size() / 3;
+        if (triangleTotal + triangleCount > MAX_OCCLUDER_TRIANGLES_TOTAL) { continue; }
+        occluderMeshes.push_back(index);
+        triangleTotal += triangleCount;
+    }
+}
+
+std::vector<Model::MaterialSlot> Model::materialSlots() const
+{
+    // Order matches the texture units the meshes bind the slots to
+    if (isPbr)
+    {
+        return {{aiTextureType_DIFFUSE, "texture_albedo"},
+                {aiTextureType_SPECULAR, "texture_metallic"},
+                {aiTextureType_SHININESS, "texture_roughness"},
+                {aiTextureType_AMBIENT, "texture_ao"},
+                {aiTextureType_NORMALS, "texture_normal"}};
+    }
+    return {{aiTextureType_DIFFUSE, "texture_diffuse"},
+            {aiTextureType_SPECULAR, "texture_specular"},
+            {aiTextureType_NORMALS, "texture_normal"}};
+}
+
+std::vector<Texture> Model::loadMaterial(aiMaterial* material)
+{
+    std::vector<Texture> textures;
+    for (const MaterialSlot& slot : materialSlots())
+    {
+        std::vector<Texture> maps = loadMaterialTextures(material, slot.type, slot.typeName);
+        textures.insert(textures.end(), maps.begin(), maps.end());
+    }
+    return textures;
 }
 
 std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string& typeName)
@@ -187,14 +814,12 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType
         }
         if (skip) { continue; }
 
-        // Diffuse and AO textures are almost always in the sRGB space. Therefore, only convert
-        // these textures into linear space when loading.
-        bool shouldCorrectGamma =
-            type == aiTextureType_DIFFUSE ||
-            type == aiTextureType_AMBIENT;
+        const bool gammaCorrection = shouldCorrectGamma(type);
         Texture texture;
         std::string path = this->directory + "/" + str.C_Str();
-        texture.id = TextureUtils::loadTexture(path, shouldCorrectGamma);
+        const TextureCodec codec = selectCodec(type, isPbr, gammaCorrection);
+        texture.id = textureStreamer ? textureStreamer->loadTexture(path, codec, gammaCorrection)
+                                     : TextureUtils::loadCompressedTexture(path, codec, gammaCorrection);
         texture.type = typeName;
         texture.name = str.C_Str();
         textures.push_back(texture);
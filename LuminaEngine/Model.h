@@ -1,22 +1,133 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <assimp/scene.h>
+#include <glm/glm.hpp>
+#include "CommandList.h"
 #include "Shader.h"
 #include "Mesh.h"
+#include "OcclusionCuller.h"
+#include "SceneGraph.h"
+#include "TextureStreamer.h"
 
 class Model
 {
 public:
-    Model(const std::string& path, bool isPbr);
+    /// <summary>
+    /// With packMaterialTextures, materials whose textures match in size and format are packed into texture
+    /// arrays and all meshes using them are merged into a single draw
+    /// </summary>
+    Model(const std::string& path, bool isPbr, TextureStreamer* textureStreamer = nullptr,
+          bool packMaterialTextures = false);
     ~Model();
     unsigned int Draw(Shader& shader);
+    /// <summary>
+    /// GPU culled submission, one multi draw indirect call per set of textures instead of one draw per mesh
+    /// </summary>
+    unsigned int DrawIndirect(Shader& shader, Shader& cullShader, const glm::mat4& modelViewProjection);
+    /// <summary>
+    /// Submits what the last DrawDepthIndirect culled, so a shading pass after the depth pre-pass does not
+    /// cull the same view again
+    /// </summary>
+    unsigned int DrawCulledIndirect(Shader& shader);
+    /// <summary>
+    /// Depth only submission from the position streams of the meshes, with the caller's shader bound.
+    /// Views other than the camera's pass false, the occlusion results only hold for the camera.
+    /// </summary>
+    unsigned int DrawDepth(bool skipOccluded = true);
+    unsigned int DrawDepthIndirect(Shader& depthShader, Shader& cullShader, const glm::mat4& modelViewProjection);
+    /// <summary>
+    /// Replays commands recorded by recordDraws, binding a material only when it changes. The shader the
+    /// materials were resolved against must be in use.
+    /// </summary>
+    unsigned int DrawCommands(const std::vector<DrawCommand>& commands);
+    /// <summary>
+    /// Resolves the material uniforms of every mesh against the shader DrawCommands will use
+    /// </summary>
+    void resolveMaterials(Shader& shader);
+    /// <summary>
+    /// Records the visible sub mesh ranges of meshes [begin, end) and the texture detail they need. Touches
+    /// no GL state, so disjoint ranges can be recorded on several threads at once.
+    /// </summary>
+    void recordDraws(size_t begin, size_t end, const DrawView& view, CommandList& commands) const;
+    void applyTextureDetail(const std::vector<TextureDetailRequest>& requests);
+    /// <summary>
+    /// Model space sphere enclosing every mesh
+    /// </summary>
+    void getBounds(glm::vec3& center, float& radius) const;
+    /// <summary>
+    /// Rasterizes the occluder meshes into the culler, which must have begun a frame with the camera's
+    /// view projection, then tests every mesh against it. Occluded meshes are skipped by the draw calls
+    /// until the next call or clearOcclusion().
+    /// </summary>
+    void cullOccluded(OcclusionCuller& culler, const glm::mat4& model);
+    void clearOcclusion();
+    size_t occludedMeshCount() const;
+    size_t meshCount() const;
+    /// <summary>
+    /// Node hierarchy of the model file, meshes are placed by the world transforms of their nodes
+    /// </summary>
+    SceneGraph& getSceneGraph();
+    /// <summary>
+    /// Updates the world transforms of the nodes moved since the last call, uploads them for the vertex
+    /// shaders and places the bounds of the meshes below them. Call once per frame, the transforms of the
+    /// previous frame are kept for motion vectors. Returns false when no node moved.
+    /// </summary>
+    bool updateTransforms();
+    /// <summary>
+    /// Binds the node world transforms to the texture unit for the nodeTransforms sampler of the shader in
+    /// use, which every shader drawing the meshes needs
+    /// </summary>
+    void bindTransforms(Shader& shader, unsigned int unit) const;
+    /// <summary>
+    /// Same for the transforms of the previous frame and the prevNodeTransforms sampler
+    /// </summary>
+    void bindPreviousTransforms(Shader& shader, unsigned int unit) const;
+    /// <summary>
+    /// Changes whenever meshes move within the model, for caches of its geometry
+    /// </summary>
+    uint64_t getTransformVersion() const;
 
 private:
+    // The CPU microbenchmarks call processMesh and loadMaterialTextures directly
+    friend struct BenchmarkAccess;
+
+    // Geometry kept on the CPU until every material is known, so meshes can be merged before upload
+    struct MeshData
+    {
+        std::vector<Vertex> verticies;
+        std::vector<unsigned int> indices;
+        unsigned int materialIndex;
+        std::vector<SubMesh> subMeshes;
+        int node;
+    };
+
+    struct MaterialSlot
+    {
+        aiTextureType type;
+        std::string typeName;
+    };
+
+    struct PackedMaterial
+    {
+        size_t batch;
+        int layer;
+    };
+
     void loadModel(const std::string& path);
-    void processNode(aiNode* node, const aiScene* scene);
-    void processMesh(aiMesh* mesh, const aiScene* scene);
+    void processNodes(const aiScene* scene);
+    void processMesh(aiMesh* mesh, const aiScene* scene, int node);
+    void buildMaterialArrays(const aiScene* scene, std::unordered_map<unsigned int, PackedMaterial>& packedMaterials,
+                             std::vector<std::vector<Texture>>& batchTextures);
+    void createMeshes(const aiScene* scene, const std::unordered_map<unsigned int, PackedMaterial>& packedMaterials,
+                      const std::vector<std::vector<Texture>>& batchTextures);
+    void selectOccluders();
+    void setupTransforms();
+    void assignMaterialIds();
+    std::vector<MaterialSlot> materialSlots() const;
+    std::vector<Texture> loadMaterial(aiMaterial* material);
     std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string& typeName);
 
 private:
@@ -24,5 +135,23 @@ private:
     std::vector<Mesh> meshes;
     std::string directory;
     std::vector<Texture> texturesLoaded;
+    std::vector<unsigned int> textureArrays;
+    std::vector<MeshData> meshData;
+    // Large, low polygon meshes rasterized by the occlusion culler, and the per mesh results
+    std::vector<size_t> occluderMeshes;
+    std::vector<bool> meshOccluded;
+    size_t occludedCount = 0;
+    // Meshes with the same textures share an id, the primary sort key of recorded draws
+    std::vector<uint32_t> meshMaterials;
+    SceneGraph sceneGraph;
+    std::vector<uint8_t> movedNodes;
+    // Texture buffers of the node world transforms, four RGBA32F texels per matrix. The first holds the
+    // current frame's, the second the previous frame's.
+    unsigned int transformBuffers[2] = {0, 0};
+    unsigned int transformTextures[2] = {0, 0};
+    bool movedLastFrame = false;
+    uint64_t transformVersion = 0;
     bool isPbr;
+    TextureStreamer* textureStreamer;
+    bool packMaterialTextures;
 };
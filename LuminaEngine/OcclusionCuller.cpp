@@ -0,0 +1,418 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "CpuFeatures.h"
+#include "Parallel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LUMINA_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Tiles are rasterized independently on the worker threads. The width is a multiple of the 8 pixel
+    // AVX2 step, so a step never crosses into the next tile.
+    constexpr int TILE_WIDTH = 64;
+    constexpr int TILE_HEIGHT = 16;
+    constexpr unsigned int MIN_TRIANGLES_PER_THREAD = 1024;
+    // Triangles with less screen area than this cover no pixel centers worth the setup
+    constexpr float MIN_TRIANGLE_AREA = 1e-6f;
+
+    int roundUp(const int value, const int multiple)
+    {
+        return std::max(multiple, (value + multiple - 1) / multiple * multiple);
+    }
+
+    // Edge function of the edge from a to b, positive on the inner side of a counter-clockwise triangle
+    void edgeFunction(const glm::vec2& a, const glm::vec2& b, float& edgeA, float& edgeB, float& edgeC)
+    {
+        edgeA = a.y - b.y;
+        edgeB = b.x - a.x;
+        edgeC = a.x * b.y - a.y * b.x;
+    }
+
+    void rasterizeRowsScalar(const float* edgeA, const float* edgeB, const float* edgeC, const float depthDx,
+                             const float depthDy, const float depthC, const int minX, const int minY, const int maxX,
+                             const int maxY, float* depth, const int width)
+    {
+        for (int y = minY; y <= maxY; y++)
+        {
+            const float py = static_cast<float>(y) + 0.5f;
+            float* row = depth + static_cast<size_t>(y) * width;
+            for (int x = minX; x <= maxX; x++)
+            {
+                const float px = static_cast<float>(x) + 0.5f;
+                const float e0 = edgeA[0] * px + edgeB[0] * py + edgeC[0];
+                const float e1 = edgeA[1] * px + edgeB[1] * py + edgeC[1];
+                const float e2 = edgeA[2] * px + edgeB[2] * py + edgeC[2];
+                if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f) { continue; }
+
+                const float z = std::max(depthDx * px + depthDy * py + depthC, 0.0f);
+                row[x] = std::min(row[x], z);
+            }
+        }
+    }
+
+#if LUMINA_X86
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((target("avx2,fma")))
+#endif
+    void rasterizeRowsAvx2(const float* edgeA, const float* edgeB, const float* edgeC, const float depthDx,
+                           const float depthDy, const float depthC, const int minX, const int minY, const int maxX,
+                           const int maxY, float* depth, const int width)
+    {
+        const __m256 laneCenters = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+        const __m256 zero = _mm256_setzero_ps();
+        // Rows start on an 8 pixel boundary, the extra lanes fall outside the triangle's edges
+        const int startX = minX & ~7;
+        const __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(startX)), laneCenters);
+
+        const __m256 a0 = _mm256_set1_ps(edgeA[0]);
+        const __m256 a1 = _mm256_set1_ps(edgeA[1]);
+        const __m256 a2 = _mm256_set1_ps(edgeA[2]);
+        const __m256 dz = _mm256_set1_ps(depthDx);
+        const __m256 stepE0 = _mm256_set1_ps(edgeA[0] * 8.0f);
+        const __m256 stepE1 = _mm256_set1_ps(edgeA[1] * 8.0f);
+        const __m256 stepE2 = _mm256_set1_ps(edgeA[2] * 8.0f);
+        const __m256 stepZ = _mm256_set1_ps(depthDx * 8.0f);
+
+        for (int y = minY; y <= maxY; y++)
+        {
+            const float py = static_cast<float>(y) + 0.5f;
+            __m256 e0 = _mm256_fmadd_ps(a0, px, _mm256_set1_ps(edgeB[0] * py + edgeC[0]));
+            __m256 e1 = _mm256_fmadd_ps(a1, px, _mm256_set1_ps(edgeB[1] * py + edgeC[1]));
+            __m256 e2 = _mm256_fmadd_ps(a2, px, _mm256_set1_ps(edgeB[2] * py + edgeC[2]));
+            __m256 z = _mm256_fmadd_ps(dz, px, _mm256_set1_ps(depthDy * py + depthC));
+
+            float* row = depth + static_cast<size_t>(y) * width;
+            for (int x = startX; x <= maxX; x += 8)
+            {
+                const __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ),
+                                                                  _mm256_cmp_ps(e1, zero, _CMP_GE_OQ)),
+                                                    _mm256_cmp_ps(e2, zero, _CMP_GE_OQ));
+                if (_mm256_movemask_ps(inside))
+                {
+                    const __m256 current = _mm256_loadu_ps(row + x);
+                    const __m256 nearer = _mm256_min_ps(current, _mm256_max_ps(z, zero));
+                    _mm256_storeu_ps(row + x, _mm256_blendv_ps(current, nearer, inside));
+                }
+                e0 = _mm256_add_ps(e0, stepE0);
+                e1 = _mm256_add_ps(e1, stepE1);
+                e2 = _mm256_add_ps(e2, stepE2);
+                z = _mm256_add_ps(z, stepZ);
+            }
+        }
+    }
+#endif
+}
+
+OcclusionCuller::OcclusionCuller(const int width, const int height) :
+    mWidth(roundUp(width, TILE_WIDTH)),
+    mHeight(roundUp(height, TILE_HEIGHT)),
+    mTilesX(mWidth / TILE_WIDTH),
+    mTilesY(mHeight / TILE_HEIGHT),
+    mSimdEnabled(true),
+    mViewProjection(1.0f),
+    mTriangleCount(0),
+    mRasterizedTriangles(0)
+{
+    mDepth.assign(static_cast<size_t>(mWidth) * mHeight, 1.0f);
+    mTileBins.resize(static_cast<size_t>(mTilesX) * mTilesY);
+
+    glm::ivec2 size(mWidth, mHeight);
+    while (size.x > 1 || size.y > 1)
+    {
+        size = glm::max((size + 1) / 2, glm::ivec2(1));
+        mLevelSizes.push_back(size);
+        mPyramid.emplace_back(static_cast<size_t>(size.x) * size.y, 1.0f);
+    }
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& viewProjection)
+{
+    mViewProjection = viewProjection;
+    mOccluders.clear();
+    mTriangleCount = 0;
+    mRasterizedTriangles = 0;
+    std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+}
+
+void OcclusionCuller::addOccluder(const Mesh& mesh, const glm::mat4& model)
+{
+    mOccluders.push_back({&mesh, mViewProjection * model, mTriangleCount});
+    mTriangleCount += mesh.indices.size() / 3;
+}
+
+void OcclusionCuller::rasterize()
+{
+    mTriangles.resize(mTriangleCount * 2);
+    Parallel::parallelFor(static_cast<unsigned int>(mTriangleCount), MIN_TRIANGLES_PER_THREAD,
+                          [this](const unsigned int begin, const unsigned int end)
+    {
+        // Occluders are sorted by their first triangle, find the one owning the start of the range
+        auto occluder = std::upper_bound(mOccluders.begin(), mOccluders.end(), static_cast<size_t>(begin),
+                                         [](const size_t triangle, const Occluder& o) { return triangle < o.firstTriangle; });
+        size_t occluderIndex = static_cast<size_t>(occluder - mOccluders.begin()) - 1;
+        for (size_t triangle = begin; triangle < end; triangle++)
+        {
+            while (occluderIndex + 1 < mOccluders.size() && triangle >= mOccluders[occluderIndex + 1].firstTriangle)
+            {
+                occluderIndex++;
+            }
+            setupTriangles(occluderIndex, triangle - mOccluders[occluderIndex].firstTriangle,
+                           &mTriangles[triangle * 2]);
+        }
+    });
+
+    binTriangles();
+    Parallel::parallelFor(static_cast<unsigned int>(mTileBins.size()), 1,
+                          [this](const unsigned int begin, const unsigned int end)
+    {
+        for (unsigned int tile = begin; tile < end; tile++) { rasterizeTile(static_cast<int>(tile)); }
+    });
+    buildPyramid();
+}
+
+bool OcclusionCuller::isSphereOccluded(const glm::vec3& center, const float radius) const
+{
+    // The screen bounds and nearest depth of the sphere's bounding box enclose those of the sphere
+    glm::vec2 ndcMin(std::numeric_limits<float>::max());
+    glm::vec2 ndcMax(std::numeric_limits<float>::lowest());
+    float nearestDepth = 1.0f;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        const glm::vec3 offset((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius,
+                               (corner & 4) ? radius : -radius);
+        const glm::vec4 clip = mViewProjection * glm::vec4(center + offset, 1.0f);
+        // Behind or at the near plane, the projected bounds are unbounded
+        if (clip.w <= 1e-4f || clip.z < -clip.w) { return false; }
+
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        ndcMin = glm::min(ndcMin, glm::vec2(ndc));
+        ndcMax = glm::max(ndcMax, glm::vec2(ndc));
+        nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+    }
+    if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f) { return false; }
+
+    // One pixel of margin, occluder coverage is only sampled at pixel centers
+    int minX = std::max(0, static_cast<int>(std::floor((ndcMin.x * 0.5f + 0.5f) * mWidth)) - 1);
+    int minY = std::max(0, static_cast<int>(std::floor((ndcMin.y * 0.5f + 0.5f) * mHeight)) - 1);
+    int maxX = std::min(mWidth - 1, static_cast<int>(std::floor((ndcMax.x * 0.5f + 0.5f) * mWidth)) + 1);
+    int maxY = std::min(mHeight - 1, static_cast<int>(std::floor((ndcMax.y * 0.5f + 0.5f) * mHeight)) + 1);
+
+    // Coarsest level where the bounds span at most two texels per axis
+    int level = 0;
+    while (maxX - minX > 1 || maxY - minY > 1)
+    {
+        minX >>= 1;
+        minY >>= 1;
+        maxX >>= 1;
+        maxY >>= 1;
+        level++;
+    }
+
+    const float* depth = level == 0 ? mDepth.data() : mPyramid[level - 1].data();
+    const int levelWidth = level == 0 ? mWidth : mLevelSizes[level - 1].x;
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            if (nearestDepth <= depth[static_cast<size_t>(y) * levelWidth + x]) { return false; }
+        }
+    }
+    return true;
+}
+
+void OcclusionCuller::setSimdEnabled(const bool enabled)
+{
+    mSimdEnabled = enabled;
+}
+
+size_t OcclusionCuller::rasterizedTriangleCount() const
+{
+    return mRasterizedTriangles;
+}
+
+int OcclusionCuller::width() const
+{
+    return mWidth;
+}
+
+int OcclusionCuller::height() const
+{
+    return mHeight;
+}
+
+const std::vector<float>& OcclusionCuller::depthBuffer() const
+{
+    return mDepth;
+}
+
+void OcclusionCuller::setupTriangles(const size_t occluderIndex, const size_t triangle, ScreenTriangle* output) const
+{
+    output[0].valid = false;
+    output[1].valid = false;
+
+    const Occluder& occluder = mOccluders[occluderIndex];
+    const std::vector<unsigned int>& indices = occluder.mesh->indices;
+    const std::vector<Vertex>& verticies = occluder.mesh->verticies;
+    glm::vec4 clip[3];
+    for (int i = 0; i < 3; i++)
+    {
+        clip[i] = occluder.modelViewProjection * glm::vec4(verticies[indices[triangle * 3 + i]].position, 1.0f);
+    }
+
+    // Clip against the near plane (z >= -w), the other planes are handled in screen space
+    glm::vec4 polygon[4];
+    int count = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        const glm::vec4& current = clip[i];
+        const glm::vec4& next = clip[(i + 1) % 3];
+        const float currentDistance = current.z + current.w;
+        const float nextDistance = next.z + next.w;
+        if (currentDistance >= 0.0f) { polygon[count++] = current; }
+        if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+        {
+            const float t = currentDistance / (currentDistance - nextDistance);
+            polygon[count++] = current + (next - current) * t;
+        }
+    }
+
+    if (count >= 3) { addScreenTriangle(polygon[0], polygon[1], polygon[2], output[0]); }
+    if (count == 4) { addScreenTriangle(polygon[0], polygon[2], polygon[3], output[1]); }
+}
+
+void OcclusionCuller::addScreenTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2,
+                                        ScreenTriangle& output) const
+{
+    output.valid = false;
+    if (v0.w <= 0.0f || v1.w <= 0.0f || v2.w <= 0.0f) { return; }
+
+    const glm::vec3 ndc[3] = {glm::vec3(v0) / v0.w, glm::vec3(v1) / v1.w, glm::vec3(v2) / v2.w};
+    const glm::vec2 size(static_cast<float>(mWidth), static_cast<float>(mHeight));
+    glm::vec2 screen[3];
+    float depth[3];
+    for (int i = 0; i < 3; i++)
+    {
+        screen[i] = (glm::vec2(ndc[i]) * 0.5f + 0.5f) * size;
+        depth[i] = ndc[i].z * 0.5f + 0.5f;
+    }
+
+    float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) -
+                 (screen[1].y - screen[0].y) * (screen[2].x - screen[0].x);
+    if (std::abs(area) < MIN_TRIANGLE_AREA) { return; }
+    // Occluders are drawn double sided, clockwise triangles are flipped to keep the inside positive
+    if (area < 0.0f)
+    {
+        std::swap(screen[1], screen[2]);
+        std::swap(depth[1], depth[2]);
+        area = -area;
+    }
+
+    const glm::vec2 minBound = glm::min(screen[0], glm::min(screen[1], screen[2]));
+    const glm::vec2 maxBound = glm::max(screen[0], glm::max(screen[1], screen[2]));
+    output.minX = std::max(0, static_cast<int>(std::floor(minBound.x)));
+    output.minY = std::max(0, static_cast<int>(std::floor(minBound.y)));
+    output.maxX = std::min(mWidth - 1, static_cast<int>(std::ceil(maxBound.x)));
+    output.maxY = std::min(mHeight - 1, static_cast<int>(std::ceil(maxBound.y)));
+    if (output.minX > output.maxX || output.minY > output.maxY) { return; }
+    if (depth[0] > 1.0f && depth[1] > 1.0f && depth[2] > 1.0f) { return; }
+
+    edgeFunction(screen[0], screen[1], output.edgeA[0], output.edgeB[0], output.edgeC[0]);
+    edgeFunction(screen[1], screen[2], output.edgeA[1], output.edgeB[1], output.edgeC[1]);
+    edgeFunction(screen[2], screen[0], output.edgeA[2], output.edgeB[2], output.edgeC[2]);
+
+    // Depth is affine in screen space after the perspective divide
+    const glm::vec2 e1 = screen[1] - screen[0];
+    const glm::vec2 e2 = screen[2] - screen[0];
+    output.depthDx = ((depth[1] - depth[0]) * e2.y - (depth[2] - depth[0]) * e1.y) / area;
+    output.depthDy = ((depth[2] - depth[0]) * e1.x - (depth[1] - depth[0]) * e2.x) / area;
+    output.depthC = depth[0] - output.depthDx * screen[0].x - output.depthDy * screen[0].y;
+    output.valid = true;
+}
+
+void OcclusionCuller::binTriangles()
+{
+    for (std::vector<uint32_t>& bin : mTileBins) { bin.clear(); }
+    for (size_t i = 0; i < mTriangles.size(); i++)
+    {
+        const ScreenTriangle& triangle = mTriangles[i];
+        if (!triangle.valid) { continue; }
+
+        mRasterizedTriangles++;
+        const int tileMinX = triangle.minX / TILE_WIDTH;
+        const int tileMaxX = triangle.maxX / TILE_WIDTH;
+        const int tileMinY = triangle.minY / TILE_HEIGHT;
+        const int tileMaxY = triangle.maxY / TILE_HEIGHT;
+        for (int tileY = tileMinY; tileY <= tileMaxY; tileY++)
+        {
+            for (int tileX = tileMinX; tileX <= tileMaxX; tileX++)
+            {
+                mTileBins[static_cast<size_t>(tileY) * mTilesX + tileX].push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+}
+
+void OcclusionCuller::rasterizeTile(const int tile)
+{
+    const int tileMinX = (tile % mTilesX) * TILE_WIDTH;
+    const int tileMinY = (tile / mTilesX) * TILE_HEIGHT;
+    const int tileMaxX = tileMinX + TILE_WIDTH - 1;
+    const int tileMaxY = tileMinY + TILE_HEIGHT - 1;
+#if LUMINA_X86
+    const bool useAvx2 = mSimdEnabled && CpuFeatures::hasAvx2();
+#endif
+
+    for (const uint32_t index : mTileBins[tile])
+    {
+        const ScreenTriangle& triangle = mTriangles[index];
+        const int minX = std::max(triangle.minX, tileMinX);
+        const int minY = std::max(triangle.minY, tileMinY);
+        const int maxX = std::min(triangle.maxX, tileMaxX);
+        const int maxY = std::min(triangle.maxY, tileMaxY);
+#if LUMINA_X86
+        if (useAvx2)
+        {
+            rasterizeRowsAvx2(triangle.edgeA, triangle.edgeB, triangle.edgeC, triangle.depthDx, triangle.depthDy,
+                              triangle.depthC, minX, minY, maxX, maxY, mDepth.data(), mWidth);
+            continue;
+        }
+#endif
+        rasterizeRowsScalar(triangle.edgeA, triangle.edgeB, triangle.edgeC, triangle.depthDx, triangle.depthDy,
+                            triangle.depthC, minX, minY, maxX, maxY, mDepth.data(), mWidth);
+    }
+}
+
+void OcclusionCuller::buildPyramid()
+{
+    const float* source = mDepth.data();
+    glm::ivec2 sourceSize(mWidth, mHeight);
+    for (size_t level = 0; level < mPyramid.size(); level++)
+    {
+        const glm::ivec2 size = mLevelSizes[level];
+        float* destination = mPyramid[level].data();
+        for (int y = 0; y < size.y; y++)
+        {
+            const int y0 = std::min(y * 2, sourceSize.y - 1);
+            const int y1 = std::min(y * 2 + 1, sourceSize.y - 1);
+            for (int x = 0; x < size.x; x++)
+            {
+                const int x0 = std::min(x * 2, sourceSize.x - 1);
+                const int x1 = std::min(x * 2 + 1, sourceSize.x - 1);
+                // Farthest depth, a sphere in front of it is in front of every occluder below
+                destination[static_cast<size_t>(y) * size.x + x] = std::max(
+                    std::max(source[static_cast<size_t>(y0) * sourceSize.x + x0],
+                             source[static_cast<size_t>(y0) * sourceSize.x + x1]),
+                    std::max(source[static_cast<size_t>(y1) * sourceSize.x + x0],
+                             source[static_cast<size_t>(y1) * sourceSize.x + x1]));
+            }
+        }
+        source = destination;
+        sourceSize = size;
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+/// <summary>
+/// Software hierarchical-Z occlusion culling on the CPU. Occluder triangles are rasterized into a low
+/// resolution depth buffer, tile by tile on the worker threads and 8 pixels at a time with AVX2 where the
+/// CPU has it. The buffer is then reduced into a max-depth pyramid that bounding spheres are tested
+/// against, so nothing is ever read back from the GPU.
+/// </summary>
+class OcclusionCuller
+{
+public:
+    static constexpr int DEFAULT_WIDTH = 256;
+    static constexpr int DEFAULT_HEIGHT = 128;
+
+    /// <summary>
+    /// The size is rounded up to whole tiles
+    /// </summary>
+    explicit OcclusionCuller(int width = DEFAULT_WIDTH, int height = DEFAULT_HEIGHT);
+
+    /// <summary>
+    /// Clears the depth buffer and the queued occluders for a new view
+    /// </summary>
+    void beginFrame(const glm::mat4& viewProjection);
+    /// <summary>
+    /// Queues the triangles of a mesh, which must stay alive until rasterize() returns
+    /// </summary>
+    void addOccluder(const Mesh& mesh, const glm::mat4& model);
+    /// <summary>
+    /// Rasterizes the queued occluders and builds the depth pyramid
+    /// </summary>
+    void rasterize();
+    /// <summary>
+    /// True only when the world space sphere is certainly hidden behind the occluders. Spheres touching
+    /// the near plane or outside the view are never reported as occluded.
+    /// </summary>
+    bool isSphereOccluded(const glm::vec3& center, float radius) const;
+
+    /// <summary>
+    /// Forces the scalar rasterizer, for comparing it against the AVX2 one
+    /// </summary>
+    void setSimdEnabled(bool enabled);
+    size_t rasterizedTriangleCount() const;
+    int width() const;
+    int height() const;
+    /// <summary>
+    /// Normalized depth of the nearest occluder per pixel, row by row from the bottom
+    /// </summary>
+    const std::vector<float>& depthBuffer() const;
+
+private:
+    struct Occluder
+    {
+        const Mesh* mesh;
+        glm::mat4 modelViewProjection;
+        size_t firstTriangle; // Offset of the mesh's triangles in the flattened triangle range
+    };
+
+    // Screen space triangle, ready for the edge function rasterizer
+    struct ScreenTriangle
+    {
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        float depthDx;
+        float depthDy;
+        float depthC; // Depth at the pixel origin
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+        bool valid;
+    };
+
+    void setupTriangles(size_t occluderIndex, size_t triangle, ScreenTriangle* output) const;
+    void addScreenTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2, ScreenTriangle& output) const;
+    void binTriangles();
+    void rasterizeTile(int tile);
+    void buildPyramid();
+
+    int mWidth;
+    int mHeight;
+    int mTilesX;
+    int mTilesY;
+    bool mSimdEnabled;
+    glm::mat4 mViewProjection;
+    std::vector<Occluder> mOccluders;
+    size_t mTriangleCount;
+    // Two slots per source triangle, clipping against the near plane can split it in two
+    std::vector<ScreenTriangle> mTriangles;
+    std::vector<std::vector<uint32_t>> mTileBins;
+    size_t mRasterizedTriangles;
+    std::vector<float> mDepth;
+    std::vector<std::vector<float>> mPyramid; // Level 1 onwards, level 0 is mDepth
+    std::vector<glm::ivec2> mLevelSizes;
+};
@@ -0,0 +1,104 @@
+#include "OverdrawStats.h"
+
+#include <glad/glad.h>
+
+OverdrawStats::OverdrawStats() :
+    mCurrentSet(0),
+    mShadedFragments(0),
+    mSavedFragments(0),
+    mOverdraw(1.0f),
+    mHasOverdraw(false)
+{
+    for (QuerySet& set : mSets)
+    {
+        glGenQueries(QUERY_COUNT, set.queries);
+    }
+}
+
+OverdrawStats::~OverdrawStats()
+{
+    for (QuerySet& set : mSets)
+    {
+        glDeleteQueries(QUERY_COUNT, set.queries);
+    }
+}
+
+void OverdrawStats::beginFrame()
+{
+    mCurrentSet = (mCurrentSet + 1) % QUERY_SET_COUNT;
+    QuerySet& set = mSets[mCurrentSet];
+    resolve(set);
+    for (bool& used : set.used) { used = false; }
+}
+
+void OverdrawStats::beginDepthPrepass()
+{
+    beginQuery(DepthPrepass);
+}
+
+void OverdrawStats::endDepthPrepass()
+{
+    glEndQuery(GL_SAMPLES_PASSED);
+}
+
+void OverdrawStats::beginShading()
+{
+    beginQuery(Shading);
+}
+
+void OverdrawStats::endShading()
+{
+    glEndQuery(GL_SAMPLES_PASSED);
+}
+
+uint64_t OverdrawStats::shadedFragments() const
+{
+    return mShadedFragments;
+}
+
+float OverdrawStats::overdraw() const
+{
+    return mOverdraw;
+}
+
+uint64_t OverdrawStats::savedFragments() const
+{
+    return mSavedFragments;
+}
+
+bool OverdrawStats::hasOverdraw() const
+{
+    return mHasOverdraw;
+}
+
+void OverdrawStats::resolve(QuerySet& set)
+{
+    if (!set.used[Shading]) { return; }
+
+    // A frame still in flight is skipped rather than waited for
+    GLint available = 0;
+    glGetQueryObjectiv(set.queries[Shading], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) { return; }
+
+    GLuint64 shaded = 0;
+    glGetQueryObjectui64v(set.queries[Shading], GL_QUERY_RESULT, &shaded);
+    mShadedFragments = shaded;
+    mSavedFragments = 0;
+    if (!set.used[DepthPrepass]) { return; }
+
+    GLuint64 depthTested = 0;
+    glGetQueryObjectui64v(set.queries[DepthPrepass], GL_QUERY_RESULT, &depthTested);
+    if (shaded > 0)
+    {
+        mOverdraw = static_cast<float>(static_cast<double>(depthTested) / static_cast<double>(shaded));
+        mSavedFragments = depthTested > shaded ? depthTested - shaded : 0;
+        mHasOverdraw = true;
+    }
+}
+
+void OverdrawStats::beginQuery(const Query query)
+{
+    QuerySet& set = mSets[mCurrentSet];
+    glBeginQuery(GL_SAMPLES_PASSED, set.queries[query]);
+    set.used[query] = true;
+}
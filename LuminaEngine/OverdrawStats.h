@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+/// <summary>
+/// Counts the fragments of the opaque scene with GL_SAMPLES_PASSED queries, to show how much shading the
+/// depth pre-pass saves. Without the pre-pass every fragment passing the depth test is shaded. With it,
+/// the pre-pass counts those same fragments and the main pass only shades the visible ones. Queries are
+/// double-buffered and read a frame later like the profiler's.
+/// </summary>
+class OverdrawStats
+{
+public:
+    OverdrawStats();
+    ~OverdrawStats();
+
+    /// <summary>
+    /// Collects the counts of an earlier frame once the GPU has them, then starts a new frame
+    /// </summary>
+    void beginFrame();
+    void beginDepthPrepass();
+    void endDepthPrepass();
+    void beginShading();
+    void endShading();
+
+    /// <summary>
+    /// Fragments run through the object shader in the last measured frame
+    /// </summary>
+    uint64_t shadedFragments() const;
+    /// <summary>
+    /// Shaded fragments per visible pixel without the pre-pass. Only measurable while the pre-pass is on,
+    /// otherwise the last measured value is kept.
+    /// </summary>
+    float overdraw() const;
+    /// <summary>
+    /// Fragments the pre-pass kept from being shaded in the last measured frame, 0 without the pre-pass
+    /// </summary>
+    uint64_t savedFragments() const;
+    bool hasOverdraw() const;
+
+private:
+    enum Query
+    {
+        DepthPrepass,
+        Shading,
+        QUERY_COUNT
+    };
+
+    struct QuerySet
+    {
+        unsigned int queries[QUERY_COUNT] = {};
+        bool used[QUERY_COUNT] = {};
+    };
+
+    void resolve(QuerySet& set);
+    void beginQuery(Query query);
+
+    static constexpr int QUERY_SET_COUNT = 2;
+
+    QuerySet mSets[QUERY_SET_COUNT];
+    int mCurrentSet;
+    uint64_t mShadedFragments;
+    uint64_t mSavedFragments;
+    float mOverdraw;
+    bool mHasOverdraw;
+};
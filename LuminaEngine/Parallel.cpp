@@ -0,0 +1,37 @@
+#include "Parallel.h"
+
+#include <algorithm>
+#include "JobSystem.h"
+
+namespace Parallel
+{
+    unsigned int workerCount()
+    {
+        return JobSystem::workerCount();
+    }
+
+    void parallelFor(const unsigned int count, const unsigned int minRangeSize, const RangeFunction func)
+    {
+        if (count == 0) { return; }
+
+        const unsigned int maxRanges = std::max(1u, count / std::max(1u, minRangeSize));
+        const unsigned int rangeCount = std::min(workerCount(), maxRanges);
+        if (rangeCount == 1)
+        {
+            func(0, count);
+            return;
+        }
+
+        const unsigned int rangeSize = (count + rangeCount - 1) / rangeCount;
+        JobCounter ranges;
+        // Queue all ranges except the first one, the caller takes the first and then helps with the rest
+        for (unsigned int begin = rangeSize; begin < count; begin += rangeSize)
+        {
+            const unsigned int end = std::min(begin + rangeSize, count);
+            // A reference and two indices fit inside the std::function without a heap allocation
+            JobSystem::run([&func, begin, end] { func(begin, end); }, &ranges);
+        }
+        func(0, std::min(rangeSize, count));
+        JobSystem::wait(ranges);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <type_traits>
+
+namespace Parallel
+{
+    /// <summary>
+    /// Non-owning reference to a range callable, so parallelFor never copies the caller's lambda into a
+    /// std::function that may allocate
+    /// </summary>
+    struct RangeFunction
+    {
+        const void* object;
+        void (*call)(const void* object, unsigned int begin, unsigned int end);
+
+        void operator()(const unsigned int begin, const unsigned int end) const { call(object, begin, end); }
+    };
+
+    /// <summary>
+    /// Number of threads (including the calling thread) parallelFor spreads its work across
+    /// </summary>
+    unsigned int workerCount();
+
+    void parallelFor(unsigned int count, unsigned int minRangeSize, RangeFunction func);
+
+    /// <summary>
+    /// Splits [0, count) into contiguous ranges of at least minRangeSize elements and runs func on each
+    /// range, using the calling thread as one of the workers. Blocks until every range is finished.
+    /// func must not touch OpenGL, only the thread owning the context may do that.
+    /// </summary>
+    template<typename Func>
+    void parallelFor(const unsigned int count, const unsigned int minRangeSize, const Func& func)
+    {
+        using Callable = std::remove_cvref_t<Func>;
+        parallelFor(count, minRangeSize, RangeFunction{std::addressof(func),
+                    [](const void* object, const unsigned int begin, const unsigned int end)
+                    {
+                        (*static_cast<const Callable*>(object))(begin, end);
+                    }});
+    }
+}
@@ -0,0 +1,327 @@
+#include "Profiler.h"
+
+#include <fstream>
+#include <iostream>
+#include <glad/glad.h>
+#include <imgui.h>
+
+namespace
+{
+    constexpr double SMOOTHING = 0.1; // Weight of the newest frame in the averages shown in the panel
+    constexpr int CPU_THREAD_ID = 1;
+    constexpr int GPU_THREAD_ID = 2;
+
+    std::string escapeJson(const std::string_view text)
+    {
+        std::string escaped;
+        for (const char c : text)
+        {
+            if (c == '"' || c == '\\') { escaped.push_back('\\'); }
+            escaped.push_back(c);
+        }
+        return escaped;
+    }
+
+    std::pair<int, std::string_view> averageKey(const ProfileEvent& event)
+    {
+        return {event.depth, event.name};
+    }
+
+    void writeTraceEvent(std::ofstream& file, const ProfileEvent& event, const uint64_t frameIndex,
+                         const int threadId, const double startMs, const double endMs, bool& first)
+    {
+        // Chrome trace timestamps and durations are in microseconds
+        file << (first ? "" : ",\n") << "{\"name\":\"" << escapeJson(event.name) << "\",\"cat\":\""
+             << (threadId == CPU_THREAD_ID ? "cpu" : "gpu") << "\",\"ph\":\"X\",\"ts\":" << startMs * 1000.0
+             << ",\"dur\":" << (endMs - startMs) * 1000.0 << ",\"pid\":1,\"tid\":" << threadId
+             << ",\"args\":{\"frame\":" << frameIndex << "}}";
+        first = false;
+    }
+}
+
+Profiler::Profiler() :
+    mStartTime(std::chrono::steady_clock::now()),
+    mCurrentSet(0),
+    mFrameIndex(0),
+    mInFrame(false),
+    mHistoryNext(0),
+    mDroppedFrames(0)
+{
+    mHistory.reserve(HISTORY_SIZE);
+}
+
+Profiler::~Profiler()
+{
+    for (QuerySet& set : mSets)
+    {
+        if (!set.queries.empty())
+        {
+            glDeleteQueries(static_cast<GLsizei>(set.queries.size()), set.queries.data());
+        }
+    }
+}
+
+void Profiler::beginFrame(const std::string& label)
+{
+    if (mInFrame) { endFrame(); }
+
+    QuerySet& set = mSets[mCurrentSet];
+    // Results of the frame that last used this set, issued a full frame ago
+    resolve(set, false);
+
+    set.frame.label = label;
+    set.frame.index = mFrameIndex;
+    set.frame.events.clear();
+    set.eventQueries.clear();
+    set.usedQueries = 0;
+
+    GLint64 gpuTime = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+    set.gpuOffsetMs = nowMs() - static_cast<double>(gpuTime) / 1.0e6;
+
+    mInFrame = true;
+    beginScope(label);
+}
+
+void Profiler::endFrame(const bool waitForGpu)
+{
+    if (!mInFrame) { return; }
+
+    while (!mScopeStack.empty())
+    {
+        endScope();
+    }
+    mInFrame = false;
+
+    QuerySet& set = mSets[mCurrentSet];
+    set.pending = true;
+    set.keep = waitForGpu;
+    if (waitForGpu)
+    {
+        resolve(set, true);
+    }
+
+    mCurrentSet = (mCurrentSet + 1) % QUERY_SET_COUNT;
+    mFrameIndex++;
+}
+
+void Profiler::beginScope(const std::string_view name, const bool gpu)
+{
+    if (!mInFrame) { return; }
+
+    QuerySet& set = mSets[mCurrentSet];
+    mScopeStack.push_back(set.frame.events.size());
+    set.frame.events.push_back({intern(name), static_cast<int>(mScopeStack.size()) - 1, nowMs(), 0.0, -1.0, -1.0});
+    set.eventQueries.emplace_back(gpu ? issueTimestamp(set) : -1, -1);
+}
+
+void Profiler::endScope()
+{
+    if (!mInFrame || mScopeStack.empty()) { return; }
+
+    QuerySet& set = mSets[mCurrentSet];
+    const size_t event = mScopeStack.back();
+    mScopeStack.pop_back();
+    if (set.eventQueries[event].first >= 0)
+    {
+        set.eventQueries[event].second = issueTimestamp(set);
+    }
+    set.frame.events[event].cpuEndMs = nowMs();
+}
+
+void Profiler::drawUI()
+{
+    ImGui::SetNextWindowSize(ImVec2(360, 0), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Profiler");
+
+    const ProfileFrame* frame = latestFrame();
+    if (frame && ImGui::BeginTable("passes", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+    {
+        ImGui::TableSetupColumn("Pass");
+        ImGui::TableSetupColumn("CPU ms");
+        ImGui::TableSetupColumn("GPU ms");
+        ImGui::TableHeadersRow();
+        for (const ProfileEvent& event : frame->events)
+        {
+            const auto average = mAverages.find(averageKey(event));
+            if (average == mAverages.end()) { continue; }
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%*s%s", event.depth * 2, "", event.name.data());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", average->second.first);
+            ImGui::TableNextColumn();
+            if (event.gpuStartMs >= 0.0) { ImGui::Text("%.3f", average->second.second); }
+            else { ImGui::TextDisabled("-"); }
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Text("Dropped frames: %llu", static_cast<unsigned long long>(mDroppedFrames));
+
+    for (const ProfileFrame& kept : mKeptFrames)
+    {
+        if (!ImGui::CollapsingHeader(kept.label.c_str())) { continue; }
+        for (const ProfileEvent& event : kept.events)
+        {
+            ImGui::Text("%*s%s: %.2f ms CPU, %.2f ms GPU", event.depth * 2, "", event.name.data(),
+                        event.cpuEndMs - event.cpuStartMs,
+                        event.gpuStartMs >= 0.0 ? event.gpuEndMs - event.gpuStartMs : 0.0);
+        }
+    }
+
+    if (ImGui::Button("Export Chrome Trace"))
+    {
+        const std::string path = "profile_trace.json";
+        mExportStatus = exportChromeTrace(path) ? "Saved " + path : "Failed to save " + path;
+    }
+    if (!mExportStatus.empty())
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", mExportStatus.c_str());
+    }
+
+    ImGui::End();
+}
+
+bool Profiler::exportChromeTrace(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::PROFILER::Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << CPU_THREAD_ID
+         << ",\"args\":{\"name\":\"CPU\"}},\n"
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_THREAD_ID
+         << ",\"args\":{\"name\":\"GPU\"}}";
+    bool first = false;
+
+    auto writeFrame = [&file, &first](const ProfileFrame& frame)
+    {
+        for (const ProfileEvent& event : frame.events)
+        {
+            writeTraceEvent(file, event, frame.index, CPU_THREAD_ID, event.cpuStartMs, event.cpuEndMs, first);
+            if (event.gpuStartMs >= 0.0)
+            {
+                writeTraceEvent(file, event, frame.index, GPU_THREAD_ID, event.gpuStartMs, event.gpuEndMs, first);
+            }
+        }
+    };
+    for (const ProfileFrame& frame : mKeptFrames) { writeFrame(frame); }
+    // Oldest first, the ring starts at the next frame to overwrite once it is full
+    for (size_t i = 0; i < mHistory.size(); i++)
+    {
+        writeFrame(mHistory[(mHistoryNext + i) % mHistory.size()]);
+    }
+
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
+
+const ProfileFrame* Profiler::latestFrame() const
+{
+    return mHistory.empty() ? nullptr : &mHistory[(mHistoryNext + mHistory.size() - 1) % mHistory.size()];
+}
+
+const ProfileFrame* Profiler::endedFrame() const
+{
+    if (mFrameIndex == 0) { return nullptr; }
+    return &mSets[(mCurrentSet + QUERY_SET_COUNT - 1) % QUERY_SET_COUNT].frame;
+}
+
+const std::vector<ProfileFrame>& Profiler::keptFrames() const
+{
+    return mKeptFrames;
+}
+
+void Profiler::resolve(QuerySet& set, const bool wait)
+{
+    if (!set.pending) { return; }
+    set.pending = false;
+
+    if (set.usedQueries > 0 && !wait)
+    {
+        // Timestamps complete in order, so the last one being ready means all of them are
+        GLint available = 0;
+        glGetQueryObjectiv(set.queries[set.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            mDroppedFrames++;
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < set.frame.events.size(); i++)
+    {
+        const auto [beginQuery, endQuery] = set.eventQueries[i];
+        if (beginQuery < 0 || endQuery < 0) { continue; }
+
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(set.queries[beginQuery], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(set.queries[endQuery], GL_QUERY_RESULT, &end);
+        set.frame.events[i].gpuStartMs = static_cast<double>(begin) / 1.0e6 + set.gpuOffsetMs;
+        set.frame.events[i].gpuEndMs = static_cast<double>(end) / 1.0e6 + set.gpuOffsetMs;
+    }
+
+    if (set.keep)
+    {
+        mKeptFrames.push_back(set.frame);
+        return;
+    }
+
+    for (const ProfileEvent& event : set.frame.events)
+    {
+        const double cpuMs = event.cpuEndMs - event.cpuStartMs;
+        const double gpuMs = event.gpuStartMs >= 0.0 ? event.gpuEndMs - event.gpuStartMs : 0.0;
+        const auto [average, inserted] = mAverages.try_emplace(averageKey(event), cpuMs, gpuMs);
+        if (!inserted)
+        {
+            average->second.first += (cpuMs - average->second.first) * SMOOTHING;
+            average->second.second += (gpuMs - average->second.second) * SMOOTHING;
+        }
+    }
+
+    // Copy assigning keeps the capacity of the overwritten frame's events
+    if (mHistory.size() < HISTORY_SIZE) { mHistory.push_back(set.frame); }
+    else { mHistory[mHistoryNext] = set.frame; }
+    mHistoryNext = (mHistoryNext + 1) % HISTORY_SIZE;
+}
+
+int Profiler::issueTimestamp(QuerySet& set)
+{
+    if (set.usedQueries == set.queries.size())
+    {
+        unsigned int query = 0;
+        glGenQueries(1, &query);
+        set.queries.push_back(query);
+    }
+    glQueryCounter(set.queries[set.usedQueries], GL_TIMESTAMP);
+    return static_cast<int>(set.usedQueries++);
+}
+
+double Profiler::nowMs() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStartTime).count();
+}
+
+std::string_view Profiler::intern(const std::string_view name)
+{
+    auto found = mNames.find(name);
+    if (found == mNames.end()) { found = mNames.emplace(name).first; }
+    return *found;
+}
+
+ProfileScope::ProfileScope(Profiler* profiler, const std::string_view name, const bool gpu) : mProfiler(profiler)
+{
+    if (mProfiler) { mProfiler->beginScope(name, gpu); }
+}
+
+ProfileScope::~ProfileScope()
+{
+    if (mProfiler) { mProfiler->endScope(); }
+}
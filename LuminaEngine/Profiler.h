@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+struct ProfileEvent
+{
+    std::string_view name; // Interned by the profiler, valid as long as it lives
+    int depth;
+    double cpuStartMs;
+    double cpuEndMs;
+    // Mapped onto the CPU timeline. Negative when the scope was not timed on the GPU.
+    double gpuStartMs;
+    double gpuEndMs;
+};
+
+struct ProfileFrame
+{
+    std::string label;
+    uint64_t index;
+    std::vector<ProfileEvent> events; // In begin order, the first event spans the whole frame
+};
+
+/// <summary>
+/// Hierarchical CPU/GPU profiler. CPU scopes are timed with the steady clock and GPU scopes with
+/// GL_TIMESTAMP query pairs. Queries are double-buffered and read a frame later, so timing never stalls
+/// the pipeline. A frame whose results are still in flight by then is dropped. Scope names are copied
+/// once, the first time they are seen, and the event and history storage is reused, so a frame with the
+/// same scopes as the ones before does not allocate.
+/// </summary>
+class Profiler
+{
+public:
+    Profiler();
+    ~Profiler();
+
+    void beginFrame(const std::string& label = "Frame");
+    /// <summary>
+    /// With waitForGpu the results are read back right away and the frame is kept for good,
+    /// which suits one-off phases such as startup
+    /// </summary>
+    void endFrame(bool waitForGpu = false);
+    void beginScope(std::string_view name, bool gpu = true);
+    void endScope();
+
+    void drawUI();
+    bool exportChromeTrace(const std::string& path) const;
+    const ProfileFrame* latestFrame() const;
+    /// <summary>
+    /// The frame endFrame last closed. Its CPU timings are final, its GPU timings are read back later
+    /// and only reach latestFrame if the queries were ready in time.
+    /// </summary>
+    const ProfileFrame* endedFrame() const;
+    const std::vector<ProfileFrame>& keptFrames() const;
+
+private:
+    struct QuerySet
+    {
+        ProfileFrame frame;
+        std::vector<unsigned int> queries;
+        size_t usedQueries = 0;
+        std::vector<std::pair<int, int>> eventQueries; // Begin and end query of every event, -1 for none
+        double gpuOffsetMs = 0.0; // CPU minus GPU clock when the frame began
+        bool pending = false;
+        bool keep = false;
+    };
+
+    // Hashes std::string and std::string_view alike, so names are looked up without a copy
+    struct NameHash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+    };
+
+    void resolve(QuerySet& set, bool wait);
+    int issueTimestamp(QuerySet& set);
+    double nowMs() const;
+    std::string_view intern(std::string_view name);
+
+    static constexpr size_t QUERY_SET_COUNT = 2;
+    static constexpr size_t HISTORY_SIZE = 300;
+
+    std::chrono::steady_clock::time_point mStartTime;
+    QuerySet mSets[QUERY_SET_COUNT];
+    size_t mCurrentSet;
+    uint64_t mFrameIndex;
+    bool mInFrame;
+    std::vector<size_t> mScopeStack;
+    std::unordered_set<std::string, NameHash, std::equal_to<>> mNames;
+    // Ring of the last HISTORY_SIZE frames, the frames are overwritten in place once it is full
+    std::vector<ProfileFrame> mHistory;
+    size_t mHistoryNext;
+    std::vector<ProfileFrame> mKeptFrames;
+    // Smoothed CPU and GPU milliseconds per scope, keyed by depth and name
+    std::map<std::pair<int, std::string_view>, std::pair<double, double>> mAverages;
+    uint64_t mDroppedFrames;
+    std::string mExportStatus;
+};
+
+/// <summary>
+/// Times the enclosing block. A null profiler turns the scope into a no-op.
+/// </summary>
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler* profiler, std::string_view name, bool gpu = true);
+    ~ProfileScope();
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler* mProfiler;
+};
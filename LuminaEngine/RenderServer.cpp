@@ -0,0 +1,511 @@
+#include "RenderServer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <glad/glad.h>
+#include <stb_image_write.h>
+
+#include "GpuMemory.h"
+
+namespace
+{
+    constexpr float FIXED_DELTA_TIME = 1.0f / 60.0f;
+    // Jobs taken off the queue at once, every one of them may hold a frame of pixels until it is sent
+    constexpr size_t MAX_BATCH_SIZE = 16;
+    constexpr unsigned int MAX_OUTPUT_SIZE = 8192;
+
+    double millisecondsBetween(const std::chrono::steady_clock::time_point start,
+                               const std::chrono::steady_clock::time_point end)
+    {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    bool parseFloats(const std::string& text, float* values, const int count)
+    {
+        std::istringstream stream(text);
+        for (int i = 0; i < count; i++)
+        {
+            if (i > 0 && stream.get() != ',') { return false; }
+            if (!(stream >> values[i])) { return false; }
+        }
+        return stream.peek() == std::char_traits<char>::eof();
+    }
+
+    bool parseFlag(const std::string& text, bool& value)
+    {
+        if (text != "0" && text != "1") { return false; }
+        value = text == "1";
+        return true;
+    }
+
+    void appendBytes(void* context, void* data, const int size)
+    {
+        auto* bytes = static_cast<std::vector<unsigned char>*>(context);
+        bytes->insert(bytes->end(), static_cast<unsigned char*>(data), static_cast<unsigned char*>(data) + size);
+    }
+
+    // Nearest rank percentile of sorted values
+    double percentile(const std::vector<double>& sorted, const double p)
+    {
+        const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+}
+
+RenderServer::Client::~Client()
+{
+    if (socket >= 0) { close(socket); }
+}
+
+RenderServer::RenderServer(Renderer& renderer, const RenderSettings& settings, const unsigned int outputFramebuffer,
+                           const unsigned int outputRenderbuffer, const double startupMs) :
+    mRenderer(renderer),
+    mSettings(settings),
+    mOutputFramebuffer(outputFramebuffer),
+    mOutputRenderbuffer(outputRenderbuffer),
+    mOutputWidth(0),
+    mOutputHeight(0),
+    mDefaultWidth(0),
+    mDefaultHeight(0),
+    mStartupMs(startupMs),
+    mStop(false)
+{
+    // Jobs are unrelated frames, history from the previous one would only ghost into the next
+    mSettings.enableTaa = false;
+    mSettings.enableDynamicResolution = false;
+
+    GLint width = 0;
+    GLint height = 0;
+    glBindRenderbuffer(GL_RENDERBUFFER, mOutputRenderbuffer);
+    glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_WIDTH, &width);
+    glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_HEIGHT, &height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    mOutputWidth = static_cast<unsigned int>(width);
+    mOutputHeight = static_cast<unsigned int>(height);
+    mDefaultWidth = mOutputWidth;
+    mDefaultHeight = mOutputHeight;
+
+    mLatencies.reserve(LATENCY_WINDOW);
+
+    // Read back rows start at the bottom of the image
+    stbi_flip_vertically_on_write(1);
+}
+
+RenderServer::~RenderServer()
+{
+    stop();
+    if (mListenSocket >= 0)
+    {
+        // Wakes the accept call
+        shutdown(mListenSocket, SHUT_RDWR);
+    }
+    if (mAcceptThread.joinable()) { mAcceptThread.join(); }
+    if (mReadback) { mReadback->deinit(); }
+
+    // The accept thread is gone, nothing adds connections any more
+    for (Connection& connection : mConnections) { shutdown(connection.client->socket, SHUT_RDWR); }
+    for (Connection& connection : mConnections) { connection.thread.join(); }
+
+    if (mListenSocket >= 0)
+    {
+        close(mListenSocket);
+        unlink(mSocketPath.c_str());
+    }
+}
+
+bool RenderServer::listen(const std::string& socketPath)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        std::cout << "ERROR::RENDER_SERVER::Socket path too long: " << socketPath << std::endl;
+        return false;
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    mListenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (mListenSocket < 0)
+    {
+        std::cout << "ERROR::RENDER_SERVER::Failed to create a socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // A socket file left behind by a server that did not shut down cleanly
+    unlink(socketPath.c_str());
+    if (bind(mListenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(mListenSocket, SOMAXCONN) != 0)
+    {
+        std::cout << "ERROR::RENDER_SERVER::Failed to listen on " << socketPath << ": " << std::strerror(errno)
+                  << std::endl;
+        close(mListenSocket);
+        mListenSocket = -1;
+        return false;
+    }
+
+    mSocketPath = socketPath;
+    mAcceptThread = std::thread(&RenderServer::acceptThread, this);
+    std::cout << "Listening on " << socketPath << ", the " << mStartupMs
+              << " ms startup is paid once instead of per request" << std::endl;
+    return true;
+}
+
+void RenderServer::run()
+{
+    while (true)
+    {
+        std::vector<Job> batch;
+        {
+            std::unique_lock<std::mutex> lock(mQueueMutex);
+            mQueueReady.wait(lock, [&] { return mStop.load() || !mQueue.empty(); });
+            if (mStop.load()) { break; }
+
+            const size_t count = std::min(mQueue.size(), MAX_BATCH_SIZE);
+            batch.assign(std::make_move_iterator(mQueue.begin()), std::make_move_iterator(mQueue.begin() + count));
+            mQueue.erase(mQueue.begin(), mQueue.begin() + count);
+        }
+
+        // Jobs of the same size render back to back, so the targets are resized once per size
+        std::stable_sort(batch.begin(), batch.end(), [](const Job& a, const Job& b)
+        {
+            return a.width != b.width ? a.width < b.width : a.height < b.height;
+        });
+        size_t first = 0;
+        while (first < batch.size())
+        {
+            size_t last = first + 1;
+            while (last < batch.size() && batch[last].width == batch[first].width &&
+                   batch[last].height == batch[first].height)
+            {
+                last++;
+            }
+            std::vector<Job> group(std::make_move_iterator(batch.begin() + first),
+                                   std::make_move_iterator(batch.begin() + last));
+            renderBatch(group);
+            first = last;
+        }
+    }
+}
+
+void RenderServer::renderBatch(std::vector<Job>& jobs)
+{
+    setOutputSize(jobs.front().width, jobs.front().height);
+    if (!mReadback)
+    {
+        mReadback = std::make_unique<FrameReadback>(static_cast<int>(mOutputWidth), static_cast<int>(mOutputHeight),
+                                                    [this](const int frame, std::vector<unsigned char>&& pixels)
+        {
+            Job& job = (*mBatch)[frame];
+            job.renderMs = millisecondsBetween(job.received, std::chrono::steady_clock::now()) - job.queueMs;
+            JobSystem::run([this, &job, pixels = std::move(pixels)]() mutable
+            {
+                finishJob(job, std::move(pixels));
+            }, &mSent);
+        });
+    }
+
+    Profiler& profiler = mRenderer.getProfiler();
+    mBatch = &jobs;
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        Job& job = jobs[i];
+        job.queueMs = millisecondsBetween(job.received, std::chrono::steady_clock::now());
+        profiler.beginFrame();
+        mRenderer.render(job.camera, job.settings, FIXED_DELTA_TIME);
+        mReadback->capture(mOutputFramebuffer, static_cast<int>(i));
+        profiler.endFrame();
+    }
+    mReadback->flush();
+    JobSystem::wait(mSent);
+    mBatch = nullptr;
+}
+
+void RenderServer::setOutputSize(const unsigned int width, const unsigned int height)
+{
+    if (width == mOutputWidth && height == mOutputHeight) { return; }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, mOutputRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    GpuMemory::track(GpuResourceType::Renderbuffer, mOutputRenderbuffer,
+                     GpuMemory::textureBytes(GL_RGBA8, static_cast<int>(width), static_cast<int>(height)),
+                     "Render Targets", "Output color");
+    mRenderer.resize(width, height);
+    mOutputWidth = width;
+    mOutputHeight = height;
+
+    // The pack buffers are sized for the old output, the next batch allocates new ones
+    if (mReadback)
+    {
+        mReadback->deinit();
+        mReadback.reset();
+    }
+}
+
+void RenderServer::finishJob(Job& job, std::vector<unsigned char>&& pixels)
+{
+    const int width = static_cast<int>(job.width);
+    const int height = static_cast<int>(job.height);
+    std::vector<unsigned char> payload;
+    if (job.raw)
+    {
+        // Same row order as the PNG
+        const size_t rowBytes = static_cast<size_t>(width) * 4;
+        payload.resize(pixels.size());
+        for (int y = 0; y < height; y++)
+        {
+            std::memcpy(payload.data() + static_cast<size_t>(y) * rowBytes,
+                        pixels.data() + static_cast<size_t>(height - 1 - y) * rowBytes, rowBytes);
+        }
+    }
+    else if (!stbi_write_png_to_func(appendBytes, &payload, width, height, 4, pixels.data(), width * 4))
+    {
+        reply(*job.client, "error job=" + std::to_string(job.id) + " PNG encoding failed\n");
+        return;
+    }
+
+    const double totalMs = millisecondsBetween(job.received, std::chrono::steady_clock::now());
+    char header[256];
+    std::snprintf(header, sizeof(header),
+                  "ok job=%llu format=%s width=%d height=%d bytes=%zu queue_ms=%.3f render_ms=%.3f total_ms=%.3f\n",
+                  static_cast<unsigned long long>(job.id), job.raw ? "raw" : "png", width, height, payload.size(),
+                  job.queueMs, job.renderMs, totalMs);
+    reply(*job.client, header, payload.data(), payload.size());
+    recordLatency(totalMs);
+
+    // One insertion, so lines of jobs finishing together do not interleave
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(3) << "Job " << job.id << ": " << width << "x" << height << " "
+           << (job.raw ? "raw" : "png") << ", queued " << job.queueMs << " ms, rendered " << job.renderMs
+           << " ms, total " << totalMs << " ms\n";
+    std::cout << report.str() << std::flush;
+}
+
+void RenderServer::acceptThread()
+{
+    while (!mStop.load())
+    {
+        const int socket = accept(mListenSocket, nullptr, nullptr);
+        if (socket < 0)
+        {
+            if (errno == EINTR) { continue; }
+            break; // Listening socket shut down
+        }
+
+        // Threads of the connections closed since the last accept are done
+        for (Connection& connection : mConnections)
+        {
+            if (connection.client->isClosed.load()) { connection.thread.join(); }
+        }
+        mConnections.erase(std::remove_if(mConnections.begin(), mConnections.end(),
+                                          [](const Connection& connection) { return !connection.thread.joinable(); }),
+                           mConnections.end());
+
+        auto client = std::make_shared<Client>();
+        client->socket = socket;
+        mConnections.push_back({client, std::thread(&RenderServer::clientThread, this, client)});
+    }
+}
+
+void RenderServer::clientThread(std::shared_ptr<Client> client)
+{
+    std::string pending;
+    char buffer[4096];
+    while (true)
+    {
+        const ssize_t received = recv(client->socket, buffer, sizeof(buffer), 0);
+        if (received <= 0) { break; }
+        pending.append(buffer, static_cast<size_t>(received));
+
+        size_t lineEnd;
+        while ((lineEnd = pending.find('\n')) != std::string::npos)
+        {
+            std::string line = pending.substr(0, lineEnd);
+            pending.erase(0, lineEnd + 1);
+            if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+            if (line.empty()) { continue; }
+
+            const std::string command = line.substr(0, line.find(' '));
+            if (command == "render")
+            {
+                Job job;
+                job.client = client;
+                job.id = client->nextJob++;
+                job.received = std::chrono::steady_clock::now();
+                std::string error;
+                if (!parseJob(line, job, error))
+                {
+                    reply(*client, "error job=" + std::to_string(job.id) + " " + error + "\n");
+                    continue;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mQueueMutex);
+                    mQueue.push_back(std::move(job));
+                }
+                mQueueReady.notify_one();
+            }
+            else if (command == "stats")
+            {
+                reply(*client, statsReply());
+            }
+            else if (command == "shutdown")
+            {
+                reply(*client, "ok\n");
+                stop();
+            }
+            else
+            {
+                reply(*client, "error Unknown command: " + command + "\n");
+            }
+        }
+    }
+
+    client->isClosed.store(true);
+}
+
+bool RenderServer::parseJob(const std::string& line, Job& job, std::string& error) const
+{
+    job.width = mDefaultWidth;
+    job.height = mDefaultHeight;
+    job.settings = mSettings;
+
+    std::istringstream stream(line);
+    std::string token;
+    stream >> token; // The command
+    while (stream >> token)
+    {
+        const size_t separator = token.find('=');
+        if (separator == std::string::npos)
+        {
+            error = "Expected key=value: " + token;
+            return false;
+        }
+        const std::string key = token.substr(0, separator);
+        const std::string value = token.substr(separator + 1);
+        float vector[3] = {0.0f, 0.0f, 0.0f};
+
+        bool isValid = true;
+        if (key == "width" || key == "height")
+        {
+            const int size = std::atoi(value.c_str());
+            isValid = size > 0 && static_cast<unsigned int>(size) <= MAX_OUTPUT_SIZE;
+            (key == "width" ? job.width : job.height) = static_cast<unsigned int>(size);
+        }
+        else if (key == "position")
+        {
+            isValid = parseFloats(value, vector, 3);
+            job.camera.position = glm::vec3(vector[0], vector[1], vector[2]);
+        }
+        else if (key == "front")
+        {
+            isValid = parseFloats(value, vector, 3) && glm::length(glm::vec3(vector[0], vector[1], vector[2])) > 0.0f;
+            if (isValid) { job.camera.front = glm::normalize(glm::vec3(vector[0], vector[1], vector[2])); }
+        }
+        else if (key == "fov")
+        {
+            isValid = parseFloats(value, vector, 1) && vector[0] > 0.0f && vector[0] < 180.0f;
+            job.camera.fov = vector[0];
+        }
+        else if (key == "format")
+        {
+            isValid = value == "png" || value == "raw";
+            job.raw = value == "raw";
+        }
+        else if (key == "object_position") { isValid = parseFloats(value, job.settings.position, 3); }
+        else if (key == "object_rotation") { isValid = parseFloats(value, job.settings.rotation, 3); }
+        else if (key == "object_scale") { isValid = parseFloats(value, job.settings.scale, 3); }
+        else if (key == "skybox") { isValid = parseFlag(value, job.settings.showSkybox); }
+        else if (key == "ibl") { isValid = parseFlag(value, job.settings.enableIBL); }
+        else if (key == "bloom") { isValid = parseFlag(value, job.settings.enableBloom); }
+        else if (key == "ssao") { isValid = parseFlag(value, job.settings.enableSsao); }
+        else if (key == "shadows") { isValid = parseFlag(value, job.settings.enableShadows); }
+        else if (key == "point_lights") { isValid = parseFlag(value, job.settings.enablePointLights); }
+        else
+        {
+            error = "Unknown key: " + key;
+            return false;
+        }
+
+        if (!isValid)
+        {
+            error = "Invalid value for " + key + ": " + value;
+            return false;
+        }
+    }
+    return true;
+}
+
+void RenderServer::recordLatency(const double totalMs)
+{
+    std::lock_guard<std::mutex> lock(mStatsMutex);
+    if (mLatencies.size() < LATENCY_WINDOW) { mLatencies.push_back(totalMs); }
+    else { mLatencies[mJobCount % LATENCY_WINDOW] = totalMs; }
+    mJobCount++;
+}
+
+std::string RenderServer::statsReply()
+{
+    std::vector<double> sorted;
+    uint64_t jobCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(mStatsMutex);
+        sorted = mLatencies;
+        jobCount = mJobCount;
+    }
+    char text[256];
+    if (sorted.empty())
+    {
+        std::snprintf(text, sizeof(text), "ok jobs=0 startup_ms=%.3f\n", mStartupMs);
+        return text;
+    }
+
+    std::sort(sorted.begin(), sorted.end());
+    double totalMs = 0.0;
+    for (const double latency : sorted) { totalMs += latency; }
+    std::snprintf(text, sizeof(text), "ok jobs=%llu startup_ms=%.3f mean_ms=%.3f p50_ms=%.3f p99_ms=%.3f max_ms=%.3f\n",
+                  static_cast<unsigned long long>(jobCount), mStartupMs, totalMs / static_cast<double>(sorted.size()), percentile(sorted, 50.0),
+                  percentile(sorted, 99.0), sorted.back());
+    return text;
+}
+
+void RenderServer::reply(Client& client, const std::string& header, const unsigned char* payload,
+                         const size_t payloadBytes)
+{
+    std::lock_guard<std::mutex> lock(client.writeMutex);
+    const auto sendAll = [&](const void* data, size_t bytes)
+    {
+        const auto* cursor = static_cast<const char*>(data);
+        while (bytes > 0)
+        {
+            // A client gone away must not take the server down with SIGPIPE
+            const ssize_t written = send(client.socket, cursor, bytes, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR) { continue; }
+            if (written <= 0) { return false; }
+            cursor += written;
+            bytes -= static_cast<size_t>(written);
+        }
+        return true;
+    };
+    if (sendAll(header.data(), header.size()) && payloadBytes > 0)
+    {
+        sendAll(payload, payloadBytes);
+    }
+}
+
+void RenderServer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mStop.store(true);
+    }
+    mQueueReady.notify_all();
+}
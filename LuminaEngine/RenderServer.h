@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameReadback.h"
+#include "JobSystem.h"
+#include "Renderer.h"
+
+/// <summary>
+/// Keeps a renderer resident and takes render jobs over a Unix domain socket, so the model import,
+/// shader compiles and IBL bake are paid once instead of per request. Requests are text lines:
+///
+///   render [width=W] [height=H] [position=x,y,z] [front=x,y,z] [fov=deg] [format=png|raw]
+///          [object_position=x,y,z] [object_rotation=x,y,z] [object_scale=x,y,z] [skybox=0|1] [ibl=0|1]
+///          [bloom=0|1] [ssao=0|1] [shadows=0|1] [point_lights=0|1]
+///   stats
+///   shutdown
+///
+/// A render is answered with "ok job=N format=F width=W height=H bytes=B queue_ms=Q render_ms=R total_ms=T"
+/// and a newline, followed by B bytes of PNG or top row first RGBA8. Jobs are numbered per connection in
+/// request order, replies may arrive out of order. Failures are answered with "error message". Stats report
+/// the number of jobs served and the latencies of the last LATENCY_WINDOW of them.
+/// TAA and dynamic resolution are always off, jobs are unrelated frames without a history to resolve against,
+/// so there is no key for them and "taa" is rejected as unknown.
+/// </summary>
+class RenderServer
+{
+public:
+    static constexpr size_t LATENCY_WINDOW = 1024;
+
+    /// <summary>
+    /// Renders into the given framebuffer, the renderbuffer attached to it is resized with the jobs.
+    /// startupMs is what a cold start took, reported next to the job latencies for comparison.
+    /// </summary>
+    RenderServer(Renderer& renderer, const RenderSettings& settings, unsigned int outputFramebuffer,
+                 unsigned int outputRenderbuffer, double startupMs);
+    ~RenderServer();
+    RenderServer(const RenderServer&) = delete;
+    RenderServer& operator=(const RenderServer&) = delete;
+
+    bool listen(const std::string& socketPath);
+    /// <summary>
+    /// Serves jobs on the thread owning the OpenGL context until a shutdown request arrives
+    /// </summary>
+    void run();
+
+private:
+    struct Client
+    {
+        ~Client();
+
+        int socket = -1;
+        uint64_t nextJob = 0;
+        std::mutex writeMutex; // Replies are written from the encoding jobs
+        std::atomic<bool> isClosed{false};
+    };
+
+    struct Connection
+    {
+        std::shared_ptr<Client> client;
+        std::thread thread;
+    };
+
+    struct Job
+    {
+        std::shared_ptr<Client> client;
+        uint64_t id = 0;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        Camera camera;
+        RenderSettings settings;
+        bool raw = false;
+        std::chrono::steady_clock::time_point received;
+        double queueMs = 0.0;
+        double renderMs = 0.0;
+    };
+
+    void acceptThread();
+    void clientThread(std::shared_ptr<Client> client);
+    bool parseJob(const std::string& line, Job& job, std::string& error) const;
+    void renderBatch(std::vector<Job>& jobs);
+    void setOutputSize(unsigned int width, unsigned int height);
+    void finishJob(Job& job, std::vector<unsigned char>&& pixels);
+    void recordLatency(double totalMs);
+    std::string statsReply();
+    static void reply(Client& client, const std::string& header, const unsigned char* payload = nullptr,
+                      size_t payloadBytes = 0);
+    void stop();
+
+private:
+    Renderer& mRenderer;
+    RenderSettings mSettings;
+    unsigned int mOutputFramebuffer;
+    unsigned int mOutputRenderbuffer;
+    unsigned int mOutputWidth;
+    unsigned int mOutputHeight;
+    // Size of jobs that do not ask for one, read by the connection threads
+    unsigned int mDefaultWidth;
+    unsigned int mDefaultHeight;
+    double mStartupMs;
+    // Kept between batches, reallocated only when the output size changes
+    std::unique_ptr<FrameReadback> mReadback;
+    std::vector<Job>* mBatch = nullptr; // Jobs of the batch being read back
+    JobCounter mSent;
+
+    std::string mSocketPath;
+    int mListenSocket = -1;
+    std::thread mAcceptThread;
+    std::vector<Connection> mConnections; // Owned by the accept thread until it is joined
+
+    std::mutex mQueueMutex;
+    std::condition_variable mQueueReady;
+    std::deque<Job> mQueue;
+    std::atomic<bool> mStop;
+
+    std::mutex mStatsMutex;
+    std::vector<double> mLatencies; // Ring of the last LATENCY_WINDOW job latencies
+    uint64_t mJobCount = 0;
+};
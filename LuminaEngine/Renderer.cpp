@@ -0,0 +1,965 @@
+#include "Renderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <span>
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "FrameArena.h"
+#include "GpuMemory.h"
+#include "JobSystem.h"
+#include "TextureUtils.h"
+
+namespace
+{
+    constexpr int CUBE_FACE_COUNT = 6;
+
+    const char* OBJ_V_SHADER_PATH = "Assets/Shaders/shader_object.vert";
+    const char* OBJ_F_SHADER_PATH = "Assets/Shaders/shader_object.frag";
+
+    const char* LIGHT_V_SHADER_PATH = "Assets/Shaders/shader_light.vert";
+    const char* LIGHT_F_SHADER_PATH = "Assets/Shaders/shader_light.frag";
+
+    const char* SCR_V_SHADER_PATH = "Assets/Shaders/shader_screen.vert";
+    const char* SCR_F_SHADER_PATH = "Assets/Shaders/shader_screen.frag";
+
+    const char* SKYBOX_V_SHADER_PATH = "Assets/Shaders/shader_skybox.vert";
+    const char* SKYBOX_F_SHADER_PATH = "Assets/Shaders/shader_skybox.frag";
+
+    const char* EQR_TO_CUBE_V_SHADER_PATH = "Assets/Shaders/shader_cube_capture.vert";
+    const char* EQR_TO_CUBE_F_SHADER_PATH = "Assets/Shaders/shader_eqrect_to_cubemap.frag";
+
+    const char* IRRADIANCE_V_SHADER_PATH = "Assets/Shaders/shader_cube_capture.vert";
+    const char* IRRADIANCE_F_SHADER_PATH = "Assets/Shaders/shader_irradiance.frag";
+
+    const char* PREFILTER_V_SHADER_PATH = "Assets/Shaders/shader_cube_capture.vert";
+    const char* PREFILTER_F_SHADER_PATH = "Assets/Shaders/shader_prefilter.frag";
+
+    const char* BRDF_V_SHADER_PATH = "Assets/Shaders/shader_brdf.vert";
+    const char* BRDF_F_SHADER_PATH = "Assets/Shaders/shader_brdf.frag";
+
+    const char* CULL_C_SHADER_PATH = "Assets/Shaders/shader_cull.comp";
+
+    const char* DEPTH_PREPASS_V_SHADER_PATH = "Assets/Shaders/shader_depth_prepass.vert";
+    const char* DEPTH_F_SHADER_PATH = "Assets/Shaders/shader_depth.frag";
+
+    constexpr int SKYBOX_RES = 2048;
+    constexpr int IRRADIANCE_MAP_RES = 128;
+    constexpr int PREFILTER_MAP_RES = 128;
+    constexpr int BRDF_MAP_RES = 512;
+
+    // Reserving unit 0 to 4 for PBR/phong material texture maps, 12 and 13 for parking unused material samplers
+    // and 14, 15 for shadow maps. GL 3.3 only guarantees 16 units, so the object shader must stay below 16.
+    constexpr unsigned int skyboxTexUnit = 5;
+    constexpr unsigned int hdriTexUnit = 6;
+    constexpr unsigned int screenTexUnit = 7;
+    constexpr unsigned int irradianceTexUnit = 8;
+    constexpr unsigned int prefilterTexUnit = 9;
+    constexpr unsigned int brdfLutTexUnit = 10;
+    constexpr unsigned int bloomBlurTexUnit = 11;
+    constexpr unsigned int cascadeShadowTexUnit = 14;
+    constexpr unsigned int pointShadowTexUnit = 15;
+    // The HDRI is only bound while the IBL maps are baked, its unit is free once frames render
+    constexpr unsigned int ssaoTexUnit = hdriTexUnit;
+    // Only the composite pass samples the screen and bloom units, and it runs after every pass drawing the model
+    constexpr unsigned int nodeTransformTexUnit = screenTexUnit;
+    constexpr unsigned int prevNodeTransformTexUnit = bloomBlurTexUnit;
+
+    const glm::vec3 dirLightDirection(-0.2f, -1.0f, -0.3f);
+
+    const glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+    const glm::mat4 captureViews[] =
+    {
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
+    };
+
+    const glm::vec3 pointLightPositions[] = {
+            glm::vec3(1.2f,  0.2f,  2.0f),
+            glm::vec3(-1.2f,  0.5f,  2.0f),
+            glm::vec3(-1.0f, 0.3f, -4.0f),
+            glm::vec3(1.0f,  0.0f, -3.7f)
+    };
+
+    const glm::vec3 pointLightColors[] = {
+            glm::vec3(1.0f, 1.0f, 1.0f),
+            glm::vec3(1.0f, 0.0f, 0.0f),
+            glm::vec3(0.0f, 1.0f, 0.0f),
+            glm::vec3(0.0f, 0.0f, 1.0f),
+    };
+}
+
+Renderer::Renderer(const RendererConfig& config) : config(config)
+{
+    profiler = new Profiler();
+    GpuMemory::setBudget(static_cast<size_t>(config.gpuMemoryBudgetMb * 1024.0f * 1024.0f));
+}
+
+Renderer::~Renderer()
+{
+    delete(modelAsset);
+    delete(textureStreamer);
+    delete(objectShader);
+    delete(lightPreview);
+    delete(lightShader);
+    delete(screenShader);
+    delete(skyboxShader);
+    delete(equirectToCubemapShader);
+    delete(irradianceShader);
+    delete(prefilterShader);
+    delete(brdfShader);
+    delete(cullShader);
+    delete(depthPrepassShader);
+    delete(overdrawStats);
+    delete(occlusionCuller);
+    delete(framePreparer);
+    delete(bloomRenderer);
+    delete(temporalAA);
+    delete(shadowRenderer);
+    delete(ssaoRenderer);
+    delete(frameGraph);
+    delete(profiler);
+
+    for (const unsigned int texture : {skyboxTex, irradianceMapTex, prefiltetMapTex, brdfLutTex})
+    {
+        GpuMemory::release(GpuResourceType::Texture, texture);
+    }
+    GpuMemory::release(GpuResourceType::Buffer, quadVBO);
+    GpuMemory::release(GpuResourceType::Buffer, cubeVBO);
+    glDeleteTextures(1, &skyboxTex);
+    glDeleteTextures(1, &irradianceMapTex);
+    glDeleteTextures(1, &prefiltetMapTex);
+    glDeleteTextures(1, &brdfLutTex);
+    glDeleteVertexArrays(1, &quadVAO);
+    glDeleteBuffers(1, &quadVBO);
+    glDeleteVertexArrays(1, &cubeVAO);
+    glDeleteBuffers(1, &cubeVBO);
+}
+
+void Renderer::init()
+{
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+    profiler->beginFrame("Startup");
+
+    profiler->beginScope("Load Model");
+    textureStreamer = new TextureStreamer(static_cast<size_t>(config.textureBudgetMb * 1024.0f * 1024.0f));
+    modelAsset = new Model(config.modelPath, config.isPbr, textureStreamer, config.packMaterialTextures);
+    profiler->endScope();
+
+    profiler->beginScope("Compile Shaders");
+    objectShader = new Shader(OBJ_V_SHADER_PATH, OBJ_F_SHADER_PATH);
+    lightPreview = new LightPreview();
+    lightShader = new Shader(LIGHT_V_SHADER_PATH, LIGHT_F_SHADER_PATH);
+    screenShader = new Shader(SCR_V_SHADER_PATH, SCR_F_SHADER_PATH);
+    skyboxShader = new Shader(SKYBOX_V_SHADER_PATH, SKYBOX_F_SHADER_PATH);
+    equirectToCubemapShader = new Shader(EQR_TO_CUBE_V_SHADER_PATH, EQR_TO_CUBE_F_SHADER_PATH);
+    irradianceShader = new Shader(IRRADIANCE_V_SHADER_PATH, IRRADIANCE_F_SHADER_PATH);
+    prefilterShader = new Shader(PREFILTER_V_SHADER_PATH, PREFILTER_F_SHADER_PATH);
+    gpuCullingSupported = GLAD_GL_VERSION_4_3;
+    if (gpuCullingSupported)
+    {
+        cullShader = new Shader(CULL_C_SHADER_PATH);
+    }
+    brdfShader = new Shader(BRDF_V_SHADER_PATH, BRDF_F_SHADER_PATH);
+    depthPrepassShader = new Shader(DEPTH_PREPASS_V_SHADER_PATH, DEPTH_F_SHADER_PATH);
+    overdrawStats = new OverdrawStats();
+    profiler->endScope();
+
+    // Skybox texture setup
+    glGenTextures(1, &skyboxTex);
+    glActiveTexture(GL_TEXTURE0 + skyboxTexUnit);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTex);
+    for (unsigned int i = 0; i < CUBE_FACE_COUNT; i++)
+    {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+            0, GL_RGB16F, SKYBOX_RES, SKYBOX_RES, 0, GL_RGB, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Mips are generated once the cubemap is captured
+    GpuMemory::track(GpuResourceType::Texture, skyboxTex,
+                     GpuMemory::textureBytes(GL_RGB16F, SKYBOX_RES, SKYBOX_RES,
+                                             GpuMemory::fullMipCount(SKYBOX_RES, SKYBOX_RES), CUBE_FACE_COUNT),
+                     "Environment", "Skybox cubemap");
+
+    // Irradiance map texture setup
+    glGenTextures(1, &irradianceMapTex);
+    glActiveTexture(GL_TEXTURE0 + irradianceTexUnit);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMapTex);
+    for (unsigned int i = 0; i < CUBE_FACE_COUNT; i++)
+    {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+            0, GL_RGB16F, IRRADIANCE_MAP_RES, IRRADIANCE_MAP_RES, 0, GL_RGB, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    GpuMemory::track(GpuResourceType::Texture, irradianceMapTex,
+                     GpuMemory::textureBytes(GL_RGB16F, IRRADIANCE_MAP_RES, IRRADIANCE_MAP_RES, 1, CUBE_FACE_COUNT),
+                     "Environment", "Irradiance cubemap");
+
+    // Prefilter map texture setup
+    glGenTextures(1, &prefiltetMapTex);
+    glActiveTexture(GL_TEXTURE0 + prefilterTexUnit);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, prefiltetMapTex);
+    for (unsigned int i = 0; i < CUBE_FACE_COUNT; i++)
+    {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+            0, GL_RGB16F, PREFILTER_MAP_RES, PREFILTER_MAP_RES, 0, GL_RGB, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Generate mipmaps for the cubemap so OpenGL automatically allocates the required memory
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    GpuMemory::track(GpuResourceType::Texture, prefiltetMapTex,
+                     GpuMemory::textureBytes(GL_RGB16F, PREFILTER_MAP_RES, PREFILTER_MAP_RES,
+                                             GpuMemory::fullMipCount(PREFILTER_MAP_RES, PREFILTER_MAP_RES),
+                                             CUBE_FACE_COUNT),
+                     "Environment", "Prefilter cubemap");
+
+    // BRDF LUT map texture setup
+    glGenTextures(1, &brdfLutTex);
+    glActiveTexture(GL_TEXTURE0 + brdfLutTexUnit);
+    glBindTexture(GL_TEXTURE_2D, brdfLutTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, BRDF_MAP_RES, BRDF_MAP_RES, 0, GL_RG, GL_FLOAT, nullptr);
+    GpuMemory::track(GpuResourceType::Texture, brdfLutTex, GpuMemory::textureBytes(GL_RG16F, BRDF_MAP_RES, BRDF_MAP_RES),
+                     "Environment", "BRDF LUT");
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Load cubemap
+    profiler->beginScope("Load HDRI");
+    glActiveTexture(GL_TEXTURE0 + hdriTexUnit);
+    hdriTexture = TextureUtils::loadHdrImage(config.hdrImagePath, config.verbose);
+    glBindTexture(GL_TEXTURE_2D, hdriTexture);
+    profiler->endScope();
+
+    // The capture depth targets only live while the environment maps are baked, the graph frees them
+    // when it goes out of scope
+    FrameGraph bakeGraph("Environment");
+    const FrameGraphResource skybox = bakeGraph.importTexture("Skybox cubemap", skyboxTex);
+    const FrameGraphResource irradianceMap = bakeGraph.importTexture("Irradiance cubemap", irradianceMapTex);
+    const FrameGraphResource prefilterMap = bakeGraph.importTexture("Prefilter cubemap", prefiltetMapTex);
+    const FrameGraphResource brdfLut = bakeGraph.importTexture("BRDF LUT", brdfLutTex);
+    const FrameGraphResource skyboxDepth =
+        bakeGraph.createTexture("Skybox capture depth", {SKYBOX_RES, SKYBOX_RES, GL_DEPTH_COMPONENT24, false});
+    const FrameGraphResource irradianceDepth = bakeGraph.createTexture(
+        "Irradiance capture depth", {IRRADIANCE_MAP_RES, IRRADIANCE_MAP_RES, GL_DEPTH_COMPONENT24, false});
+    // Smaller mips render into the corner of the full size depth target
+    const FrameGraphResource prefilterDepth = bakeGraph.createTexture(
+        "Prefilter capture depth", {PREFILTER_MAP_RES, PREFILTER_MAP_RES, GL_DEPTH_COMPONENT24, false});
+    const FrameGraphResource brdfDepth =
+        bakeGraph.createTexture("BRDF capture depth", {BRDF_MAP_RES, BRDF_MAP_RES, GL_DEPTH_COMPONENT24, false});
+
+    // Convert HDR equirectangular environment map to cubemap equivalent
+    bakeGraph.addPass("Equirect To Cubemap", {}, {skybox, skyboxDepth}, [&](FrameGraph& graph)
+    {
+        graph.bindFramebuffer({}, skyboxDepth);
+        equirectToCubemapShader->use();
+        equirectToCubemapShader->setMat4("projection", captureProjection);
+        equirectToCubemapShader->setInt("equirectangularMap", hdriTexUnit);
+
+        glViewport(0, 0, SKYBOX_RES, SKYBOX_RES); // Configure the viewport to the capture dimensions
+        for (int i = 0; i < CUBE_FACE_COUNT; i++)
+        {
+            equirectToCubemapShader->setMat4("view", captureViews[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                   GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, skyboxTex, 0);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            renderCube();
+        }
+
+        // The equirectangular source is only needed to build the skybox cubemap, so release it right away
+        // instead of keeping the full resolution HDR image resident for the whole session
+        GpuMemory::release(GpuResourceType::Texture, hdriTexture);
+        glDeleteTextures(1, &hdriTexture);
+        hdriTexture = 0;
+
+        // Generate mipmaps of skybox
+        glActiveTexture(GL_TEXTURE0 + skyboxTexUnit);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTex);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    });
+
+    bakeGraph.addPass("Irradiance Map", {skybox}, {irradianceMap, irradianceDepth}, [&](FrameGraph& graph)
+    {
+        graph.bindFramebuffer({}, irradianceDepth);
+        irradianceShader->use();
+        irradianceShader->setMat4("projection", captureProjection);
+        irradianceShader->setInt("environmentMap", skyboxTexUnit);
+        glActiveTexture(GL_TEXTURE0 + skyboxTexUnit);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTex);
+        glViewport(0, 0, IRRADIANCE_MAP_RES, IRRADIANCE_MAP_RES);
+        for (int i = 0; i < CUBE_FACE_COUNT; i++)
+        {
+            irradianceShader->setMat4("view", captureViews[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                   GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMapTex, 0);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            renderCube();
+        }
+    });
+
+    bakeGraph.addPass("Prefilter Map", {skybox}, {prefilterMap, prefilterDepth}, [&](FrameGraph& graph)
+    {
+        graph.bindFramebuffer({}, prefilterDepth);
+        prefilterShader->use();
+        prefilterShader->setMat4("projection", captureProjection);
+        prefilterShader->setInt("environmentMap", skyboxTexUnit);
+        prefilterShader->setInt("skyboxResolution", SKYBOX_RES);
+        glActiveTexture(GL_TEXTURE0 + skyboxTexUnit);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTex);
+        constexpr unsigned int MAX_MIP_LEVELS = 8;
+        for (int mip = 0; mip < MAX_MIP_LEVELS; mip++)
+        {
+            // Reisze the viewport according to mip-level size
+            const auto mipWidth = static_cast<unsigned int>(PREFILTER_MAP_RES * std::pow(0.5, mip));
+            const auto mipHeight = static_cast<unsigned int>(PREFILTER_MAP_RES * std::pow(0.5, mip));
+            glViewport(0, 0, mipWidth, mipHeight);
+
+            float roughness = static_cast<float>(mip) / static_cast<float>(MAX_MIP_LEVELS - 1);
+            prefilterShader->setFloat("roughness", roughness);
+
+            for (int i = 0; i < CUBE_FACE_COUNT; i++)
+            {
+                prefilterShader->setMat4("view", captureViews[i]);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefiltetMapTex, mip);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                renderCube();
+            }
+        }
+    });
+
+    bakeGraph.addPass("BRDF LUT", {}, {brdfLut, brdfDepth}, [&](FrameGraph& graph)
+    {
+        graph.bindFramebuffer({}, brdfDepth);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLutTex, 0);
+        glViewport(0, 0, BRDF_MAP_RES, BRDF_MAP_RES);
+        brdfShader->use();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderQuad();
+    });
+
+    bakeGraph.execute(profiler);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    const FrameGraphStats& bakeStats = bakeGraph.stats();
+    std::cout << "Environment capture targets: " << bakeStats.physicalTextureCount << " textures for "
+              << bakeStats.textureCount << " targets, " << bakeStats.allocatedBytes / 1024 << " KB of "
+              << bakeStats.requestedBytes / 1024 << " KB requested, " << bakeStats.savedBytes() / 1024
+              << " KB saved by aliasing" << std::endl;
+
+    // Before rendering, config the viewport to the output dimensions
+    glViewport(0, 0, config.width, config.height);
+
+    bloomRenderer = new BloomRenderer(config.width, config.height);
+    temporalAA = new TemporalAA(config.width, config.height);
+    shadowRenderer = new ShadowRenderer();
+    ssaoRenderer = new SsaoRenderer(config.width, config.height);
+    occlusionCuller = new OcclusionCuller();
+    framePreparer = new FramePreparer();
+    frameGraph = new FrameGraph("Render Targets");
+
+    // Setting constant uniforms
+    modelAsset->resolveMaterials(*objectShader);
+    objectShader->use();
+    objectShader->setInt("skybox", skyboxTexUnit);
+    objectShader->setInt("irradianceMap", irradianceTexUnit);
+    objectShader->setInt("prefilterMap", prefilterTexUnit);
+    objectShader->setInt("brdfLut", brdfLutTexUnit);
+    objectShader->setInt("ssaoTexture", ssaoTexUnit);
+
+    skyboxShader->use();
+    skyboxShader->setInt("skybox", skyboxTexUnit);
+
+    screenShader->use();
+    screenShader->setInt("screenTexture", screenTexUnit);
+    screenShader->setInt("bloomBlurTexture", bloomBlurTexUnit);
+
+    // Startup only runs once, so waiting for its GPU timings is fine
+    profiler->endFrame(true);
+}
+
+unsigned int Renderer::render(const Camera& camera, const RenderSettings& settings, const float deltaTime)
+{
+    unsigned int indiceCount = 0;
+
+    // Everything the last frame built in the arena is gone by now
+    FrameArena::frame().reset();
+
+    // Work the jobs queued for the thread owning the context
+    JobSystem::runMainThreadJobs();
+
+    // Frames resolved by now were rendered at most a couple of frames ago, which the controller allows for
+    if (settings.enableDynamicResolution)
+    {
+        renderScale = dynamicResolution.update(profiler->latestFrame(), settings.targetFrameMs,
+                                               settings.minRenderScale);
+    }
+    else
+    {
+        dynamicResolution.reset();
+        renderScale = 1.0f;
+    }
+    const int renderWidth = std::max(1, static_cast<int>(std::lround(config.width * renderScale)));
+    const int renderHeight = std::max(1, static_cast<int>(std::lround(config.height * renderScale)));
+
+    const glm::mat4 view = glm::lookAt(camera.position, camera.position + camera.front, camera.up);
+    const glm::mat4 projection = glm::perspective(glm::radians(camera.fov),
+        static_cast<float>(config.width) / static_cast<float>(config.height), 0.1f, 100.0f);
+    const glm::mat4 viewSkybox = glm::mat4(glm::mat3(view));
+
+    // The projection stays unjittered for culling and streaming, the scene shaders offset their output
+    glm::vec2 jitter(0.0f);
+    if (settings.enableTaa)
+    {
+        jitter = temporalAA->nextJitter() * 2.0f / glm::vec2(renderWidth, renderHeight);
+    }
+    else
+    {
+        temporalAA->invalidateHistory();
+    }
+    const glm::vec2 renderSize(static_cast<float>(renderWidth), static_cast<float>(renderHeight));
+    if (!hasPreviousFrame)
+    {
+        prevViewProjection = projection * view;
+        prevSkyboxViewProjection = projection * viewSkybox;
+    }
+
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::rotate(model, glm::radians(settings.rotation[0]), glm::vec3(1.0, 0.0, 0.0));
+    model = glm::rotate(model, glm::radians(settings.rotation[1]), glm::vec3(0.0, 1.0, 0.0));
+    model = glm::rotate(model, glm::radians(settings.rotation[2]), glm::vec3(0.0, 0.0, 1.0));
+    model = glm::translate(model, glm::vec3(settings.position[0], settings.position[1], settings.position[2]));
+    model = glm::scale(model, glm::vec3(settings.scale[0], settings.scale[1], settings.scale[2]));
+    const glm::mat4 objectModel = model;
+
+    {
+        // Moved nodes are placed before anything reads the mesh bounds or draws the meshes
+        ProfileScope scope(profiler, "Scene Graph", false);
+        modelAsset->updateTransforms();
+    }
+
+    if (settings.enableShadows)
+    {
+        const ShadowCamera shadowCamera = {view, glm::radians(camera.fov),
+                                           static_cast<float>(config.width) / static_cast<float>(config.height), 0.1f};
+        std::span<const glm::vec3> shadowedPointLights;
+        if (settings.enablePointLights)
+        {
+            shadowedPointLights = pointLightPositions;
+        }
+        shadowRenderer->update(shadowCamera, settings.enableDirectionalLight ? &dirLightDirection : nullptr,
+                               shadowedPointLights, *modelAsset, objectModel, profiler);
+    }
+
+    if (settings.enableOcclusionCulling)
+    {
+        ProfileScope scope(profiler, "Occlusion Culling", false);
+        occlusionCuller->beginFrame(projection * view);
+        modelAsset->cullOccluded(*occlusionCuller, objectModel);
+    }
+    else
+    {
+        modelAsset->clearOcclusion();
+    }
+
+    // Culling, texture detail and sorting run on the worker threads. The recorded draws are replayed
+    // unless GPU culling submits the model, the texture detail is used either way.
+    {
+        ProfileScope scope(profiler, "Frame Preparation", false);
+        framePreparer->prepare(*modelAsset, {model, projection * view, camera.position, glm::radians(camera.fov),
+                                             static_cast<float>(renderHeight)});
+    }
+
+    unsigned int ssaoTexture = 0;
+    if (settings.enableSsao)
+    {
+        ssaoRenderer->setResolutionDivisor(settings.ssaoQuarterResolution ? 4 : 2);
+        ssaoTexture = ssaoRenderer->render(*modelAsset, objectModel, view, projection,
+                                           glm::ivec2(renderWidth, renderHeight), settings.ssaoRadius,
+                                           settings.ssaoIntensity, profiler);
+    }
+
+    // Scene targets are allocated at the output size, dynamic resolution renders into the bottom left part
+    // of them. Single floating point color buffer, bloom extracts the bright parts itself while downsampling.
+    const int outputWidth = static_cast<int>(config.width);
+    const int outputHeight = static_cast<int>(config.height);
+    const GLenum hdrFormat = config.compactHdrTarget ? GL_R11F_G11F_B10F : GL_RGBA16F;
+    const FrameGraphResource hdrColor = frameGraph->createTexture("HDR color", {outputWidth, outputHeight, hdrFormat});
+    const FrameGraphResource hdrDepth =
+        frameGraph->createTexture("HDR depth", {outputWidth, outputHeight, GL_DEPTH_COMPONENT24, false});
+    FrameVector<FrameGraphResource> sceneTargets = {hdrColor};
+    FrameGraphResource velocity = -1;
+    if (settings.enableTaa)
+    {
+        // Screen space motion of every pixel for the TAA reprojection, only allocated while TAA needs it
+        velocity = frameGraph->createTexture("Velocity", {outputWidth, outputHeight, GL_RG16F, false});
+        sceneTargets.push_back(velocity);
+    }
+    FrameVector<FrameGraphResource> sceneWrites = sceneTargets;
+    sceneWrites.push_back(hdrDepth);
+
+    frameGraph->addPass("Scene", {}, sceneWrites, [&](FrameGraph& graph)
+    {
+        graph.bindFramebuffer(sceneTargets, hdrDepth);
+        glViewport(0, 0, renderWidth, renderHeight);
+        glEnable(GL_DEPTH_TEST); // Enable depth testing (disabled for rendering screen-space quad)
+        glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (settings.enableTaa)
+        {
+            constexpr float noMotion[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            glClearBufferfv(GL_COLOR, 1, noMotion);
+        }
+
+        const bool gpuCulling = gpuCullingSupported && settings.enableGpuCulling;
+        // The pre-pass culls the same view the shading pass draws, its commands are reused
+        const bool commandsCulled = gpuCulling && settings.enableDepthPrepass;
+        overdrawStats->beginFrame();
+        if (settings.enableDepthPrepass)
+        {
+            ProfileScope scope(profiler, "Depth Pre-Pass");
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            depthPrepassShader->use();
+            depthPrepassShader->setMat4("model", model);
+            depthPrepassShader->setMat4("view", view);
+            depthPrepassShader->setMat4("projection", projection);
+            depthPrepassShader->setVec2("jitter", jitter);
+            modelAsset->bindTransforms(*depthPrepassShader, nodeTransformTexUnit);
+            overdrawStats->beginDepthPrepass();
+            if (gpuCulling)
+            {
+                modelAsset->DrawDepthIndirect(*depthPrepassShader, *cullShader, projection * view * model);
+            }
+            else
+            {
+                modelAsset->DrawDepth();
+            }
+            overdrawStats->endDepthPrepass();
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+            // Only the nearest surface of every pixel matches the laid down depth
+            glDepthFunc(GL_EQUAL);
+            glDepthMask(GL_FALSE);
+        }
+
+        profiler->beginScope("Shading");
+        objectShader->use();
+        setLightParameters(camera, settings);
+        objectShader->setFloat("material.shininess", 192.0f);
+        objectShader->setMat4("projection", projection);
+        objectShader->setMat4("view", view);
+        objectShader->setVec3("camPos", camera.position);
+        objectShader->setBool("shadowsEnabled", settings.enableShadows);
+        if (settings.enableShadows)
+        {
+            shadowRenderer->bind(*objectShader, cascadeShadowTexUnit, pointShadowTexUnit);
+        }
+        objectShader->setBool("ssaoEnabled", settings.enableSsao);
+        if (settings.enableSsao)
+        {
+            glActiveTexture(GL_TEXTURE0 + ssaoTexUnit);
+            glBindTexture(GL_TEXTURE_2D, ssaoTexture);
+            objectShader->setVec2("ssaoUvScale", ssaoRenderer->uvScale());
+        }
+        objectShader->setMat4("model", model);
+        objectShader->setMat4("prevModel", hasPreviousFrame ? prevModel : model);
+        modelAsset->bindTransforms(*objectShader, nodeTransformTexUnit);
+        modelAsset->bindPreviousTransforms(*objectShader, prevNodeTransformTexUnit);
+        objectShader->setMat4("prevViewProjection", prevViewProjection);
+        objectShader->setVec2("jitter", jitter);
+        objectShader->setVec2("renderSize", renderSize);
+
+        // Stream in the texture detail the model needs from this viewpoint
+        profiler->beginScope("Texture Streaming");
+        framePreparer->applyTextureDetail(*modelAsset);
+        textureStreamer->update(deltaTime);
+        profiler->endScope();
+
+        // Activate and bind skybox texture for reflections before drawing the model
+        glActiveTexture(GL_TEXTURE0 + skyboxTexUnit);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTex);
+        objectShader->setBool("enableIBL", settings.enableIBL);
+
+        const auto submitStart = std::chrono::steady_clock::now();
+        overdrawStats->beginShading();
+        if (commandsCulled)
+        {
+            indiceCount += modelAsset->DrawCulledIndirect(*objectShader);
+        }
+        else if (gpuCulling)
+        {
+            indiceCount += modelAsset->DrawIndirect(*objectShader, *cullShader, projection * view * model);
+        }
+        else
+        {
+            indiceCount += modelAsset->DrawCommands(framePreparer->commands());
+        }
+        overdrawStats->endShading();
+        modelSubmitTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
+        profiler->endScope();
+
+        if (settings.enableDepthPrepass)
+        {
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_TRUE);
+        }
+
+        if (settings.enablePointLights)
+        {
+            ProfileScope scope(profiler, "Light Previews");
+            lightShader->use();
+            lightShader->setMat4("projection", projection);
+            lightShader->setMat4("view", view);
+            lightShader->setMat4("prevViewProjection", prevViewProjection);
+            lightShader->setVec2("jitter", jitter);
+            lightShader->setVec2("renderSize", renderSize);
+            for (int i = 0; i < std::size(pointLightPositions); i++)
+            {
+                model = glm::mat4(1.0f);
+                model = glm::translate(model, pointLightPositions[i]);
+                model = glm::scale(model, glm::vec3(0.1f));
+                lightShader->setMat4("model", model);
+
+                lightPreview->Draw(*lightShader, pointLightColors[i] * settings.pointLightIntensity);
+            }
+        }
+
+        if (settings.showSkybox)
+        {
+            ProfileScope scope(profiler, "Skybox");
+            // Draw the skybox
+            // Depth test passes when values are equal to depth buffer's content. Even though ideally this
+            // should be GL_EQUAL, some artifacts will occur on the skybox when panning because sometimes
+            // incoming pixel depth value < depth value in depth buffer, so we use GL_LEQUAL to avoid them
+            glDepthFunc(GL_LEQUAL);
+            // The view without its translation (upper-left 3x3 matrix) rotates the skybox but does not move it
+            skyboxShader->use();
+            skyboxShader->setMat4("projection", projection);
+            skyboxShader->setMat4("view", viewSkybox);
+            skyboxShader->setMat4("prevViewProjection", prevSkyboxViewProjection);
+            skyboxShader->setVec2("jitter", jitter);
+            skyboxShader->setVec2("renderSize", renderSize);
+            renderCube();
+            glDepthFunc(GL_LESS); // Set depth function back to default
+        }
+    });
+
+    // Part of the scene targets holding this frame. TAA resolves it to the output resolution, without
+    // TAA bloom and the composite read the scaled region directly.
+    const glm::vec2 sceneUvScale(static_cast<float>(renderWidth) / static_cast<float>(config.width),
+                                 static_cast<float>(renderHeight) / static_cast<float>(config.height));
+    glm::vec2 uvScale = sceneUvScale;
+    FrameGraphResource sceneColor = hdrColor;
+    if (settings.enableTaa)
+    {
+        const FrameGraphResource history = frameGraph->importTexture("TAA history", temporalAA->nextResolveTarget());
+        frameGraph->addPass("TAA", {hdrColor, velocity}, {history}, [&](FrameGraph& graph)
+        {
+            temporalAA->resolve(graph.texture(hdrColor), graph.texture(velocity), sceneUvScale, profiler);
+        });
+        sceneColor = history;
+        uvScale = glm::vec2(1.0f);
+    }
+
+    // Culled along with its mips while the composite does not read them
+    FrameVector<FrameGraphResource> bloomMips;
+    bloomMips.reserve(bloomRenderer->mipChain().size());
+    for (const BloomMip& mip : bloomRenderer->mipChain())
+    {
+        bloomMips.push_back(frameGraph->createTexture(FrameArena::frame().format("Bloom mip %zu", bloomMips.size()),
+                                                      {static_cast<int>(mip.size.x), static_cast<int>(mip.size.y),
+                                                       GL_R11F_G11F_B10F}));
+    }
+    frameGraph->addPass("Bloom", {sceneColor}, bloomMips, [&](FrameGraph& graph)
+    {
+        FrameVector<unsigned int> mipTextures;
+        mipTextures.reserve(bloomMips.size());
+        for (const FrameGraphResource mip : bloomMips) { mipTextures.push_back(graph.texture(mip)); }
+        bloomRenderer->renderBloomTexture(graph.texture(sceneColor), mipTextures, uvScale, settings.bloomFilterRadius,
+                                          settings.bloomThreshold, settings.bloomSoftKnee, profiler);
+    });
+
+    // The output framebuffer belongs to the window system or the headless runner, not to a texture
+    const FrameGraphResource output = frameGraph->importTexture("Output", 0);
+    FrameVector<FrameGraphResource> compositeReads = {sceneColor};
+    if (settings.enableBloom) { compositeReads.push_back(bloomMips.front()); }
+    frameGraph->addPass("Composite", compositeReads, {output}, [&](FrameGraph& graph)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+        glViewport(0, 0, config.width, config.height);
+        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        screenShader->use();
+        screenShader->setFloat("gamma", 2.0f);
+        screenShader->setFloat("exposure", 1.0f);
+        screenShader->setBool("bloomEnabled", settings.enableBloom);
+        screenShader->setVec2("renderScale", uvScale);
+        glDisable(GL_DEPTH_TEST);
+        glActiveTexture(GL_TEXTURE0 + screenTexUnit);
+        glBindTexture(GL_TEXTURE_2D, graph.texture(sceneColor));
+        glActiveTexture(GL_TEXTURE0 + bloomBlurTexUnit);
+        glBindTexture(GL_TEXTURE_2D, settings.enableBloom ? graph.texture(bloomMips.front()) : 0);
+        renderQuad();
+    });
+
+    frameGraph->execute(profiler);
+
+    prevViewProjection = projection * view;
+    prevSkyboxViewProjection = projection * viewSkybox;
+    prevModel = objectModel;
+    hasPreviousFrame = true;
+
+    // Wireframe mode
+    // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+    return indiceCount;
+}
+
+void Renderer::resize(const unsigned int width, const unsigned int height)
+{
+    // Minimized windows report a zero sized framebuffer, keep the targets until it is restored
+    if (width == 0 || height == 0 || (width == config.width && height == config.height)) { return; }
+
+    config.width = width;
+    config.height = height;
+    if (!bloomRenderer) { return; } // Not initialized yet, init() allocates at the new size
+
+    bloomRenderer->resize(width, height);
+    temporalAA->resize(width, height);
+    ssaoRenderer->resize(width, height);
+}
+
+float Renderer::getRenderScale() const
+{
+    return renderScale;
+}
+
+unsigned int Renderer::getShadowMapsRendered() const
+{
+    return shadowRenderer ? shadowRenderer->renderedMapCount() : 0;
+}
+
+const OverdrawStats& Renderer::getOverdrawStats() const
+{
+    return *overdrawStats;
+}
+
+SceneGraph& Renderer::getSceneGraph()
+{
+    return modelAsset->getSceneGraph();
+}
+
+const FrameGraphStats& Renderer::getFrameGraphStats() const
+{
+    return frameGraph->stats();
+}
+
+const FramePreparer& Renderer::getFramePreparer() const
+{
+    return *framePreparer;
+}
+
+size_t Renderer::getOccludedMeshCount() const
+{
+    return modelAsset ? modelAsset->occludedMeshCount() : 0;
+}
+
+size_t Renderer::getMeshCount() const
+{
+    return modelAsset ? modelAsset->meshCount() : 0;
+}
+
+void Renderer::setOutputFramebuffer(const unsigned int framebuffer)
+{
+    outputFramebuffer = framebuffer;
+}
+
+Profiler& Renderer::getProfiler()
+{
+    return *profiler;
+}
+
+TextureStreamer& Renderer::getTextureStreamer()
+{
+    return *textureStreamer;
+}
+
+bool Renderer::isGpuCullingSupported() const
+{
+    return gpuCullingSupported;
+}
+
+double Renderer::getModelSubmitTime() const
+{
+    return modelSubmitTime;
+}
+
+void Renderer::setLightParameters(const Camera& camera, const RenderSettings& settings)
+{
+    glm::vec3 ambient(0.05);
+    glm::vec3 diffuse(0.8f);
+    glm::vec3 specular(1.0f);
+
+    // Directional light
+    objectShader->setBool("dirLight.isActive", settings.enableDirectionalLight);
+    objectShader->setVec3("dirLightDirection", dirLightDirection);
+    objectShader->setVec3("dirLight.ambient", ambient);
+    objectShader->setVec3("dirLight.diffuse", diffuse);
+    objectShader->setVec3("dirLight.specular", specular);
+
+    // Point light
+    FrameArena& arena = FrameArena::frame();
+    int i = 0;
+    for (const glm::vec3& position : pointLightPositions)
+    {
+        objectShader->setVec3(arena.format("pointLightPos[%d]", i), position);
+
+        objectShader->setBool(arena.format("pointLights[%d].isActive", i), settings.enablePointLights);
+        objectShader->setVec3(arena.format("pointLights[%d].ambient", i),
+                              ambient * pointLightColors[i] * settings.pointLightIntensity);
+        objectShader->setVec3(arena.format("pointLights[%d].diffuse", i),
+                              diffuse * pointLightColors[i] * settings.pointLightIntensity);
+        objectShader->setVec3(arena.format("pointLights[%d].specular", i), specular);
+        // https://wiki.ogre3d.org/tiki-index.php?page=-Point+Light+Attenuation
+        objectShader->setFloat(arena.format("pointLights[%d].constant", i), 1.0f);
+        objectShader->setFloat(arena.format("pointLights[%d].linear", i), 0.09f);
+        objectShader->setFloat(arena.format("pointLights[%d].quadratic", i), 0.032f);
+        i++;
+    }
+
+    // Spot light
+    objectShader->setBool("spotLights[0].isActive", false);
+    objectShader->setVec3("spotLightPos[0]", camera.position);
+    objectShader->setVec3("spotLightDir[0]", camera.front);
+    objectShader->setFloat("spotLights[0].cutOff", glm::cos(glm::radians(12.5f)));
+    objectShader->setFloat("spotLights[0].outerCutOff", glm::cos(glm::radians(18.5f)));
+    objectShader->setVec3("spotLights[0].ambient", glm::vec3(0.2f));
+    objectShader->setVec3("spotLights[0].diffuse", diffuse);
+    objectShader->setVec3("spotLights[0].specular", specular);
+    objectShader->setFloat("spotLights[0].constant", 1.0f);
+    objectShader->setFloat("spotLights[0].linear", 0.09f);
+    objectShader->setFloat("spotLights[0].quadratic", 0.032f);
+}
+
+// Renders a 1x1 3D cube in NDC
+void Renderer::renderCube()
+{
+    // initialize (if necessary)
+    if (cubeVAO == 0)
+    {
+        constexpr float vertices[] = {
+            // back face
+            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+             1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+             1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right
+             1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+            -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
+            // front face
+            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+             1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
+             1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+             1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+            -1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
+            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+            // left face
+            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+            -1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
+            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+            -1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+            // right face
+             1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+             1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+             1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
+             1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+             1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+             1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+            // bottom face
+            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+             1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
+             1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+             1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+            -1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+            // top face
+            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+             1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+             1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
+             1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+            -1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left
+        };
+        glGenVertexArrays(1, &cubeVAO);
+        glGenBuffers(1, &cubeVBO);
+        // fill buffer
+        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        GpuMemory::track(GpuResourceType::Buffer, cubeVBO, sizeof(vertices), "Geometry", "Unit cube");
+        // link vertex attributes
+        glBindVertexArray(cubeVAO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+    // render Cube
+    glBindVertexArray(cubeVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+}
+
+void Renderer::renderQuad()
+{
+    if (quadVAO == 0)
+    {
+        constexpr float QUAD_VERTICIES[] = {
+            // positions        // texture Coords
+            -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
+            -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+             1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
+             1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
+        };
+        // setup plane VAO
+        glGenVertexArrays(1, &quadVAO);
+        glGenBuffers(1, &quadVBO);
+        glBindVertexArray(quadVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICIES), &QUAD_VERTICIES, GL_STATIC_DRAW);
+        GpuMemory::track(GpuResourceType::Buffer, quadVBO, sizeof(QUAD_VERTICIES), "Geometry", "Screen quad");
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    }
+
+    glBindVertexArray(quadVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <string>
+#include <glm/glm.hpp>
+
+#include "BloomRenderer.h"
+#include "DynamicResolution.h"
+#include "FrameGraph.h"
+#include "FramePreparer.h"
+#include "LightPreview.h"
+#include "Model.h"
+#include "OcclusionCuller.h"
+#include "OverdrawStats.h"
+#include "Profiler.h"
+#include "Shader.h"
+#include "ShadowRenderer.h"
+#include "SsaoRenderer.h"
+#include "TemporalAA.h"
+#include "TextureStreamer.h"
+
+struct RendererConfig
+{
+    unsigned int width = 1280;
+    unsigned int height = 720;
+    std::string modelPath = "Assets/Models/GuitarBackpack/guitar_backpack.obj";
+    std::string hdrImagePath = "Assets/Textures/Skybox/adams_place_bridge_4k.hdr";
+    bool isPbr = true;
+    float textureBudgetMb = 256.0f;
+    // Packs materials with matching texture sizes and formats into texture arrays so their meshes share draws.
+    // The arrays stay fully resident outside the texture streamer's budget, so packing is opt-in.
+    bool packMaterialTextures = false;
+    float gpuMemoryBudgetMb = 2048.0f;
+    // Stores the HDR scene colour as GL_R11F_G11F_B10F instead of GL_RGBA16F, halving its bandwidth. The
+    // scene never reads destination alpha, so only precision is lost (6 and 5 bit mantissas).
+    bool compactHdrTarget = true;
+    bool verbose = false; // Prints asset load timings
+};
+
+// Per frame settings, tweaked from the UI
+struct RenderSettings
+{
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    float rotation[3] = {0.0f, 0.0f, 0.0f};
+    float scale[3] = {1.0f, 1.0f, 1.0f};
+    bool showSkybox = true;
+    bool enableIBL = true;
+    bool enablePointLights = true;
+    float pointLightIntensity = 5.0f;
+    bool enableBloom = true;
+    float bloomFilterRadius = 0.005f;
+    float bloomThreshold = 1.0f; // Scene luminance where bloom starts
+    float bloomSoftKnee = 0.5f;  // Fraction of the threshold over which bloom fades in
+    bool enableGpuCulling = true;
+    // Renders the scene at a fraction of the output resolution, lowered while frames miss the target time
+    bool enableDynamicResolution = true;
+    float targetFrameMs = 1000.0f / 60.0f;
+    float minRenderScale = 0.5f;
+    bool enableTaa = true;
+    bool enableShadows = true;
+    bool enableDirectionalLight = false;
+    // Lays down depth first so the object shader runs once per pixel, pays off with heavy overdraw
+    bool enableDepthPrepass = false;
+    bool enableSsao = true;
+    bool ssaoQuarterResolution = false; // Half resolution otherwise
+    float ssaoRadius = 0.5f; // World units
+    float ssaoIntensity = 1.5f;
+    // Skips meshes hidden behind the largest meshes, tested against a depth buffer rasterized on the CPU
+    bool enableOcclusionCulling = true;
+};
+
+struct Camera
+{
+    glm::vec3 position = glm::vec3(0.0f, 0.0f, 7.0f);
+    glm::vec3 front = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+    float fov = 45.0f; // Vertical, in degrees
+};
+
+/// <summary>
+/// Owns the scene and every render pass, independent of the window system so the same frames can be
+/// rendered in a window or offscreen. Needs a current GL context for its whole lifetime.
+/// </summary>
+class Renderer
+{
+public:
+    explicit Renderer(const RendererConfig& config);
+    ~Renderer();
+
+    /// <summary>
+    /// Loads the scene and bakes the IBL maps. Recorded in the profiler as the "Startup" frame.
+    /// </summary>
+    void init();
+    /// <summary>
+    /// Renders a frame into the output framebuffer and returns the number of indices drawn. Must be called
+    /// between Profiler::beginFrame and Profiler::endFrame.
+    /// </summary>
+    unsigned int render(const Camera& camera, const RenderSettings& settings, float deltaTime);
+    /// <summary>
+    /// Framebuffer the final image is composited into, 0 for the default framebuffer
+    /// </summary>
+    void setOutputFramebuffer(unsigned int framebuffer);
+    /// <summary>
+    /// Reallocates the render targets for a new output size. Zero sizes, as reported for minimized
+    /// windows, are ignored.
+    /// </summary>
+    void resize(unsigned int width, unsigned int height);
+
+    Profiler& getProfiler();
+    TextureStreamer& getTextureStreamer();
+    /// <summary>
+    /// Nodes of the loaded model, moved nodes take effect on the next render
+    /// </summary>
+    SceneGraph& getSceneGraph();
+    bool isGpuCullingSupported() const;
+    double getModelSubmitTime() const;
+    float getRenderScale() const;
+    unsigned int getShadowMapsRendered() const;
+    const OverdrawStats& getOverdrawStats() const;
+    const FrameGraphStats& getFrameGraphStats() const;
+    const FramePreparer& getFramePreparer() const;
+    size_t getOccludedMeshCount() const;
+    size_t getMeshCount() const;
+
+private:
+    // Benchmarked on its own, see Benchmarks/EngineBenchmarks.cpp
+    friend struct BenchmarkAccess;
+
+    void setLightParameters(const Camera& camera, const RenderSettings& settings);
+    void renderCube();
+    void renderQuad();
+
+private:
+    RendererConfig config;
+    unsigned int outputFramebuffer = 0;
+
+    Model* modelAsset = nullptr;
+    Profiler* profiler = nullptr;
+    TextureStreamer* textureStreamer = nullptr;
+    LightPreview* lightPreview = nullptr;
+    BloomRenderer* bloomRenderer = nullptr;
+    TemporalAA* temporalAA = nullptr;
+    ShadowRenderer* shadowRenderer = nullptr;
+    SsaoRenderer* ssaoRenderer = nullptr;
+    OverdrawStats* overdrawStats = nullptr;
+    OcclusionCuller* occlusionCuller = nullptr;
+    FramePreparer* framePreparer = nullptr;
+    // Render targets of the frame, allocated and aliased by the graph from what the passes declare
+    FrameGraph* frameGraph = nullptr;
+    Shader* objectShader = nullptr;
+    Shader* lightShader = nullptr;
+    Shader* screenShader = nullptr;
+    Shader* skyboxShader = nullptr;
+    Shader* equirectToCubemapShader = nullptr;
+    Shader* irradianceShader = nullptr;
+    Shader* prefilterShader = nullptr;
+    Shader* brdfShader = nullptr;
+    Shader* cullShader = nullptr;
+    Shader* depthPrepassShader = nullptr;
+
+    // GPU driven culling and multi draw indirect need GL 4.3, older contexts keep the per mesh draws
+    bool gpuCullingSupported = false;
+    double modelSubmitTime = 0.0; // CPU time spent submitting the model, in milliseconds
+    DynamicResolution dynamicResolution;
+    float renderScale = 1.0f;
+
+    // Transforms of the previous frame, for the TAA velocity output
+    glm::mat4 prevViewProjection = glm::mat4(1.0f);
+    glm::mat4 prevSkyboxViewProjection = glm::mat4(1.0f);
+    glm::mat4 prevModel = glm::mat4(1.0f);
+    bool hasPreviousFrame = false;
+
+    unsigned int quadVAO = 0;
+    unsigned int quadVBO = 0;
+    unsigned int cubeVAO = 0;
+    unsigned int cubeVBO = 0;
+
+    unsigned int hdriTexture = 0;
+    unsigned int skyboxTex = 0;
+    unsigned int irradianceMapTex = 0;
+    unsigned int prefiltetMapTex = 0;
+    unsigned int brdfLutTex = 0;
+};
@@ -0,0 +1,212 @@
+#include "SceneGraph.h"
+
+#include <algorithm>
+#include <iostream>
+#include "CpuFeatures.h"
+#include "Parallel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LUMINA_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Below this many nodes a depth is multiplied on the calling thread, waking the workers costs more
+    constexpr unsigned int MIN_PARALLEL_NODES = 1024;
+    constexpr unsigned int MIN_NODES_PER_WORKER = 256;
+
+#if LUMINA_X86
+    // out = a * b for column major 4x4 matrices, two result columns per 256 bit register. Every result
+    // column is the columns of a weighted by the elements of the matching column of b.
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((target("avx2,fma")))
+#endif
+    void multiplyAvx2(const float* a, const float* b, float* out)
+    {
+        const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a));
+        const __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 4));
+        const __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 8));
+        const __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 12));
+        for (int column = 0; column < 4; column += 2)
+        {
+            const __m256 weights = _mm256_loadu_ps(b + column * 4);
+            __m256 result = _mm256_mul_ps(a0, _mm256_permute_ps(weights, 0x00));
+            result = _mm256_fmadd_ps(a1, _mm256_permute_ps(weights, 0x55), result);
+            result = _mm256_fmadd_ps(a2, _mm256_permute_ps(weights, 0xAA), result);
+            result = _mm256_fmadd_ps(a3, _mm256_permute_ps(weights, 0xFF), result);
+            _mm256_storeu_ps(out + column * 4, result);
+        }
+    }
+#endif
+}
+
+int SceneGraph::addNode(const std::string& name, const int parent, const glm::mat4& localTransform)
+{
+    const auto node = static_cast<int>(mParents.size());
+    const int depth = parent == NO_PARENT ? 0 : mDepths[parent] + 1;
+    const bool shallower = !mDepths.empty() && depth < mDepths.back();
+    // Children of a node must follow each other
+    const bool splitsSiblings = parent != NO_PARENT && mChildCounts[parent] > 0 &&
+                                mFirstChildren[parent] + mChildCounts[parent] != node;
+    if (parent >= node || shallower || splitsSiblings)
+    {
+        std::cout << "ERROR::SCENEGRAPH::Node " << name << " is not in breadth first order" << std::endl;
+        return NO_PARENT;
+    }
+
+    if (parent != NO_PARENT)
+    {
+        if (mChildCounts[parent] == 0) { mFirstChildren[parent] = node; }
+        mChildCounts[parent]++;
+    }
+    if (mLevelEnds.size() <= static_cast<size_t>(depth)) { mLevelEnds.push_back(node); }
+    mLevelEnds[depth] = node + 1;
+
+    mNames.push_back(name);
+    mParents.push_back(parent);
+    mDepths.push_back(depth);
+    mFirstChildren.push_back(0);
+    mChildCounts.push_back(0);
+    mLocalTransforms.push_back(localTransform);
+    mWorldTransforms.push_back(parent == NO_PARENT ? localTransform : mWorldTransforms[parent] * localTransform);
+    mDirty.push_back(0);
+    return node;
+}
+
+void SceneGraph::clear()
+{
+    mNames.clear();
+    mParents.clear();
+    mDepths.clear();
+    mFirstChildren.clear();
+    mChildCounts.clear();
+    mLocalTransforms.clear();
+    mWorldTransforms.clear();
+    mDirty.clear();
+    mLevelEnds.clear();
+    mPendingNodes.clear();
+    mUpdatedNodes.clear();
+}
+
+void SceneGraph::setLocalTransform(const int node, const glm::mat4& localTransform)
+{
+    mLocalTransforms[node] = localTransform;
+    if (mDirty[node]) { return; }
+    mDirty[node] = 1;
+    mPendingNodes.push_back(node);
+}
+
+bool SceneGraph::update()
+{
+    mUpdatedNodes.clear();
+    if (mPendingNodes.empty()) { return false; }
+
+    // Node order is depth order, so the flagged nodes can be taken a depth at a time
+    std::sort(mPendingNodes.begin(), mPendingNodes.end());
+    std::vector<int> batch;
+    std::vector<int> previous;
+    size_t next = 0;
+    for (size_t depth = 0; depth < mLevelEnds.size(); depth++)
+    {
+        batch.clear();
+        // Everything below a recomputed node inherits its new world transform
+        for (const int node : previous)
+        {
+            for (int child = mFirstChildren[node]; child < mFirstChildren[node] + mChildCounts[node]; child++)
+            {
+                mDirty[child] = 0;
+                batch.push_back(child);
+            }
+        }
+        for (; next < mPendingNodes.size() && mPendingNodes[next] < mLevelEnds[depth]; next++)
+        {
+            const int node = mPendingNodes[next];
+            // Already taken along with its parent
+            if (!mDirty[node]) { continue; }
+            mDirty[node] = 0;
+            batch.push_back(node);
+        }
+        if (batch.empty() && next == mPendingNodes.size()) { break; }
+
+        multiplyBatch(batch);
+        mUpdatedNodes.insert(mUpdatedNodes.end(), batch.begin(), batch.end());
+        std::swap(previous, batch);
+    }
+
+    mPendingNodes.clear();
+    return true;
+}
+
+void SceneGraph::setSimdEnabled(const bool enabled)
+{
+    mSimdEnabled = enabled;
+}
+
+size_t SceneGraph::nodeCount() const
+{
+    return mParents.size();
+}
+
+const std::string& SceneGraph::name(const int node) const
+{
+    return mNames[node];
+}
+
+int SceneGraph::parent(const int node) const
+{
+    return mParents[node];
+}
+
+const glm::mat4& SceneGraph::localTransform(const int node) const
+{
+    return mLocalTransforms[node];
+}
+
+const glm::mat4& SceneGraph::worldTransform(const int node) const
+{
+    return mWorldTransforms[node];
+}
+
+const std::vector<int>& SceneGraph::updatedNodes() const
+{
+    return mUpdatedNodes;
+}
+
+void SceneGraph::multiplyBatch(const std::vector<int>& nodes)
+{
+#if LUMINA_X86
+    const bool useAvx2 = mSimdEnabled && CpuFeatures::hasAvx2();
+#endif
+    // The nodes of a batch share a depth, none of them reads a world transform another one writes
+    const auto multiplyRange = [&](const unsigned int begin, const unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            const int node = nodes[i];
+            const int parent = mParents[node];
+            if (parent == NO_PARENT)
+            {
+                mWorldTransforms[node] = mLocalTransforms[node];
+                continue;
+            }
+#if LUMINA_X86
+            if (useAvx2)
+            {
+                multiplyAvx2(&mWorldTransforms[parent][0][0], &mLocalTransforms[node][0][0],
+                             &mWorldTransforms[node][0][0]);
+                continue;
+            }
+#endif
+            mWorldTransforms[node] = mWorldTransforms[parent] * mLocalTransforms[node];
+        }
+    };
+
+    const auto count = static_cast<unsigned int>(nodes.size());
+    if (count < MIN_PARALLEL_NODES)
+    {
+        multiplyRange(0, count);
+        return;
+    }
+    Parallel::parallelFor(count, MIN_NODES_PER_WORKER, multiplyRange);
+}
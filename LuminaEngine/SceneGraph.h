@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// <summary>
+/// Node hierarchy stored as parallel arrays of parents, local and world transforms. Nodes are kept in
+/// breadth first order, so every parent comes before its children, the nodes of a depth are contiguous
+/// and so are the children of a node. Changing a local transform only flags the node, update() then
+/// recomputes the world transforms of the flagged subtrees one depth at a time, where no node depends on
+/// another and the matrices are multiplied in batches.
+/// </summary>
+class SceneGraph
+{
+public:
+    static constexpr int NO_PARENT = -1;
+
+    /// <summary>
+    /// Appends a node, which must not be shallower than the last one added. Returns its index, or
+    /// NO_PARENT when the order would break.
+    /// </summary>
+    int addNode(const std::string& name, int parent, const glm::mat4& localTransform);
+    void clear();
+
+    void setLocalTransform(int node, const glm::mat4& localTransform);
+    /// <summary>
+    /// Recomputes the world transforms of the nodes changed since the last update and everything below
+    /// them. Returns false when nothing changed.
+    /// </summary>
+    bool update();
+
+    /// <summary>
+    /// Forces scalar matrix multiplies, for comparing them against the AVX2 ones
+    /// </summary>
+    void setSimdEnabled(bool enabled);
+
+    size_t nodeCount() const;
+    const std::string& name(int node) const;
+    int parent(int node) const;
+    const glm::mat4& localTransform(int node) const;
+    const glm::mat4& worldTransform(int node) const;
+    /// <summary>
+    /// Nodes whose world transform the last update recomputed, shallowest first
+    /// </summary>
+    const std::vector<int>& updatedNodes() const;
+
+private:
+    void multiplyBatch(const std::vector<int>& nodes);
+
+    // Structure of arrays, indexed by node
+    std::vector<std::string> mNames;
+    std::vector<int> mParents;
+    std::vector<int> mDepths;
+    std::vector<int> mFirstChildren;
+    std::vector<int> mChildCounts;
+    std::vector<glm::mat4> mLocalTransforms;
+    std::vector<glm::mat4> mWorldTransforms;
+    std::vector<uint8_t> mDirty;
+
+    std::vector<int> mLevelEnds;     // One past the last node of every depth
+    std::vector<int> mPendingNodes;  // Flagged since the last update, in any order
+    std::vector<int> mUpdatedNodes;
+    bool mSimdEnabled = true;
+};
@@ -41,6 +41,28 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
     compileAndLink(vertexCode.c_str(), fragmentCode.c_str());
 }
 
+Shader::Shader(const char* computePath)
+{
+    std::string computeCode;
+    std::ifstream cShaderFile;
+    cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+    try
+    {
+        cShaderFile.open(computePath);
+        std::stringstream cShaderStream;
+        cShaderStream << cShaderFile.rdbuf();
+        cShaderFile.close();
+        computeCode = cShaderStream.str();
+    }
+    catch (const std::ifstream::failure& e)
+    {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << e.what() << std::endl;
+    }
+
+    compileAndLink(computeCode.c_str());
+}
+
 Shader::~Shader()
 {
     glDeleteProgram(programID);
@@ -56,48 +78,48 @@ unsigned int Shader::getProgramID()
     return programID;
 }
 
-void Shader::setBool(const std::string& name, const bool& value) const
+void Shader::setBool(const char* name, const bool& value) const
 {
-    glUniform1i(glGetUniformLocation(programID, name.c_str()), static_cast<int>(value));
+    glUniform1i(glGetUniformLocation(programID, name), static_cast<int>(value));
 }
 
-void Shader::setInt(const std::string& name, const int& value) const
+void Shader::setInt(const char* name, const int& value) const
 {
-    glUniform1i(glGetUniformLocation(programID, name.c_str()), value);
+    glUniform1i(glGetUniformLocation(programID, name), value);
 }
 
-void Shader::setFloat(const std::string& name, const float& value) const
+void Shader::setFloat(const char* name, const float& value) const
 {
-    glUniform1f(glGetUniformLocation(programID, name.c_str()), value);
+    glUniform1f(glGetUniformLocation(programID, name), value);
 }
 
-void Shader::setMat3(const std::string& name, const glm::mat3& value) const
+void Shader::setMat3(const char* name, const glm::mat3& value) const
 {
-    int uniformLoc = glGetUniformLocation(programID, name.c_str());
+    int uniformLoc = glGetUniformLocation(programID, name);
     glUniformMatrix3fv(uniformLoc, 1, GL_FALSE, glm::value_ptr(value));
 }
 
-void Shader::setMat4(const std::string& name, const glm::mat4& value) const
+void Shader::setMat4(const char* name, const glm::mat4& value) const
 {
-    int uniformLoc = glGetUniformLocation(programID, name.c_str());
+    int uniformLoc = glGetUniformLocation(programID, name);
     glUniformMatrix4fv(uniformLoc, 1, GL_FALSE, glm::value_ptr(value));
 }
 
-void Shader::setVec2(const std::string& name, const glm::vec2& value) const
+void Shader::setVec2(const char* name, const glm::vec2& value) const
 {
-    int uniformLoc = glGetUniformLocation(programID, name.c_str());
+    int uniformLoc = glGetUniformLocation(programID, name);
     glUniform2fv(uniformLoc, 1, glm::value_ptr(value));
 }
 
-void Shader::setVec3(const std::string& name, const glm::vec3& value) const
+void Shader::setVec3(const char* name, const glm::vec3& value) const
 {
-    int uniformLoc = glGetUniformLocation(programID, name.c_str());
+    int uniformLoc = glGetUniformLocation(programID, name);
     glUniform3fv(uniformLoc, 1, glm::value_ptr(value));
 }
 
-void Shader::setVec4(const std::string& name, const glm::vec4& value) const
+void Shader::setVec4(const char* name, const glm::vec4& value) const
 {
-    int uniformLoc = glGetUniformLocation(programID, name.c_str());
+    int uniformLoc = glGetUniformLocation(programID, name);
     glUniform4fv(uniformLoc, 1, glm::value_ptr(value));
 }
 
@@ -125,6 +147,19 @@ void Shader::compileAndLink(const char* vShaderCode, const char* fShaderCode)
     glDeleteShader(fragment);
 }
 
+void Shader::compileAndLink(const char* cShaderCode)
+{
+    unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute, 1, &cShaderCode, nullptr);
+    glCompileShader(compute);
+    checkCompileErrors(compute, "COMPUTE");
+    programID = glCreateProgram();
+    glAttachShader(programID, compute);
+    glLinkProgram(programID);
+    checkCompileErrors(programID, "PROGRAM");
+    glDeleteShader(compute);
+}
+
 void Shader::checkCompileErrors(unsigned int shader, const std::string& type)
 {
     int success;
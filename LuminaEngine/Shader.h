@@ -7,6 +7,10 @@ class Shader
 {
 public:
     Shader(const char* vertexPath, const char* fragmentPath);
+    /// <summary>
+    /// Compute shader program, requires a GL 4.3+ context
+    /// </summary>
+    explicit Shader(const char* computePath);
     ~Shader();
 
     /// <summary>
@@ -16,18 +20,19 @@ public:
 
     unsigned int getProgramID();
 
-    // Utility uniform functions
-    void setBool(const std::string &name, const bool& value) const;
-    void setInt(const std::string &name, const int& value) const;
-    void setFloat(const std::string &name, const float& value) const;
-    void setMat3(const std::string& name, const glm::mat3& value) const;
-    void setMat4(const std::string& name, const glm::mat4& value) const;
-    void setVec2(const std::string& name, const glm::vec2& value) const;
-    void setVec3(const std::string& name, const glm::vec3& value) const;
-    void setVec4(const std::string& name, const glm::vec4& value) const;
+    // Utility uniform functions. Names built at runtime come from FrameArena::format, not std::string.
+    void setBool(const char* name, const bool& value) const;
+    void setInt(const char* name, const int& value) const;
+    void setFloat(const char* name, const float& value) const;
+    void setMat3(const char* name, const glm::mat3& value) const;
+    void setMat4(const char* name, const glm::mat4& value) const;
+    void setVec2(const char* name, const glm::vec2& value) const;
+    void setVec3(const char* name, const glm::vec3& value) const;
+    void setVec4(const char* name, const glm::vec4& value) const;
 
 private:
     void compileAndLink(const char* vShaderCode, const char* fShaderCode);
+    void compileAndLink(const char* cShaderCode);
     void checkCompileErrors(unsigned int shader, const std::string& type);
 
 private:
@@ -0,0 +1,372 @@
+#include "ShadowRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "FrameArena.h"
+#include "Frustum.h"
+#include "GpuMemory.h"
+
+namespace
+{
+    const char* SHADOW_V_SHADER_PATH = "Assets/Shaders/shader_shadow.vert";
+    const char* DEPTH_F_SHADER_PATH = "Assets/Shaders/shader_depth.frag";
+    const char* POINT_SHADOW_F_SHADER_PATH = "Assets/Shaders/shader_shadow_point.frag";
+
+    constexpr int CASCADE_RES = 2048;
+    constexpr int POINT_SHADOW_RES = 512;
+    constexpr int CUBE_FACE_COUNT = 6;
+
+    // View depth covered by the cascades and the blend between logarithmic and uniform splits
+    constexpr float SHADOW_DISTANCE = 30.0f;
+    constexpr float SPLIT_LAMBDA = 0.75f;
+    // Cascades cover more than their slice of the view, so small camera moves stay inside the cached map
+    constexpr float CASCADE_PADDING = 1.3f;
+    // Casters this far towards the light from a cascade still land in it
+    constexpr float CASTER_MARGIN = 20.0f;
+    constexpr float POINT_SHADOW_NEAR = 0.05f;
+    constexpr float POINT_SHADOW_FAR = 25.0f;
+
+    // Face order and orientation of GL_TEXTURE_CUBE_MAP_POSITIVE_X onwards, matching how the object
+    // shader picks a layer and its coordinates from a direction
+    const glm::vec3 faceDirections[CUBE_FACE_COUNT] = {
+        glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3( 0.0f,  1.0f,  0.0f),
+        glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3( 0.0f,  0.0f, -1.0f)
+    };
+    const glm::vec3 faceUps[CUBE_FACE_COUNT] = {
+        glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f),
+        glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)
+    };
+
+    unsigned int createDepthArray(const int resolution, const int layers, const GLint wrap, const std::string& owner)
+    {
+        unsigned int texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, layers, 0,
+                     GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        // Hardware depth comparison with bilinear filtering gives 2x2 PCF for every tap
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrap);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrap);
+        constexpr float borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+        glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+        GpuMemory::track(GpuResourceType::Texture, texture,
+                         GpuMemory::textureBytes(GL_DEPTH_COMPONENT24, resolution, resolution, 1, layers), "Shadows",
+                         owner);
+        return texture;
+    }
+
+    void worldBounds(Model& model, const glm::mat4& transform, glm::vec3& center, float& radius)
+    {
+        model.getBounds(center, radius);
+        const float maxScale = std::max({glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+                                         glm::length(glm::vec3(transform[2]))});
+        center = glm::vec3(transform * glm::vec4(center, 1.0f));
+        radius *= maxScale;
+    }
+}
+
+ShadowRenderer::ShadowRenderer() :
+    mPointLightCount(0),
+    mDirectionalActive(false),
+    mCasterModel(1.0f),
+    mCasterVersion(0),
+    mCasterCenter(0.0f),
+    mCasterRadius(0.0f),
+    mHasCasterModel(false),
+    mNextCascade(1),
+    mNextPointLight(0),
+    mRenderedMaps(0),
+    mFBO(0),
+    mCascadeTexture(0),
+    mPointTexture(0),
+    mDepthShader(nullptr),
+    mPointDepthShader(nullptr)
+{
+    mDepthShader = new Shader(SHADOW_V_SHADER_PATH, DEPTH_F_SHADER_PATH);
+    mPointDepthShader = new Shader(SHADOW_V_SHADER_PATH, POINT_SHADOW_F_SHADER_PATH);
+    mCascadeTexture = createDepthArray(CASCADE_RES, CASCADE_COUNT, GL_CLAMP_TO_BORDER, "Cascaded shadow maps");
+    mPointTexture = createDepthArray(POINT_SHADOW_RES, MAX_POINT_LIGHTS * CUBE_FACE_COUNT, GL_CLAMP_TO_EDGE,
+                                     "Point light shadow maps");
+
+    glGenFramebuffers(1, &mFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mCascadeTexture, 0, 0);
+    // Depth only
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::SHADOWS::Shadow map framebuffer is not complete!" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+ShadowRenderer::~ShadowRenderer()
+{
+    GpuMemory::release(GpuResourceType::Texture, mCascadeTexture);
+    GpuMemory::release(GpuResourceType::Texture, mPointTexture);
+    glDeleteTextures(1, &mCascadeTexture);
+    glDeleteTextures(1, &mPointTexture);
+    glDeleteFramebuffers(1, &mFBO);
+    delete mDepthShader;
+    delete mPointDepthShader;
+}
+
+void ShadowRenderer::update(const ShadowCamera& camera, const glm::vec3* lightDirection,
+                            std::span<const glm::vec3> pointLights, Model& casters, const glm::mat4& casterModel,
+                            Profiler* profiler)
+{
+    mRenderedMaps = 0;
+    mDirectionalActive = lightDirection != nullptr;
+    mPointLightCount = std::min(static_cast<int>(pointLights.size()), MAX_POINT_LIGHTS);
+
+    if (mDirectionalActive) { fitCascades(camera, glm::normalize(*lightDirection)); }
+    for (int i = 0; i < mPointLightCount; i++)
+    {
+        PointShadow& shadow = mPointShadows[i];
+        if (!shadow.valid || shadow.pendingPosition != pointLights[i])
+        {
+            shadow.pendingPosition = pointLights[i];
+            shadow.dirty = true;
+        }
+    }
+    markMovedCasters(casters, casterModel);
+
+    bool anyDirty = false;
+    for (const Cascade& cascade : mCascades) { anyDirty |= mDirectionalActive && cascade.dirty; }
+    for (int i = 0; i < mPointLightCount; i++) { anyDirty |= mPointShadows[i].dirty; }
+    if (!anyDirty) { return; }
+
+    ProfileScope scope(profiler, "Shadows");
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+    glEnable(GL_DEPTH_TEST);
+
+    if (mDirectionalActive)
+    {
+        // The nearest cascade is the most visible, keep it current. The others take turns.
+        if (mCascades[0].dirty) { renderCascade(0, casters, casterModel); }
+        for (int attempt = 1; attempt < CASCADE_COUNT; attempt++)
+        {
+            const int index = 1 + static_cast<int>(mNextCascade++ % (CASCADE_COUNT - 1));
+            if (mCascades[index].dirty)
+            {
+                renderCascade(index, casters, casterModel);
+                break;
+            }
+        }
+    }
+
+    for (int attempt = 0; attempt < mPointLightCount; attempt++)
+    {
+        const int index = static_cast<int>(mNextPointLight++ % mPointLightCount);
+        if (mPointShadows[index].dirty)
+        {
+            renderPointShadow(index, casters, casterModel);
+            break;
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+}
+
+void ShadowRenderer::bind(const Shader& shader, const unsigned int cascadeTexUnit,
+                          const unsigned int pointTexUnit) const
+{
+    glActiveTexture(GL_TEXTURE0 + cascadeTexUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mCascadeTexture);
+    glActiveTexture(GL_TEXTURE0 + pointTexUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mPointTexture);
+    shader.setInt("cascadeShadowMap", static_cast<int>(cascadeTexUnit));
+    shader.setInt("pointShadowMap", static_cast<int>(pointTexUnit));
+    shader.setFloat("pointShadowFar", POINT_SHADOW_FAR);
+
+    FrameArena& arena = FrameArena::frame();
+    for (int i = 0; i < CASCADE_COUNT; i++)
+    {
+        const Cascade& cascade = mCascades[i];
+        // A cascade not rendered yet covers nothing, fragments fall through to the next one
+        shader.setFloat(arena.format("cascadeSplits[%d]", i),
+                        mDirectionalActive && cascade.valid ? cascade.rendered.splitFar : -1.0f);
+        shader.setMat4(arena.format("cascadeViewProjections[%d]", i), cascade.rendered.viewProjection);
+        shader.setFloat(arena.format("cascadeTexelSizes[%d]", i), 2.0f * cascade.rendered.extent / CASCADE_RES);
+    }
+    for (int i = 0; i < MAX_POINT_LIGHTS; i++)
+    {
+        shader.setBool(arena.format("pointShadowValid[%d]", i), i < mPointLightCount && mPointShadows[i].valid);
+        shader.setVec3(arena.format("pointShadowPos[%d]", i), mPointShadows[i].position);
+    }
+}
+
+void ShadowRenderer::invalidate()
+{
+    for (Cascade& cascade : mCascades) { cascade.dirty = true; }
+    for (PointShadow& shadow : mPointShadows) { shadow.dirty = true; }
+}
+
+unsigned int ShadowRenderer::renderedMapCount() const
+{
+    return mRenderedMaps;
+}
+
+void ShadowRenderer::fitCascades(const ShadowCamera& camera, const glm::vec3& lightDirection)
+{
+    const float tanHalfFov = std::tan(camera.fovY * 0.5f);
+    const glm::mat4 cameraWorld = glm::inverse(camera.view);
+    const glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    // Rotation into light space, used to snap cascade centers to whole texels
+    const glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
+
+    float splitNear = camera.nearPlane;
+    for (int i = 0; i < CASCADE_COUNT; i++)
+    {
+        Cascade& cascade = mCascades[i];
+        const float p = static_cast<float>(i + 1) / CASCADE_COUNT;
+        const float logSplit = camera.nearPlane * std::pow(SHADOW_DISTANCE / camera.nearPlane, p);
+        const float uniformSplit = camera.nearPlane + (SHADOW_DISTANCE - camera.nearPlane) * p;
+        const float splitFar = SPLIT_LAMBDA * logSplit + (1.0f - SPLIT_LAMBDA) * uniformSplit;
+
+        // Bounding sphere of the slice, its radius does not change as the camera turns
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const float depth = corner < 4 ? splitNear : splitFar;
+            const float y = depth * tanHalfFov * ((corner & 1) ? 1.0f : -1.0f);
+            const float x = depth * tanHalfFov * camera.aspect * ((corner & 2) ? 1.0f : -1.0f);
+            corners[corner] = glm::vec3(cameraWorld * glm::vec4(x, y, -depth, 1.0f));
+            center += corners[corner] / 8.0f;
+        }
+        float radius = 0.0f;
+        for (const glm::vec3& corner : corners) { radius = std::max(radius, glm::length(corner - center)); }
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        splitNear = splitFar;
+        cascade.pending.splitFar = splitFar;
+
+        // Compared against the latest fit, a map waiting for its turn is not refitted every frame
+        const bool insideFittedArea = cascade.hasFit &&
+                                      glm::length(center - cascade.pending.center) + radius <= cascade.pending.extent;
+        if (insideFittedArea && cascade.pending.lightDirection == lightDirection)
+        {
+            // The rendered map is the fitted one and covers the slice
+            if (!cascade.dirty) { cascade.rendered.splitFar = splitFar; }
+            continue;
+        }
+
+        const float extent = radius * CASCADE_PADDING;
+        const float texelSize = 2.0f * extent / CASCADE_RES;
+        glm::vec3 lightSpaceCenter = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+        lightSpaceCenter.x = std::floor(lightSpaceCenter.x / texelSize) * texelSize;
+        lightSpaceCenter.y = std::floor(lightSpaceCenter.y / texelSize) * texelSize;
+        const glm::vec3 snappedCenter = glm::vec3(glm::inverse(lightRotation) * glm::vec4(lightSpaceCenter, 1.0f));
+
+        const float depthRange = extent + CASTER_MARGIN;
+        const glm::mat4 lightView = glm::lookAt(snappedCenter - lightDirection * depthRange, snappedCenter, up);
+        const glm::mat4 lightProjection = glm::ortho(-extent, extent, -extent, extent, 0.0f, 2.0f * depthRange);
+
+        cascade.pending.viewProjection = lightProjection * lightView;
+        cascade.pending.center = snappedCenter;
+        cascade.pending.extent = extent;
+        cascade.pending.lightDirection = lightDirection;
+        cascade.hasFit = true;
+        cascade.dirty = true;
+    }
+}
+
+void ShadowRenderer::renderCascade(const int index, Model& casters, const glm::mat4& casterModel)
+{
+    Cascade& cascade = mCascades[index];
+    // Until now bind() kept uploading the fit the old map was rendered with
+    cascade.rendered = cascade.pending;
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mCascadeTexture, 0, index);
+    glViewport(0, 0, CASCADE_RES, CASCADE_RES);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    mDepthShader->use();
+    mDepthShader->setMat4("lightViewProjection", cascade.rendered.viewProjection);
+    mDepthShader->setMat4("model", casterModel);
+    casters.bindTransforms(*mDepthShader, 0);
+    // Slope scaled bias against acne on surfaces at grazing angles to the light
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+    // Meshes hidden from the camera still cast shadows into its view
+    casters.DrawDepth(false);
+    glDisable(GL_POLYGON_OFFSET_FILL);
+
+    cascade.valid = true;
+    cascade.dirty = false;
+    mRenderedMaps++;
+}
+
+void ShadowRenderer::renderPointShadow(const int index, Model& casters, const glm::mat4& casterModel)
+{
+    PointShadow& shadow = mPointShadows[index];
+    shadow.position = shadow.pendingPosition;
+    const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, POINT_SHADOW_NEAR, POINT_SHADOW_FAR);
+
+    glViewport(0, 0, POINT_SHADOW_RES, POINT_SHADOW_RES);
+    mPointDepthShader->use();
+    mPointDepthShader->setVec3("lightPos", shadow.position);
+    mPointDepthShader->setFloat("farPlane", POINT_SHADOW_FAR);
+    mPointDepthShader->setMat4("model", casterModel);
+    casters.bindTransforms(*mPointDepthShader, 0);
+    for (int face = 0; face < CUBE_FACE_COUNT; face++)
+    {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mPointTexture, 0,
+                                  index * CUBE_FACE_COUNT + face);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        const glm::mat4 view = glm::lookAt(shadow.position, shadow.position + faceDirections[face], faceUps[face]);
+        mPointDepthShader->setMat4("lightViewProjection", projection * view);
+        casters.DrawDepth(false);
+    }
+
+    shadow.valid = true;
+    shadow.dirty = false;
+    mRenderedMaps++;
+}
+
+void ShadowRenderer::markMovedCasters(Model& casters, const glm::mat4& casterModel)
+{
+    if (mHasCasterModel && casterModel == mCasterModel && casters.getTransformVersion() == mCasterVersion) { return; }
+
+    glm::vec3 newCenter;
+    float newRadius;
+    worldBounds(casters, casterModel, newCenter, newRadius);
+    // Parts moving within the model change its bounds, so the old ones are kept rather than recomputed
+    const glm::vec3 oldCenter = mHasCasterModel ? mCasterCenter : newCenter;
+    const float oldRadius = mHasCasterModel ? mCasterRadius : newRadius;
+    mCasterModel = casterModel;
+    mCasterVersion = casters.getTransformVersion();
+    mCasterCenter = newCenter;
+    mCasterRadius = newRadius;
+    mHasCasterModel = true;
+
+    for (Cascade& cascade : mCascades)
+    {
+        const std::array<glm::vec4, 6> planes = Frustum::extractPlanes(cascade.rendered.viewProjection);
+        if (Frustum::isSphereVisible(planes, newCenter, newRadius) ||
+            Frustum::isSphereVisible(planes, oldCenter, oldRadius))
+        {
+            cascade.dirty = true;
+        }
+    }
+    for (PointShadow& shadow : mPointShadows)
+    {
+        if (glm::length(newCenter - shadow.position) <= POINT_SHADOW_FAR + newRadius ||
+            glm::length(oldCenter - shadow.position) <= POINT_SHADOW_FAR + oldRadius)
+        {
+            shadow.dirty = true;
+        }
+    }
+}
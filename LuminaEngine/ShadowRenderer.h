@@ -0,0 +1,102 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Model.h"
+#include "Profiler.h"
+#include "Shader.h"
+
+// View the cascades are fitted to
+struct ShadowCamera
+{
+    glm::mat4 view;
+    float fovY; // In radians
+    float aspect;
+    float nearPlane;
+};
+
+/// <summary>
+/// Cascaded shadow maps for the directional light and cube shadow maps for point lights. Every map is
+/// cached and only re-rendered when its light changes, a caster it covers moves or, for cascades, the
+/// camera leaves the area it was fitted to, so a static scene renders no shadow maps at all. Past the
+/// nearest cascade, at most one cascade and one point light are re-rendered per frame.
+/// </summary>
+class ShadowRenderer
+{
+public:
+    static constexpr int CASCADE_COUNT = 3;
+    static constexpr int MAX_POINT_LIGHTS = 4;
+
+    ShadowRenderer();
+    ~ShadowRenderer();
+
+    /// <summary>
+    /// Re-renders the shadow maps that are out of date. A null lightDirection skips the cascades and an
+    /// empty pointLights the point light maps, both keep their cached maps for later.
+    /// </summary>
+    void update(const ShadowCamera& camera, const glm::vec3* lightDirection, std::span<const glm::vec3> pointLights,
+                Model& casters, const glm::mat4& casterModel, Profiler* profiler = nullptr);
+    /// <summary>
+    /// Binds the maps to the given texture units and sets the shadow uniforms of the object shader
+    /// </summary>
+    void bind(const Shader& shader, unsigned int cascadeTexUnit, unsigned int pointTexUnit) const;
+    void invalidate();
+    unsigned int renderedMapCount() const;
+
+private:
+    // Light space fit of one cascade to its slice of the view
+    struct CascadeFit
+    {
+        glm::mat4 viewProjection = glm::mat4(1.0f);
+        glm::vec3 center = glm::vec3(0.0f);
+        float extent = 0.0f;      // Half size of the area the cascade covers
+        float splitFar = 0.0f;    // View depth where the next cascade takes over
+        glm::vec3 lightDirection = glm::vec3(0.0f);
+    };
+
+    struct Cascade
+    {
+        CascadeFit rendered; // What the map holds, which bind() uploads
+        // Latest fit, swapped into rendered once the map has been rendered with it
+        CascadeFit pending;
+        bool hasFit = false;
+        bool valid = false;
+        bool dirty = true;
+    };
+
+    struct PointShadow
+    {
+        glm::vec3 position = glm::vec3(0.0f); // The map was rendered from here
+        glm::vec3 pendingPosition = glm::vec3(0.0f);
+        bool valid = false;
+        bool dirty = true;
+    };
+
+    void fitCascades(const ShadowCamera& camera, const glm::vec3& lightDirection);
+    void renderCascade(int index, Model& casters, const glm::mat4& casterModel);
+    void renderPointShadow(int index, Model& casters, const glm::mat4& casterModel);
+    // Flags the maps covering the old or new caster bounds when the caster moved
+    void markMovedCasters(Model& casters, const glm::mat4& casterModel);
+
+    Cascade mCascades[CASCADE_COUNT];
+    PointShadow mPointShadows[MAX_POINT_LIGHTS];
+    int mPointLightCount;
+    bool mDirectionalActive;
+
+    glm::mat4 mCasterModel;
+    uint64_t mCasterVersion;  // Transform version of the casters the maps were rendered with
+    glm::vec3 mCasterCenter;  // World space bounds of the casters the maps were rendered with
+    float mCasterRadius;
+    bool mHasCasterModel;
+    unsigned int mNextCascade;    // Round robin over the far cascades
+    unsigned int mNextPointLight; // Round robin over the point lights
+    unsigned int mRenderedMaps;   // Shadow maps rendered by the last update
+
+    unsigned int mFBO;
+    unsigned int mCascadeTexture;
+    unsigned int mPointTexture;
+    Shader* mDepthShader;
+    Shader* mPointDepthShader; // Writes the distance to the light instead of the projected depth
+};
@@ -0,0 +1,169 @@
+#include "Simulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float CAMERA_SPEED = 5.0f; // Units per second
+    // Further behind than this the thread skips ticks instead of running them back to back
+    constexpr double MAX_LAG_SECONDS = 0.25;
+
+    double secondsSince(const std::chrono::steady_clock::time_point time)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - time).count();
+    }
+
+    glm::vec3 cameraFront(const double yaw, const double pitch)
+    {
+        return glm::normalize(glm::vec3(std::cos(glm::radians(yaw)) * std::cos(glm::radians(pitch)),
+                                        std::sin(glm::radians(pitch)),
+                                        std::sin(glm::radians(yaw)) * std::cos(glm::radians(pitch))));
+    }
+}
+
+Simulation::Simulation(const SimulationState& initial) :
+    mStart(std::chrono::steady_clock::now()),
+    mSnapshots(SceneSnapshot{0, initial, initial}),
+    mMeasuredTickRate(0.0f),
+    mStop(false)
+{
+    mInput.objectPosition = initial.objectPosition;
+    mInput.objectRotation = initial.objectRotation;
+    mInput.objectScale = initial.objectScale;
+    mThread = std::thread(&Simulation::simulationThread, this);
+}
+
+Simulation::~Simulation()
+{
+    mStop.store(true, std::memory_order_relaxed);
+    mThread.join();
+}
+
+void Simulation::setMoveKeys(const uint32_t keys)
+{
+    std::lock_guard<std::mutex> lock(mInputMutex);
+    mInput.moveKeys = keys;
+}
+
+void Simulation::addLook(const double yawDegrees, const double pitchDegrees)
+{
+    std::lock_guard<std::mutex> lock(mInputMutex);
+    mInput.yawDelta += yawDegrees;
+    mInput.pitchDelta += pitchDegrees;
+}
+
+void Simulation::addZoom(const float fovDegrees)
+{
+    std::lock_guard<std::mutex> lock(mInputMutex);
+    mInput.fovDelta += fovDegrees;
+}
+
+void Simulation::setObjectTransform(const float position[3], const float rotation[3], const float scale[3])
+{
+    std::lock_guard<std::mutex> lock(mInputMutex);
+    mInput.objectPosition = glm::vec3(position[0], position[1], position[2]);
+    mInput.objectRotation = glm::vec3(rotation[0], rotation[1], rotation[2]);
+    mInput.objectScale = glm::vec3(scale[0], scale[1], scale[2]);
+}
+
+SimulationState Simulation::sample()
+{
+    const SceneSnapshot& snapshot = mSnapshots.read();
+    const SimulationState& a = snapshot.previous;
+    const SimulationState& b = snapshot.current;
+    const auto t = static_cast<float>(std::clamp((secondsSince(mStart) - b.time) / TICK_SECONDS, 0.0, 1.0));
+
+    SimulationState state;
+    state.time = a.time + (b.time - a.time) * t;
+    state.cameraPosition = glm::mix(a.cameraPosition, b.cameraPosition, t);
+    state.cameraYaw = a.cameraYaw + (b.cameraYaw - a.cameraYaw) * t;
+    state.cameraPitch = a.cameraPitch + (b.cameraPitch - a.cameraPitch) * t;
+    state.cameraFov = glm::mix(a.cameraFov, b.cameraFov, t);
+    state.objectPosition = glm::mix(a.objectPosition, b.objectPosition, t);
+    state.objectRotation = glm::mix(a.objectRotation, b.objectRotation, t);
+    state.objectScale = glm::mix(a.objectScale, b.objectScale, t);
+    return state;
+}
+
+Camera Simulation::toCamera(const SimulationState& state)
+{
+    Camera camera;
+    camera.position = state.cameraPosition;
+    camera.front = cameraFront(state.cameraYaw, state.cameraPitch);
+    camera.fov = state.cameraFov;
+    return camera;
+}
+
+float Simulation::measuredTickRate() const
+{
+    return mMeasuredTickRate.load(std::memory_order_relaxed);
+}
+
+void Simulation::simulationThread()
+{
+    using Clock = std::chrono::steady_clock;
+    const auto tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(TICK_SECONDS));
+
+    SimulationState state = mSnapshots.back().current;
+    uint64_t tick = 0;
+    Clock::time_point nextTick = mStart + tickDuration;
+    Clock::time_point rateStart = mStart;
+    unsigned int rateTicks = 0;
+
+    while (!mStop.load(std::memory_order_relaxed))
+    {
+        std::this_thread::sleep_until(nextTick);
+        const Clock::time_point now = Clock::now();
+        if (now - nextTick > std::chrono::duration<double>(MAX_LAG_SECONDS))
+        {
+            nextTick = now;
+        }
+
+        Input input;
+        {
+            std::lock_guard<std::mutex> lock(mInputMutex);
+            input = mInput;
+            mInput.yawDelta = 0.0;
+            mInput.pitchDelta = 0.0;
+            mInput.fovDelta = 0.0f;
+        }
+
+        SceneSnapshot& snapshot = mSnapshots.back();
+        snapshot.previous = state;
+        step(state, input);
+        state.time = std::chrono::duration<double>(nextTick - mStart).count();
+        snapshot.current = state;
+        snapshot.tick = ++tick;
+        mSnapshots.publish();
+
+        rateTicks++;
+        if (now - rateStart >= std::chrono::seconds(1))
+        {
+            mMeasuredTickRate.store(static_cast<float>(rateTicks / std::chrono::duration<double>(now - rateStart).count()),
+                                    std::memory_order_relaxed);
+            rateStart = now;
+            rateTicks = 0;
+        }
+        nextTick += tickDuration;
+    }
+}
+
+void Simulation::step(SimulationState& state, const Input& input) const
+{
+    state.cameraYaw += input.yawDelta;
+    state.cameraPitch = std::clamp(state.cameraPitch + input.pitchDelta, -89.0, 89.0);
+    state.cameraFov = std::clamp(state.cameraFov - input.fovDelta, 1.0f, 45.0f);
+
+    const glm::vec3 front = cameraFront(state.cameraYaw, state.cameraPitch);
+    const glm::vec3 right = glm::normalize(glm::cross(front, Camera().up));
+    const float distance = CAMERA_SPEED * static_cast<float>(TICK_SECONDS);
+    if (input.moveKeys & MOVE_FORWARD) { state.cameraPosition += distance * front; }
+    if (input.moveKeys & MOVE_BACKWARD) { state.cameraPosition -= distance * front; }
+    if (input.moveKeys & MOVE_LEFT) { state.cameraPosition -= distance * right; }
+    if (input.moveKeys & MOVE_RIGHT) { state.cameraPosition += distance * right; }
+
+    state.objectPosition = input.objectPosition;
+    state.objectRotation = input.objectRotation;
+    state.objectScale = input.objectScale;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <glm/glm.hpp>
+
+#include "Renderer.h"
+#include "TripleBuffer.h"
+
+enum MoveKey : uint32_t
+{
+    MOVE_FORWARD = 1 << 0,
+    MOVE_BACKWARD = 1 << 1,
+    MOVE_LEFT = 1 << 2,
+    MOVE_RIGHT = 1 << 3
+};
+
+// Everything the simulation moves, at one tick
+struct SimulationState
+{
+    double time = 0.0; // Seconds since the simulation started
+    glm::vec3 cameraPosition = glm::vec3(0.0f, 0.0f, 7.0f);
+    double cameraYaw = -90.0;  // Rotation around Y axis, in degrees
+    double cameraPitch = 0.0;  // Rotation around X axis, in degrees
+    float cameraFov = 45.0f;
+    glm::vec3 objectPosition = glm::vec3(0.0f);
+    glm::vec3 objectRotation = glm::vec3(0.0f); // Euler angles in degrees
+    glm::vec3 objectScale = glm::vec3(1.0f);
+};
+
+// Published once per tick with the previous tick as well, so the renderer can interpolate from a single
+// snapshot however many ticks it missed
+struct SceneSnapshot
+{
+    uint64_t tick = 0;
+    SimulationState previous;
+    SimulationState current;
+};
+
+/// <summary>
+/// Runs input handling and camera motion on its own thread at a fixed tick, so a slow GPU frame no longer
+/// slows the camera down. Input arrives from the window thread, the results leave as snapshots through a
+/// triple buffer and the render thread interpolates between the two ticks of the latest one.
+/// </summary>
+class Simulation
+{
+public:
+    static constexpr double TICK_SECONDS = 1.0 / 120.0;
+
+    explicit Simulation(const SimulationState& initial = SimulationState());
+    ~Simulation();
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    /// <summary>
+    /// Held MoveKey flags, applied on every tick until they change
+    /// </summary>
+    void setMoveKeys(uint32_t keys);
+    /// <summary>
+    /// Mouse look in degrees, accumulated until the next tick
+    /// </summary>
+    void addLook(double yawDegrees, double pitchDegrees);
+    void addZoom(float fovDegrees);
+    void setObjectTransform(const float position[3], const float rotation[3], const float scale[3]);
+
+    /// <summary>
+    /// Render thread only. State one tick behind the simulation, interpolated to the current time.
+    /// </summary>
+    SimulationState sample();
+    static Camera toCamera(const SimulationState& state);
+    float measuredTickRate() const;
+
+private:
+    struct Input
+    {
+        uint32_t moveKeys = 0;
+        double yawDelta = 0.0;
+        double pitchDelta = 0.0;
+        float fovDelta = 0.0f;
+        glm::vec3 objectPosition = glm::vec3(0.0f);
+        glm::vec3 objectRotation = glm::vec3(0.0f);
+        glm::vec3 objectScale = glm::vec3(1.0f);
+    };
+
+    void simulationThread();
+    void step(SimulationState& state, const Input& input) const;
+
+    std::chrono::steady_clock::time_point mStart;
+    std::mutex mInputMutex;
+    Input mInput;
+    TripleBuffer<SceneSnapshot> mSnapshots;
+    std::atomic<float> mMeasuredTickRate;
+    std::atomic<bool> mStop;
+    std::thread mThread;
+};
@@ -0,0 +1,288 @@
+#include "SsaoRenderer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <glad/glad.h>
+
+#include "GpuMemory.h"
+
+namespace
+{
+    // Must match KERNEL_SIZE in shader_ssao.frag
+    constexpr int KERNEL_SIZE = 16;
+    constexpr int NOISE_RES = 4;
+
+    // Hemisphere samples around +Z, denser close to the origin where occluders matter most
+    std::vector<glm::vec3> createKernel()
+    {
+        std::mt19937 generator(1337);
+        std::uniform_real_distribution<float> random(0.0f, 1.0f);
+        std::vector<glm::vec3> kernel;
+        kernel.reserve(KERNEL_SIZE);
+        for (int i = 0; i < KERNEL_SIZE; i++)
+        {
+            glm::vec3 sample(random(generator) * 2.0f - 1.0f, random(generator) * 2.0f - 1.0f, random(generator));
+            sample = glm::normalize(sample) * random(generator);
+            float scale = static_cast<float>(i) / KERNEL_SIZE;
+            scale = 0.1f + 0.9f * scale * scale;
+            kernel.push_back(sample * scale);
+        }
+        return kernel;
+    }
+
+    int divideRoundingUp(const int value, const int divisor)
+    {
+        return std::max(1, (value + divisor - 1) / divisor);
+    }
+}
+
+SsaoRenderer::SsaoRenderer(const unsigned int outputWidth, const unsigned int outputHeight,
+                           const int resolutionDivisor) :
+    mGeometryFBO(0),
+    mGeometryDepthRBO(0),
+    mNormalDepthTexture(0),
+    mAoFBO(0),
+    mAoTextures{0, 0},
+    mNoiseTexture(0),
+    mOutputSize(outputWidth, outputHeight),
+    mTargetSize(),
+    mViewportSize(),
+    mResolutionDivisor(resolutionDivisor),
+    mQuadVAO(0),
+    mQuadVBO(0),
+    mGeometryShader(nullptr),
+    mSsaoShader(nullptr),
+    mBlurShader(nullptr)
+{
+    constexpr float QUAD_VERTICIES[] = {
+        // positions        // texture Coords
+        -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
+        -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+         1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
+         1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
+    };
+
+    glGenVertexArrays(1, &mQuadVAO);
+    glGenBuffers(1, &mQuadVBO);
+    glBindVertexArray(mQuadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mQuadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICIES), &QUAD_VERTICIES, GL_STATIC_DRAW);
+    GpuMemory::track(GpuResourceType::Buffer, mQuadVBO, sizeof(QUAD_VERTICIES), "SSAO", "SSAO quad");
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Random rotations of the kernel around the normal, tiled over the screen
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> random(-1.0f, 1.0f);
+    std::vector<glm::vec2> noise(NOISE_RES * NOISE_RES);
+    for (glm::vec2& rotation : noise) { rotation = glm::vec2(random(generator), random(generator)); }
+    glGenTextures(1, &mNoiseTexture);
+    glBindTexture(GL_TEXTURE_2D, mNoiseTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, NOISE_RES, NOISE_RES, 0, GL_RG, GL_FLOAT, noise.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    GpuMemory::track(GpuResourceType::Texture, mNoiseTexture,
+                     GpuMemory::textureBytes(GL_RG16F, NOISE_RES, NOISE_RES), "SSAO", "SSAO noise");
+
+    mGeometryShader = new Shader("Assets/Shaders/shader_ssao_geometry.vert",
+                                 "Assets/Shaders/shader_ssao_geometry.frag");
+
+    mSsaoShader = new Shader("Assets/Shaders/shader_screen.vert", "Assets/Shaders/shader_ssao.frag");
+    mSsaoShader->use();
+    mSsaoShader->setInt("normalDepthTexture", 0);
+    mSsaoShader->setInt("noiseTexture", 1);
+    const std::vector<glm::vec3> kernel = createKernel();
+    char name[16];
+    for (int i = 0; i < KERNEL_SIZE; i++)
+    {
+        std::snprintf(name, sizeof(name), "samples[%d]", i);
+        mSsaoShader->setVec3(name, kernel[i]);
+    }
+
+    mBlurShader = new Shader("Assets/Shaders/shader_screen.vert", "Assets/Shaders/shader_ssao_blur.frag");
+    mBlurShader->use();
+    mBlurShader->setInt("aoTexture", 0);
+
+    createTargets();
+}
+
+SsaoRenderer::~SsaoRenderer()
+{
+    destroyTargets();
+    GpuMemory::release(GpuResourceType::Texture, mNoiseTexture);
+    glDeleteTextures(1, &mNoiseTexture);
+    GpuMemory::release(GpuResourceType::Buffer, mQuadVBO);
+    glDeleteBuffers(1, &mQuadVBO);
+    glDeleteVertexArrays(1, &mQuadVAO);
+    delete mGeometryShader;
+    delete mSsaoShader;
+    delete mBlurShader;
+}
+
+unsigned int SsaoRenderer::render(Model& model, const glm::mat4& modelMatrix, const glm::mat4& view,
+                                  const glm::mat4& projection, const glm::ivec2& renderSize, const float radius,
+                                  const float intensity, Profiler* profiler)
+{
+    ProfileScope scope(profiler, "SSAO");
+    mViewportSize = glm::min(glm::ivec2(divideRoundingUp(renderSize.x, mResolutionDivisor),
+                                        divideRoundingUp(renderSize.y, mResolutionDivisor)), mTargetSize);
+    const glm::vec2 textureUvScale = uvScale();
+    const glm::vec2 texelSize = 1.0f / glm::vec2(mTargetSize);
+
+    // View space normals and depth, zero depth marks pixels without geometry
+    glBindFramebuffer(GL_FRAMEBUFFER, mGeometryFBO);
+    glViewport(0, 0, mViewportSize.x, mViewportSize.y);
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    mGeometryShader->use();
+    mGeometryShader->setMat4("model", modelMatrix);
+    mGeometryShader->setMat4("view", view);
+    mGeometryShader->setMat4("projection", projection);
+    model.bindTransforms(*mGeometryShader, 0);
+    // Positions only, occlusion needs no material
+    model.DrawDepth();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mAoFBO);
+    glDisable(GL_DEPTH_TEST);
+    glBindVertexArray(mQuadVAO);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mAoTextures[0], 0);
+    mSsaoShader->use();
+    mSsaoShader->setMat4("projection", projection);
+    mSsaoShader->setVec2("uvScale", textureUvScale);
+    mSsaoShader->setVec2("noiseScale", glm::vec2(mViewportSize) / static_cast<float>(NOISE_RES));
+    mSsaoShader->setFloat("radius", radius);
+    mSsaoShader->setFloat("intensity", intensity);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mNormalDepthTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, mNoiseTexture);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // Horizontal then vertical, ending back in the first texture
+    mBlurShader->use();
+    mBlurShader->setVec2("uvScale", textureUvScale);
+    glActiveTexture(GL_TEXTURE0);
+    for (int pass = 0; pass < 2; pass++)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mAoTextures[1 - pass], 0);
+        glBindTexture(GL_TEXTURE_2D, mAoTextures[pass]);
+        mBlurShader->setVec2("direction", pass == 0 ? glm::vec2(texelSize.x, 0.0f) : glm::vec2(0.0f, texelSize.y));
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return mAoTextures[0];
+}
+
+glm::vec2 SsaoRenderer::uvScale() const
+{
+    return glm::vec2(mViewportSize) / glm::vec2(mTargetSize);
+}
+
+void SsaoRenderer::setResolutionDivisor(const int resolutionDivisor)
+{
+    if (resolutionDivisor == mResolutionDivisor || resolutionDivisor < 1) { return; }
+    mResolutionDivisor = resolutionDivisor;
+    destroyTargets();
+    createTargets();
+}
+
+void SsaoRenderer::resize(const unsigned int outputWidth, const unsigned int outputHeight)
+{
+    mOutputSize = glm::ivec2(outputWidth, outputHeight);
+    destroyTargets();
+    createTargets();
+}
+
+bool SsaoRenderer::createTargets()
+{
+    mTargetSize = glm::ivec2(divideRoundingUp(mOutputSize.x, mResolutionDivisor),
+                             divideRoundingUp(mOutputSize.y, mResolutionDivisor));
+    mViewportSize = mTargetSize;
+
+    glGenFramebuffers(1, &mGeometryFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, mGeometryFBO);
+    glGenTextures(1, &mNormalDepthTexture);
+    glBindTexture(GL_TEXTURE_2D, mNormalDepthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mTargetSize.x, mTargetSize.y, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GpuMemory::track(GpuResourceType::Texture, mNormalDepthTexture,
+                     GpuMemory::textureBytes(GL_RGBA16F, mTargetSize.x, mTargetSize.y), "SSAO", "SSAO normals");
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mNormalDepthTexture, 0);
+
+    glGenRenderbuffers(1, &mGeometryDepthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, mGeometryDepthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mTargetSize.x, mTargetSize.y);
+    GpuMemory::track(GpuResourceType::Renderbuffer, mGeometryDepthRBO,
+                     GpuMemory::textureBytes(GL_DEPTH_COMPONENT24, mTargetSize.x, mTargetSize.y), "SSAO",
+                     "SSAO depth");
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mGeometryDepthRBO);
+
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete)
+    {
+        std::cout << "ERROR::SSAO::Geometry framebuffer is not complete!" << std::endl;
+    }
+
+    glGenFramebuffers(1, &mAoFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, mAoFBO);
+    glGenTextures(2, mAoTextures);
+    char owner[24];
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        glBindTexture(GL_TEXTURE_2D, mAoTextures[i]);
+        // Depth travels with the occlusion for the depth-aware blur and upsample
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, mTargetSize.x, mTargetSize.y, 0, GL_RG, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        std::snprintf(owner, sizeof(owner), "SSAO occlusion %u", i);
+        GpuMemory::track(GpuResourceType::Texture, mAoTextures[i],
+                         GpuMemory::textureBytes(GL_RG16F, mTargetSize.x, mTargetSize.y), "SSAO", owner);
+    }
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mAoTextures[0], 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::SSAO::Occlusion framebuffer is not complete!" << std::endl;
+        complete = false;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return complete;
+}
+
+void SsaoRenderer::destroyTargets()
+{
+    for (unsigned int& texture : mAoTextures)
+    {
+        GpuMemory::release(GpuResourceType::Texture, texture);
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+    GpuMemory::release(GpuResourceType::Texture, mNormalDepthTexture);
+    glDeleteTextures(1, &mNormalDepthTexture);
+    mNormalDepthTexture = 0;
+    GpuMemory::release(GpuResourceType::Renderbuffer, mGeometryDepthRBO);
+    glDeleteRenderbuffers(1, &mGeometryDepthRBO);
+    mGeometryDepthRBO = 0;
+    glDeleteFramebuffers(1, &mGeometryFBO);
+    glDeleteFramebuffers(1, &mAoFBO);
+    mGeometryFBO = 0;
+    mAoFBO = 0;
+}
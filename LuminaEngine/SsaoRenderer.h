@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Model.h"
+#include "Profiler.h"
+#include "Shader.h"
+
+/// <summary>
+/// Screen-space ambient occlusion at a fraction of the render resolution. Draws view space face normals and
+/// depth of the model from its position only stream into its own low resolution target, estimates occlusion
+/// from them and blurs it with a separable depth-aware filter. The result holds occlusion in red and view depth
+/// in green, so the object shader can upsample it bilaterally without another texture.
+/// </summary>
+class SsaoRenderer
+{
+public:
+    SsaoRenderer(unsigned int outputWidth, unsigned int outputHeight, int resolutionDivisor = 2);
+    ~SsaoRenderer();
+
+    /// <summary>
+    /// Renders the occlusion of the model for a scene of renderSize pixels and returns the AO texture.
+    /// Only the uvScale() part of the texture holds the frame.
+    /// </summary>
+    unsigned int render(Model& model, const glm::mat4& modelMatrix, const glm::mat4& view, const glm::mat4& projection,
+                        const glm::ivec2& renderSize, float radius, float intensity, Profiler* profiler = nullptr);
+    glm::vec2 uvScale() const;
+    /// <summary>
+    /// Output pixels per AO pixel along each axis, 2 for half and 4 for quarter resolution
+    /// </summary>
+    void setResolutionDivisor(int resolutionDivisor);
+    void resize(unsigned int outputWidth, unsigned int outputHeight);
+
+private:
+    bool createTargets();
+    void destroyTargets();
+
+    unsigned int mGeometryFBO;
+    unsigned int mGeometryDepthRBO;
+    unsigned int mNormalDepthTexture;
+    unsigned int mAoFBO;
+    unsigned int mAoTextures[2]; // Occlusion and its blurred copies, ping-ponged between the passes
+    unsigned int mNoiseTexture;
+    glm::ivec2 mOutputSize;
+    glm::ivec2 mTargetSize;
+    glm::ivec2 mViewportSize; // Part of the targets used by the last render
+    int mResolutionDivisor;
+    unsigned int mQuadVAO;
+    unsigned int mQuadVBO;
+    Shader* mGeometryShader;
+    Shader* mSsaoShader;
+    Shader* mBlurShader;
+};
@@ -0,0 +1,177 @@
+#include "TemporalAA.h"
+
+#include <iostream>
+#include <string>
+#include <glad/glad.h>
+
+#include "GpuMemory.h"
+
+namespace
+{
+    // Length of the jitter sequence, long enough to cover a pixel well without visible cycling
+    constexpr unsigned int JITTER_SAMPLE_COUNT = 8;
+
+    // Halton low discrepancy sequence, index starts at 1
+    float halton(unsigned int index, const unsigned int base)
+    {
+        float fraction = 1.0f;
+        float result = 0.0f;
+        while (index > 0)
+        {
+            fraction /= static_cast<float>(base);
+            result += fraction * static_cast<float>(index % base);
+            index /= base;
+        }
+        return result;
+    }
+}
+
+TemporalAA::TemporalAA(const unsigned int outputWidth, const unsigned int outputHeight) :
+    mFBO(0),
+    mHistoryTextures{0, 0},
+    mCurrentHistory(0),
+    mHistoryValid(false),
+    mFrameIndex(0),
+    mOutputSize(),
+    mQuadVAO(0),
+    mQuadVBO(0),
+    mResolveShader(nullptr)
+{
+    constexpr float QUAD_VERTICIES[] = {
+        // positions        // texture Coords
+        -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
+        -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+         1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
+         1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
+    };
+
+    glGenVertexArrays(1, &mQuadVAO);
+    glGenBuffers(1, &mQuadVBO);
+    glBindVertexArray(mQuadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mQuadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICIES), &QUAD_VERTICIES, GL_STATIC_DRAW);
+    GpuMemory::track(GpuResourceType::Buffer, mQuadVBO, sizeof(QUAD_VERTICIES), "TAA", "TAA quad");
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    mResolveShader = new Shader("Assets/Shaders/shader_screen.vert", "Assets/Shaders/shader_taa.frag");
+    mResolveShader->use();
+    mResolveShader->setInt("sceneTexture", 0);
+    mResolveShader->setInt("velocityTexture", 1);
+    mResolveShader->setInt("historyTexture", 2);
+
+    createTargets(outputWidth, outputHeight);
+}
+
+TemporalAA::~TemporalAA()
+{
+    destroyTargets();
+    GpuMemory::release(GpuResourceType::Buffer, mQuadVBO);
+    glDeleteBuffers(1, &mQuadVBO);
+    glDeleteVertexArrays(1, &mQuadVAO);
+    delete mResolveShader;
+}
+
+glm::vec2 TemporalAA::nextJitter()
+{
+    mFrameIndex++;
+    const unsigned int index = mFrameIndex % JITTER_SAMPLE_COUNT + 1;
+    return {halton(index, 2) - 0.5f, halton(index, 3) - 0.5f};
+}
+
+unsigned int TemporalAA::resolve(const unsigned int sceneTexture, const unsigned int velocityTexture,
+                                 const glm::vec2& sceneUvScale, Profiler* profiler)
+{
+    ProfileScope scope(profiler, "TAA Resolve");
+    const unsigned int previousHistory = 1 - mCurrentHistory;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           mHistoryTextures[mCurrentHistory], 0);
+    glViewport(0, 0, mOutputSize.x, mOutputSize.y);
+    glDisable(GL_DEPTH_TEST);
+
+    mResolveShader->use();
+    mResolveShader->setVec2("sceneUvScale", sceneUvScale);
+    mResolveShader->setBool("historyValid", mHistoryValid);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sceneTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, velocityTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, mHistoryTextures[previousHistory]);
+
+    glBindVertexArray(mQuadVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    const unsigned int resolved = mHistoryTextures[mCurrentHistory];
+    mCurrentHistory = previousHistory;
+    mHistoryValid = true;
+    return resolved;
+}
+
+unsigned int TemporalAA::nextResolveTarget() const
+{
+    return mHistoryTextures[mCurrentHistory];
+}
+
+void TemporalAA::invalidateHistory()
+{
+    mHistoryValid = false;
+}
+
+void TemporalAA::resize(const unsigned int outputWidth, const unsigned int outputHeight)
+{
+    destroyTargets();
+    createTargets(outputWidth, outputHeight);
+}
+
+bool TemporalAA::createTargets(const unsigned int outputWidth, const unsigned int outputHeight)
+{
+    mOutputSize = glm::ivec2(outputWidth, outputHeight);
+    mHistoryValid = false;
+
+    glGenFramebuffers(1, &mFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+    glGenTextures(2, mHistoryTextures);
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        glBindTexture(GL_TEXTURE_2D, mHistoryTextures[i]);
+        // Half floats even with the compact scene format, the history accumulates rounding over many frames
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mOutputSize.x, mOutputSize.y, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        GpuMemory::track(GpuResourceType::Texture, mHistoryTextures[i],
+                         GpuMemory::textureBytes(GL_RGBA16F, mOutputSize.x, mOutputSize.y), "TAA",
+                         "TAA history " + std::to_string(i));
+    }
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mHistoryTextures[0], 0);
+
+    const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete)
+    {
+        std::cout << "ERROR::TAA::History framebuffer is not complete!" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return complete;
+}
+
+void TemporalAA::destroyTargets()
+{
+    for (unsigned int& texture : mHistoryTextures)
+    {
+        GpuMemory::release(GpuResourceType::Texture, texture);
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+    glDeleteFramebuffers(1, &mFBO);
+    mFBO = 0;
+}
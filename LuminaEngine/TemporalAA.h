@@ -0,0 +1,52 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Profiler.h"
+#include "Shader.h"
+
+/// <summary>
+/// Temporal anti-aliasing. Hands out a Halton (2, 3) sub-pixel jitter for each frame and resolves the
+/// jittered scene against the reprojected history of previous frames. The history is kept at the output
+/// resolution, so the resolve also upscales scenes rendered at a lower resolution.
+/// </summary>
+class TemporalAA
+{
+public:
+    TemporalAA(unsigned int outputWidth, unsigned int outputHeight);
+    ~TemporalAA();
+
+    /// <summary>
+    /// Advances to the next frame and returns its jitter in pixels, in the range [-0.5, 0.5]
+    /// </summary>
+    glm::vec2 nextJitter();
+    /// <summary>
+    /// Resolves the scene into the history and returns the resolved texture. Only the sceneUvScale part
+    /// of the scene and velocity textures is read.
+    /// </summary>
+    unsigned int resolve(unsigned int sceneTexture, unsigned int velocityTexture, const glm::vec2& sceneUvScale,
+                         Profiler* profiler = nullptr);
+    /// <summary>
+    /// History texture the next resolve writes and returns
+    /// </summary>
+    unsigned int nextResolveTarget() const;
+    /// <summary>
+    /// Starts the next resolve from the current frame alone, for camera cuts or after TAA was off
+    /// </summary>
+    void invalidateHistory();
+    void resize(unsigned int outputWidth, unsigned int outputHeight);
+
+private:
+    bool createTargets(unsigned int outputWidth, unsigned int outputHeight);
+    void destroyTargets();
+
+    unsigned int mFBO;
+    unsigned int mHistoryTextures[2];
+    unsigned int mCurrentHistory; // Written by the next resolve, the other one holds the previous frame
+    bool mHistoryValid;
+    unsigned int mFrameIndex;
+    glm::ivec2 mOutputSize;
+    unsigned int mQuadVAO;
+    unsigned int mQuadVBO;
+    Shader* mResolveShader;
+};
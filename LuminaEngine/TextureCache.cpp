@@ -0,0 +1,190 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace TextureCache
+{
+    namespace
+    {
+        constexpr char MAGIC[4] = {'L', 'T', 'C', '1'};
+        const std::filesystem::path CACHE_DIRECTORY = "TextureCache";
+
+        bool sourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& writeTime)
+        {
+            std::error_code error;
+            size = std::filesystem::file_size(sourcePath, error);
+            if (error) { return false; }
+            writeTime = std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count();
+            return !error;
+        }
+
+        int fullMipCount(const uint32_t width, const uint32_t height)
+        {
+            int levels = 1;
+            for (uint32_t size = std::max(width, height); size > 1; size /= 2) { levels++; }
+            return levels;
+        }
+
+        bool readMipData(std::ifstream& file, const CacheMipEntry& entry, CompressedMip& mip)
+        {
+            mip.width = static_cast<int>(entry.width);
+            mip.height = static_cast<int>(entry.height);
+            mip.data.resize(entry.size);
+            file.seekg(static_cast<std::streamoff>(entry.offset));
+            return static_cast<bool>(file.read(reinterpret_cast<char*>(mip.data.data()),
+                                               static_cast<std::streamsize>(mip.data.size())));
+        }
+    }
+
+    std::string cachePathFor(const std::string& sourcePath, const TextureCodec codec, const bool gammaCorrection)
+    {
+        std::string name = sourcePath;
+        for (char& c : name)
+        {
+            if (c == '/' || c == '\\' || c == ':') { c = '_'; }
+        }
+        name.append(".").append(TextureCompressor::codecName(codec)).append(gammaCorrection ? ".srgb.ltc" : ".ltc");
+        return (CACHE_DIRECTORY / name).string();
+    }
+
+    bool read(const std::string& cachePath, const std::string& sourcePath, const TextureCodec codec, const bool srgb,
+              CompressedTexture& texture)
+    {
+        CacheHeader header {};
+        std::vector<CacheMipEntry> entries;
+        if (!readLayout(cachePath, sourcePath, codec, srgb, header, entries)) { return false; }
+
+        texture.codec = codec;
+        texture.srgb = srgb;
+        texture.width = static_cast<int>(header.width);
+        texture.height = static_cast<int>(header.height);
+        texture.sourceChannels = static_cast<int>(header.sourceChannels);
+        texture.psnr = header.psnr;
+        texture.mips.resize(header.mipCount);
+
+        std::ifstream file(cachePath, std::ios::binary);
+        for (uint32_t i = 0; i < header.mipCount; i++)
+        {
+            if (!readMipData(file, entries[i], texture.mips[i])) { return false; }
+        }
+        return true;
+    }
+
+    bool readLayout(const std::string& cachePath, const std::string& sourcePath, const TextureCodec codec,
+                    const bool srgb, CacheHeader& header, std::vector<CacheMipEntry>& entries)
+    {
+        std::ifstream file(cachePath, std::ios::binary);
+        if (!file) { return false; }
+
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) { return false; }
+
+        uint64_t sourceSize = 0;
+        int64_t sourceWriteTime = 0;
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            header.version != VERSION ||
+            header.codec != static_cast<uint32_t>(codec) ||
+            header.srgb != static_cast<uint32_t>(srgb) ||
+            !sourceStamp(sourcePath, sourceSize, sourceWriteTime) ||
+            header.sourceSize != sourceSize ||
+            header.sourceWriteTime != sourceWriteTime)
+        {
+            return false; // Stale or foreign cache, it is rebuilt by the caller
+        }
+
+        // A damaged header must not size the reads, the mip table and every level have to fit in the file
+        std::error_code error;
+        const uint64_t fileSize = std::filesystem::file_size(cachePath, error);
+        const uint64_t tableEnd = sizeof(CacheHeader) + static_cast<uint64_t>(header.mipCount) * sizeof(CacheMipEntry);
+        if (error || header.width == 0 || header.height == 0 || header.mipCount == 0 ||
+            header.mipCount > static_cast<uint32_t>(fullMipCount(header.width, header.height)) || tableEnd > fileSize)
+        {
+            return false;
+        }
+
+        entries.resize(header.mipCount);
+        if (!file.read(reinterpret_cast<char*>(entries.data()),
+                       static_cast<std::streamsize>(entries.size() * sizeof(CacheMipEntry))))
+        {
+            return false;
+        }
+
+        for (size_t level = 0; level < entries.size(); level++)
+        {
+            const CacheMipEntry& entry = entries[level];
+            const size_t expectedSize =
+                TextureCompressor::mipByteSize(codec, static_cast<int>(entry.width), static_cast<int>(entry.height));
+            const bool expectedExtent = entry.width == std::max(1u, header.width >> level) &&
+                                        entry.height == std::max(1u, header.height >> level);
+            if (!expectedExtent || entry.size != expectedSize || entry.offset < tableEnd ||
+                entry.offset + entry.size > fileSize)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool readMip(const std::string& cachePath, const CacheMipEntry& entry, CompressedMip& mip)
+    {
+        std::ifstream file(cachePath, std::ios::binary);
+        return file && readMipData(file, entry, mip);
+    }
+
+    bool write(const std::string& cachePath, const std::string& sourcePath, const CompressedTexture& texture)
+    {
+        CacheHeader header {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.codec = static_cast<uint32_t>(texture.codec);
+        header.srgb = texture.srgb ? 1 : 0;
+        header.width = static_cast<uint32_t>(texture.width);
+        header.height = static_cast<uint32_t>(texture.height);
+        header.mipCount = static_cast<uint32_t>(texture.mips.size());
+        header.sourceChannels = static_cast<uint32_t>(texture.sourceChannels);
+        header.psnr = texture.psnr;
+        if (!sourceStamp(sourcePath, header.sourceSize, header.sourceWriteTime)) { return false; }
+
+        std::vector<CacheMipEntry> entries(texture.mips.size());
+        uint64_t offset = sizeof(CacheHeader) + entries.size() * sizeof(CacheMipEntry);
+        for (size_t i = 0; i < texture.mips.size(); i++)
+        {
+            entries[i].offset = offset;
+            entries[i].size = texture.mips[i].data.size();
+            entries[i].width = static_cast<uint32_t>(texture.mips[i].width);
+            entries[i].height = static_cast<uint32_t>(texture.mips[i].height);
+            offset += entries[i].size;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+
+        // Write to a temporary file first so an interrupted run never leaves a truncated cache behind
+        const std::string tempPath = cachePath + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file) { return false; }
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(entries.data()),
+                       static_cast<std::streamsize>(entries.size() * sizeof(CacheMipEntry)));
+            for (const CompressedMip& mip : texture.mips)
+            {
+                file.write(reinterpret_cast<const char*>(mip.data.data()), static_cast<std::streamsize>(mip.data.size()));
+            }
+            if (!file) { return false; }
+        }
+
+        std::filesystem::rename(tempPath, cachePath, error);
+        if (error)
+        {
+            std::cout << "Failed to write texture cache " << cachePath << ": " << error.message() << std::endl;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TextureCompressor.h"
+
+// On-disk container for block compressed mip chains. A file starts with a CacheHeader, followed by one
+// CacheMipEntry per mip level (largest first) and then the raw block data of every level, so any
+// level can be read on its own. Entries are invalidated when the source image size or timestamp changes.
+namespace TextureCache
+{
+    constexpr uint32_t VERSION = 1;
+
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t codec;
+        uint32_t srgb;
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipCount;
+        uint32_t sourceChannels;
+        uint64_t sourceSize;
+        int64_t sourceWriteTime;
+        float psnr;
+        uint32_t reserved;
+    };
+
+    struct CacheMipEntry
+    {
+        uint64_t offset; // From the start of the file
+        uint64_t size;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    /// <summary>
+    /// Location of the cache file for a source image. Gamma corrected sources are encoded differently and
+    /// get a file of their own. Caches live outside the Assets directory, which is recreated on every build.
+    /// </summary>
+    std::string cachePathFor(const std::string& sourcePath, TextureCodec codec, bool gammaCorrection);
+
+    bool read(const std::string& cachePath, const std::string& sourcePath, TextureCodec codec, bool srgb,
+              CompressedTexture& texture);
+
+    /// <summary>
+    /// Reads and validates only the header and the mip table, without touching any block data
+    /// </summary>
+    bool readLayout(const std::string& cachePath, const std::string& sourcePath, TextureCodec codec, bool srgb,
+                    CacheHeader& header, std::vector<CacheMipEntry>& entries);
+
+    /// <summary>
+    /// Reads the block data of a single mip level. Safe to call from any thread.
+    /// </summary>
+    bool readMip(const std::string& cachePath, const CacheMipEntry& entry, CompressedMip& mip);
+
+    bool write(const std::string& cachePath, const std::string& sourcePath, const CompressedTexture& texture);
+}
@@ -0,0 +1,668 @@
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include "Parallel.h"
+
+namespace TextureCompressor
+{
+    namespace
+    {
+        constexpr unsigned int MIN_ROWS_PER_THREAD = 8;
+
+        struct Block
+        {
+            uint8_t texels[16][4];
+        };
+
+        struct BitWriter
+        {
+            uint8_t* data;
+            int position = 0;
+
+            void write(const uint32_t value, const int bitCount)
+            {
+                for (int i = 0; i < bitCount; i++, position++)
+                {
+                    if ((value >> i) & 1) { data[position >> 3] |= static_cast<uint8_t>(1 << (position & 7)); }
+                }
+            }
+        };
+
+        const std::array<float, 256>& srgbToLinearTable()
+        {
+            static const std::array<float, 256> table = []
+            {
+                std::array<float, 256> values {};
+                for (int i = 0; i < 256; i++)
+                {
+                    const float c = static_cast<float>(i) / 255.0f;
+                    values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                }
+                return values;
+            }();
+            return table;
+        }
+
+        uint8_t linearToSrgb(const float value)
+        {
+            // 4096 entries keep the quantization error of dark values below one 8-bit step
+            static const std::array<uint8_t, 4096> table = []
+            {
+                std::array<uint8_t, 4096> values {};
+                for (int i = 0; i < 4096; i++)
+                {
+                    const float c = static_cast<float>(i) / 4095.0f;
+                    const float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+                    values[i] = static_cast<uint8_t>(std::lround(std::clamp(s, 0.0f, 1.0f) * 255.0f));
+                }
+                return values;
+            }();
+            return table[static_cast<size_t>(std::clamp(value, 0.0f, 1.0f) * 4095.0f + 0.5f)];
+        }
+
+        uint8_t toByte(const float value)
+        {
+            return static_cast<uint8_t>(std::clamp(std::lround(value), 0L, 255L));
+        }
+
+        // Halves an RGBA image with a box filter. Odd edges are clamped.
+        void downsample(const uint8_t* src, const int srcWidth, const int srcHeight, std::vector<uint8_t>& dst,
+                        const int dstWidth, const int dstHeight, const CompressionSettings& settings)
+        {
+            dst.resize(static_cast<size_t>(dstWidth) * dstHeight * 4);
+            const std::array<float, 256>& toLinear = srgbToLinearTable();
+
+            Parallel::parallelFor(dstHeight, MIN_ROWS_PER_THREAD, [&](const unsigned int first, const unsigned int last)
+            {
+                for (unsigned int y = first; y < last; y++)
+                {
+                    for (int x = 0; x < dstWidth; x++)
+                    {
+                        const int x0 = std::min(x * 2, srcWidth - 1);
+                        const int x1 = std::min(x * 2 + 1, srcWidth - 1);
+                        const int y0 = std::min(static_cast<int>(y) * 2, srcHeight - 1);
+                        const int y1 = std::min(static_cast<int>(y) * 2 + 1, srcHeight - 1);
+                        const uint8_t* taps[4] = {
+                            src + (static_cast<size_t>(y0) * srcWidth + x0) * 4,
+                            src + (static_cast<size_t>(y0) * srcWidth + x1) * 4,
+                            src + (static_cast<size_t>(y1) * srcWidth + x0) * 4,
+                            src + (static_cast<size_t>(y1) * srcWidth + x1) * 4,
+                        };
+
+                        float sum[4] = {};
+                        for (const uint8_t* tap : taps)
+                        {
+                            for (int c = 0; c < 4; c++)
+                            {
+                                const bool linearize = settings.srgb && c < 3;
+                                sum[c] += linearize ? toLinear[tap[c]] : static_cast<float>(tap[c]);
+                            }
+                        }
+
+                        uint8_t* out = dst.data() + (static_cast<size_t>(y) * dstWidth + x) * 4;
+                        if (settings.normalMap)
+                        {
+                            float n[3];
+                            for (int c = 0; c < 3; c++) { n[c] = sum[c] / (4.0f * 127.5f) - 1.0f; }
+                            const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                            if (length < 1e-6f) { n[0] = 0.0f; n[1] = 0.0f; n[2] = 1.0f; }
+                            else { for (float& v : n) { v /= length; } }
+                            for (int c = 0; c < 3; c++) { out[c] = toByte((n[c] + 1.0f) * 127.5f); }
+                        }
+                        else if (settings.srgb)
+                        {
+                            for (int c = 0; c < 3; c++) { out[c] = linearToSrgb(sum[c] * 0.25f); }
+                        }
+                        else
+                        {
+                            for (int c = 0; c < 3; c++) { out[c] = toByte(sum[c] * 0.25f); }
+                        }
+                        out[3] = toByte(sum[3] * 0.25f);
+                    }
+                }
+            });
+        }
+
+        void fetchBlock(const uint8_t* rgba, const int width, const int height, const int bx, const int by,
+                        Block& block)
+        {
+            for (int y = 0; y < 4; y++)
+            {
+                for (int x = 0; x < 4; x++)
+                {
+                    // Blocks overlapping the image edge repeat the last row/column
+                    const int sx = std::min(bx * 4 + x, width - 1);
+                    const int sy = std::min(by * 4 + y, height - 1);
+                    std::memcpy(block.texels[y * 4 + x], rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+                }
+            }
+        }
+
+        // Fits a line through the block texels (first channelCount channels) using the principal axis of
+        // their covariance, and returns the extreme points along it as endpoint candidates.
+        void fitEndpoints(const Block& block, const int channelCount, float lowEnd[4], float highEnd[4])
+        {
+            float mean[4] = {};
+            for (const auto& texel : block.texels)
+            {
+                for (int c = 0; c < channelCount; c++) { mean[c] += texel[c]; }
+            }
+            for (int c = 0; c < channelCount; c++) { mean[c] /= 16.0f; }
+
+            float covariance[4][4] = {};
+            for (const auto& texel : block.texels)
+            {
+                float d[4];
+                for (int c = 0; c < channelCount; c++) { d[c] = texel[c] - mean[c]; }
+                for (int i = 0; i < channelCount; i++)
+                {
+                    for (int j = 0; j < channelCount; j++) { covariance[i][j] += d[i] * d[j]; }
+                }
+            }
+
+            // Power iteration converges to the dominant eigenvector in a handful of steps for 3-4 dims
+            float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+            for (int iteration = 0; iteration < 8; iteration++)
+            {
+                float next[4] = {};
+                float largest = 0.0f;
+                for (int i = 0; i < channelCount; i++)
+                {
+                    for (int j = 0; j < channelCount; j++) { next[i] += covariance[i][j] * axis[j]; }
+                    largest = std::max(largest, std::abs(next[i]));
+                }
+                if (largest < 1e-8f) { break; } // All texels are identical
+                for (int i = 0; i < channelCount; i++) { axis[i] = next[i] / largest; }
+            }
+
+            float axisLength = 0.0f;
+            for (int c = 0; c < channelCount; c++) { axisLength += axis[c] * axis[c]; }
+            axisLength = std::sqrt(axisLength);
+            for (int c = 0; c < channelCount; c++) { axis[c] /= axisLength; }
+
+            float minT = 0.0f;
+            float maxT = 0.0f;
+            for (const auto& texel : block.texels)
+            {
+                float t = 0.0f;
+                for (int c = 0; c < channelCount; c++) { t += (texel[c] - mean[c]) * axis[c]; }
+                minT = std::min(minT, t);
+                maxT = std::max(maxT, t);
+            }
+
+            for (int c = 0; c < channelCount; c++)
+            {
+                lowEnd[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+                highEnd[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+            }
+        }
+
+        // Least-squares endpoints for fixed texel weights, where weights[i] is how much of endpoint 1
+        // texel i receives. Returns false when the system is degenerate.
+        bool refineEndpoints(const Block& block, const int channelCount, const float weights[16],
+                             float end0[4], float end1[4])
+        {
+            float a00 = 0.0f, a01 = 0.0f, a11 = 0.0f;
+            float b0[4] = {}, b1[4] = {};
+            for (int i = 0; i < 16; i++)
+            {
+                const float w1 = weights[i];
+                const float w0 = 1.0f - w1;
+                a00 += w0 * w0;
+                a01 += w0 * w1;
+                a11 += w1 * w1;
+                for (int c = 0; c < channelCount; c++)
+                {
+                    b0[c] += w0 * block.texels[i][c];
+                    b1[c] += w1 * block.texels[i][c];
+                }
+            }
+
+            const float determinant = a00 * a11 - a01 * a01;
+            if (std::abs(determinant) < 1e-6f) { return false; }
+
+            for (int c = 0; c < channelCount; c++)
+            {
+                end0[c] = std::clamp((a11 * b0[c] - a01 * b1[c]) / determinant, 0.0f, 255.0f);
+                end1[c] = std::clamp((a00 * b1[c] - a01 * b0[c]) / determinant, 0.0f, 255.0f);
+            }
+            return true;
+        }
+
+        // ---------------------------------------------------------------------------------------------
+        // BC1
+        // ---------------------------------------------------------------------------------------------
+
+        uint16_t packRgb565(const float color[4])
+        {
+            const auto r = static_cast<uint16_t>(std::lround(color[0] * 31.0f / 255.0f));
+            const auto g = static_cast<uint16_t>(std::lround(color[1] * 63.0f / 255.0f));
+            const auto b = static_cast<uint16_t>(std::lround(color[2] * 31.0f / 255.0f));
+            return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        void unpackRgb565(const uint16_t value, int color[3])
+        {
+            const int r = (value >> 11) & 31;
+            const int g = (value >> 5) & 63;
+            const int b = value & 31;
+            color[0] = (r << 3) | (r >> 2);
+            color[1] = (g << 2) | (g >> 4);
+            color[2] = (b << 3) | (b >> 2);
+        }
+
+        // Encodes a BC1 block for the given endpoints, picking the closest palette entry per texel.
+        // Returns the squared error.
+        int64_t encodeBc1WithEndpoints(const Block& block, uint16_t c0, uint16_t c1, uint8_t* out,
+                                       Block& decoded, float weights[16])
+        {
+            // Four color mode requires c0 > c1. Equal endpoints fall back to three color mode where
+            // index 0 still decodes to c0.
+            if (c0 < c1) { std::swap(c0, c1); }
+
+            int palette[4][3];
+            unpackRgb565(c0, palette[0]);
+            unpackRgb565(c1, palette[1]);
+            const bool fourColor = c0 > c1;
+            const int paletteSize = fourColor ? 4 : 3;
+            const float paletteWeights[4] = {0.0f, 1.0f, fourColor ? 1.0f / 3.0f : 0.5f, 2.0f / 3.0f};
+            for (int c = 0; c < 3; c++)
+            {
+                if (fourColor)
+                {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+                else
+                {
+                    palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                }
+            }
+
+            uint32_t indices = 0;
+            int64_t totalError = 0;
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0;
+                int bestError = INT32_MAX;
+                for (int p = 0; p < paletteSize; p++)
+                {
+                    int error = 0;
+                    for (int c = 0; c < 3; c++)
+                    {
+                        const int d = block.texels[i][c] - palette[p][c];
+                        error += d * d;
+                    }
+                    if (error < bestError) { bestError = error; best = p; }
+                }
+                indices |= static_cast<uint32_t>(best) << (i * 2);
+                totalError += bestError;
+                weights[i] = paletteWeights[best];
+                for (int c = 0; c < 3; c++) { decoded.texels[i][c] = static_cast<uint8_t>(palette[best][c]); }
+                decoded.texels[i][3] = 255;
+            }
+
+            out[0] = static_cast<uint8_t>(c0 & 0xFF);
+            out[1] = static_cast<uint8_t>(c0 >> 8);
+            out[2] = static_cast<uint8_t>(c1 & 0xFF);
+            out[3] = static_cast<uint8_t>(c1 >> 8);
+            std::memcpy(out + 4, &indices, sizeof(indices));
+            return totalError;
+        }
+
+        void encodeBc1(const Block& block, uint8_t* out, Block& decoded)
+        {
+            float low[4], high[4];
+            fitEndpoints(block, 3, low, high);
+
+            float weights[16];
+            int64_t error = encodeBc1WithEndpoints(block, packRgb565(high), packRgb565(low), out, decoded, weights);
+
+            // One least-squares pass on the chosen indices usually recovers the quantization loss of
+            // the bounding endpoints. Keep it only when it actually lowers the error.
+            float end0[4], end1[4];
+            if (error > 0 && refineEndpoints(block, 3, weights, end0, end1))
+            {
+                uint8_t refined[8];
+                Block refinedDecoded;
+                float refinedWeights[16];
+                const int64_t refinedError = encodeBc1WithEndpoints(block, packRgb565(end0), packRgb565(end1),
+                                                                    refined, refinedDecoded, refinedWeights);
+                if (refinedError < error)
+                {
+                    std::memcpy(out, refined, sizeof(refined));
+                    decoded = refinedDecoded;
+                }
+            }
+        }
+
+        // ---------------------------------------------------------------------------------------------
+        // BC4 / BC5
+        // ---------------------------------------------------------------------------------------------
+
+        void encodeBc4Channel(const Block& block, const int channel, uint8_t* out, Block& decoded)
+        {
+            uint8_t minValue = 255;
+            uint8_t maxValue = 0;
+            for (const auto& texel : block.texels)
+            {
+                minValue = std::min(minValue, texel[channel]);
+                maxValue = std::max(maxValue, texel[channel]);
+            }
+
+            // Eight value mode (a0 > a1) interpolates six values between the endpoints. With equal
+            // endpoints the six value mode is selected, where index 0 still decodes to a0.
+            float palette[8] = {static_cast<float>(maxValue), static_cast<float>(minValue)};
+            for (int i = 2; i < 8; i++)
+            {
+                palette[i] = (static_cast<float>(8 - i) * maxValue + static_cast<float>(i - 1) * minValue) / 7.0f;
+            }
+            const int paletteSize = maxValue > minValue ? 8 : 1;
+
+            uint64_t indices = 0;
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0;
+                float bestError = 1e30f;
+                for (int p = 0; p < paletteSize; p++)
+                {
+                    const float error = std::abs(block.texels[i][channel] - palette[p]);
+                    if (error < bestError) { bestError = error; best = p; }
+                }
+                indices |= static_cast<uint64_t>(best) << (i * 3);
+                decoded.texels[i][channel] = toByte(palette[best]);
+            }
+
+            out[0] = maxValue;
+            out[1] = minValue;
+            for (int i = 0; i < 6; i++) { out[2 + i] = static_cast<uint8_t>(indices >> (i * 8)); }
+        }
+
+        // ---------------------------------------------------------------------------------------------
+        // BC7 (mode 6 only: one subset, RGBA 7.7.7.7 endpoints with unique p-bits, 4-bit indices)
+        // ---------------------------------------------------------------------------------------------
+
+        constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        struct Bc7Endpoint
+        {
+            int quantized[4]; // 7 bits per channel
+            int pBit;
+            int value[4]; // Expanded 8-bit value: (quantized << 1) | pBit
+        };
+
+        Bc7Endpoint quantizeBc7Endpoint(const float color[4])
+        {
+            Bc7Endpoint best {};
+            float bestError = 1e30f;
+            for (int pBit = 0; pBit < 2; pBit++)
+            {
+                Bc7Endpoint candidate {};
+                candidate.pBit = pBit;
+                float error = 0.0f;
+                for (int c = 0; c < 4; c++)
+                {
+                    candidate.quantized[c] = std::clamp(static_cast<int>(std::lround((color[c] - pBit) / 2.0f)), 0, 127);
+                    candidate.value[c] = (candidate.quantized[c] << 1) | pBit;
+                    const float d = color[c] - static_cast<float>(candidate.value[c]);
+                    error += d * d;
+                }
+                if (error < bestError) { bestError = error; best = candidate; }
+            }
+            return best;
+        }
+
+        int64_t encodeBc7Mode6WithEndpoints(const Block& block, Bc7Endpoint e0, Bc7Endpoint e1, uint8_t* out,
+                                            Block& decoded, float weights[16])
+        {
+            int palette[16][4];
+            for (int i = 0; i < 16; i++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    palette[i][c] = ((64 - BC7_WEIGHTS[i]) * e0.value[c] + BC7_WEIGHTS[i] * e1.value[c] + 32) >> 6;
+                }
+            }
+
+            int indices[16];
+            int64_t totalError = 0;
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0;
+                int bestError = INT32_MAX;
+                for (int p = 0; p < 16; p++)
+                {
+                    int error = 0;
+                    for (int c = 0; c < 4; c++)
+                    {
+                        const int d = block.texels[i][c] - palette[p][c];
+                        error += d * d;
+                    }
+                    if (error < bestError) { bestError = error; best = p; }
+                }
+                indices[i] = best;
+                totalError += bestError;
+            }
+
+            // The first texel's index is stored with an implicit zero MSB, so swap the endpoints if needed
+            if (indices[0] & 8)
+            {
+                std::swap(e0, e1);
+                for (int& index : indices) { index = 15 - index; }
+                for (int i = 0; i < 16; i++)
+                {
+                    for (int c = 0; c < 4; c++)
+                    {
+                        palette[i][c] = ((64 - BC7_WEIGHTS[i]) * e0.value[c] + BC7_WEIGHTS[i] * e1.value[c] + 32) >> 6;
+                    }
+                }
+            }
+
+            for (int i = 0; i < 16; i++)
+            {
+                weights[i] = static_cast<float>(BC7_WEIGHTS[indices[i]]) / 64.0f;
+                for (int c = 0; c < 4; c++) { decoded.texels[i][c] = static_cast<uint8_t>(palette[indices[i]][c]); }
+            }
+
+            std::memset(out, 0, 16);
+            BitWriter writer {out};
+            writer.write(1 << 6, 7); // Mode 6
+            for (int c = 0; c < 4; c++)
+            {
+                writer.write(static_cast<uint32_t>(e0.quantized[c]), 7);
+                writer.write(static_cast<uint32_t>(e1.quantized[c]), 7);
+            }
+            writer.write(static_cast<uint32_t>(e0.pBit), 1);
+            writer.write(static_cast<uint32_t>(e1.pBit), 1);
+            writer.write(static_cast<uint32_t>(indices[0]), 3);
+            for (int i = 1; i < 16; i++) { writer.write(static_cast<uint32_t>(indices[i]), 4); }
+
+            return totalError;
+        }
+
+        void encodeBc7(const Block& block, uint8_t* out, Block& decoded)
+        {
+            float low[4], high[4];
+            fitEndpoints(block, 4, low, high);
+
+            float weights[16];
+            const int64_t error = encodeBc7Mode6WithEndpoints(block, quantizeBc7Endpoint(low),
+                                                              quantizeBc7Endpoint(high), out, decoded, weights);
+
+            float end0[4], end1[4];
+            if (error > 0 && refineEndpoints(block, 4, weights, end0, end1))
+            {
+                uint8_t refined[16];
+                Block refinedDecoded;
+                float refinedWeights[16];
+                const int64_t refinedError = encodeBc7Mode6WithEndpoints(
+                    block, quantizeBc7Endpoint(end0), quantizeBc7Endpoint(end1), refined, refinedDecoded, refinedWeights);
+                if (refinedError < error)
+                {
+                    std::memcpy(out, refined, sizeof(refined));
+                    decoded = refinedDecoded;
+                }
+            }
+        }
+
+        // ---------------------------------------------------------------------------------------------
+
+        int psnrChannelCount(const TextureCodec codec)
+        {
+            switch (codec)
+            {
+                case TextureCodec::BC4: return 1;
+                case TextureCodec::BC5: return 2;
+                default: return 3;
+            }
+        }
+
+        // Encodes one mip level. When squaredError is set, the error of every texel inside the image
+        // (over the channels the codec keeps) is accumulated into it.
+        void encodeLevel(const uint8_t* rgba, const int width, const int height, const TextureCodec codec,
+                         CompressedMip& mip, std::atomic<uint64_t>* squaredError)
+        {
+            const int blocksX = (width + 3) / 4;
+            const int blocksY = (height + 3) / 4;
+            const size_t bytesPerBlock = blockBytes(codec);
+            const int errorChannels = psnrChannelCount(codec);
+
+            mip.width = width;
+            mip.height = height;
+            mip.data.assign(static_cast<size_t>(blocksX) * blocksY * bytesPerBlock, 0);
+
+            Parallel::parallelFor(blocksY, 4, [&](const unsigned int first, const unsigned int last)
+            {
+                uint64_t rangeError = 0;
+                for (unsigned int by = first; by < last; by++)
+                {
+                    for (int bx = 0; bx < blocksX; bx++)
+                    {
+                        Block block;
+                        Block decoded = {};
+                        fetchBlock(rgba, width, height, bx, static_cast<int>(by), block);
+                        uint8_t* out = mip.data.data() + (static_cast<size_t>(by) * blocksX + bx) * bytesPerBlock;
+
+                        switch (codec)
+                        {
+                            case TextureCodec::BC1:
+                                encodeBc1(block, out, decoded);
+                                break;
+                            case TextureCodec::BC4:
+                                encodeBc4Channel(block, 0, out, decoded);
+                                break;
+                            case TextureCodec::BC5:
+                                encodeBc4Channel(block, 0, out, decoded);
+                                encodeBc4Channel(block, 1, out + 8, decoded);
+                                break;
+                            case TextureCodec::BC7:
+                                encodeBc7(block, out, decoded);
+                                break;
+                            default:
+                                break;
+                        }
+
+                        if (!squaredError) { continue; }
+                        for (int i = 0; i < 16; i++)
+                        {
+                            if (bx * 4 + i % 4 >= width || static_cast<int>(by) * 4 + i / 4 >= height) { continue; }
+                            for (int c = 0; c < errorChannels; c++)
+                            {
+                                const int d = block.texels[i][c] - decoded.texels[i][c];
+                                rangeError += static_cast<uint64_t>(d * d);
+                            }
+                        }
+                    }
+                }
+                if (squaredError) { squaredError->fetch_add(rangeError); }
+            });
+        }
+    }
+
+    bool compress(const uint8_t* rgba, int width, int height, const CompressionSettings& settings,
+                  CompressedTexture& texture)
+    {
+        if (!rgba || width <= 0 || height <= 0 || settings.codec == TextureCodec::None) { return false; }
+
+        texture.codec = settings.codec;
+        texture.srgb = settings.srgb;
+        texture.width = width;
+        texture.height = height;
+        texture.mips.clear();
+
+        std::atomic<uint64_t> squaredError = 0;
+        const uint8_t* level = rgba;
+        std::vector<uint8_t> current;
+        std::vector<uint8_t> next;
+
+        while (true)
+        {
+            CompressedMip& mip = texture.mips.emplace_back();
+            encodeLevel(level, width, height, settings.codec, mip, texture.mips.size() == 1 ? &squaredError : nullptr);
+            if (width == 1 && height == 1) { break; }
+
+            const int nextWidth = std::max(1, width / 2);
+            const int nextHeight = std::max(1, height / 2);
+            downsample(level, width, height, next, nextWidth, nextHeight, settings);
+            current.swap(next);
+            level = current.data();
+            width = nextWidth;
+            height = nextHeight;
+        }
+
+        const double samples = static_cast<double>(texture.width) * texture.height * psnrChannelCount(settings.codec);
+        const double meanSquaredError = static_cast<double>(squaredError.load()) / samples;
+        texture.psnr = meanSquaredError > 0.0
+            ? static_cast<float>(10.0 * std::log10(255.0 * 255.0 / meanSquaredError))
+            : 99.0f; // Lossless, report a capped value instead of infinity
+        return true;
+    }
+
+    void linearizeSrgb(uint8_t* rgba, const size_t pixelCount)
+    {
+        const std::array<float, 256>& toLinear = srgbToLinearTable();
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                rgba[i * 4 + c] = toByte(toLinear[rgba[i * 4 + c]] * 255.0f);
+            }
+        }
+    }
+
+    size_t blockBytes(const TextureCodec codec)
+    {
+        switch (codec)
+        {
+            case TextureCodec::BC1:
+            case TextureCodec::BC4:
+                return 8;
+            case TextureCodec::BC5:
+            case TextureCodec::BC7:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    size_t mipByteSize(const TextureCodec codec, const int width, const int height)
+    {
+        return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockBytes(codec);
+    }
+
+    const char* codecName(const TextureCodec codec)
+    {
+        switch (codec)
+        {
+            case TextureCodec::BC1: return "BC1";
+            case TextureCodec::BC4: return "BC4";
+            case TextureCodec::BC5: return "BC5";
+            case TextureCodec::BC7: return "BC7";
+            default: return "Uncompressed";
+        }
+    }
+}
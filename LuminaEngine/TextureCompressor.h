@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Values are stored in texture cache files, do not reorder
+enum class TextureCodec : uint32_t
+{
+    None = 0,
+    BC1 = 1, // RGB, 4 bpp
+    BC4 = 2, // Single channel, 4 bpp
+    BC5 = 3, // Two channels, 8 bpp. Only used for tangent-space normal maps.
+    BC7 = 4, // RGB(A), 8 bpp
+};
+
+struct CompressedMip
+{
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> data;
+};
+
+struct CompressedTexture
+{
+    TextureCodec codec = TextureCodec::None;
+    bool srgb = false;
+    int width = 0;
+    int height = 0;
+    int sourceChannels = 0;
+    float psnr = 0.0f; // Of the top mip, over the channels the codec keeps
+    std::vector<CompressedMip> mips;
+};
+
+struct CompressionSettings
+{
+    TextureCodec codec = TextureCodec::None;
+    // Source texels are sRGB encoded. Mips are filtered in linear space and the result is meant to be
+    // sampled through an sRGB format.
+    bool srgb = false;
+    // Source is a tangent-space normal map. Mips are renormalized after filtering.
+    bool normalMap = false;
+};
+
+// CPU block compression encoders. The full mip chain is generated on the CPU and every level is
+// encoded in parallel, so no glGenerateMipmap call is needed at upload time.
+namespace TextureCompressor
+{
+    /// <summary>
+    /// Builds and encodes the full mip chain of an 8-bit RGBA image
+    /// </summary>
+    bool compress(const uint8_t* rgba, int width, int height, const CompressionSettings& settings,
+                  CompressedTexture& texture);
+
+    /// <summary>
+    /// Converts the RGB channels of 8-bit RGBA pixels from sRGB to linear in place
+    /// </summary>
+    void linearizeSrgb(uint8_t* rgba, size_t pixelCount);
+
+    size_t blockBytes(TextureCodec codec);
+    size_t mipByteSize(TextureCodec codec, int width, int height);
+    const char* codecName(TextureCodec codec);
+}
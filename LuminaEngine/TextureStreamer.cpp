@@ -0,0 +1,372 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <glad/glad.h>
+#include "FrameArena.h"
+#include "GpuMemory.h"
+#include "TextureUtils.h"
+
+namespace
+{
+    // Levels at or below this size are loaded up front and never evicted
+    constexpr uint32_t TAIL_MAX_SIZE = 128;
+    // Caps the time spent in glCompressedTexImage2D per frame
+    constexpr size_t MAX_UPLOAD_BYTES_PER_FRAME = 8 * 1024 * 1024;
+    constexpr size_t MAX_REQUESTS_IN_FLIGHT = 8;
+    // How fast a freshly uploaded level is blended in through GL_TEXTURE_MIN_LOD, in levels per second
+    constexpr float FADE_SPEED = 4.0f;
+}
+
+TextureStreamer::TextureStreamer(const size_t budgetBytes)
+    : mBudgetBytes(budgetBytes), mResidentBytes(0), mPendingBytes(0), mFullResolutionBytes(0), mFrame(0),
+      mNextSerial(0), mStop(false)
+{
+    mThread = std::thread(&TextureStreamer::streamingThread, this);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    {
+        std::lock_guard lock(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_all();
+    mThread.join();
+}
+
+unsigned int TextureStreamer::loadTexture(const std::string& filePath, const TextureCodec codec,
+                                          const bool gammaCorrection)
+{
+    const bool srgb = TextureUtils::isSrgbCompressed(codec, gammaCorrection);
+    if (codec == TextureCodec::None || !TextureUtils::isCodecSupported(codec, srgb))
+    {
+        return TextureUtils::loadTexture(filePath, gammaCorrection);
+    }
+
+    // Only the mip table is read here, block data is pulled from the cache level by level
+    const std::string cachePath = TextureCache::cachePathFor(filePath, codec, gammaCorrection);
+    TextureCache::CacheHeader header {};
+    std::vector<TextureCache::CacheMipEntry> entries;
+    if (!TextureCache::readLayout(cachePath, filePath, codec, srgb, header, entries))
+    {
+        CompressedTexture texture;
+        bool fromCache = false;
+        if (!TextureUtils::loadCompressedMips(filePath, codec, gammaCorrection, texture, fromCache) ||
+            !TextureCache::readLayout(cachePath, filePath, codec, srgb, header, entries))
+        {
+            std::cout << "Texture cache unavailable, streaming disabled for " << filePath << std::endl;
+            return TextureUtils::loadCompressedTexture(filePath, codec, gammaCorrection);
+        }
+    }
+
+    StreamedTexture texture;
+    texture.serial = mNextSerial++;
+    texture.filePath = filePath;
+    texture.cachePath = cachePath;
+    texture.mips = entries;
+    texture.internalFormat = TextureUtils::compressedFormat(codec, srgb);
+    texture.finestLevel = 0;
+    texture.tailLevel = static_cast<int>(entries.size()) - 1;
+    while (texture.tailLevel > 0 &&
+           std::max(entries[texture.tailLevel - 1].width, entries[texture.tailLevel - 1].height) <= TAIL_MAX_SIZE)
+    {
+        texture.tailLevel--;
+    }
+    texture.residentLevel = texture.tailLevel;
+    texture.desiredLevel = texture.tailLevel;
+    texture.pendingLevel = -1;
+    texture.lastDemandFrame = mFrame;
+    texture.fadeLod = 0.0f;
+
+    unsigned int textureID = 0;
+    glGenTextures(1, &textureID);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+
+    for (int level = texture.tailLevel; level < static_cast<int>(entries.size()); level++)
+    {
+        CompressedMip mip;
+        if (!TextureCache::readMip(cachePath, entries[level], mip))
+        {
+            std::cout << "Failed to read texture cache " << cachePath << std::endl;
+            glDeleteTextures(1, &textureID);
+            return TextureUtils::loadCompressedTexture(filePath, codec, gammaCorrection);
+        }
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.internalFormat, mip.width, mip.height, 0,
+                               static_cast<int>(mip.data.size()), mip.data.data());
+        mResidentBytes += mip.data.size();
+    }
+    for (const TextureCache::CacheMipEntry& entry : entries)
+    {
+        mFullResolutionBytes += entry.size;
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<int>(entries.size()) - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    applyLevelParameters(textureID, texture);
+
+    std::cout << "Streaming texture " << filePath << ": " << TextureCompressor::codecName(codec) << " "
+              << header.width << "x" << header.height << ", " << entries.size() - texture.tailLevel << " of "
+              << entries.size() << " mips resident" << std::endl;
+
+    trackResidency(textureID, texture);
+    mTextures.emplace(textureID, std::move(texture));
+    return textureID;
+}
+
+void TextureStreamer::removeTexture(const unsigned int textureId)
+{
+    const auto it = mTextures.find(textureId);
+    if (it == mTextures.end()) { return; }
+
+    const StreamedTexture& texture = it->second;
+    if (texture.pendingLevel >= 0)
+    {
+        mPendingBytes -= texture.mips[texture.pendingLevel].size;
+    }
+    for (size_t level = 0; level < texture.mips.size(); level++)
+    {
+        if (static_cast<int>(level) >= texture.residentLevel) { mResidentBytes -= texture.mips[level].size; }
+        mFullResolutionBytes -= texture.mips[level].size;
+    }
+    // Reads still in flight are dropped when they finish, the serial no longer matches anything
+    mTextures.erase(it);
+    GpuMemory::release(GpuResourceType::Texture, textureId);
+}
+
+void TextureStreamer::requestDetail(const unsigned int textureId, const float uvPerPixel)
+{
+    const auto it = mTextures.find(textureId);
+    if (it == mTextures.end()) { return; }
+
+    StreamedTexture& texture = it->second;
+    texture.desiredLevel = std::min(texture.desiredLevel, levelForDensity(texture, uvPerPixel));
+}
+
+void TextureStreamer::update(const float deltaTime)
+{
+    mFrame++;
+
+    for (auto& [id, texture] : mTextures)
+    {
+        if (texture.desiredLevel <= texture.residentLevel) { texture.lastDemandFrame = mFrame; }
+    }
+
+    uploadFinishedMips();
+
+    // The budget may have been lowered since the last frame
+    while (mResidentBytes > mBudgetBytes && evictOneLevel(0, true)) {}
+
+    scheduleRequests();
+
+    for (auto& [id, texture] : mTextures)
+    {
+        if (texture.fadeLod > 0.0f)
+        {
+            texture.fadeLod = std::max(0.0f, texture.fadeLod - deltaTime * FADE_SPEED);
+            applyLevelParameters(id, texture);
+        }
+        texture.desiredLevel = texture.tailLevel; // Rebuilt from next frame's requests
+    }
+}
+
+void TextureStreamer::uploadFinishedMips()
+{
+    size_t uploadedBytes = 0;
+    while (uploadedBytes < MAX_UPLOAD_BYTES_PER_FRAME)
+    {
+        MipResult result;
+        {
+            std::lock_guard lock(mMutex);
+            if (mResults.empty()) { break; }
+            result = std::move(mResults.front());
+            mResults.pop_front();
+        }
+
+        const auto it = mTextures.find(result.textureId);
+        if (it == mTextures.end() || it->second.serial != result.serial) { continue; }
+
+        StreamedTexture& texture = it->second;
+        mPendingBytes -= texture.mips[result.level].size;
+        texture.pendingLevel = -1;
+
+        if (!result.success)
+        {
+            std::cout << "Failed to stream mip " << result.level << " from " << texture.cachePath << std::endl;
+            texture.finestLevel = texture.residentLevel;
+            continue;
+        }
+        // The next coarser level was evicted while this one was being read
+        if (result.level != texture.residentLevel - 1) { continue; }
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, result.textureId);
+        glCompressedTexImage2D(GL_TEXTURE_2D, result.level, texture.internalFormat, result.mip.width,
+                               result.mip.height, 0, static_cast<int>(result.mip.data.size()), result.mip.data.data());
+        texture.residentLevel = result.level;
+        // LOD is relative to the base level, so start one level coarser to keep the same image on screen
+        texture.fadeLod += 1.0f;
+        applyLevelParameters(result.textureId, texture);
+
+        mResidentBytes += result.mip.data.size();
+        uploadedBytes += result.mip.data.size();
+        trackResidency(result.textureId, texture);
+    }
+}
+
+void TextureStreamer::scheduleRequests()
+{
+    FrameVector<std::pair<unsigned int, StreamedTexture*>> candidates;
+    size_t inFlight = 0;
+    for (auto& [id, texture] : mTextures)
+    {
+        if (texture.pendingLevel >= 0) { inFlight++; }
+        else if (texture.desiredLevel < texture.residentLevel) { candidates.emplace_back(id, &texture); }
+    }
+
+    // Textures missing the most detail go first
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b)
+    {
+        return a.second->residentLevel - a.second->desiredLevel > b.second->residentLevel - b.second->desiredLevel;
+    });
+
+    bool queued = false;
+    for (auto& [id, texture] : candidates)
+    {
+        if (inFlight >= MAX_REQUESTS_IN_FLIGHT) { break; }
+
+        const int level = texture->residentLevel - 1;
+        const size_t size = texture->mips[level].size;
+        while (mResidentBytes + mPendingBytes + size > mBudgetBytes && evictOneLevel(id, false)) {}
+        if (mResidentBytes + mPendingBytes + size > mBudgetBytes) { continue; }
+        // The engine wide budget may refuse detail the streaming budget still has room for
+        if (!GpuMemory::canAllocate(size, texture->filePath)) { continue; }
+
+        texture->pendingLevel = level;
+        mPendingBytes += size;
+        inFlight++;
+        {
+            std::lock_guard lock(mMutex);
+            mRequests.push_back({id, texture->serial, level, texture->cachePath, texture->mips[level]});
+        }
+        queued = true;
+    }
+
+    if (queued) { mCondition.notify_one(); }
+}
+
+bool TextureStreamer::evictOneLevel(const unsigned int exceptTextureId, const bool allowDemanded)
+{
+    // Least recently needed detail goes first
+    unsigned int victimId = 0;
+    StreamedTexture* victim = nullptr;
+    for (auto& [id, texture] : mTextures)
+    {
+        if (id == exceptTextureId || texture.residentLevel >= texture.tailLevel) { continue; }
+        if (!allowDemanded && texture.desiredLevel <= texture.residentLevel) { continue; }
+        if (!victim || texture.lastDemandFrame < victim->lastDemandFrame)
+        {
+            victimId = id;
+            victim = &texture;
+        }
+    }
+    if (!victim) { return false; }
+
+    const int level = victim->residentLevel;
+    victim->residentLevel++;
+    victim->fadeLod = std::max(0.0f, victim->fadeLod - 1.0f);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, victimId);
+    applyLevelParameters(victimId, *victim);
+    // Respecifying the level as a zero sized image releases its storage. Levels below the base level
+    // are not considered for completeness, so the texture stays usable.
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, victim->internalFormat, 0, 0, 0, 0, nullptr);
+
+    mResidentBytes -= victim->mips[level].size;
+    trackResidency(victimId, *victim);
+    return true;
+}
+
+void TextureStreamer::applyLevelParameters(const unsigned int textureId, const StreamedTexture& texture) const
+{
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture.residentLevel);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, texture.fadeLod);
+}
+
+void TextureStreamer::trackResidency(const unsigned int textureId, const StreamedTexture& texture) const
+{
+    size_t bytes = 0;
+    for (size_t level = texture.residentLevel; level < texture.mips.size(); level++)
+    {
+        bytes += texture.mips[level].size;
+    }
+    GpuMemory::track(GpuResourceType::Texture, textureId, bytes, "Streamed Textures", texture.filePath);
+}
+
+int TextureStreamer::levelForDensity(const StreamedTexture& texture, const float uvPerPixel) const
+{
+    if (uvPerPixel <= 0.0f) { return texture.tailLevel; }
+
+    // One texel per pixel is the level where texels per pixel drops to 1 or below
+    const float size = static_cast<float>(std::max(texture.mips[0].width, texture.mips[0].height));
+    const float texelsPerPixel = uvPerPixel * size;
+    const int level = texelsPerPixel > 1.0f ? static_cast<int>(std::floor(std::log2(texelsPerPixel))) : 0;
+    return std::clamp(level, texture.finestLevel, texture.tailLevel);
+}
+
+void TextureStreamer::setBudget(const size_t budgetBytes)
+{
+    mBudgetBytes = budgetBytes;
+}
+
+size_t TextureStreamer::budget() const
+{
+    return mBudgetBytes;
+}
+
+size_t TextureStreamer::residentBytes() const
+{
+    return mResidentBytes;
+}
+
+size_t TextureStreamer::fullResolutionBytes() const
+{
+    return mFullResolutionBytes;
+}
+
+unsigned int TextureStreamer::streamingCount() const
+{
+    return static_cast<unsigned int>(mTextures.size());
+}
+
+void TextureStreamer::streamingThread()
+{
+    while (true)
+    {
+        MipRequest request;
+        {
+            std::unique_lock lock(mMutex);
+            mCondition.wait(lock, [this] { return mStop || !mRequests.empty(); });
+            if (mStop) { return; }
+            request = std::move(mRequests.front());
+            mRequests.pop_front();
+        }
+
+        MipResult result;
+        result.textureId = request.textureId;
+        result.serial = request.serial;
+        result.level = request.level;
+        result.success = TextureCache::readMip(request.cachePath, request.entry, result.mip);
+
+        std::lock_guard lock(mMutex);
+        mResults.push_back(std::move(result));
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "TextureCache.h"
+
+// Streams the mip levels of block compressed material textures from the texture cache. Textures start
+// with only their coarse mip tail resident, finer levels are read on a background thread as meshes ask
+// for more detail and uploaded on the render thread. Detail no mesh asked for recently is evicted when
+// the resident set would exceed the memory budget.
+class TextureStreamer
+{
+public:
+    explicit TextureStreamer(size_t budgetBytes);
+    ~TextureStreamer();
+
+    /// <summary>
+    /// Creates a texture with only its mip tail resident. Falls back to a fully resident texture when
+    /// the codec is not supported or the texture cache cannot be used.
+    /// </summary>
+    unsigned int loadTexture(const std::string& filePath, TextureCodec codec, bool gammaCorrection);
+    void removeTexture(unsigned int textureId);
+
+    /// <summary>
+    /// Reports how many texture coordinate units a screen pixel covers on a mesh sampling this texture.
+    /// The finest level requested during a frame is the one streamed in.
+    /// </summary>
+    void requestDetail(unsigned int textureId, float uvPerPixel);
+
+    /// <summary>
+    /// Uploads finished reads, schedules new ones and enforces the budget. Call once per frame on the
+    /// thread owning the OpenGL context, after all requestDetail calls for the frame.
+    /// </summary>
+    void update(float deltaTime);
+
+    void setBudget(size_t budgetBytes);
+    size_t budget() const;
+    size_t residentBytes() const;
+    size_t fullResolutionBytes() const;
+    unsigned int streamingCount() const;
+
+private:
+    struct StreamedTexture
+    {
+        uint64_t serial;
+        std::string filePath;
+        std::string cachePath;
+        std::vector<TextureCache::CacheMipEntry> mips;
+        unsigned int internalFormat;
+        int finestLevel;        // Finest level that can be streamed in, raised when a read fails
+        int tailLevel;          // Levels from here on are always resident
+        int residentLevel;      // Finest resident level, also the GL_TEXTURE_BASE_LEVEL
+        int desiredLevel;       // Finest level asked for during the current frame
+        int pendingLevel;       // Level being read on the streaming thread, -1 when idle
+        uint64_t lastDemandFrame; // Last frame a mesh needed the finest resident level
+        float fadeLod;          // GL_TEXTURE_MIN_LOD used to blend in a freshly uploaded level
+    };
+
+    struct MipRequest
+    {
+        unsigned int textureId;
+        uint64_t serial;
+        int level;
+        std::string cachePath;
+        TextureCache::CacheMipEntry entry;
+    };
+
+    struct MipResult
+    {
+        unsigned int textureId;
+        uint64_t serial;
+        int level;
+        bool success;
+        CompressedMip mip;
+    };
+
+    void streamingThread();
+    void uploadFinishedMips();
+    void scheduleRequests();
+    bool evictOneLevel(unsigned int exceptTextureId, bool allowDemanded);
+    void applyLevelParameters(unsigned int textureId, const StreamedTexture& texture) const;
+    // Reports the resident levels of the texture to the GPU memory registry
+    void trackResidency(unsigned int textureId, const StreamedTexture& texture) const;
+    int levelForDensity(const StreamedTexture& texture, float uvPerPixel) const;
+
+    std::unordered_map<unsigned int, StreamedTexture> mTextures;
+    size_t mBudgetBytes;
+    size_t mResidentBytes;
+    size_t mPendingBytes;
+    size_t mFullResolutionBytes;
+    uint64_t mFrame;
+    uint64_t mNextSerial;
+
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<MipRequest> mRequests;
+    std::deque<MipResult> mResults;
+    bool mStop;
+};
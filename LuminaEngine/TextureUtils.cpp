@@ -1,10 +1,103 @@
 #include "TextureUtils.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <unordered_set>
+#include "GpuMemory.h"
+#include "HdrDecoder.h"
+#include "TextureCache.h"
+
+// Compressed formats that are not part of the core 3.3 profile
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
 
 namespace TextureUtils
 {
+    namespace
+    {
+        TextureMemoryStats memoryStats;
+
+        // Size of a texture with a full mip chain, as allocated by glGenerateMipmap
+        size_t uncompressedSize(const int width, const int height, const int nrChannels)
+        {
+            size_t bytes = 0;
+            int w = width;
+            int h = height;
+            while (true)
+            {
+                bytes += static_cast<size_t>(w) * h * nrChannels;
+                if (w == 1 && h == 1) { break; }
+                w = std::max(1, w / 2);
+                h = std::max(1, h / 2);
+            }
+            return bytes;
+        }
+
+        double toMegabytes(const size_t bytes)
+        {
+            return static_cast<double>(bytes) / (1024.0 * 1024.0);
+        }
+
+        // First level of the longest mip tail left in the GPU memory budget. The last level is taken even
+        // when nothing is left, it is a few bytes and keeps the material from rendering black.
+        size_t firstFittingLevel(const std::vector<CompressedMip>& mips, const size_t layers)
+        {
+            const size_t available = GpuMemory::budget() > GpuMemory::totalBytes()
+                                         ? GpuMemory::budget() - GpuMemory::totalBytes() : 0;
+            size_t tailBytes = 0;
+            size_t level = mips.size();
+            while (level > 0 && tailBytes + mips[level - 1].data.size() * layers <= available)
+            {
+                tailBytes += mips[level - 1].data.size() * layers;
+                level--;
+            }
+            return std::min(level, mips.size() - 1);
+        }
+
+        // Last level of a full mip chain
+        std::vector<unsigned char> averageColor(const unsigned char* data, const int width, const int height,
+                                                const int nrChannels)
+        {
+            std::vector<size_t> sums(nrChannels, 0);
+            const size_t pixelCount = static_cast<size_t>(width) * height;
+            for (size_t pixel = 0; pixel < pixelCount; pixel++)
+            {
+                for (int channel = 0; channel < nrChannels; channel++)
+                {
+                    sums[channel] += data[pixel * nrChannels + channel];
+                }
+            }
+
+            std::vector<unsigned char> color(nrChannels);
+            for (int channel = 0; channel < nrChannels; channel++)
+            {
+                color[channel] = static_cast<unsigned char>(sums[channel] / pixelCount);
+            }
+            return color;
+        }
+
+        void reportMipTail(const std::string& owner, const int width, const int height)
+        {
+            std::cout << "WARNING::TEXTURE::" << owner << " is over the GPU memory budget, uploaded at " << width
+                      << "x" << height << std::endl;
+            memoryStats.reducedTextures++;
+        }
+    }
+
     unsigned int loadTexture(const std::string& filePath, const bool& gammaCorrection)
     {
         unsigned int textureID = 0;
@@ -15,11 +108,24 @@ namespace TextureUtils
         unsigned char* data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
         if (data)
         {
+            const size_t fullBytes = uncompressedSize(width, height, nrChannels);
+            size_t bytes = fullBytes;
+            std::vector<unsigned char> tail;
+            if (!GpuMemory::canAllocate(bytes, filePath))
+            {
+                tail = averageColor(data, width, height, nrChannels);
+                reportMipTail(filePath, 1, 1);
+                width = 1;
+                height = 1;
+                bytes = tail.size();
+            }
+
             GLenum internalFormat;
             GLenum dataFormat;
             if (!evaluateFormats(nrChannels, internalFormat, dataFormat, gammaCorrection))
             {
-                glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, GL_UNSIGNED_BYTE, data);
+                glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, GL_UNSIGNED_BYTE,
+                             tail.empty() ? data : tail.data());
             }
             else
             {
@@ -28,6 +134,13 @@ namespace TextureUtils
                 return 0;
             }
             glGenerateMipmap(GL_TEXTURE_2D);
+            stbi_image_free(data);
+
+            GpuMemory::track(GpuResourceType::Texture, textureID, bytes, "Materials", filePath);
+            memoryStats.textureCount++;
+            memoryStats.uploadedBytes += bytes;
+            memoryStats.uncompressedBytes += fullBytes;
+
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -42,6 +155,188 @@ namespace TextureUtils
         return textureID;
     }
 
+    unsigned int loadCompressedTexture(const std::string& filePath, const TextureCodec& codec, const bool& gammaCorrection)
+    {
+        const bool srgb = isSrgbCompressed(codec, gammaCorrection);
+        if (codec == TextureCodec::None || !isCodecSupported(codec, srgb))
+        {
+            return loadTexture(filePath, gammaCorrection);
+        }
+
+        CompressedTexture texture;
+        bool fromCache = false;
+        if (!loadCompressedMips(filePath, codec, gammaCorrection, texture, fromCache))
+        {
+            std::cout << "Texture compression failed, loading uncompressed: " << filePath << std::endl;
+            return loadTexture(filePath, gammaCorrection);
+        }
+
+        size_t compressedBytes = 0;
+        for (const CompressedMip& mip : texture.mips) { compressedBytes += mip.data.size(); }
+        size_t firstLevel = 0;
+        if (!GpuMemory::canAllocate(compressedBytes, filePath))
+        {
+            firstLevel = firstFittingLevel(texture.mips, 1);
+            reportMipTail(filePath, texture.mips[firstLevel].width, texture.mips[firstLevel].height);
+            compressedBytes = 0;
+            for (size_t level = firstLevel; level < texture.mips.size(); level++)
+            {
+                compressedBytes += texture.mips[level].data.size();
+            }
+        }
+
+        unsigned int textureID = 0;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+
+        const GLenum internalFormat = compressedFormat(codec, srgb);
+        for (size_t level = firstLevel; level < texture.mips.size(); level++)
+        {
+            const CompressedMip& mip = texture.mips[level];
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<int>(level - firstLevel), internalFormat, mip.width,
+                                   mip.height, 0, static_cast<int>(mip.data.size()), mip.data.data());
+        }
+        GpuMemory::track(GpuResourceType::Texture, textureID, compressedBytes, "Materials", filePath);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<int>(texture.mips.size() - firstLevel) - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        const size_t uncompressedBytes = uncompressedSize(texture.width, texture.height, texture.sourceChannels);
+        memoryStats.textureCount++;
+        memoryStats.uploadedBytes += compressedBytes;
+        memoryStats.uncompressedBytes += uncompressedBytes;
+
+        std::ostringstream report;
+        report << std::fixed << std::setprecision(2)
+               << "Texture " << filePath << ": " << TextureCompressor::codecName(codec) << (srgb ? " sRGB " : " ")
+               << texture.width << "x" << texture.height << ", " << toMegabytes(uncompressedBytes) << " MB -> "
+               << toMegabytes(compressedBytes) << " MB, PSNR " << texture.psnr << " dB"
+               << (fromCache ? " (cached)" : "");
+        std::cout << report.str() << std::endl;
+
+        return textureID;
+    }
+
+    bool loadCompressedMips(const std::string& filePath, const TextureCodec& codec, const bool& gammaCorrection,
+                            CompressedTexture& texture, bool& fromCache)
+    {
+        const bool srgb = isSrgbCompressed(codec, gammaCorrection);
+        const std::string cachePath = TextureCache::cachePathFor(filePath, codec, gammaCorrection);
+        fromCache = TextureCache::read(cachePath, filePath, codec, srgb, texture);
+        if (fromCache) { return true; }
+
+        int width, height, nrChannels;
+        unsigned char* data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 4);
+        if (!data)
+        {
+            std::cout << "Texture failed to load at path: " << filePath << std::endl;
+            return false;
+        }
+
+        if (gammaCorrection && !srgb)
+        {
+            TextureCompressor::linearizeSrgb(data, static_cast<size_t>(width) * height);
+        }
+
+        CompressionSettings settings;
+        settings.codec = codec;
+        settings.srgb = srgb;
+        settings.normalMap = codec == TextureCodec::BC5;
+        const bool compressed = TextureCompressor::compress(data, width, height, settings, texture);
+        stbi_image_free(data);
+        if (!compressed) { return false; }
+
+        texture.sourceChannels = nrChannels;
+        TextureCache::write(cachePath, filePath, texture);
+        return true;
+    }
+
+    unsigned int loadCompressedTextureArray(const std::vector<const CompressedTexture*>& layers)
+    {
+        if (layers.empty()) { return 0; }
+
+        const CompressedTexture& first = *layers.front();
+        const std::string owner = "Texture array, " + std::to_string(layers.size()) + " layers of " +
+                                  std::to_string(first.width) + "x" + std::to_string(first.height);
+        size_t arrayBytes = 0;
+        for (const CompressedMip& mip : first.mips) { arrayBytes += mip.data.size() * layers.size(); }
+        size_t firstLevel = 0;
+        if (!GpuMemory::canAllocate(arrayBytes, owner))
+        {
+            firstLevel = firstFittingLevel(first.mips, layers.size());
+            reportMipTail(owner, first.mips[firstLevel].width, first.mips[firstLevel].height);
+        }
+
+        unsigned int textureID = 0;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+
+        const GLenum internalFormat = compressedFormat(first.codec, first.srgb);
+        const auto layerCount = static_cast<int>(layers.size());
+        size_t compressedBytes = 0;
+        std::vector<uint8_t> levelData;
+        for (size_t level = firstLevel; level < first.mips.size(); level++)
+        {
+            // Layers of a level are stored back to back
+            levelData.clear();
+            for (const CompressedTexture* layer : layers)
+            {
+                const std::vector<uint8_t>& data = layer->mips[level].data;
+                levelData.insert(levelData.end(), data.begin(), data.end());
+            }
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, static_cast<int>(level - firstLevel), internalFormat,
+                                   first.mips[level].width, first.mips[level].height, layerCount, 0,
+                                   static_cast<int>(levelData.size()), levelData.data());
+            compressedBytes += levelData.size();
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL,
+                        static_cast<int>(first.mips.size() - firstLevel) - 1);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        GpuMemory::track(GpuResourceType::Texture, textureID, compressedBytes, "Materials", owner);
+
+        size_t uncompressedBytes = 0;
+        for (const CompressedTexture* layer : layers)
+        {
+            uncompressedBytes += uncompressedSize(layer->width, layer->height, layer->sourceChannels);
+        }
+        memoryStats.textureCount++;
+        memoryStats.uploadedBytes += compressedBytes;
+        memoryStats.uncompressedBytes += uncompressedBytes;
+
+        std::ostringstream report;
+        report << std::fixed << std::setprecision(2) << "Texture array: " << layerCount << " layers of "
+               << TextureCompressor::codecName(first.codec) << (first.srgb ? " sRGB " : " ") << first.width << "x"
+               << first.height << ", " << toMegabytes(compressedBytes) << " MB";
+        std::cout << report.str() << std::endl;
+
+        return textureID;
+    }
+
+    GLenum compressedFormat(const TextureCodec& codec, const bool& srgb)
+    {
+        switch (codec)
+        {
+            case TextureCodec::BC1: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case TextureCodec::BC4: return GL_COMPRESSED_RED_RGTC1;
+            case TextureCodec::BC5: return GL_COMPRESSED_RG_RGTC2;
+            case TextureCodec::BC7: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+            default: return GL_NONE;
+        }
+    }
+
+    bool isSrgbCompressed(const TextureCodec& codec, const bool& gammaCorrection)
+    {
+        // BC4 and BC5 have no sRGB variants, so gamma corrected single/two channel maps are converted
+        // to linear before encoding instead
+        return gammaCorrection && (codec == TextureCodec::BC1 || codec == TextureCodec::BC7);
+    }
+
     unsigned int loadCubemapTexture(const std::array<std::string, 6>& filePaths, const bool& gammaCorrection)
     {
         unsigned int textureID = 0;
@@ -49,12 +344,25 @@ namespace TextureUtils
         glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
         int width, height, nrChannels;
+        size_t bytes = 0;
         for (int i = 0; i < filePaths.size() ; i++)
         {
             unsigned char* data = stbi_load(filePaths[i].c_str(), &width, &height, &nrChannels, 0);
             if (!data)
             {
                 std::cout << "Texture failed to load at path: " << filePaths[i] << std::endl;
+                glDeleteTextures(1, &textureID);
+                GpuMemory::release(GpuResourceType::Texture, textureID);
+                return 0;
+            }
+
+            // Faces may differ in size and channels, every one is sized on its own
+            const size_t faceBytes = static_cast<size_t>(width) * height * nrChannels;
+            if (!GpuMemory::canAllocate(faceBytes, filePaths[i]))
+            {
+                stbi_image_free(data);
+                glDeleteTextures(1, &textureID);
+                GpuMemory::release(GpuResourceType::Texture, textureID);
                 return 0;
             }
 
@@ -70,8 +378,14 @@ namespace TextureUtils
             {
                 std::cout << "Texture load failed! Undefined image channels: " << filePaths[i] << std::endl;
                 stbi_image_free(data);
+                glDeleteTextures(1, &textureID);
+                GpuMemory::release(GpuResourceType::Texture, textureID);
                 return 0;
             }
+
+            // Tracked face by face, so the budget checks of the later faces count the earlier ones
+            bytes += faceBytes;
+            GpuMemory::track(GpuResourceType::Texture, textureID, bytes, "Environment", filePaths[0]);
         }
 
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -84,23 +398,51 @@ namespace TextureUtils
         return textureID;
     }
 
-    unsigned int loadHdrImage(const std::string& filePath)
+    unsigned int loadHdrImage(const std::string& filePath, const bool& verbose)
     {
-        unsigned int textureID = 0;
-        glGenTextures(1, &textureID);
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        const auto startTime = std::chrono::steady_clock::now();
 
-        stbi_set_flip_vertically_on_load(true);
-        int width, height, nrChannels;
-        float* data = stbi_loadf(filePath.c_str(), &width, &height, &nrChannels, 0);
-        if (!data)
+        // Decode straight to half-floats so the upload already matches the GL_RGB16F storage and the
+        // driver does not have to convert a full 32-bit float copy of the image
+        HdrImage image;
+        if (!HdrDecoder::decodeRgbe(filePath, image))
         {
-            std::cout << "Texture failed to load at path: " << filePath << std::endl;
-            return 0;
+            std::cout << "HDR decoder could not read " << filePath << ", falling back to stb_image" << std::endl;
+
+            stbi_set_flip_vertically_on_load(true);
+            int nrChannels;
+            float* data = stbi_loadf(filePath.c_str(), &image.width, &image.height, &nrChannels, 3);
+            stbi_set_flip_vertically_on_load(false);
+            if (!data)
+            {
+                std::cout << "Texture failed to load at path: " << filePath << std::endl;
+                return 0;
+            }
+
+            image.pixels.resize(static_cast<size_t>(image.width) * image.height * 3);
+            HdrDecoder::floatToHalf(data, image.pixels.data(), image.pixels.size());
+            stbi_image_free(data);
         }
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data);
-        stbi_image_free(data);
+        if (verbose)
+        {
+            const auto decodeTime =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime);
+            std::cout << "Loaded HDR image " << filePath << " (" << image.width << "x" << image.height << ") in "
+                      << decodeTime.count() << " ms" << std::endl;
+        }
+
+        unsigned int textureID = 0;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+
+        // Rows of 3 half-floats are only guaranteed to be 2 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, image.width, image.height, 0, GL_RGB, GL_HALF_FLOAT,
+                     image.pixels.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        GpuMemory::track(GpuResourceType::Texture, textureID,
+                         GpuMemory::textureBytes(GL_RGB16F, image.width, image.height), "Environment", filePath);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -134,4 +476,49 @@ namespace TextureUtils
                 return -1;
         }
     }
+
+    bool isCodecSupported(const TextureCodec& codec, const bool& srgb)
+    {
+        int majorVersion = 0;
+        int minorVersion = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+        glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+
+        switch (codec)
+        {
+            case TextureCodec::BC4:
+            case TextureCodec::BC5:
+                return true; // RGTC is core since OpenGL 3.0
+            case TextureCodec::BC7:
+                return majorVersion > 4 || (majorVersion == 4 && minorVersion >= 2) ||
+                       hasExtension("GL_ARB_texture_compression_bptc");
+            case TextureCodec::BC1:
+                return hasExtension("GL_EXT_texture_compression_s3tc") &&
+                       (!srgb || hasExtension("GL_EXT_texture_sRGB") ||
+                        hasExtension("GL_EXT_texture_compression_s3tc_srgb"));
+            default:
+                return false;
+        }
+    }
+
+    bool hasExtension(const std::string& name)
+    {
+        static const std::unordered_set<std::string> extensions = []
+        {
+            std::unordered_set<std::string> names;
+            int count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (int i = 0; i < count; i++)
+            {
+                names.emplace(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)));
+            }
+            return names;
+        }();
+        return extensions.contains(name);
+    }
+
+    const TextureMemoryStats& textureMemoryStats()
+    {
+        return memoryStats;
+    }
 }
@@ -2,11 +2,33 @@
 #include <glad/glad.h>
 #include <string>
 #include <array>
+#include <vector>
+#include "TextureCompressor.h"
+
+struct TextureMemoryStats
+{
+    unsigned int textureCount = 0;
+    size_t uploadedBytes = 0;     // GPU memory used by the loaded material textures, including mips
+    size_t uncompressedBytes = 0; // What the same textures would use if uploaded uncompressed
+    unsigned int reducedTextures = 0; // Uploaded from a smaller mip to stay within the GPU memory budget
+};
 
 namespace TextureUtils
 {
     unsigned int loadTexture(const std::string& filePath, const bool& gammaCorrection);
+    unsigned int loadCompressedTexture(const std::string& filePath, const TextureCodec& codec, const bool& gammaCorrection);
+    // Reads the encoded mip chain from the texture cache, or encodes the image and writes the cache
+    bool loadCompressedMips(const std::string& filePath, const TextureCodec& codec, const bool& gammaCorrection,
+                            CompressedTexture& texture, bool& fromCache);
+    // Uploads encoded textures of identical size, codec and mip count as the layers of a texture array
+    unsigned int loadCompressedTextureArray(const std::vector<const CompressedTexture*>& layers);
     unsigned int loadCubemapTexture(const std::array<std::string, 6>& filePaths, const bool& gammaCorrection);
-    unsigned int loadHdrImage(const std::string& filePath);
+    // Prints the decode time when verbose
+    unsigned int loadHdrImage(const std::string& filePath, const bool& verbose = false);
     int evaluateFormats(const int& nrChannels, GLenum& internalFormat, GLenum& dataFormat, const bool& correctGamma);
+    GLenum compressedFormat(const TextureCodec& codec, const bool& srgb);
+    bool isSrgbCompressed(const TextureCodec& codec, const bool& gammaCorrection);
+    bool isCodecSupported(const TextureCodec& codec, const bool& srgb);
+    bool hasExtension(const std::string& name);
+    const TextureMemoryStats& textureMemoryStats();
 }
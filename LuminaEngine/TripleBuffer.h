@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+/// <summary>
+/// Hands the latest value from one writer thread to one reader thread without locks, neither side ever
+/// waits for the other. Three slots rotate: the writer fills its back slot and swaps it with the shared
+/// middle one, the reader swaps its front slot with the middle one whenever something newer is there.
+/// </summary>
+template <typename T>
+class TripleBuffer
+{
+public:
+    explicit TripleBuffer(const T& initial = T()) :
+        mSlots{initial, initial, initial},
+        mMiddle(1),
+        mBack(2),
+        mFront(0)
+    {
+    }
+
+    /// <summary>
+    /// Writer only, the slot to fill before publish()
+    /// </summary>
+    T& back()
+    {
+        return mSlots[mBack];
+    }
+
+    /// <summary>
+    /// Writer only, makes the back slot the latest value
+    /// </summary>
+    void publish()
+    {
+        mBack = mMiddle.exchange(mBack | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    /// <summary>
+    /// Reader only, the latest published value. Stays valid and unchanged until the next read().
+    /// </summary>
+    const T& read()
+    {
+        if (mMiddle.load(std::memory_order_relaxed) & FRESH)
+        {
+            mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+        return mSlots[mFront];
+    }
+
+private:
+    // The middle index carries a flag telling whether the writer published since the reader last swapped
+    static constexpr unsigned int FRESH = 4;
+    static constexpr unsigned int INDEX_MASK = 3;
+
+    std::array<T, 3> mSlots;
+    std::atomic<unsigned int> mMiddle;
+    unsigned int mBack;  // Owned by the writer
+    unsigned int mFront; // Owned by the reader
+};
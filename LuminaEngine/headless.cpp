@@ -0,0 +1,512 @@
+// Offscreen benchmark runner. Renders a fixed number of frames along a camera path without a window and
+// writes frame time percentiles, per pass timings and startup phase timings as JSON.
+// With --batch it renders images instead, one PNG per key of the camera path or per step of a turntable
+// of --frames images, and reports the throughput. With --serve it stays resident and takes render jobs over
+// a Unix domain socket, see RenderServer.h for the protocol.
+//
+// Usage: LuminaHeadless [--model <path>] [--hdri <path>] [--path <camera path>] [--frames <n>]
+//                       [--warmup <n>] [--width <px>] [--height <px>] [--out <json>] [--no-gpu-culling]
+//                       [--rgba16f-hdr] [--batch <output dir>] [--readback-ring <n>] [--serve <socket path>]
+//                       [--expect-no-allocations] [--pack-materials] [--verbose]
+//
+// --expect-no-allocations fails the run when a timed frame allocates from the global heap on the render thread
+// inside Renderer::render, so steady-state allocation regressions break CI.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include "AllocationCounter.h"
+#include "CameraPath.h"
+#include "FrameReadback.h"
+#include "GpuMemory.h"
+#include "JobSystem.h"
+#include "RenderServer.h"
+#include "Renderer.h"
+
+namespace
+{
+    // The camera path and the texture streamer advance by a fixed step so runs do not depend on frame rate
+    constexpr float FIXED_DELTA_TIME = 1.0f / 60.0f;
+    constexpr float ORBIT_DURATION = 10.0f; // In seconds
+
+    struct BenchmarkOptions
+    {
+        RendererConfig config;
+        std::string cameraPathFile;
+        std::string outputFile = "benchmark.json";
+        int frames = 600;
+        int warmupFrames = 60;
+        bool gpuCulling = true;
+        std::string batchDirectory; // Batch mode when set
+        unsigned int readbackRing = FrameReadback::DEFAULT_RING_SIZE;
+        std::string socketPath; // Server mode when set
+        bool expectNoAllocations = false;
+    };
+
+    struct PassStats
+    {
+        std::string name;
+        int depth;
+        double cpuMs = 0.0;
+        double gpuMs = 0.0;
+        int count = 0;
+    };
+
+    bool parseArguments(const int argc, char** argv, BenchmarkOptions& options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--no-gpu-culling") { options.gpuCulling = false; }
+            else if (arg == "--rgba16f-hdr") { options.config.compactHdrTarget = false; }
+            else if (arg == "--pack-materials") { options.config.packMaterialTextures = true; }
+            else if (arg == "--verbose") { options.config.verbose = true; }
+            else if (arg == "--expect-no-allocations") { options.expectNoAllocations = true; }
+            else if (arg == "--model" && hasValue) { options.config.modelPath = argv[++i]; }
+            else if (arg == "--hdri" && hasValue) { options.config.hdrImagePath = argv[++i]; }
+            else if (arg == "--path" && hasValue) { options.cameraPathFile = argv[++i]; }
+            else if (arg == "--out" && hasValue) { options.outputFile = argv[++i]; }
+            else if (arg == "--frames" && hasValue) { options.frames = std::max(1, std::atoi(argv[++i])); }
+            else if (arg == "--warmup" && hasValue) { options.warmupFrames = std::max(0, std::atoi(argv[++i])); }
+            else if (arg == "--width" && hasValue) { options.config.width = std::max(1, std::atoi(argv[++i])); }
+            else if (arg == "--height" && hasValue) { options.config.height = std::max(1, std::atoi(argv[++i])); }
+            else if (arg == "--batch" && hasValue) { options.batchDirectory = argv[++i]; }
+            else if (arg == "--serve" && hasValue) { options.socketPath = argv[++i]; }
+            else if (arg == "--readback-ring" && hasValue)
+            {
+                options.readbackRing = static_cast<unsigned int>(std::max(1, std::atoi(argv[++i])));
+            }
+            else
+            {
+                std::cout << "Unknown or incomplete argument: " << arg << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Surfaceless EGL context, so no display server is needed (e.g. Mesa llvmpipe on CI machines)
+    bool createContext(EGLDisplay& display, EGLContext& context)
+    {
+        display = EGL_NO_DISPLAY;
+        const auto getPlatformDisplay =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay)
+        {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (display == EGL_NO_DISPLAY)
+        {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+
+        EGLint major = 0;
+        EGLint minor = 0;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+        {
+            std::cout << "Failed to initialize EGL" << std::endl;
+            return false;
+        }
+
+        constexpr EGLint CONFIG_ATTRIBUTES[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+        EGLConfig config = nullptr;
+        EGLint configCount = 0;
+        eglChooseConfig(display, CONFIG_ATTRIBUTES, &config, 1, &configCount);
+
+        // Same preference as the windowed engine, 4.3 for GPU driven culling with a 3.3 fallback
+        constexpr EGLint CONTEXT_VERSIONS[][2] = {{4, 3}, {3, 3}};
+        context = EGL_NO_CONTEXT;
+        for (const auto& [contextMajor, contextMinor] : CONTEXT_VERSIONS)
+        {
+            const EGLint contextAttributes[] = {
+                EGL_CONTEXT_MAJOR_VERSION, contextMajor,
+                EGL_CONTEXT_MINOR_VERSION, contextMinor,
+                EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                EGL_NONE
+            };
+            context = eglCreateContext(display, configCount > 0 ? config : nullptr, EGL_NO_CONTEXT, contextAttributes);
+            if (context != EGL_NO_CONTEXT) { break; }
+        }
+
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        {
+            std::cout << "Failed to create a surfaceless OpenGL context" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Nearest rank percentile of sorted values
+    double percentile(const std::vector<double>& sorted, const double p)
+    {
+        const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    std::string escapeJson(const std::string_view text)
+    {
+        std::string escaped;
+        for (const char c : text)
+        {
+            if (c == '"' || c == '\\') { escaped.push_back('\\'); }
+            escaped.push_back(c);
+        }
+        return escaped;
+    }
+
+    // Every key of a loaded camera path, or a turntable of the requested number of images
+    std::vector<Camera> batchPoses(const BenchmarkOptions& options, const CameraPath& cameraPath, const bool isLoaded)
+    {
+        std::vector<Camera> poses;
+        if (isLoaded)
+        {
+            for (const CameraKey& key : cameraPath.getKeys()) { poses.push_back(cameraPath.sample(key.time)); }
+            return poses;
+        }
+        for (int i = 0; i < options.frames; i++)
+        {
+            poses.push_back(cameraPath.sample(cameraPath.duration() * static_cast<float>(i) / static_cast<float>(options.frames)));
+        }
+        return poses;
+    }
+
+    // Renders every pose to a PNG. The copy of each frame overlaps rendering the next ones and encoding
+    // runs on the job system, so throughput is bound by the slowest of the three rather than their sum.
+    int runBatch(const BenchmarkOptions& options, const std::vector<Camera>& poses, Renderer& renderer,
+                 const RenderSettings& frameSettings, const unsigned int outputFBO)
+    {
+        // Poses are separate images, TAA history would ghost each one into the next and a scale picked
+        // from frame times would vary the resolution between them
+        RenderSettings settings = frameSettings;
+        settings.enableTaa = false;
+        settings.enableDynamicResolution = false;
+
+        std::error_code error;
+        std::filesystem::create_directories(options.batchDirectory, error);
+        if (error)
+        {
+            std::cout << "Failed to create " << options.batchDirectory << ": " << error.message() << std::endl;
+            return -1;
+        }
+
+        const int width = options.config.width;
+        const int height = options.config.height;
+        // Read back rows start at the bottom of the image
+        stbi_flip_vertically_on_write(1);
+
+        // Every encode in flight holds a whole frame, a frame waits for the one this many frames earlier
+        const unsigned int maxEncodes = 2 * JobSystem::maxWorkerCount();
+        std::vector<std::unique_ptr<JobCounter>> encodes(maxEncodes);
+        for (std::unique_ptr<JobCounter>& counter : encodes) { counter = std::make_unique<JobCounter>(); }
+        std::atomic<int> failedWrites{0};
+
+        FrameReadback readback(width, height, [&](const int frame, std::vector<unsigned char>&& pixels)
+        {
+            JobCounter& counter = *encodes[static_cast<unsigned int>(frame) % maxEncodes];
+            JobSystem::wait(counter);
+
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%05d.png", frame);
+            const std::string path = (std::filesystem::path(options.batchDirectory) / name).string();
+            JobSystem::run([path, width, height, pixels = std::move(pixels), &failedWrites]
+            {
+                if (!stbi_write_png(path.c_str(), width, height, 4, pixels.data(), width * 4))
+                {
+                    std::cout << "Failed to write " << path << std::endl;
+                    failedWrites.fetch_add(1, std::memory_order_relaxed);
+                }
+            }, &counter);
+        }, options.readbackRing);
+
+        Profiler& profiler = renderer.getProfiler();
+        for (int frame = 0; frame < options.warmupFrames; frame++)
+        {
+            profiler.beginFrame();
+            renderer.render(poses.front(), settings, FIXED_DELTA_TIME);
+            profiler.endFrame();
+        }
+        glFinish();
+
+        const auto batchStart = std::chrono::steady_clock::now();
+        for (size_t frame = 0; frame < poses.size(); frame++)
+        {
+            profiler.beginFrame();
+            renderer.render(poses[frame], settings, FIXED_DELTA_TIME);
+            profiler.beginScope("Readback");
+            readback.capture(outputFBO, static_cast<int>(frame));
+            profiler.endScope();
+            profiler.endFrame();
+        }
+        readback.flush();
+        for (std::unique_ptr<JobCounter>& counter : encodes) { JobSystem::wait(*counter); }
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+        const double framesPerSecond = static_cast<double>(poses.size()) / seconds;
+        const uint64_t stalls = readback.stallCount();
+        readback.deinit();
+
+        std::ofstream file(options.outputFile);
+        if (!file)
+        {
+            std::cout << "Failed to open " << options.outputFile << " for writing" << std::endl;
+            return -1;
+        }
+
+        file << std::fixed << std::setprecision(4);
+        file << "{\n";
+        file << "  \"renderer\": \"" << escapeJson(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) << "\",\n";
+        file << "  \"glVersion\": \"" << escapeJson(reinterpret_cast<const char*>(glGetString(GL_VERSION))) << "\",\n";
+        file << "  \"config\": {\"model\": \"" << escapeJson(options.config.modelPath) << "\", \"width\": " << width
+             << ", \"height\": " << height << ", \"warmupFrames\": " << options.warmupFrames << ", \"cameraPath\": \""
+             << escapeJson(options.cameraPathFile.empty() ? "turntable" : options.cameraPathFile)
+             << "\", \"readbackRing\": " << options.readbackRing << ", \"encodeThreads\": "
+             << JobSystem::maxWorkerCount() << "},\n";
+        file << "  \"batch\": {\"frames\": " << poses.size() << ", \"seconds\": " << seconds << ", \"fps\": "
+             << framesPerSecond << ", \"readbackStalls\": " << stalls << ", \"failedWrites\": "
+             << failedWrites.load() << ", \"outputDirectory\": \"" << escapeJson(options.batchDirectory) << "\"}\n";
+        file << "}\n";
+        file.close();
+
+        std::cout << std::fixed << std::setprecision(3) << "Rendered " << poses.size() << " images in " << seconds
+                  << " s, " << framesPerSecond << " fps. Results written to " << options.outputFile << std::endl;
+        return failedWrites.load() == 0 ? 0 : -1;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    BenchmarkOptions options;
+    if (!parseArguments(argc, argv, options)) { return -1; }
+
+    const auto contextStart = std::chrono::steady_clock::now();
+    EGLDisplay display;
+    EGLContext context;
+    if (!createContext(display, context)) { return -1; }
+
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    const double contextMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - contextStart).count();
+
+    CameraPath cameraPath;
+    const bool isPathLoaded = !options.cameraPathFile.empty() && cameraPath.load(options.cameraPathFile);
+    if (!isPathLoaded)
+    {
+        cameraPath = CameraPath::orbit(glm::vec3(0.0f), 7.0f, 1.0f, ORBIT_DURATION);
+    }
+
+    // There is no surface to present to, so the final image goes into an offscreen framebuffer and
+    // nothing waits on vsync
+    unsigned int outputFBO = 0;
+    unsigned int outputRBO = 0;
+    glGenFramebuffers(1, &outputFBO);
+    glGenRenderbuffers(1, &outputRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, outputRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, options.config.width, options.config.height);
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, outputRBO);
+    GpuMemory::track(GpuResourceType::Renderbuffer, outputRBO,
+                     GpuMemory::textureBytes(GL_RGBA8, options.config.width, options.config.height), "Render Targets",
+                     "Output color");
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    Renderer* renderer = new Renderer(options.config);
+    renderer->setOutputFramebuffer(outputFBO);
+    renderer->init();
+
+    RenderSettings settings;
+    settings.enableGpuCulling = options.gpuCulling;
+    // Every frame renders at the requested resolution, so runs stay comparable
+    settings.enableDynamicResolution = false;
+
+    const auto shutdown = [&]()
+    {
+        delete renderer;
+        glDeleteFramebuffers(1, &outputFBO);
+        GpuMemory::release(GpuResourceType::Renderbuffer, outputRBO);
+        glDeleteRenderbuffers(1, &outputRBO);
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+    };
+
+    if (!options.batchDirectory.empty())
+    {
+        const int result = runBatch(options, batchPoses(options, cameraPath, isPathLoaded), *renderer, settings,
+                                    outputFBO);
+        shutdown();
+        return result;
+    }
+
+    if (!options.socketPath.empty())
+    {
+        // Warm up the texture streamer before the first job, it counts as startup like the rest
+        for (int frame = 0; frame < options.warmupFrames; frame++)
+        {
+            renderer->getProfiler().beginFrame();
+            renderer->render(cameraPath.sample(0.0f), settings, FIXED_DELTA_TIME);
+            renderer->getProfiler().endFrame();
+        }
+        glFinish();
+        const double startupMs =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - contextStart).count();
+
+        int result = -1;
+        {
+            RenderServer server(*renderer, settings, outputFBO, outputRBO, startupMs);
+            if (server.listen(options.socketPath))
+            {
+                server.run();
+                result = 0;
+            }
+        }
+        shutdown();
+        return result;
+    }
+
+    Profiler& profiler = renderer->getProfiler();
+
+    std::vector<double> frameTimes;
+    frameTimes.reserve(options.frames);
+    uint64_t totalAllocations = 0;
+    uint64_t maxAllocations = 0;
+    std::vector<PassStats> passes;
+    std::map<std::string, size_t> passIndices;
+    uint64_t lastResolvedFrame = 0;
+
+    const int totalFrames = options.warmupFrames + options.frames;
+    for (int frame = 0; frame < totalFrames; frame++)
+    {
+        const float time = std::fmod(static_cast<float>(frame) * FIXED_DELTA_TIME, cameraPath.duration());
+        const Camera camera = cameraPath.sample(time);
+
+        const auto frameStart = std::chrono::steady_clock::now();
+        profiler.beginFrame();
+        const uint64_t allocationsBefore = AllocationCounter::count();
+        renderer->render(camera, settings, FIXED_DELTA_TIME);
+        const uint64_t allocations = AllocationCounter::count() - allocationsBefore;
+        // Wait for the GPU so the frame time covers the whole frame and not only its submission
+        profiler.beginScope("Finish", false);
+        glFinish();
+        profiler.endScope();
+        profiler.endFrame();
+        const double frameMs =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+
+        if (frame >= options.warmupFrames)
+        {
+            frameTimes.push_back(frameMs);
+            totalAllocations += allocations;
+            maxAllocations = std::max(maxAllocations, allocations);
+        }
+
+        // Pass timings arrive a frame late. Frame 0 of the profiler is startup, so benchmark frame n is n + 1.
+        const ProfileFrame* resolved = profiler.latestFrame();
+        if (!resolved || resolved->index == lastResolvedFrame) { continue; }
+        lastResolvedFrame = resolved->index;
+        if (resolved->index <= static_cast<uint64_t>(options.warmupFrames)) { continue; }
+
+        for (const ProfileEvent& event : resolved->events)
+        {
+            const std::string key = std::to_string(event.depth) + "|" + std::string(event.name);
+            auto pass = passIndices.find(key);
+            if (pass == passIndices.end())
+            {
+                pass = passIndices.emplace(key, passes.size()).first;
+                passes.push_back({std::string(event.name), event.depth});
+            }
+            PassStats& stats = passes[pass->second];
+            stats.cpuMs += event.cpuEndMs - event.cpuStartMs;
+            stats.gpuMs += event.gpuStartMs >= 0.0 ? event.gpuEndMs - event.gpuStartMs : 0.0;
+            stats.count++;
+        }
+    }
+
+    std::vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double totalMs = 0.0;
+    for (const double frameMs : frameTimes) { totalMs += frameMs; }
+
+    std::ofstream file(options.outputFile);
+    if (!file)
+    {
+        std::cout << "Failed to open " << options.outputFile << " for writing" << std::endl;
+        shutdown();
+        return -1;
+    }
+
+    file << std::fixed << std::setprecision(4);
+    file << "{\n";
+    file << "  \"renderer\": \"" << escapeJson(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) << "\",\n";
+    file << "  \"glVersion\": \"" << escapeJson(reinterpret_cast<const char*>(glGetString(GL_VERSION))) << "\",\n";
+    file << "  \"config\": {\"model\": \"" << escapeJson(options.config.modelPath) << "\", \"width\": "
+         << options.config.width << ", \"height\": " << options.config.height << ", \"frames\": " << options.frames
+         << ", \"warmupFrames\": " << options.warmupFrames << ", \"cameraPath\": \""
+         << escapeJson(options.cameraPathFile.empty() ? "orbit" : options.cameraPathFile) << "\", \"gpuCulling\": "
+         << (options.gpuCulling && renderer->isGpuCullingSupported() ? "true" : "false") << ", \"hdrFormat\": \""
+         << (options.config.compactHdrTarget ? "R11F_G11F_B10F" : "RGBA16F") << "\"},\n";
+
+    file << "  \"startupMs\": {\"Context\": " << contextMs;
+    for (const ProfileFrame& kept : profiler.keptFrames())
+    {
+        for (const ProfileEvent& event : kept.events)
+        {
+            file << ", \"" << escapeJson(event.name) << "\": " << event.cpuEndMs - event.cpuStartMs;
+        }
+    }
+    file << "},\n";
+
+    file << "  \"frameTimeMs\": {\"mean\": " << totalMs / static_cast<double>(frameTimes.size())
+         << ", \"p50\": " << percentile(sorted, 50.0) << ", \"p90\": " << percentile(sorted, 90.0)
+         << ", \"p95\": " << percentile(sorted, 95.0) << ", \"p99\": " << percentile(sorted, 99.0)
+         << ", \"min\": " << sorted.front() << ", \"max\": " << sorted.back() << "},\n";
+
+    file << "  \"heapAllocationsPerFrame\": {\"mean\": "
+         << static_cast<double>(totalAllocations) / static_cast<double>(frameTimes.size()) << ", \"max\": "
+         << maxAllocations << "},\n";
+    file << "  \"gpuMemoryMb\": " << static_cast<double>(GpuMemory::totalBytes()) / (1024.0 * 1024.0) << ",\n";
+    file << "  \"passes\": [";
+    for (size_t i = 0; i < passes.size(); i++)
+    {
+        const PassStats& pass = passes[i];
+        file << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << escapeJson(pass.name) << "\", \"depth\": "
+             << pass.depth << ", \"cpuMs\": " << pass.cpuMs / pass.count << ", \"gpuMs\": " << pass.gpuMs / pass.count
+             << ", \"frames\": " << pass.count << "}";
+    }
+    file << "\n  ]\n}\n";
+    file.close();
+
+    std::cout << std::fixed << std::setprecision(3) << "Rendered " << options.frames << " frames, p50 "
+              << percentile(sorted, 50.0) << " ms, p99 " << percentile(sorted, 99.0) << " ms. Results written to "
+              << options.outputFile << std::endl;
+
+    shutdown();
+    if (options.expectNoAllocations && maxAllocations > 0)
+    {
+        std::cout << "ERROR::HEADLESS::Steady-state frames allocated from the heap, up to " << maxAllocations
+                  << " allocations per frame" << std::endl;
+        return -1;
+    }
+    return 0;
+}
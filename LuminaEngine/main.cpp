@@ -1,6 +1,5 @@
-#include <array>
+#include <algorithm>
 #include <iostream>
-#include <sstream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <imgui.h>
@@ -9,103 +8,42 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "BloomRenderer.h"
+#ifdef LUMINA_COUNT_ALLOCATIONS
+#include "AllocationCounter.h"
+#endif
+#include "CameraPath.h"
+#include "FrameArena.h"
+#include "FrameTelemetry.h"
+#include "GpuMemory.h"
+#include "Renderer.h"
+#include "Simulation.h"
 #include "TextureUtils.h"
-#include "Model.h"
-#include "Shader.h"
-#include "LightPreview.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void cursor_pos_callback(GLFWwindow* window, double xPos, double yPos);
 void scroll_callback(GLFWwindow* window, double xOffset, double yOffset);
-void sceneSetup();
+void sceneSetup(GLFWwindow* window);
 void renderLoop(GLFWwindow* window);
-void setLightParameters();
-glm::vec3 getCameraDirection(double yaw, double pitch);
 void displayUI(const unsigned int& triangleCount);
 void deinit();
-void renderCube();
-void renderQuad();
 
 constexpr unsigned int SCR_WIDTH = 1280;
 constexpr unsigned int SCR_HEIGHT = 720;
 constexpr float MOUSE_SENSITIVITY = 0.1f;
 constexpr float DURATION_TO_MOUSE_HOLD = 0.1f; // In seconds
-constexpr int CUBE_FACE_COUNT = 6;
 
-const std::string MODEL_PATH = "Assets/Models/GuitarBackpack/guitar_backpack.obj";
+static RenderSettings settings;
+static float texture_budget_mb = 0.0f;
+static int selected_node = 0;
+#ifdef LUMINA_COUNT_ALLOCATIONS
+static uint64_t frame_allocations = 0; // Global heap allocations inside the last Renderer::render
+#endif
+static float node_offset[3] = {0.0f, 0.0f, 0.0f}; // Moved so far, in the space of the node's parent
 
-const char* OBJ_V_SHADER_PATH = "Assets/Shaders/shader_object.vert";
-const char* OBJ_F_SHADER_PATH = "Assets/Shaders/shader_object.frag";
-
-const char* LIGHT_V_SHADER_PATH = "Assets/Shaders/shader_light.vert";
-const char* LIGHT_F_SHADER_PATH = "Assets/Shaders/shader_light.frag";
-
-const char* SCR_V_SHADER_PATH = "Assets/Shaders/shader_screen.vert";
-const char* SCR_F_SHADER_PATH = "Assets/Shaders/shader_screen.frag";
-
-const char* SKYBOX_V_SHADER_PATH = "Assets/Shaders/shader_skybox.vert";
-const char* SKYBOX_F_SHADER_PATH = "Assets/Shaders/shader_skybox.frag";
-
-const char* EQR_TO_CUBE_V_SHADER_PATH = "Assets/Shaders/shader_cube_capture.vert";
-const char* EQR_TO_CUBE_F_SHADER_PATH = "Assets/Shaders/shader_eqrect_to_cubemap.frag";
-
-const char* IRRADIANCE_V_SHADER_PATH = "Assets/Shaders/shader_cube_capture.vert";
-const char* IRRADIANCE_F_SHADER_PATH = "Assets/Shaders/shader_irradiance.frag";
-
-const char* PREFILTER_V_SHADER_PATH = "Assets/Shaders/shader_cube_capture.vert";
-const char* PREFILTER_F_SHADER_PATH = "Assets/Shaders/shader_prefilter.frag";
-
-const char* BRDF_V_SHADER_PATH = "Assets/Shaders/shader_brdf.vert";
-const char* BRDF_F_SHADER_PATH = "Assets/Shaders/shader_brdf.frag";
-
-const std::string HDR_IMAGE_PATH = "Assets/Textures/Skybox/adams_place_bridge_4k.hdr";
-constexpr int SKYBOX_RES = 2048;
-constexpr int IRRADIANCE_MAP_RES = 128;
-constexpr int PREFILTER_MAP_RES = 128;
-constexpr int BRDF_MAP_RES = 512;
-
-// Reserving unit 0 to 4 for PBR/phong material texture maps
-constexpr unsigned int skyboxTexUnit = 5;
-constexpr unsigned int hdriTexUnit = 6;
-constexpr unsigned int screenTexUnit = 7;
-constexpr unsigned int irradianceTexUnit = 8;
-constexpr unsigned int prefilterTexUnit = 9;
-constexpr unsigned int brdfLutTexUnit = 10;
-constexpr unsigned int bloomBlurTexUnit = 11;
-
-static float pos[3];
-static float rot[3];
-static float scale[] = {1.0f, 1.0f, 1.0f};
-static bool show_skybox = true;
-static bool enableIBL = true;
-static bool enable_point_lights = true;
-static float point_light_intensity = 5.0f;
-static bool enable_bloom = true;
-static float bloom_filter_radius = 0.005f;
-
-const glm::vec3 world_front(0.0f, 0.0f, -1.0f);
-const glm::vec3 world_up(0.0f, 1.0f, 0.0f);
-
-const glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-const glm::mat4 captureViews[] =
-{
-    glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-    glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-    glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
-    glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
-    glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-    glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
-};
-
-glm::vec3 cameraPosition(0.0f, 0.0f, 7.0f);
-glm::vec3 cameraFront = world_front;
-glm::vec3 cameraUp = world_up;
-double camYaw = -90.0f; // Rotation around Y axis
-double camPitch = 0.0f; // Rotation around X axis
-float fov = 45.0f;
+// Camera and object motion run at a fixed tick on their own thread, frames render its interpolated state
+Simulation* simulation = nullptr;
 
 bool shouldPanCamera = false;
 bool isFirstMouse = true;
@@ -119,47 +57,14 @@ bool isLeftMouseHolding = false;
 double mouseHoldStartTime = 0.0f;
 double mouseHoldDuration = 0.0f;
 
-Model* modelAsset = nullptr;
-LightPreview* lightPreview = nullptr;
-BloomRenderer* bloomRenderer;
-Shader* objectShader = nullptr;
-Shader* lightShader = nullptr;
-Shader* screenShader = nullptr;
-Shader* skyboxShader = nullptr;
-Shader* equirectToCubemapShader = nullptr;
-Shader* irradianceShader = nullptr;
-Shader* prefilterShader = nullptr;
-Shader* brdfShader = nullptr;
-
-unsigned int hdrFBO = 0;
-unsigned int rbo = 0;
-unsigned int quadVAO = 0;
-unsigned int quadVBO = 0;
-unsigned int cubeVAO = 0;
-unsigned int cubeVBO = 0;
-
-unsigned int colorBuffTextures[2] = {0, 0};
-unsigned int hdriTexture = 0;
-unsigned int captureFBO = 0;
-unsigned int captureRBO = 0;
-unsigned int skyboxTex = 0;
-unsigned int irradianceMapTex = 0;
-unsigned int prefiltetMapTex = 0;
-unsigned int brdfLutTex = 0;
-
-glm::vec3 pointLightPositions[] = {
-        glm::vec3(1.2f,  0.2f,  2.0f),
-        glm::vec3(-1.2f,  0.5f,  2.0f),
-        glm::vec3(-1.0f, 0.3f, -4.0f),
-        glm::vec3(1.0f,  0.0f, -3.7f)
-};
-
-glm::vec3 pointLightColors[] = {
-        glm::vec3(1.0f, 1.0f, 1.0f),
-        glm::vec3(1.0f, 0.0f, 0.0f),
-        glm::vec3(0.0f, 1.0f, 0.0f),
-        glm::vec3(0.0f, 0.0f, 1.0f),
-};
+Renderer* renderer = nullptr;
+FrameTelemetry* telemetry = nullptr;
+
+// Camera keys recorded for the headless benchmark
+CameraPath recordedPath;
+bool isRecordingPath = false;
+float recordTime = 0.0f;
+std::string recordStatus;
 
 void processInput(GLFWwindow *window)
 {
@@ -168,45 +73,39 @@ void processInput(GLFWwindow *window)
         glfwSetWindowShouldClose(window, true);
     }
 
-    const float camera_speed = 5.0f * deltaTime;
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-    {
-        cameraPosition += camera_speed * cameraFront;
-    }
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-    {
-        cameraPosition -= camera_speed * cameraFront;
-    }
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-    {
-        cameraPosition -= glm::normalize(glm::cross(cameraFront, cameraUp)) * camera_speed;
-    }
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-    {
-        cameraPosition += glm::normalize(glm::cross(cameraFront, cameraUp)) * camera_speed;
-    }
+    // GLFW only reports keys on the window thread, the simulation moves the camera while they are held
+    uint32_t keys = 0;
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) { keys |= MOVE_FORWARD; }
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) { keys |= MOVE_BACKWARD; }
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) { keys |= MOVE_LEFT; }
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) { keys |= MOVE_RIGHT; }
+    simulation->setMoveKeys(keys);
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
+    if (renderer)
+    {
+        renderer->resize(static_cast<unsigned int>(width), static_cast<unsigned int>(height));
+    }
 }
 
 void sceneSetup(GLFWwindow* window)
 {
-    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-
-    constexpr bool isPbr = true;
-    modelAsset = new Model(MODEL_PATH, isPbr);
-    objectShader = new Shader(OBJ_V_SHADER_PATH, OBJ_F_SHADER_PATH);
-    lightPreview = new LightPreview();
-    lightShader = new Shader(LIGHT_V_SHADER_PATH, LIGHT_F_SHADER_PATH);
-    screenShader = new Shader(SCR_V_SHADER_PATH, SCR_F_SHADER_PATH);
-    skyboxShader = new Shader(SKYBOX_V_SHADER_PATH, SKYBOX_F_SHADER_PATH);
-    equirectToCubemapShader = new Shader(EQR_TO_CUBE_V_SHADER_PATH, EQR_TO_CUBE_F_SHADER_PATH);
-    irradianceShader = new Shader(IRRADIANCE_V_SHADER_PATH, IRRADIANCE_F_SHADER_PATH);
-    prefilterShader = new Shader(PREFILTER_V_SHADER_PATH, PREFILTER_F_SHADER_PATH);
-    brdfShader = new Shader(BRDF_V_SHADER_PATH, BRDF_F_SHADER_PATH);
+    // The framebuffer can be larger than the window on high DPI displays
+    int framebufferWidth = 0;
+    int framebufferHeight = 0;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+    RendererConfig config;
+    config.width = framebufferWidth > 0 ? framebufferWidth : SCR_WIDTH;
+    config.height = framebufferHeight > 0 ? framebufferHeight : SCR_HEIGHT;
+    texture_budget_mb = config.textureBudgetMb;
+    renderer = new Renderer(config);
+    renderer->init();
+    telemetry = new FrameTelemetry();
+    simulation = new Simulation();
 
     // IMGUI setup
     IMGUI_CHECKVERSION();
@@ -217,270 +116,12 @@ void sceneSetup(GLFWwindow* window)
     // install_callback=true will install GLFW callbacks and chain to existing ones.
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init();
-
-    // Framebuffer config
-    glGenFramebuffers(1, &hdrFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-    // Create 2 floating point color buffers for normal rendering and for brightness threshold values
-    glGenTextures(2, colorBuffTextures);
-    for (unsigned int i = 0; i < std::size(colorBuffTextures); i++)
-    {
-        glBindTexture(GL_TEXTURE_2D, colorBuffTextures[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        // We clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        // Attach texture to framebuffer
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffTextures[i], 0);
-    }
-    // Renderbuffer object for depth attachment
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rbo);
-    // Tell OpenGL which color attachments we'll use (of this framebuffer) for rendering
-    constexpr unsigned int attachments[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
-    glDrawBuffers(2, attachments);
-    // Finally check if framebuffer is complete
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-    {
-        std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // Framebuffer and renderbuffer setup for generating cubemaps by capturing the given environment
-    glGenFramebuffers(1, &captureFBO);
-    glGenRenderbuffers(1, &captureRBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, SKYBOX_RES, SKYBOX_RES);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
-
-    // Skybox texture setup
-    glGenTextures(1, &skyboxTex);
-    glActiveTexture(GL_TEXTURE0 + skyboxTexUnit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTex);
-    for (unsigned int i = 0; i < CUBE_FACE_COUNT; i++)
-    {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-            0, GL_RGB16F, SKYBOX_RES, SKYBOX_RES, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // Irradiance map texture setup
-    glGenTextures(1, &irradianceMapTex);
-    glActiveTexture(GL_TEXTURE0 + irradianceTexUnit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMapTex);
-    for (unsigned int i = 0; i < CUBE_FACE_COUNT; i++)
-    {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-            0, GL_RGB16F, IRRADIANCE_MAP_RES, IRRADIANCE_MAP_RES, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // Prefilter map texture setup
-    glGenTextures(1, &prefiltetMapTex);
-    glActiveTexture(GL_TEXTURE0 + prefilterTexUnit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, prefiltetMapTex);
-    for (unsigned int i = 0; i < CUBE_FACE_COUNT; i++)
-    {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-            0, GL_RGB16F, PREFILTER_MAP_RES, PREFILTER_MAP_RES, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // Generate mipmaps for the cubemap so OpenGL automatically allocates the required memory
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-    // BRDF LUT map texture setup
-    glGenTextures(1, &brdfLutTex);
-    glActiveTexture(GL_TEXTURE0 + brdfLutTexUnit);
-    glBindTexture(GL_TEXTURE_2D, brdfLutTex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, BRDF_MAP_RES, BRDF_MAP_RES, 0, GL_RG, GL_FLOAT, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // Load cubemap
-    glActiveTexture(GL_TEXTURE0 + hdriTexUnit);
-    hdriTexture = TextureUtils::loadHdrImage(HDR_IMAGE_PATH);
-    glBindTexture(GL_TEXTURE_2D, hdriTexture);
-
-    // Convert HDR equirectangular environment map to cubemap equivalent
-    equirectToCubemapShader->use();
-    equirectToCubemapShader->setMat4("projection", captureProjection);
-    equirectToCubemapShader->setInt("equirectangularMap", hdriTexUnit);
-
-    glViewport(0, 0, SKYBOX_RES, SKYBOX_RES); // Configure the viewport to the capture dimensions
-    for (int i = 0; i < CUBE_FACE_COUNT; i++)
-    {
-        equirectToCubemapShader->setMat4("view", captureViews[i]);
-        // Already bound to captureFBO
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                               GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, skyboxTex, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        renderCube();
-    }
-
-    // Generate mipmaps of skybox
-    glActiveTexture(GL_TEXTURE0 + skyboxTexUnit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTex);
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-    irradianceShader->use();
-    irradianceShader->setMat4("projection", captureProjection);
-    irradianceShader->setInt("environmentMap", skyboxTexUnit);
-    glActiveTexture(GL_TEXTURE0 + skyboxTexUnit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTex);
-    glViewport(0, 0, IRRADIANCE_MAP_RES, IRRADIANCE_MAP_RES);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IRRADIANCE_MAP_RES, IRRADIANCE_MAP_RES);
-    for (int i = 0; i < CUBE_FACE_COUNT; i++)
-    {
-        irradianceShader->setMat4("view", captureViews[i]);
-        // Already bound to captureFBO
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                               GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMapTex, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        renderCube();
-    }
-
-    prefilterShader->use();
-    prefilterShader->setMat4("projection", captureProjection);
-    prefilterShader->setInt("environmentMap", skyboxTexUnit);
-    prefilterShader->setInt("skyboxResolution", SKYBOX_RES);
-    glActiveTexture(GL_TEXTURE0 + skyboxTexUnit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTex);
-    constexpr unsigned int MAX_MIP_LEVELS = 8;
-    for (int mip = 0; mip < MAX_MIP_LEVELS; mip++)
-    {
-        // Reisze framebuffer according to mip-level size
-        const auto mipWidth = static_cast<unsigned int>(PREFILTER_MAP_RES * std::pow(0.5, mip));
-        const auto mipHeight = static_cast<unsigned int>(PREFILTER_MAP_RES * std::pow(0.5, mip));
-        // Already bound to captureRBO
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
-        glViewport(0, 0, mipWidth, mipHeight);
-
-        float roughness = static_cast<float>(mip) / static_cast<float>(MAX_MIP_LEVELS - 1);
-        prefilterShader->setFloat("roughness", roughness);
-
-        for (int i = 0; i < CUBE_FACE_COUNT; i++)
-        {
-            prefilterShader->setMat4("view", captureViews[i]);
-            // Already bound to captureFBO
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                                   GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefiltetMapTex, mip);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            renderCube();
-        }
-    }
-
-    // Already bound to captureFBO and captureRBO
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, BRDF_MAP_RES, BRDF_MAP_RES);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLutTex, 0);
-    glViewport(0, 0, BRDF_MAP_RES, BRDF_MAP_RES);
-    brdfShader->use();
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    renderQuad();
-
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // Before rendering, config the viewport to the original framebuffer's screen dimensions
-    int scrWidth, scrHeight;
-    glfwGetFramebufferSize(window, &scrWidth, &scrHeight);
-    glViewport(0, 0, scrWidth, scrHeight);
-
-    const glm::mat4 projection = glm::perspective(glm::radians(fov),
-        static_cast<float>(SCR_WIDTH) / static_cast<float>(SCR_HEIGHT), 0.1f, 100.0f);
-
-    bloomRenderer = new BloomRenderer(SCR_WIDTH, SCR_HEIGHT);
-
-    // Setting constant uniforms
-    objectShader->use();
-    objectShader->setMat4("projection", projection);
-    objectShader->setInt("skybox", skyboxTexUnit);
-    objectShader->setInt("irradianceMap", irradianceTexUnit);
-    objectShader->setInt("prefilterMap", prefilterTexUnit);
-    objectShader->setInt("brdfLut", brdfLutTexUnit);
-
-    lightShader->use();
-    lightShader->setMat4("projection", projection);
-
-    skyboxShader->use();
-    skyboxShader->setMat4("projection", projection);
-    skyboxShader->setInt("skybox", skyboxTexUnit);
-
-    screenShader->use();
-    screenShader->setInt("screenTexture", screenTexUnit);
-    screenShader->setInt("bloomBlurTexture", bloomBlurTexUnit);
-}
-
-void setLightParameters()
-{
-    glm::vec3 ambient(0.05);
-    glm::vec3 diffuse(0.8f);
-    glm::vec3 specular(1.0f);
-
-    // Directional light
-    objectShader->setBool("dirLight.isActive", false);
-    objectShader->setVec3("dirLightDirection", glm::vec3(-0.2f, -1.0f, -0.3f));
-    objectShader->setVec3("dirLight.ambient", ambient);
-    objectShader->setVec3("dirLight.diffuse", diffuse);
-    objectShader->setVec3("dirLight.specular", specular);
-
-    // Point light
-    int i = 0;
-    for (const glm::vec3& position : pointLightPositions)
-    {
-        std::ostringstream ossLightPos;
-        ossLightPos << "pointLightPos[" << i << "]";
-        std::string pointLightPos = ossLightPos.str();
-        objectShader->setVec3(pointLightPos, position);
-
-        std::ostringstream ossLightParams;
-        ossLightParams << "pointLights[" << i << "]";
-        std::string pointLight = ossLightParams.str();
-        objectShader->setBool(pointLight + ".isActive", enable_point_lights);
-        objectShader->setVec3(pointLight + ".ambient", ambient * pointLightColors[i] * point_light_intensity);
-        objectShader->setVec3(pointLight + ".diffuse", diffuse * pointLightColors[i] * point_light_intensity);
-        objectShader->setVec3(pointLight + ".specular", specular);
-        // https://wiki.ogre3d.org/tiki-index.php?page=-Point+Light+Attenuation
-        objectShader->setFloat(pointLight + ".constant", 1.0f);
-        objectShader->setFloat(pointLight + ".linear", 0.09f);
-        objectShader->setFloat(pointLight + ".quadratic", 0.032f);
-        i++;
-    }
-
-    // Spot light
-    objectShader->setBool("spotLights[0].isActive", false);
-    objectShader->setVec3("spotLightPos[0]", cameraPosition);
-    objectShader->setVec3("spotLightDir[0]", cameraFront);
-    objectShader->setFloat("spotLights[0].cutOff", glm::cos(glm::radians(12.5f)));
-    objectShader->setFloat("spotLights[0].outerCutOff", glm::cos(glm::radians(18.5f)));
-    objectShader->setVec3("spotLights[0].ambient", glm::vec3(0.2f));
-    objectShader->setVec3("spotLights[0].diffuse", diffuse);
-    objectShader->setVec3("spotLights[0].specular", specular);
-    objectShader->setFloat("spotLights[0].constant", 1.0f);
-    objectShader->setFloat("spotLights[0].linear", 0.09f);
-    objectShader->setFloat("spotLights[0].quadratic", 0.032f);
 }
 
 void renderLoop(GLFWwindow* window)
 {
-    unsigned int indiceCount = 0;
+    Profiler& profiler = renderer->getProfiler();
+    profiler.beginFrame();
     processInput(window);
     glfwPollEvents();
 
@@ -488,95 +129,55 @@ void renderLoop(GLFWwindow* window)
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
-    const glm::mat4 view = glm::lookAt(cameraPosition, cameraPosition + cameraFront, world_up);
-
-    // Bind to framebuffer and draw scene as we normally would to color texture
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-    glEnable(GL_DEPTH_TEST); // Enable depth testing (disabled for rendering screen-space quad)
-
-    glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    objectShader->use();
-    setLightParameters();
-    objectShader->setFloat("material.shininess", 192.0f);
-    objectShader->setMat4("view", view);
-    objectShader->setVec3("camPos", cameraPosition);
-
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::rotate(model, glm::radians(rot[0]), glm::vec3(1.0, 0.0, 0.0));
-    model = glm::rotate(model, glm::radians(rot[1]), glm::vec3(0.0, 1.0, 0.0));
-    model = glm::rotate(model, glm::radians(rot[2]), glm::vec3(0.0, 0.0, 1.0));
-    model = glm::translate(model, glm::vec3(pos[0], pos[1], pos[2]));
-    model = glm::scale(model, glm::vec3(scale[0], scale[1], scale[2]));
-    objectShader->setMat4("model", model);
-
-    // Activate and bind skybox texture for reflections before drawing the model
-    glActiveTexture(GL_TEXTURE0 + skyboxTexUnit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTex);
-    objectShader->setBool("enableIBL", enableIBL);
-
-    indiceCount += modelAsset->Draw(*objectShader);
-
-    if (enable_point_lights)
+    simulation->setObjectTransform(settings.position, settings.rotation, settings.scale);
+    const SimulationState state = simulation->sample();
+    const Camera camera = Simulation::toCamera(state);
+    RenderSettings frameSettings = settings;
+    for (int i = 0; i < 3; i++)
     {
-        lightShader->use();
-        lightShader->setMat4("view", view);
-        for (int i = 0; i < std::size(pointLightPositions); i++)
-        {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, pointLightPositions[i]);
-            model = glm::scale(model, glm::vec3(0.1f));
-            lightShader->setMat4("model", model);
-
-            lightPreview->Draw(*lightShader, pointLightColors[i] * point_light_intensity);
-        }
+        frameSettings.position[i] = state.objectPosition[i];
+        frameSettings.rotation[i] = state.objectRotation[i];
+        frameSettings.scale[i] = state.objectScale[i];
     }
 
-    if (show_skybox)
+    if (isRecordingPath)
     {
-        // Draw the skybox
-        // Depth test passes when values are equal to depth buffer's content. Even though ideally this
-        // should be GL_EQUAL, some artifacts will occur on the skybox when panning because sometimes
-        // incoming pixel depth value < depth value in depth buffer, so we use GL_LEQUAL to avoid them
-        glDepthFunc(GL_LEQUAL);
-        // Remove translation section of the view transform matrix by taking only the upper-left 3x3 matrix,
-        // so the skybox will rotate but not scale or move.
-        const auto viewSkybox = glm::mat4(glm::mat3(view));
-        skyboxShader->use();
-        skyboxShader->setMat4("view", viewSkybox);
-        renderCube();
-        glDepthFunc(GL_LESS); // Set depth function back to default
+        recordTime += static_cast<float>(deltaTime);
+        recordedPath.addKey({recordTime, camera.position, camera.front, camera.fov});
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0); // Back to default framebuffer
-
-    bloomRenderer->renderBloomTexture(colorBuffTextures[1], bloom_filter_radius);
-
-    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    screenShader->use();
-    screenShader->setFloat("gamma", 2.0f);
-    screenShader->setFloat("exposure", 1.0f);
-    screenShader->setBool("bloomEnabled", enable_bloom);
-    glDisable(GL_DEPTH_TEST);
-    glActiveTexture(GL_TEXTURE0 + screenTexUnit);
-    glBindTexture(GL_TEXTURE_2D, colorBuffTextures[0]);
-    glActiveTexture(GL_TEXTURE0 + bloomBlurTexUnit);
-    glBindTexture(GL_TEXTURE_2D, bloomRenderer->bloomTexture());
-    renderQuad();
-
-    // Wireframe mode
-    // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+#ifdef LUMINA_COUNT_ALLOCATIONS
+    const uint64_t allocationsBefore = AllocationCounter::count();
+    const unsigned int indiceCount = renderer->render(camera, frameSettings, static_cast<float>(deltaTime));
+    frame_allocations = AllocationCounter::count() - allocationsBefore;
+#else
+    const unsigned int indiceCount = renderer->render(camera, frameSettings, static_cast<float>(deltaTime));
+#endif
 
+    profiler.beginScope("ImGui");
     const unsigned int triCount = indiceCount / 3;
     displayUI(triCount);
 
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    profiler.endScope();
 
+    profiler.beginScope("Swap", false);
     glfwSwapBuffers(window);
+    profiler.endScope();
+
+    profiler.endFrame();
+
+    // Every frame is recorded from its CPU timings, hitches included. GPU timings arrive a frame late
+    // and are dropped when not ready, so they are patched in once they resolve.
+    if (const ProfileFrame* frame = profiler.endedFrame())
+    {
+        telemetry->record(*frame);
+    }
+    if (const ProfileFrame* frame = profiler.latestFrame())
+    {
+        telemetry->resolveGpu(*frame);
+    }
 }
 
 // Helper to display a little (?) mark which shows a tooltip when hovered
@@ -605,35 +206,188 @@ void displayUI(const unsigned int& triangleCount)
 
     // Start Transform section
     ImGui::SeparatorText("Transform");
-    ImGui::DragFloat3("Position", pos, 0.001f);
-    ImGui::DragFloat3("Rotation", rot, 0.01f);
-    ImGui::DragFloat3("Scale", scale, 0.001f);
+    ImGui::DragFloat3("Position", settings.position, 0.001f);
+    ImGui::DragFloat3("Rotation", settings.rotation, 0.01f);
+    ImGui::DragFloat3("Scale", settings.scale, 0.001f);
     // End Transform section
 
     ImGui::Spacing();
 
+    ImGui::SeparatorText("Scene Graph");
+    {
+        SceneGraph& sceneGraph = renderer->getSceneGraph();
+        const int nodeCount = static_cast<int>(sceneGraph.nodeCount());
+        ImGui::Text("Nodes: %d (%zu updated)", nodeCount, sceneGraph.updatedNodes().size());
+        if (nodeCount > 0)
+        {
+            selected_node = std::clamp(selected_node, 0, nodeCount - 1);
+            if (ImGui::SliderInt("Node", &selected_node, 0, nodeCount - 1))
+            {
+                std::fill(std::begin(node_offset), std::end(node_offset), 0.0f);
+            }
+            ImGui::SameLine(); helpMarker(sceneGraph.name(selected_node).c_str());
+            float offset[3] = {node_offset[0], node_offset[1], node_offset[2]};
+            if (ImGui::DragFloat3("Node Offset", offset, 0.001f))
+            {
+                const glm::vec3 delta(offset[0] - node_offset[0], offset[1] - node_offset[1], offset[2] - node_offset[2]);
+                sceneGraph.setLocalTransform(selected_node, glm::translate(glm::mat4(1.0f), delta) *
+                                                            sceneGraph.localTransform(selected_node));
+                std::copy(std::begin(offset), std::end(offset), std::begin(node_offset));
+            }
+        }
+    }
+
+    ImGui::Spacing();
+
     ImGui::SeparatorText("Skybox");
-    ImGui::Checkbox("Show skybox", &show_skybox);
+    ImGui::Checkbox("Show skybox", &settings.showSkybox);
 
     ImGui::Spacing();
 
     ImGui::SeparatorText("Lights");
-    ImGui::Checkbox("Enable Point Lights", &enable_point_lights);
+    ImGui::Checkbox("Enable Point Lights", &settings.enablePointLights);
     ImGui::PushItemWidth(60);
-    ImGui::DragFloat("Intensity", &point_light_intensity, 0.1f, 0.0f, 500.0f, "%.1f");
+    ImGui::DragFloat("Intensity", &settings.pointLightIntensity, 0.1f, 0.0f, 500.0f, "%.1f");
     ImGui::SameLine(); helpMarker("Applies to all point lights equally");
 
     ImGui::Spacing();
 
     ImGui::SeparatorText("IBL (Image Based Lighting)");
-    ImGui::Checkbox("Enable IBL", &enableIBL);
+    ImGui::Checkbox("Enable IBL", &settings.enableIBL);
 
     ImGui::Spacing();
 
     ImGui::SeparatorText("Bloom");
-    ImGui::Checkbox("Enable Bloom", &enable_bloom);
+    ImGui::Checkbox("Enable Bloom", &settings.enableBloom);
     ImGui::PushItemWidth(80);
-    ImGui::DragFloat("Filter Radius", &bloom_filter_radius, 0.0001f, 0.0f, 1.0f, "%.4f");
+    ImGui::DragFloat("Filter Radius", &settings.bloomFilterRadius, 0.0001f, 0.0f, 1.0f, "%.4f");
+    ImGui::DragFloat("Threshold", &settings.bloomThreshold, 0.01f, 0.0f, 10.0f, "%.2f");
+    ImGui::DragFloat("Soft Knee", &settings.bloomSoftKnee, 0.01f, 0.0f, 1.0f, "%.2f");
+
+    ImGui::Spacing();
+
+    ImGui::SeparatorText("Culling");
+    if (renderer->isGpuCullingSupported())
+    {
+        ImGui::Checkbox("GPU Culling", &settings.enableGpuCulling);
+        ImGui::SameLine(); helpMarker("Culls meshes in a compute pass and submits each set of textures with a "
+                                      "single multi draw indirect call");
+    }
+    else
+    {
+        ImGui::TextDisabled("GPU Culling requires OpenGL 4.3");
+    }
+    ImGui::Checkbox("Occlusion Culling", &settings.enableOcclusionCulling);
+    ImGui::SameLine(); helpMarker("Rasterizes the largest meshes into a small depth buffer on the CPU and skips "
+                                  "meshes hidden behind them");
+    ImGui::Text("Occluded meshes: %zu / %zu", renderer->getOccludedMeshCount(), renderer->getMeshCount());
+    const FramePreparer& framePreparer = renderer->getFramePreparer();
+    ImGui::Text("Prepared draws: %zu from %zu jobs", framePreparer.commands().size(), framePreparer.jobCount());
+    ImGui::SameLine(); helpMarker("Culled, sorted and recorded on the worker threads. Replayed when GPU culling "
+                                  "is off, their texture detail is streamed either way");
+
+    ImGui::Spacing();
+
+    ImGui::SeparatorText("Overdraw");
+    ImGui::Checkbox("Depth Pre-Pass", &settings.enableDepthPrepass);
+    ImGui::SameLine(); helpMarker("Renders depth first, so the object shader runs once per visible pixel. Pays "
+                                  "off when overdraw is well above 1x.");
+    const OverdrawStats& overdraw = renderer->getOverdrawStats();
+    ImGui::Text("Shaded fragments: %.2f M", static_cast<double>(overdraw.shadedFragments()) / 1.0e6);
+    if (overdraw.hasOverdraw())
+    {
+        ImGui::Text("Overdraw: %.2fx", overdraw.overdraw());
+        ImGui::Text("Saved by pre-pass: %.2f M", static_cast<double>(overdraw.savedFragments()) / 1.0e6);
+    }
+    else
+    {
+        ImGui::TextDisabled("Overdraw is measured while the pre-pass is on");
+    }
+
+    ImGui::Spacing();
+
+    ImGui::SeparatorText("Frame Graph");
+    {
+        const FrameGraphStats& frameGraph = renderer->getFrameGraphStats();
+        ImGui::Text("Passes: %zu (%zu culled)", frameGraph.passCount, frameGraph.culledPassCount);
+        ImGui::Text("Targets: %zu in %zu textures", frameGraph.textureCount, frameGraph.physicalTextureCount);
+        ImGui::SameLine(); helpMarker("Transient targets whose lifetimes do not overlap share a texture");
+        ImGui::Text("Target memory: %.2f MB of %.2f MB requested",
+                    static_cast<double>(frameGraph.allocatedBytes) / (1024.0 * 1024.0),
+                    static_cast<double>(frameGraph.requestedBytes) / (1024.0 * 1024.0));
+        ImGui::Text("Saved by aliasing: %.2f MB", static_cast<double>(frameGraph.savedBytes()) / (1024.0 * 1024.0));
+    }
+
+    ImGui::Spacing();
+
+    ImGui::SeparatorText("Anti-Aliasing");
+    ImGui::Checkbox("TAA", &settings.enableTaa);
+    ImGui::SameLine(); helpMarker("Temporal anti-aliasing, also upscales the scene when dynamic resolution "
+                                  "lowers it");
+
+    ImGui::Spacing();
+
+    ImGui::SeparatorText("Shadows");
+    ImGui::Checkbox("Enable Shadows", &settings.enableShadows);
+    ImGui::SameLine(); helpMarker("Shadow maps are cached and only re-rendered when a light, a caster or, for "
+                                  "the directional light, the camera moves");
+    ImGui::Checkbox("Directional Light", &settings.enableDirectionalLight);
+    ImGui::Text("Shadow maps rendered: %u", renderer->getShadowMapsRendered());
+
+    ImGui::Spacing();
+
+    ImGui::SeparatorText("Ambient Occlusion");
+    ImGui::Checkbox("SSAO", &settings.enableSsao);
+    ImGui::SameLine(); helpMarker("Screen-space ambient occlusion, darkens the image based lighting in creases");
+    ImGui::Checkbox("Quarter Resolution", &settings.ssaoQuarterResolution);
+    ImGui::PushItemWidth(80);
+    ImGui::DragFloat("AO Radius", &settings.ssaoRadius, 0.01f, 0.05f, 5.0f, "%.2f");
+    ImGui::DragFloat("AO Intensity", &settings.ssaoIntensity, 0.05f, 0.5f, 8.0f, "%.2f");
+    ImGui::PopItemWidth();
+
+    ImGui::Spacing();
+
+    ImGui::SeparatorText("Dynamic Resolution");
+    ImGui::Checkbox("Enable Dynamic Resolution", &settings.enableDynamicResolution);
+    ImGui::SameLine(); helpMarker("Lowers the scene resolution while frames take longer than the target and "
+                                  "upscales it when compositing");
+    ImGui::PushItemWidth(80);
+    ImGui::DragFloat("Target (ms)", &settings.targetFrameMs, 0.1f, 4.0f, 100.0f, "%.2f");
+    ImGui::SameLine();
+    ImGui::DragFloat("Min Scale", &settings.minRenderScale, 0.01f, 0.25f, 1.0f, "%.2f");
+    ImGui::Text("Render scale: %.0f%%", renderer->getRenderScale() * 100.0f);
+
+    ImGui::Spacing();
+
+    ImGui::SeparatorText("Texture Streaming");
+    ImGui::PushItemWidth(80);
+    if (ImGui::DragFloat("Budget (MB)", &texture_budget_mb, 1.0f, 16.0f, 8192.0f, "%.0f"))
+    {
+        renderer->getTextureStreamer().setBudget(static_cast<size_t>(texture_budget_mb * 1024.0f * 1024.0f));
+    }
+    ImGui::SameLine(); helpMarker("Memory available to material textures. Detail no visible mesh needs is "
+                                  "evicted first when the budget is reached.");
+
+    ImGui::Spacing();
+
+    ImGui::SeparatorText("Camera Path");
+    if (!isRecordingPath && ImGui::Button("Record"))
+    {
+        recordedPath.clear();
+        recordTime = 0.0f;
+        recordStatus.clear();
+        isRecordingPath = true;
+    }
+    else if (isRecordingPath && ImGui::Button("Stop & Save"))
+    {
+        const std::string path = "camera_path.txt";
+        isRecordingPath = false;
+        recordStatus = recordedPath.save(path) ? "Saved " + path : "Failed to save " + path;
+    }
+    ImGui::SameLine();
+    if (isRecordingPath) { ImGui::Text("%.1f s", recordTime); }
+    else if (!recordStatus.empty()) { ImGui::TextDisabled("%s", recordStatus.c_str()); }
+    else { helpMarker("Records the camera for replay with LuminaHeadless --path"); }
 
     ImGui::End();
     // End Settings window
@@ -652,8 +406,28 @@ void displayUI(const unsigned int& triangleCount)
     ImGui::Text("FPS: %.1f", io.Framerate);
     ImGui::Text("Avg: %.3f ms", 1000.0f / io.Framerate);
     ImGui::Text("Triangles: %d", triangleCount);
+    ImGui::Text("Model submit: %.3f ms", renderer->getModelSubmitTime());
+    ImGui::Text("Simulation: %.0f ticks/s", simulation->measuredTickRate());
+#ifdef LUMINA_COUNT_ALLOCATIONS
+    ImGui::Text("Heap allocations: %llu per frame", static_cast<unsigned long long>(frame_allocations));
+#endif
+    ImGui::Text("Frame arena: %.1f / %.1f KB", static_cast<double>(FrameArena::frame().peakBytes()) / 1024.0,
+                static_cast<double>(FrameArena::frame().capacity()) / 1024.0);
+    const TextureStreamer& textureStreamer = renderer->getTextureStreamer();
+    const TextureMemoryStats& textureStats = TextureUtils::textureMemoryStats();
+    ImGui::Text("Textures: %.1f MB (%.1f MB uncompressed)",
+                static_cast<double>(textureStats.uploadedBytes) / (1024.0 * 1024.0),
+                static_cast<double>(textureStats.uncompressedBytes) / (1024.0 * 1024.0));
+    ImGui::Text("Streamed: %.1f / %.1f MB (%.1f MB full res)",
+                static_cast<double>(textureStreamer.residentBytes()) / (1024.0 * 1024.0),
+                static_cast<double>(textureStreamer.budget()) / (1024.0 * 1024.0),
+                static_cast<double>(textureStreamer.fullResolutionBytes()) / (1024.0 * 1024.0));
     ImGui::End();
     // End stats window
+
+    renderer->getProfiler().drawUI();
+    telemetry->drawUI();
+    GpuMemory::drawUI();
 }
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
@@ -705,157 +479,36 @@ void cursor_pos_callback(GLFWwindow* window, double xPos, double yPos)
     xOffset *= MOUSE_SENSITIVITY;
     yOffset *= MOUSE_SENSITIVITY;
 
-    camYaw += xOffset;
-    camPitch += yOffset;
-
-    if (camPitch > 89.0f) { camPitch = 89.0f; }
-    if (camPitch < -89.0f) { camPitch = -89.0f; }
-
-    glm::vec3 cameraDirection = getCameraDirection(camYaw, camPitch);
-    cameraFront = glm::normalize(cameraDirection);
+    simulation->addLook(xOffset, yOffset);
 }
 
 void scroll_callback(GLFWwindow* window, double xOffset, double yOffset)
 {
-    fov -= (float)yOffset;
-    if (fov < 1.0f) { fov = 1.0f; }
-    if (fov > 45.0f) { fov = 45.0f; }
-}
-
-glm::vec3 getCameraDirection(const double yaw, const double pitch)
-{
-    glm::vec3 cameraDirection;
-    cameraDirection.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-    cameraDirection.y = sin(glm::radians(pitch));
-    cameraDirection.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-
-    return cameraDirection;
+    simulation->addZoom(static_cast<float>(yOffset));
 }
 
 void deinit()
 {
-    glDeleteTextures(1, &hdriTexture);
-    delete(modelAsset);
-    delete(objectShader);
-    delete(lightPreview);
-    delete(lightShader);
-    delete(screenShader);
-    delete(skyboxShader);
-    delete(equirectToCubemapShader);
-    delete(irradianceShader);
-    delete(prefilterShader);
-    delete(brdfShader);
-    delete(bloomRenderer);
-}
-
-// Renders a 1x1 3D cube in NDC
-void renderCube()
-{
-    // initialize (if necessary)
-    if (cubeVAO == 0)
-    {
-        constexpr float vertices[] = {
-            // back face
-            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-             1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-             1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right
-             1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-            -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
-            // front face
-            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-             1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
-             1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-             1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-            -1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
-            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-            // left face
-            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
-            -1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
-            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
-            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
-            -1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
-            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
-            // right face
-             1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
-             1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
-             1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
-             1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
-             1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
-             1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            // bottom face
-            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
-             1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
-             1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
-             1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
-            -1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
-            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
-            // top face
-            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
-             1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-             1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
-             1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
-            -1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left
-        };
-        glGenVertexArrays(1, &cubeVAO);
-        glGenBuffers(1, &cubeVBO);
-        // fill buffer
-        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-        // link vertex attributes
-        glBindVertexArray(cubeVAO);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
-    }
-    // render Cube
-    glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
-}
-
-void renderQuad()
-{
-    if (quadVAO == 0)
-    {
-        constexpr float QUAD_VERTICIES[] = {
-            // positions        // texture Coords
-            -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
-            -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
-             1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
-             1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
-        };
-        // setup plane VAO
-        glGenVertexArrays(1, &quadVAO);
-        glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICIES), &QUAD_VERTICIES, GL_STATIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    }
-
-    glBindVertexArray(quadVAO);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    delete(simulation);
+    delete(renderer);
+    delete(telemetry);
 }
 
 int main()
 {
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Lumina Engine", nullptr, nullptr);
+    // Prefer 4.3 for GPU driven culling, fall back to 3.3 where it is not available (e.g. macOS)
+    constexpr int CONTEXT_VERSIONS[][2] = {{4, 3}, {3, 3}};
+    GLFWwindow* window = nullptr;
+    for (const auto& [major, minor] : CONTEXT_VERSIONS)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Lumina Engine", nullptr, nullptr);
+        if (window) { break; }
+    }
     if (window == nullptr)
     {
         std::cout << "Failed to create GLFW window" << std::endl;
@@ -900,9 +553,10 @@ int main()
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
-    glfwTerminate();
-
+    // GL objects have to go before the context does
     deinit();
 
+    glfwTerminate();
+
     return 0;
 }